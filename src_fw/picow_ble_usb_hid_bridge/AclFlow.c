@@ -0,0 +1,277 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "tusb.h"
+#include "AclFlow.h"
+#include "CryptoOffload.h"
+#include "Log.h"
+
+#if ACLF_ENABLE
+
+// [Definitions]
+// HCI_Host_Number_Of_Completed_Packets: Num_Handles, then Handle and Num_Completed_Packets of each
+#define ACLF_OPCODE_HOST_NUM_COMPLETED_PACKETS 0x0C35
+
+// [Structures]
+// Credits held for one connection
+typedef struct _ST_ACLF_CREDIT {
+    USHORT handle;                      // Connection handle
+    USHORT count;                       // ACL packets not returned yet (0 = free entry)
+} ST_ACLF_CREDIT;
+
+// [File Scope Variables]
+static const hci_transport_t *f_pstBase = NULL;  // Transport below
+static hci_transport_t f_stTransport;            // Transport handed to the layer above
+static void (*f_pfnHandler)(uint8_t packet_type, uint8_t *packet, uint16_t size) = NULL; // Layer above
+static ST_ACLF_CREDIT f_astCredit[ACLF_HANDLE_MAX]; // Held credits (core1)
+static volatile bool f_bHeld = false;            // Credits are held (written by core1)
+static volatile bool f_bDrained = false;         // A USB host drains the queue (written by core0)
+static volatile bool f_bPosted = false;          // aclf_release is pending on core1's run loop
+static ULONG f_sentOwed = 0;                     // PACKET_SENT events of our own commands, not for the layer above
+static uint32_t f_holdUs = 0;                    // Time the credits were held
+static btstack_context_callback_registration_t f_stRelease;
+static ST_ACLF_STAT f_stStat = {0};              // Statistics
+
+// [Function Prototypes]
+#if !CRYP_ENABLE
+const hci_transport_t *__real_hci_transport_cyw43_instance(void);
+const hci_transport_t *__wrap_hci_transport_cyw43_instance(void);
+#endif
+
+// The queue has drained enough, or nobody drains it
+static inline bool aclf_can_release(void)
+{
+    return !f_bDrained || (CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) <= ACLF_LOW_WATER);
+}
+
+// Accepts a command the way the transport below does
+static void aclf_ack(void)
+{
+    static const UCHAR aucEvt[2] = { HCI_EVENT_TRANSPORT_PACKET_SENT, 0 };
+
+    if (f_pstBase->can_send_packet_now != NULL) {
+        f_pfnHandler(HCI_EVENT_PACKET, (uint8_t *)aucEvt, sizeof(aucEvt));
+    }
+}
+
+// Adds credits of a command to the held ones. Returns false if there is no room.
+static bool aclf_hold(const uint8_t *packet, int size)
+{
+    ULONG num = packet[3];
+    ULONG i, j;
+    USHORT handle;
+
+    if (size != (int)(4 + num * 4)) {
+        return false;
+    }
+    // All or nothing: the command is either held or forwarded unchanged
+    for (i = 0; i < num; i++) {
+        handle = little_endian_read_16(packet, 4 + i * 4);
+        for (j = 0; j < ACLF_HANDLE_MAX; j++) {
+            if ((f_astCredit[j].count == 0) || (f_astCredit[j].handle == handle)) {
+                break;
+            }
+        }
+        if (j == ACLF_HANDLE_MAX) {
+            return false;
+        }
+    }
+    for (i = 0; i < num; i++) {
+        handle = little_endian_read_16(packet, 4 + i * 4);
+        for (j = 0; j < ACLF_HANDLE_MAX; j++) {
+            if ((f_astCredit[j].count == 0) || (f_astCredit[j].handle == handle)) {
+                break;
+            }
+        }
+        f_astCredit[j].handle = handle;
+        f_astCredit[j].count += little_endian_read_16(packet, 6 + i * 4);
+        f_stStat.credit_cnt += little_endian_read_16(packet, 6 + i * 4);
+    }
+    return true;
+}
+
+// Returns the held credits in one command (core1)
+static void aclf_release(void *pCtx)
+{
+    uint8_t aucCmd[4 + ACLF_HANDLE_MAX * 4];
+    ULONG num = 0;
+    ULONG i;
+
+    (void)pCtx;
+    CMN_EntrySpinLock();
+    f_bPosted = false;
+    CMN_ExitSpinLock();
+    if (!f_bHeld || !aclf_can_release()) {
+        return;
+    }
+    // hci.c has a packet in flight: ACLF_Task posts again
+    if ((f_pstBase->can_send_packet_now != NULL) && !f_pstBase->can_send_packet_now(HCI_COMMAND_DATA_PACKET)) {
+        return;
+    }
+    for (i = 0; i < ACLF_HANDLE_MAX; i++) {
+        if (f_astCredit[i].count > 0) {
+            little_endian_store_16(aucCmd, 4 + num * 4, f_astCredit[i].handle);
+            little_endian_store_16(aucCmd, 6 + num * 4, f_astCredit[i].count);
+            f_astCredit[i].count = 0;
+            num++;
+        }
+    }
+    f_bHeld = false;
+    CMN_StatAdd(&f_stStat.hold_us, time_us_32() - f_holdUs);
+    if ((f_stStat.hold_us.cnt % ACLF_LOG_HOLDS) == 0) {
+        LOG_INFO("ACL credits held %lu times, us: min %lu avg %lu max %lu (%lu packets)\n", f_stStat.hold_cnt,
+            f_stStat.hold_us.min, (ULONG)(f_stStat.hold_us.sum / f_stStat.hold_us.cnt), f_stStat.hold_us.max, f_stStat.credit_cnt);
+    }
+    if (num == 0) {
+        return;
+    }
+    little_endian_store_16(aucCmd, 0, ACLF_OPCODE_HOST_NUM_COMPLETED_PACKETS);
+    aucCmd[2] = (uint8_t)(1 + num * 4);
+    aucCmd[3] = (uint8_t)num;
+    if (f_pstBase->can_send_packet_now != NULL) {
+        f_sentOwed++;
+    }
+    (void)f_pstBase->send_packet(HCI_COMMAND_DATA_PACKET, aucCmd, (int)(4 + num * 4));
+}
+
+//--------------------------------------------------------------------+
+// Core1: HCI transport
+//--------------------------------------------------------------------+
+// Events from the controller: the PACKET_SENT of our own commands and the credits of a closed connection are dropped
+static void aclf_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size)
+{
+    ULONG i;
+
+    if (packet_type == HCI_EVENT_PACKET) {
+        if ((packet[0] == HCI_EVENT_TRANSPORT_PACKET_SENT) && (f_sentOwed > 0)) {
+            f_sentOwed--;
+            return;
+        }
+        // The controller frees the buffers of a connection when it is closed
+        if ((packet[0] == HCI_EVENT_DISCONNECTION_COMPLETE) && (size >= 5) && (packet[2] == 0)) {
+            for (i = 0; i < ACLF_HANDLE_MAX; i++) {
+                if ((f_astCredit[i].count > 0) && (f_astCredit[i].handle == little_endian_read_16(packet, 3))) {
+                    f_astCredit[i].count = 0;
+                    f_stStat.flush_cnt++;
+                }
+            }
+        }
+    }
+    f_pfnHandler(packet_type, packet, size);
+}
+
+static void aclf_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size))
+{
+    f_pfnHandler = handler;
+    f_pstBase->register_packet_handler(&aclf_packet_handler);
+}
+
+// Packets to the controller: the completed packets are held while the queue is full
+static int aclf_send_packet(uint8_t packet_type, uint8_t *packet, int size)
+{
+    if ((packet_type != HCI_COMMAND_DATA_PACKET) || (size < 4) ||
+        (little_endian_read_16(packet, 0) != ACLF_OPCODE_HOST_NUM_COMPLETED_PACKETS)) {
+        return f_pstBase->send_packet(packet_type, packet, size);
+    }
+    if (!f_bHeld && (!f_bDrained || (CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) < ACLF_HIGH_WATER))) {
+        return f_pstBase->send_packet(packet_type, packet, size);
+    }
+    if (!aclf_hold(packet, size)) {
+        return f_pstBase->send_packet(packet_type, packet, size);
+    }
+    if (!f_bHeld) {
+        f_bHeld = true;
+        f_holdUs = time_us_32();
+        f_stStat.hold_cnt++;
+    }
+    aclf_ack();
+
+    return 0;
+}
+
+/**
+ * @brief Layer the backpressure over an HCI transport.
+ *
+ * @param pstBase Transport below (CYW43)
+ * @return Transport for the layer above (crypto offload or hci_init)
+ */
+const hci_transport_t *ACLF_Transport(const hci_transport_t *pstBase)
+{
+    f_pstBase = pstBase;
+    f_stTransport = *pstBase;
+    f_stTransport.register_packet_handler = &aclf_register_packet_handler;
+    f_stTransport.send_packet = &aclf_send_packet;
+    f_stRelease.callback = &aclf_release;
+    f_stRelease.context = NULL;
+
+    return &f_stTransport;
+}
+
+#if !CRYP_ENABLE
+/**
+ * @brief CYW43 HCI transport with the backpressure (linked with --wrap).
+ *
+ * @return Transport for hci_init
+ */
+const hci_transport_t *__wrap_hci_transport_cyw43_instance(void)
+{
+    return ACLF_Transport(__real_hci_transport_cyw43_instance());
+}
+#endif
+
+/**
+ * @brief Return the held credits once the queue has drained (poll-mode CYW43 architecture, core1 loop).
+ */
+void ACLF_Poll(void)
+{
+    if (f_bHeld) {
+        aclf_release(NULL);
+    }
+}
+
+//--------------------------------------------------------------------+
+// Core0: queue drain
+//--------------------------------------------------------------------+
+/**
+ * @brief Follow the USB host and schedule the return of the credits (core0 loop, after hid_task).
+ */
+void ACLF_Task(void)
+{
+#if !PICO_CYW43_ARCH_POLL
+    bool bPost;
+#endif
+
+    f_bDrained = tud_mounted();
+#if !PICO_CYW43_ARCH_POLL
+    if (!f_bHeld || !aclf_can_release()) {
+        return;
+    }
+    CMN_EntrySpinLock();
+    bPost = !f_bPosted;
+    f_bPosted = true;
+    CMN_ExitSpinLock();
+    if (bPost) {
+        btstack_run_loop_execute_on_main_thread(&f_stRelease);
+    }
+#endif
+}
+
+/**
+ * @brief Check if the credits are held.
+ *
+ * @return true while the controller is kept from delivering
+ */
+bool ACLF_IsHeld(void)
+{
+    return f_bHeld;
+}
+
+/**
+ * @brief Get the statistics.
+ *
+ * @return Statistics
+ */
+const ST_ACLF_STAT* ACLF_GetStat(void)
+{
+    return &f_stStat;
+}
+
+#endif
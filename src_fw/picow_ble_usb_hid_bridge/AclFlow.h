@@ -0,0 +1,73 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef ACLFLOW_H
+#define ACLFLOW_H
+
+#include "btstack_config.h"
+#include "btstack.h"
+#include "Common.h"
+
+// Backpressure from the report queue to the BLE link.
+// With ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL, the controller delivers at most
+// HCI_HOST_ACL_PACKET_NUM ACL packets that BTstack has not returned yet with
+// HCI_Host_Number_Of_Completed_Packets. That command is held back in the HCI transport
+// (wrapped like in CryptoOffload.h) while the report queue is at ACLF_HIGH_WATER or above:
+// the controller stops delivering, its receive buffers fill, and the link layer stops
+// acknowledging the notifications, so the peer keeps them and retransmits them instead of
+// the bridge dropping them. When core0 has drained the queue to ACLF_LOW_WATER (ACLF_Task),
+// the held credits are returned in one command from core1's run loop.
+// Without a mounted USB host the queue is not drained, so the credits are never held.
+// The wrapped transport and the held credits are opt-in until validated on the CYW43
+// (CMake BRIDGE_ACL_BACKPRESSURE).
+
+// [Definitions]
+// Set to 1 to hold the credits while the queue is full (else reports are dropped when it is full)
+#ifndef ACLF_ENABLE
+#define ACLF_ENABLE 0
+#endif
+
+// Queue depth at which the credits are held, and at which they are returned
+#ifndef ACLF_HIGH_WATER
+#define ACLF_HIGH_WATER (((CMN_QUE_DATA_MAX_HID_RPT - 1) * 3) / 4)
+#endif
+#ifndef ACLF_LOW_WATER
+#define ACLF_LOW_WATER ((CMN_QUE_DATA_MAX_HID_RPT - 1) / 4)
+#endif
+
+// Once the credits are held, the controller may still deliver the packets it has credits for
+#if (ACLF_HIGH_WATER + HCI_HOST_ACL_PACKET_NUM) > (CMN_QUE_DATA_MAX_HID_RPT - 1)
+#error ACLF_HIGH_WATER leaves no room for the ACL packets already credited
+#endif
+#if ACLF_LOW_WATER >= ACLF_HIGH_WATER
+#error ACLF_LOW_WATER must be below ACLF_HIGH_WATER
+#endif
+
+// Connections whose credits can be held
+#define ACLF_HANDLE_MAX 2
+
+// The hold times are logged every this many holds
+#define ACLF_LOG_HOLDS 16
+
+// [Structures]
+// Statistics (cumulative)
+typedef struct _ST_ACLF_STAT {
+    ULONG hold_cnt;                     // Times the credits were held
+    ULONG credit_cnt;                   // ACL packets whose credit was held
+    ULONG flush_cnt;                    // Held credits dropped by a disconnection
+    ST_CMN_STAT hold_us;                // High to low watermark (us)
+} ST_ACLF_STAT;
+
+// [Function Prototypes]
+#if ACLF_ENABLE
+const hci_transport_t *ACLF_Transport(const hci_transport_t *pstBase);
+void ACLF_Task(void);
+void ACLF_Poll(void);
+bool ACLF_IsHeld(void);
+const ST_ACLF_STAT* ACLF_GetStat(void);
+#else
+#define ACLF_Transport(pstBase) (pstBase)
+#define ACLF_Task() ((void)0)
+#define ACLF_Poll() ((void)0)
+#define ACLF_IsHeld() (false)
+#endif
+
+#endif
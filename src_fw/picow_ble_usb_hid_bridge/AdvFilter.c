@@ -0,0 +1,212 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "hardware/clocks.h"
+#include "AdvFilter.h"
+#include "Log.h"
+
+#if ADVF_ENABLE
+
+// [Definitions]
+// Layout of GAP_EVENT_ADVERTISING_REPORT
+#define ADVF_OFS_EVENT_TYPE 2   // Advertising event type, address type, address (8 bytes)
+#define ADVF_OFS_DATA_LEN   11  // AD data length, AD data
+
+// Reports between two checks of the generation age (power of 2)
+#define ADVF_AGE_CHECK 64
+
+// Hash of the AD data after the first ADVF_KEY_AD_BYTES (FNV-1a over 32-bit words)
+#define ADVF_HASH_BASIS 0x811c9dc5
+#define ADVF_HASH_PRIME 0x01000193
+
+// Set in the AD data length byte of a key (at most 31 in a legacy report), 0 = empty entry
+#define ADVF_KEY_VALID 0x80
+
+// Slot mixing (golden ratio multiplier)
+#define ADVF_MIX_PRIME 0x9e3779b1
+
+// [Structures]
+// Key of an advertisement: event type, address type, address, AD data length, first AD bytes,
+// hash of the other AD bytes
+typedef struct _ST_ADVF_KEY {
+    ULONG aulWord[4];
+} ST_ADVF_KEY;
+
+// [File Scope Variables]
+static ST_ADVF_KEY f_astSetA[ADVF_SET_SIZE];    // Generations of keys
+static ST_ADVF_KEY f_astSetB[ADVF_SET_SIZE];
+static ST_ADVF_KEY *f_pstCur = f_astSetA;       // Current generation
+static ST_ADVF_KEY *f_pstPrev = f_astSetB;      // Previous generation
+static ULONG f_ageMs = 0;                       // Start of the current generation
+static ULONG f_startMs = 0;                     // Start of the scan
+static ST_ADVF_STAT f_stStat = {0};             // Statistics of the scan
+
+// Loads 4 bytes of the report (the event buffer may not be aligned)
+static inline ULONG advf_load(const uint8_t *p)
+{
+    return (ULONG)p[0] | ((ULONG)p[1] << 8) | ((ULONG)p[2] << 16) | ((ULONG)p[3] << 24);
+}
+
+// Key of a report; the bytes after a short AD data are zero
+static inline void advf_key(const uint8_t *packet, ST_ADVF_KEY *pstKey)
+{
+    const uint8_t *p = &packet[ADVF_OFS_DATA_LEN];
+    uint8_t aucTail[4] = {0};
+    ULONG len = *p;
+    ULONG hash = ADVF_HASH_BASIS;
+    ULONG i;
+
+    pstKey->aulWord[0] = advf_load(&packet[ADVF_OFS_EVENT_TYPE]);
+    pstKey->aulWord[1] = advf_load(&packet[ADVF_OFS_EVENT_TYPE + 4]);
+    if (len < ADVF_KEY_AD_BYTES) {
+        memcpy(aucTail, p, 1 + len);
+        pstKey->aulWord[2] = advf_load(aucTail) | ADVF_KEY_VALID;
+        pstKey->aulWord[3] = hash;
+        return;
+    }
+    pstKey->aulWord[2] = advf_load(p) | ADVF_KEY_VALID;
+    // The rest of the AD data, a word at a time, then the last 0 to 3 bytes
+    for (i = 1 + ADVF_KEY_AD_BYTES; i + 4 <= 1 + len; i += 4) {
+        hash = (hash ^ advf_load(&p[i])) * ADVF_HASH_PRIME;
+    }
+    for (; i < 1 + len; i++) {
+        hash = (hash ^ p[i]) * ADVF_HASH_PRIME;
+    }
+    pstKey->aulWord[3] = hash;
+}
+
+// Slot of a key, from its address
+static inline ULONG advf_slot(const ST_ADVF_KEY *pstKey)
+{
+    ULONG hash = (pstKey->aulWord[0] ^ pstKey->aulWord[1]) * ADVF_MIX_PRIME;
+    return (hash >> 16) & (ADVF_SET_SIZE - 1);
+}
+
+// Whether a key is in a slot of a generation or in the neighbour of the slot (two-way)
+static inline bool advf_find(const ST_ADVF_KEY *pstSet, ULONG slot, const ST_ADVF_KEY *pstKey)
+{
+    const ULONG *a = pstSet[slot].aulWord;
+    const ULONG *b = pstSet[slot ^ 1].aulWord;
+    const ULONG *k = pstKey->aulWord;
+
+    // Both ways are compared without a branch
+    return ((((a[0] ^ k[0]) | (a[1] ^ k[1]) | (a[2] ^ k[2]) | (a[3] ^ k[3])) == 0) |
+        (((b[0] ^ k[0]) | (b[1] ^ k[1]) | (b[2] ^ k[2]) | (b[3] ^ k[3])) == 0)) != 0;
+}
+
+// Adds a key to the current generation, preferring an empty way
+static void advf_insert(ULONG slot, const ST_ADVF_KEY *pstKey)
+{
+    if ((f_pstCur[slot].aulWord[2] != 0) && (f_pstCur[slot ^ 1].aulWord[2] == 0)) {
+        slot ^= 1;
+    }
+    f_pstCur[slot] = *pstKey;
+}
+
+// Starts a new generation when the current one is old enough
+static void advf_age(void)
+{
+    ULONG now = btstack_run_loop_get_time_ms();
+    ST_ADVF_KEY *pstSet;
+
+    if ((now - f_ageMs) < ADVF_AGE_MS) {
+        return;
+    }
+    pstSet = f_pstPrev;
+    f_pstPrev = f_pstCur;
+    f_pstCur = pstSet;
+    memset(f_pstCur, 0, sizeof(f_astSetA));
+    // After a long pause (no scan) both generations are out of date
+    if ((now - f_ageMs) >= (2 * ADVF_AGE_MS)) {
+        memset(f_pstPrev, 0, sizeof(f_astSetA));
+    }
+    f_ageMs = now;
+}
+
+/**
+ * @brief Start the statistics of a scan.
+ */
+void ADVF_StartScan(void)
+{
+    advf_age();
+    memset(&f_stStat, 0, sizeof(f_stStat));
+    f_startMs = btstack_run_loop_get_time_ms();
+}
+
+/**
+ * @brief Log the early rejections of the scan and the core1 time they saved.
+ */
+void ADVF_StopScan(void)
+{
+    ULONG elapsed_ms = btstack_run_loop_get_time_ms() - f_startMs;
+    ULONG hit_avg = (f_stStat.hit_cycles.cnt > 0) ? (ULONG)(f_stStat.hit_cycles.sum / f_stStat.hit_cycles.cnt) : 0;
+    ULONG miss_avg = (f_stStat.miss_cycles.cnt > 0) ? (ULONG)(f_stStat.miss_cycles.sum / f_stStat.miss_cycles.cnt) : 0;
+    ULONG saved_us = 0;
+
+    if (miss_avg > hit_avg) {
+        saved_us = (ULONG)(((uint64_t)f_stStat.hit_cnt * (miss_avg - hit_avg)) / (clock_get_hz(clk_sys) / 1000000));
+    }
+    LOG_INFO("Adv filter %lu ms: reports %lu, rejected early %lu (%lu per mille), keys added %lu\n",
+        elapsed_ms, f_stStat.report_cnt, f_stStat.hit_cnt,
+        (f_stStat.report_cnt > 0) ? (f_stStat.hit_cnt * 1000) / f_stStat.report_cnt : 0, f_stStat.add_cnt);
+    LOG_INFO("Adv filter: cycles per report, rejected early %lu, classified %lu; %lu us saved\n",
+        hit_avg, miss_avg, saved_us);
+}
+
+/**
+ * @brief Classify an advertising report, rejecting a known advertiser by its key.
+ *
+ * @param packet GAP_EVENT_ADVERTISING_REPORT
+ * @param pfnAccept Classifier of the reports not rejected early
+ * @return true if the advertiser is of interest
+ */
+bool ADVF_Accept(const uint8_t *packet, ADVF_ACCEPT_FUNC pfnAccept)
+{
+    ULONG start = CMN_CycNow();
+    ST_ADVF_KEY stKey;
+    ULONG slot;
+    bool bSample;
+
+    // The clock is read, and a rejection timed, only every ADVF_AGE_CHECK reports
+    bSample = ((++f_stStat.report_cnt & (ADVF_AGE_CHECK - 1)) == 0);
+    if (bSample) {
+        advf_age();
+    }
+    advf_key(packet, &stKey);
+    slot = advf_slot(&stKey);
+    if (advf_find(f_pstCur, slot, &stKey)) {
+        f_stStat.hit_cnt++;
+        if (bSample) {
+            CMN_StatAdd(&f_stStat.hit_cycles, CMN_CycSince(start));
+        }
+        return false;
+    }
+    if (advf_find(f_pstPrev, slot, &stKey)) {
+        advf_insert(slot, &stKey);
+        f_stStat.hit_cnt++;
+        if (bSample) {
+            CMN_StatAdd(&f_stStat.hit_cycles, CMN_CycSince(start));
+        }
+        return false;
+    }
+
+    if (pfnAccept(packet)) {
+        // Accepted reports are always classified again
+        CMN_StatAdd(&f_stStat.miss_cycles, CMN_CycSince(start));
+        return true;
+    }
+    advf_insert(slot, &stKey);
+    f_stStat.add_cnt++;
+    CMN_StatAdd(&f_stStat.miss_cycles, CMN_CycSince(start));
+    return false;
+}
+
+/**
+ * @brief Get the statistics of the current or last scan.
+ *
+ * @return Statistics
+ */
+const ST_ADVF_STAT* ADVF_GetStat(void)
+{
+    return &f_stStat;
+}
+
+#endif
@@ -0,0 +1,65 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef ADVFILTER_H
+#define ADVFILTER_H
+
+#include "btstack.h"
+#include "Common.h"
+
+// Early rejection of the advertisers already classified as not of interest (core1, while scanning).
+// Most advertising reports in a crowded place come from the same phones, beacons and tags,
+// repeating an unchanged advertisement. Each report is reduced to a 16-byte key: event type,
+// address type, address, AD data length, the first 3 bytes of the AD data (usually the flags)
+// and a 32-bit hash of the other AD bytes (the RSSI is left out). A key that was rejected
+// before is rejected again by comparing 4 words, without walking the AD structures.
+// The key is compared whole, so another advertiser is never rejected by a slot collision. An
+// advertiser that changes any byte of its AD data (a service UUID added after the manufacturer
+// data, but also a counter in it) is classified again.
+// The keys are kept in two 2-way sets: every ADVF_AGE_MS (checked at the start of a scan and
+// every few reports) the current one becomes the previous one and the old previous one is
+// dropped, so an advertiser that disappeared leaves the set after at most two periods. A key
+// found in the previous generation moves to the current one.
+// Advertisers of interest are never cached: they are classified at each report.
+// The end of each scan logs the reports rejected early and the core1 time they saved, from the
+// cycles of the classified reports and of one in ADVF_AGE_CHECK rejected reports (timing every
+// rejection would cost as much as the rejection).
+// [Definitions]
+// Set to 0 to walk the AD structures of every report
+#ifndef ADVF_ENABLE
+#define ADVF_ENABLE 1
+#endif
+
+// Keys per generation (power of 2), 16 bytes each
+#define ADVF_SET_SIZE 128
+
+// AD data bytes in the key as they are (with the AD data length, one word); the rest is hashed
+#define ADVF_KEY_AD_BYTES 3
+
+// Generation period
+#define ADVF_AGE_MS 10000 // ms
+
+// [Structures]
+// Statistics of the current scan
+typedef struct _ST_ADVF_STAT {
+    ULONG report_cnt;                   // Reports checked
+    ULONG hit_cnt;                      // Reports rejected by their key
+    ULONG add_cnt;                      // Keys added (reports rejected by the classifier)
+    ST_CMN_STAT hit_cycles;             // Reports rejected by their key (cycles, sampled)
+    ST_CMN_STAT miss_cycles;            // Reports classified (cycles)
+} ST_ADVF_STAT;
+
+// Classifier of an advertising report: true if the advertiser is of interest
+typedef bool (*ADVF_ACCEPT_FUNC)(const uint8_t *packet);
+
+// [Function Prototypes]
+#if ADVF_ENABLE
+void ADVF_StartScan(void);
+void ADVF_StopScan(void);
+bool ADVF_Accept(const uint8_t *packet, ADVF_ACCEPT_FUNC pfnAccept);
+const ST_ADVF_STAT* ADVF_GetStat(void);
+#else
+#define ADVF_StartScan() ((void)0)
+#define ADVF_StopScan() ((void)0)
+#define ADVF_Accept(packet, pfnAccept) (pfnAccept)(packet)
+#endif
+
+#endif
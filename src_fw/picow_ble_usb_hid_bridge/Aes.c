@@ -0,0 +1,181 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "Aes.h"
+#include "CryptoOffload.h"
+
+// [Definitions]
+// Rotates a word right (one RORS on the M0+)
+#define AES_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// Big-endian word of 4 bytes
+#define AES_LOAD(p) (((ULONG)(p)[0] << 24) | ((ULONG)(p)[1] << 16) | ((ULONG)(p)[2] << 8) | (ULONG)(p)[3])
+
+// [File Scope Variables]
+// The tables are read with data-dependent indexes on every round: they are kept in SRAM,
+// away from XIP cache misses and from the stalls while the TLV writes to flash.
+static const UCHAR __not_in_flash("aes") f_aucSbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+static ULONG f_aulTe[256];                 // MixColumns of SubBytes: (2·S[x], S[x], S[x], 3·S[x]), big endian
+static bool f_bTable = false;              // f_aulTe is built
+static ULONG f_aulRk[AES_RK_WORDS];        // Round keys of f_aucKey (AES_Encrypt)
+static UCHAR f_aucKey[AES_KEY_SIZE];       // Key of the last AES_Encrypt
+static bool f_bKey = false;                // f_aulRk is valid
+
+// Multiplies by x in GF(2^8)
+static UCHAR aes_xtime(UCHAR x)
+{
+    return (UCHAR)((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+// Builds the round table from the S-box (1 KB, replaces 4 KB of constant tables).
+// Both cores may build it at once: they write the same values before setting the flag.
+static void aes_build_table(void)
+{
+    UCHAR s, s2;
+    ULONG i;
+
+    for (i = 0; i < 256; i++) {
+        s = f_aucSbox[i];
+        s2 = aes_xtime(s);
+        f_aulTe[i] = ((ULONG)s2 << 24) | ((ULONG)s << 16) | ((ULONG)s << 8) | (ULONG)(s2 ^ s);
+    }
+    f_bTable = true;
+}
+
+// SubWord of the last round and of the key schedule
+static inline ULONG aes_sub_word(ULONG w0, ULONG w1, ULONG w2, ULONG w3)
+{
+    return ((ULONG)f_aucSbox[w0 >> 24] << 24) | ((ULONG)f_aucSbox[(w1 >> 16) & 0xff] << 16) |
+           ((ULONG)f_aucSbox[(w2 >> 8) & 0xff] << 8) | (ULONG)f_aucSbox[w3 & 0xff];
+}
+
+/**
+ * @brief Expand an AES-128 key into its round keys.
+ *
+ * @param pRk Round keys (AES_RK_WORDS words)
+ * @param pKey Key (16 bytes)
+ */
+void __time_critical_func(AES_ExpandKey)(ULONG *pRk, const UCHAR *pKey)
+{
+    ULONG rcon = 0x01;
+    ULONG t;
+    ULONG i;
+
+    if (!f_bTable) {
+        aes_build_table();
+    }
+    for (i = 0; i < 4; i++) {
+        pRk[i] = AES_LOAD(&pKey[4 * i]);
+    }
+    for (i = 4; i < AES_RK_WORDS; i++) {
+        t = pRk[i - 1];
+        if ((i % 4) == 0) {
+            // RotWord, SubWord and Rcon
+            t = aes_sub_word(t << 8, t << 8, t << 8, t >> 24) ^ (rcon << 24);
+            rcon = aes_xtime((UCHAR)rcon);
+        }
+        pRk[i] = pRk[i - 4] ^ t;
+    }
+}
+
+/**
+ * @brief Encrypt one block with expanded round keys.
+ *
+ * @param pRk Round keys from AES_ExpandKey
+ * @param pIn Plaintext (16 bytes)
+ * @param pOut Ciphertext (16 bytes, may be pIn)
+ */
+void __time_critical_func(AES_EncryptBlock)(const ULONG *pRk, const UCHAR *pIn, UCHAR *pOut)
+{
+    const ULONG *pTe = f_aulTe;
+    ULONG s0, s1, s2, s3;
+    ULONG t0, t1, t2, t3;
+    ULONG round;
+    ULONG i;
+
+    s0 = AES_LOAD(&pIn[0]) ^ pRk[0];
+    s1 = AES_LOAD(&pIn[4]) ^ pRk[1];
+    s2 = AES_LOAD(&pIn[8]) ^ pRk[2];
+    s3 = AES_LOAD(&pIn[12]) ^ pRk[3];
+
+    // SubBytes, ShiftRows and MixColumns of one column: one lookup and one rotation per byte
+    for (round = 1; round < AES_ROUNDS; round++) {
+        pRk += 4;
+        t0 = pTe[s0 >> 24] ^ AES_ROR(pTe[(s1 >> 16) & 0xff], 8) ^ AES_ROR(pTe[(s2 >> 8) & 0xff], 16) ^ AES_ROR(pTe[s3 & 0xff], 24) ^ pRk[0];
+        t1 = pTe[s1 >> 24] ^ AES_ROR(pTe[(s2 >> 16) & 0xff], 8) ^ AES_ROR(pTe[(s3 >> 8) & 0xff], 16) ^ AES_ROR(pTe[s0 & 0xff], 24) ^ pRk[1];
+        t2 = pTe[s2 >> 24] ^ AES_ROR(pTe[(s3 >> 16) & 0xff], 8) ^ AES_ROR(pTe[(s0 >> 8) & 0xff], 16) ^ AES_ROR(pTe[s1 & 0xff], 24) ^ pRk[2];
+        t3 = pTe[s3 >> 24] ^ AES_ROR(pTe[(s0 >> 16) & 0xff], 8) ^ AES_ROR(pTe[(s1 >> 8) & 0xff], 16) ^ AES_ROR(pTe[s2 & 0xff], 24) ^ pRk[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    // Last round: no MixColumns
+    pRk += 4;
+    t0 = aes_sub_word(s0, s1, s2, s3) ^ pRk[0];
+    t1 = aes_sub_word(s1, s2, s3, s0) ^ pRk[1];
+    t2 = aes_sub_word(s2, s3, s0, s1) ^ pRk[2];
+    t3 = aes_sub_word(s3, s0, s1, s2) ^ pRk[3];
+    for (i = 0; i < 4; i++) {
+        pOut[i] = (UCHAR)(t0 >> (24 - 8 * i));
+        pOut[4 + i] = (UCHAR)(t1 >> (24 - 8 * i));
+        pOut[8 + i] = (UCHAR)(t2 >> (24 - 8 * i));
+        pOut[12 + i] = (UCHAR)(t3 >> (24 - 8 * i));
+    }
+}
+
+/**
+ * @brief Encrypt one block with AES-128 (one core only).
+ *
+ * The round keys of the last key are kept, so a series of blocks with the same key
+ * (AES-CMAC, address resolution with one IRK) is not expanded again.
+ *
+ * @param pKey Key (16 bytes)
+ * @param pIn Plaintext (16 bytes)
+ * @param pOut Ciphertext (16 bytes, may be pIn)
+ */
+void __time_critical_func(AES_Encrypt)(const UCHAR *pKey, const UCHAR *pIn, UCHAR *pOut)
+{
+    if (!f_bKey || (memcmp(f_aucKey, pKey, AES_KEY_SIZE) != 0)) {
+        AES_ExpandKey(f_aulRk, pKey);
+        memcpy(f_aucKey, pKey, AES_KEY_SIZE);
+        f_bKey = true;
+    }
+    AES_EncryptBlock(f_aulRk, pIn, pOut);
+}
+
+#if !CRYP_ENABLE
+// BTstack computes the SM crypto itself (ENABLE_SOFTWARE_AES128) with rijndael.c.
+// The firmware is then linked with --wrap for both functions to use this kernel instead.
+int __wrap_rijndaelSetupEncrypt(ULONG *rk, const UCHAR *key, int keybits);
+void __wrap_rijndaelEncrypt(const ULONG *rk, int nrounds, const UCHAR plaintext[16], UCHAR ciphertext[16]);
+
+int __wrap_rijndaelSetupEncrypt(ULONG *rk, const UCHAR *key, int keybits)
+{
+    (void)keybits; // Always 128 in BTstack
+    AES_ExpandKey(rk, key);
+    return AES_ROUNDS;
+}
+
+void __wrap_rijndaelEncrypt(const ULONG *rk, int nrounds, const UCHAR plaintext[16], UCHAR ciphertext[16])
+{
+    (void)nrounds;
+    AES_EncryptBlock(rk, plaintext, ciphertext);
+}
+#endif
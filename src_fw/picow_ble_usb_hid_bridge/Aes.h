@@ -0,0 +1,27 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef AES_H
+#define AES_H
+
+#include "Common.h"
+
+// AES-128 encryption (FIPS-197) for the Security Manager: c1/s1, f4-f6 (AES-CMAC), ah and
+// the re-encryption, either for the crypto offload (HCI LE Encrypt) or for BTstack itself,
+// and for the resolution of private addresses while scanning (RpaCache.h).
+// One round table of 1 KB and the S-box in SRAM; each round is 16 table lookups, 12 rotations
+// and the round key, with the state in 4 registers.
+// Keys and blocks are in FIPS-197 byte order (most significant octet first).
+// AES_ExpandKey and AES_EncryptBlock keep no state (any core, e.g. RpaCache.h on core1);
+// AES_Encrypt keeps the round keys of the last key (one core only).
+
+// [Definitions]
+#define AES_BLOCK_SIZE 16
+#define AES_KEY_SIZE   16
+#define AES_ROUNDS     10
+#define AES_RK_WORDS   (4 * (AES_ROUNDS + 1)) // Round keys
+
+// [Function Prototypes]
+void AES_ExpandKey(ULONG *pRk, const UCHAR *pKey);
+void AES_EncryptBlock(const ULONG *pRk, const UCHAR *pIn, UCHAR *pOut);
+void AES_Encrypt(const UCHAR *pKey, const UCHAR *pIn, UCHAR *pOut);
+
+#endif
@@ -0,0 +1,109 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "BootProf.h"
+#include "Log.h"
+#include "Diag.h"
+
+#if BPRF_ENABLE
+
+// [Definitions]
+#define BPRF_MAGIC 0x46525042 // 'BPRF'
+
+// [File Scope Variables]
+static volatile ULONG f_aulTimeUs[BPRF_MS_NUM] = {0}; // Time of each milestone (0 = not reached)
+static ST_BPRF_IMAGE f_stImage = {0};                 // Profile being read
+
+// Logs the profile in ms (at the first report)
+static void bprf_log(void)
+{
+    ULONG aulMs[BPRF_MS_NUM];
+    ULONG i;
+
+    for (i = 0; i < BPRF_MS_NUM; i++) {
+        aulMs[i] = f_aulTimeUs[i] / 1000;
+    }
+    LOG_INFO("Boot (ms): main %lu, board %lu, tud %lu, core1 %lu, cyw43 %lu, hci %lu, adv %lu\n",
+        aulMs[BPRF_MS_MAIN], aulMs[BPRF_MS_BOARD_INIT], aulMs[BPRF_MS_TUD_INIT], aulMs[BPRF_MS_CORE1_START],
+        aulMs[BPRF_MS_CYW43_INIT], aulMs[BPRF_MS_HCI_WORKING], aulMs[BPRF_MS_FIRST_ADV]);
+    LOG_INFO("Boot (ms): connected %lu, encrypted %lu, hid %lu, ready %lu, mount %lu, report %lu\n",
+        aulMs[BPRF_MS_CONNECTED], aulMs[BPRF_MS_ENCRYPTED], aulMs[BPRF_MS_HID_CONNECTED], aulMs[BPRF_MS_READY],
+        aulMs[BPRF_MS_USB_MOUNT], aulMs[BPRF_MS_FIRST_REPORT]);
+}
+
+/**
+ * @brief Record a milestone, if not reached yet.
+ *
+ * @param ms Milestone (E_BPRF_MS). Must always be marked from the same core.
+ */
+void BPRF_Mark(ULONG ms)
+{
+    ULONG now;
+
+    if ((ms >= BPRF_MS_NUM) || (f_aulTimeUs[ms] != 0)) {
+        return;
+    }
+    now = time_us_32();
+    f_aulTimeUs[ms] = (now != 0) ? now : 1;
+
+    if (ms == BPRF_MS_FIRST_REPORT) {
+        bprf_log();
+    }
+}
+
+/**
+ * @brief Get the time of a milestone.
+ *
+ * @param ms Milestone (E_BPRF_MS)
+ * @return Time since reset in us, or 0 if not reached
+ */
+ULONG BPRF_GetTimeUs(ULONG ms)
+{
+    return (ms < BPRF_MS_NUM) ? f_aulTimeUs[ms] : 0;
+}
+
+// Diagnostics source: copies the profile and returns its size
+static ULONG bprf_open(void)
+{
+    ULONG i;
+
+    f_stImage.magic = BPRF_MAGIC;
+    f_stImage.version = BPRF_VERSION;
+    f_stImage.ms_num = BPRF_MS_NUM;
+    f_stImage.now_us = time_us_32();
+    memset(f_stImage.szBuild, 0, sizeof(f_stImage.szBuild));
+    strncpy(f_stImage.szBuild, __DATE__ " " __TIME__, sizeof(f_stImage.szBuild) - 1);
+    for (i = 0; i < BPRF_MS_NUM; i++) {
+        f_stImage.aulTimeUs[i] = f_aulTimeUs[i];
+    }
+
+    return sizeof(f_stImage);
+}
+
+// Diagnostics source: reads the profile
+static ULONG bprf_read(ULONG offset, UCHAR *pBuf, ULONG len)
+{
+    if (offset >= sizeof(f_stImage)) {
+        return 0;
+    }
+    if (len > sizeof(f_stImage) - offset) {
+        len = sizeof(f_stImage) - offset;
+    }
+    memcpy(pBuf, (const UCHAR *)&f_stImage + offset, len);
+
+    return len;
+}
+
+static const ST_DIAG_SOURCE f_stDiagSrc = {
+    &bprf_open,
+    &bprf_read,
+    NULL,
+};
+
+/**
+ * @brief Initialize the boot profiler (core0, after the first milestones of main()).
+ */
+void BPRF_Init(void)
+{
+    DIAG_RegisterSource(DIAG_SRC_BOOT, &f_stDiagSrc);
+}
+
+#endif
@@ -0,0 +1,71 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef BOOTPROF_H
+#define BOOTPROF_H
+
+#include "Common.h"
+
+// Boot milestone profiler.
+// Records the time since reset of each startup milestone, from main() to the first
+// report forwarded to the USB host. Only the first occurrence of a milestone is kept,
+// so reconnections do not overwrite the boot profile. Each milestone is written by one
+// core only (no lock). The profile is logged at the first report and read over the
+// diagnostics HID interface (DIAG_SRC_BOOT) with tools/bridge_diag.py boot.
+
+// [Definitions]
+// Set to 0 to remove the boot profiler at compile time
+#ifndef BPRF_ENABLE
+#define BPRF_ENABLE 1
+#endif
+
+// Profile format version
+#define BPRF_VERSION 1
+
+// Size of the build string (__DATE__ " " __TIME__)
+#define BPRF_BUILD_SIZE 24
+
+// [Enumerations]
+// Milestones in boot order (keep in sync with tools/bridge_diag.py)
+typedef enum _E_BPRF_MS {
+    BPRF_MS_MAIN = 0,       // main() entered (boot ROM, boot2, runtime init)               core0
+    BPRF_MS_BOARD_INIT,     // board_init() done                                            core0
+    BPRF_MS_TUD_INIT,       // tud_init() done                                              core0
+    BPRF_MS_CORE1_START,    // ble_host_main() entered                                      core1
+    BPRF_MS_CYW43_INIT,     // CYW43 and BTstack initialized (firmware download)            core1
+    BPRF_MS_HCI_WORKING,    // HCI_STATE_WORKING (controller set up)                        core1
+    BPRF_MS_FIRST_ADV,      // First advertisement of a HID device (not when reconnecting)  core1
+    BPRF_MS_CONNECTED,      // LE connection complete                                       core1
+    BPRF_MS_ENCRYPTED,      // Pairing or re-encryption complete                            core1
+    BPRF_MS_HID_CONNECTED,  // GATTSERVICE_SUBEVENT_HID_SERVICE_CONNECTED                   core1
+    BPRF_MS_READY,          // BLE application state READY                                 core1
+    BPRF_MS_USB_MOUNT,      // USB device configured by the host                            core0
+    BPRF_MS_FIRST_REPORT,   // First report handed to the USB stack                         core0
+    BPRF_MS_NUM
+} E_BPRF_MS;
+
+#pragma pack(1)
+
+// [Structures]
+// Profile read over the diagnostics interface
+typedef struct _ST_BPRF_IMAGE {
+    ULONG magic;                     // 'BPRF'
+    USHORT version;                  // BPRF_VERSION
+    USHORT ms_num;                   // BPRF_MS_NUM
+    ULONG now_us;                    // Time of the snapshot
+    char szBuild[BPRF_BUILD_SIZE];   // Build date and time of the firmware
+    ULONG aulTimeUs[BPRF_MS_NUM];    // Time since reset of each milestone (0 = not reached)
+} ST_BPRF_IMAGE;
+
+#pragma pack()
+
+// [Function Prototypes]
+#if BPRF_ENABLE
+void BPRF_Init(void);
+void BPRF_Mark(ULONG ms);
+ULONG BPRF_GetTimeUs(ULONG ms);
+#else
+#define BPRF_Init() ((void)0)
+#define BPRF_Mark(ms) ((void)(ms))
+#define BPRF_GetTimeUs(ms) ((void)(ms), 0UL)
+#endif
+
+#endif
@@ -1,13 +1,15 @@
 // Copyright © 2025 Shiomachi Software. All rights reserved.
 #include "Common.h" 
+#include "pico/rand.h"
 
 // [File Scope Variables]
+// The queue is written by core1 and read by core0, so it stays in striped SRAM (too large for a scratch bank)
 static ST_QUE f_astQue[CMN_QUE_KIND_NUM] = {0}; // Array of queue control structures
 static ST_HID_RPT f_astQueData_hid[CMN_QUE_DATA_MAX_HID_RPT] = {0}; // Data buffer for the HID queue
 static critical_section_t f_stSpinLock = {0}; // Spinlock structure
 
 // Enqueues data into the specified queue
-bool CMN_Enqueue(ULONG iQue, PVOID pData) 
+bool __time_critical_func(CMN_Enqueue)(ULONG iQue, PVOID pData) 
 {
     bool bRet = false;
     ST_QUE *pstQue = &f_astQue[iQue];
@@ -40,7 +42,7 @@ bool CMN_Enqueue(ULONG iQue, PVOID pData)
 }
 
 // Dequeues data from the specified queue
-bool CMN_Dequeue(ULONG iQue, PVOID pData)
+bool __time_critical_func(CMN_Dequeue)(ULONG iQue, PVOID pData)
 {
     bool bRet = false;
     ST_QUE *pstQue = &f_astQue[iQue];   
@@ -74,7 +76,7 @@ bool CMN_Dequeue(ULONG iQue, PVOID pData)
 }
 
 // Peeks at the data from the specified queue without removing it
-bool CMN_PeekQueue(ULONG iQue, PVOID pData)
+bool __time_critical_func(CMN_PeekQueue)(ULONG iQue, PVOID pData)
 {
     bool bRet = false;
     ST_QUE *pstQue = &f_astQue[iQue];   
@@ -106,8 +108,41 @@ bool CMN_PeekQueue(ULONG iQue, PVOID pData)
     return bRet;
 }
 
+// Peeks at the entry at the given position from the head without removing it
+bool __time_critical_func(CMN_PeekQueueAt)(ULONG iQue, ULONG index, PVOID pData)
+{
+    bool bRet = false;
+    ST_QUE *pstQue = &f_astQue[iQue];
+    ST_HID_RPT *pstHidRpt;
+
+    CMN_EntrySpinLock(); // Acquire spinlock
+
+    if (index >= (pstQue->tail + pstQue->max - pstQue->head) % pstQue->max) {
+        // Fewer entries than index + 1
+
+        // Do nothing
+    }
+    else {
+        // Copy data
+        switch (iQue) {
+        case CMN_QUE_KIND_HID_RPT:  // HID Report Queue
+            pstHidRpt = (ST_HID_RPT *)pstQue->pBuf;
+            memcpy(pData, &pstHidRpt[(pstQue->head + index) % pstQue->max], sizeof(ST_HID_RPT));
+            break;
+        default:
+            // Should not be reached
+            break;
+        }
+        bRet = true;
+    }
+
+    CMN_ExitSpinLock(); // Release spinlock
+
+    return bRet;
+}
+
 // Advances the queue's read pointer (head)
-void CMN_AdvanceQueue(ULONG iQue)
+void __time_critical_func(CMN_AdvanceQueue)(ULONG iQue)
 {
     ST_QUE *pstQue = &f_astQue[iQue];
 
@@ -140,18 +175,91 @@ void CMN_ClearQueue(ULONG iQue)
     CMN_ExitSpinLock(); // Release spinlock
 }
 
+// Returns the number of entries stored in the specified queue
+ULONG __time_critical_func(CMN_GetQueueCount)(ULONG iQue)
+{
+    ULONG count;
+    ST_QUE *pstQue = &f_astQue[iQue];
+
+    CMN_EntrySpinLock(); // Acquire spinlock
+    count = (pstQue->tail + pstQue->max - pstQue->head) % pstQue->max;
+    CMN_ExitSpinLock(); // Release spinlock
+
+    return count;
+}
+
+// Adds a sample to the statistics
+// Not locked: each statistics structure must be updated by one core only
+void __time_critical_func(CMN_StatAdd)(ST_CMN_STAT *pstStat, ULONG value)
+{
+    if ((pstStat->cnt == 0) || (value < pstStat->min)) {
+        pstStat->min = value;
+    }
+    if (value > pstStat->max) {
+        pstStat->max = value;
+    }
+    pstStat->last = value;
+    pstStat->sum += value;
+    pstStat->cnt++;
+}
+
+// Clears the statistics
+void __time_critical_func(CMN_StatClear)(ST_CMN_STAT *pstStat)
+{
+    memset(pstStat, 0, sizeof(ST_CMN_STAT));
+}
+
+// CRC-32 (IEEE 802.3), bitwise: only used for small records outside the report path
+ULONG CMN_Crc32(const void *pData, ULONG len)
+{
+    const UCHAR *p = (const UCHAR *)pData;
+    ULONG crc = 0xFFFFFFFF;
+    ULONG i, j;
+
+    for (i = 0; i < len; i++) {
+        crc ^= p[i];
+        for (j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// Fills a buffer with random bytes (ring oscillator and other entropy of pico_rand)
+void CMN_Random(UCHAR *pBuf, ULONG len)
+{
+    ULONG value = 0;
+    ULONG i;
+
+    for (i = 0; i < len; i++) {
+        if ((i % 4) == 0) {
+            value = get_rand_32();
+        }
+        pBuf[i] = (UCHAR)value;
+        value >>= 8;
+    }
+}
+
 // Enters a critical section (spinlock).
-void CMN_EntrySpinLock(void)
+void __time_critical_func(CMN_EntrySpinLock)(void)
 {
     critical_section_enter_blocking(&f_stSpinLock);
 }
 
 // Exits the critical section (spinlock)
-void CMN_ExitSpinLock(void)
+void __time_critical_func(CMN_ExitSpinLock)(void)
 {
     critical_section_exit(&f_stSpinLock);
 }
 
+// Starts the cycle counter of the calling core (call once on each core)
+void CMN_CycInit(void)
+{
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+}
+
 // Initializes the common library
 void CMN_Init(void)
 {
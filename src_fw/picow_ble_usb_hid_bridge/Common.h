@@ -10,14 +10,47 @@
 #include "pico/multicore.h"
 #include "pico/flash.h"
 #include "pico/cyw43_arch.h"
+#include "hardware/structs/systick.h"
 #include "Type.h"
 
 // [Definitions]
 // Maximum size of the HID queue
+#ifndef CMN_QUE_DATA_MAX_HID_RPT
 #define CMN_QUE_DATA_MAX_HID_RPT 32
+#endif
 
 // Maximum size of the HID report data
+#ifndef CMN_HID_RPT_DATA_SIZE
 #define CMN_HID_RPT_DATA_SIZE 512
+#endif
+
+// SRAM bank placement of the data private to one core (0 = everything in striped SRAM).
+// SRAM0-3 are word-striped and shared by both cores, DMA and the CYW43 PIO, so the hot
+// data of core0 (TinyUSB side) goes to scratch Y and that of core1 (BTstack side) to
+// scratch X, each of which only one core uses. Each scratch bank is 4 KB and also holds
+// the 2 KB stack of its core (core0: Y, core1: X), so only small objects are placed.
+#ifndef CMN_BANK_PLACEMENT
+#define CMN_BANK_PLACEMENT 1
+#endif
+
+// Largest report data size for which the report buffers are placed in a scratch bank
+#define CMN_BANK_RPT_MAX 64
+
+#if CMN_BANK_PLACEMENT
+#define CMN_CORE0_DATA(group) __scratch_y(group) // Data only accessed by core0
+#define CMN_CORE1_DATA(group) __scratch_x(group) // Data only accessed by core1
+#else
+#define CMN_CORE0_DATA(group)
+#define CMN_CORE1_DATA(group)
+#endif
+
+#if CMN_BANK_PLACEMENT && (CMN_HID_RPT_DATA_SIZE <= CMN_BANK_RPT_MAX)
+#define CMN_CORE0_RPT(group) CMN_CORE0_DATA(group) // Report buffer only accessed by core0
+#define CMN_CORE1_RPT(group) CMN_CORE1_DATA(group) // Report buffer only accessed by core1
+#else
+#define CMN_CORE0_RPT(group)
+#define CMN_CORE1_RPT(group)
+#endif
 
 // [Enumerations]
 // Queue types
@@ -46,14 +79,42 @@ typedef struct _ST_HID_RPT {
 
 #pragma pack()
 
+// Statistics of a measured value (e.g. a duration in microseconds)
+typedef struct _ST_CMN_STAT {
+    ULONG cnt;    // Number of samples
+    ULONG min;    // Minimum value
+    ULONG max;    // Maximum value
+    ULONG last;   // Most recent value
+    uint64_t sum; // Sum of all values
+} ST_CMN_STAT;
+
+// Cycle counter of the calling core (SysTick, 24-bit down counter at the system clock)
+static inline ULONG CMN_CycNow(void)
+{
+    return systick_hw->cvr;
+}
+
+// Cycles elapsed since CMN_CycNow() on the same core (up to 2^24 cycles)
+static inline ULONG CMN_CycSince(ULONG start)
+{
+    return (start - systick_hw->cvr) & 0x00FFFFFF;
+}
+
 // [Function Prototypes]
 bool CMN_Enqueue(ULONG iQue, PVOID pData);
 bool CMN_Dequeue(ULONG iQue, PVOID pData);
 bool CMN_PeekQueue(ULONG iQue, PVOID pData);
+bool CMN_PeekQueueAt(ULONG iQue, ULONG index, PVOID pData);
 void CMN_AdvanceQueue(ULONG iQue);
 void CMN_ClearQueue(ULONG iQue);
+ULONG CMN_GetQueueCount(ULONG iQue);
+void CMN_StatAdd(ST_CMN_STAT *pstStat, ULONG value);
+void CMN_StatClear(ST_CMN_STAT *pstStat);
+ULONG CMN_Crc32(const void *pData, ULONG len);
+void CMN_Random(UCHAR *pBuf, ULONG len);
 void CMN_EntrySpinLock(void);
 void CMN_ExitSpinLock(void);
+void CMN_CycInit(void);
 void CMN_Init(void);
 
 #endif
@@ -0,0 +1,448 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "btstack.h"
+#include "CryptoOffload.h"
+#include "AclFlow.h"
+#include "Aes.h"
+#include "P256.h"
+#include "Log.h"
+
+#if CRYP_ENABLE
+
+// [Definitions]
+// HCI commands
+#define CRYP_OPCODE_READ_LOCAL_SUPPORTED_COMMANDS 0x1002
+#define CRYP_OPCODE_LE_ENCRYPT                    0x2017
+#define CRYP_OPCODE_LE_READ_LOCAL_P256_PUBLIC_KEY 0x2025
+#define CRYP_OPCODE_LE_GENERATE_DHKEY             0x2026
+
+// LE meta subevents of the results
+#define CRYP_SUBEVENT_READ_LOCAL_P256_PUBLIC_KEY_COMPLETE 0x08
+#define CRYP_SUBEVENT_GENERATE_DHKEY_COMPLETE             0x09
+
+// Supported Commands octet 34: LE Read Local P-256 Public Key (bit 1), LE Generate DHKey (bit 2)
+#define CRYP_SUPPORTED_OCTET 34
+#define CRYP_SUPPORTED_BITS  0x06
+
+// HCI status codes
+#define CRYP_STATUS_SUCCESS            0x00
+#define CRYP_STATUS_DISALLOWED         0x0C
+#define CRYP_STATUS_INVALID_PARAMETERS 0x12
+
+// Size of a P-256 coordinate, private key or DHKey
+#define CRYP_P256_SIZE 32
+
+// [Structures]
+// Crypto command queued to core0
+typedef struct _ST_CRYP_JOB {
+    USHORT opcode;                      // HCI command
+    UCHAR status;                       // HCI status of the result
+    bool bAcked;                        // Command Status given to BTstack (core1)
+    uint32_t submitUs;                  // Time of the command
+    UCHAR aucData[2 * CRYP_P256_SIZE];  // Parameters, replaced by the result (HCI byte order)
+} ST_CRYP_JOB;
+
+// [File Scope Variables]
+static const hci_transport_t *f_pstBase = NULL;  // CYW43 HCI transport
+static hci_transport_t f_stTransport;            // Transport handed to BTstack
+static void (*f_pfnHandler)(uint8_t packet_type, uint8_t *packet, uint16_t size) = NULL; // BTstack HCI handler
+static ST_CRYP_JOB f_astJob[CRYP_JOB_MAX];       // Job ring
+static volatile ULONG f_jobTail = 0;             // Jobs queued (core1)
+static volatile ULONG f_jobDone = 0;             // Jobs computed (core0)
+static ULONG f_jobHead = 0;                      // Jobs answered (core1)
+static volatile bool f_bPosted = false;          // cryp_deliver is pending on core1's run loop
+static btstack_context_callback_registration_t f_stDeliver;
+static UCHAR f_aucPublicKey[2 * CRYP_P256_SIZE]; // Local key pair (uECC format, big endian)
+static UCHAR f_aucPrivateKey[CRYP_P256_SIZE];
+static volatile bool f_bKey = false;             // The key pair is valid
+static ST_P256_MULT f_stMult;                    // P-256 multiplication of the current job (core0)
+static bool f_bMult = false;                     // f_stMult is running
+static uint32_t f_multUs = 0;                    // Start of f_stMult
+static ST_CRYP_STAT f_stStat = {0};              // Statistics
+
+// [Function Prototypes]
+const hci_transport_t *__real_hci_transport_cyw43_instance(void);
+const hci_transport_t *__wrap_hci_transport_cyw43_instance(void);
+static void cryp_deliver(void *pCtx);
+
+// Copies a value reversing the byte order (HCI is little endian, uECC and FIPS-197 big endian)
+static void cryp_reverse(UCHAR *pDst, const UCHAR *pSrc, ULONG len)
+{
+    ULONG i;
+
+    for (i = 0; i < len; i++) {
+        pDst[i] = pSrc[len - 1 - i];
+    }
+}
+
+// Schedules cryp_deliver on core1's run loop (any core).
+// In the poll-mode CYW43 architecture, core1's loop calls CRYP_Poll instead.
+static void cryp_post(void)
+{
+#if !PICO_CYW43_ARCH_POLL
+    bool bPost;
+
+    CMN_EntrySpinLock();
+    bPost = !f_bPosted;
+    f_bPosted = true;
+    CMN_ExitSpinLock();
+    if (bPost) {
+        btstack_run_loop_execute_on_main_thread(&f_stDeliver);
+    }
+#endif
+}
+
+//--------------------------------------------------------------------+
+// Core1: HCI transport
+//--------------------------------------------------------------------+
+// Events from the controller to BTstack: the crypto commands answered here are reported as supported
+static void cryp_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size)
+{
+    if ((packet_type == HCI_EVENT_PACKET) && (packet[0] == HCI_EVENT_COMMAND_COMPLETE) &&
+        (size > 6 + CRYP_SUPPORTED_OCTET) && (little_endian_read_16(packet, 3) == CRYP_OPCODE_READ_LOCAL_SUPPORTED_COMMANDS) &&
+        (packet[5] == CRYP_STATUS_SUCCESS)) {
+        packet[6 + CRYP_SUPPORTED_OCTET] |= CRYP_SUPPORTED_BITS;
+    }
+    f_pfnHandler(packet_type, packet, size);
+}
+
+static void cryp_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size))
+{
+    f_pfnHandler = handler;
+    f_pstBase->register_packet_handler(&cryp_packet_handler);
+}
+
+// Packets from BTstack to the controller: the crypto commands are queued to core0
+static int cryp_send_packet(uint8_t packet_type, uint8_t *packet, int size)
+{
+    ST_CRYP_JOB *pstJob;
+    USHORT opcode;
+
+    if ((packet_type != HCI_COMMAND_DATA_PACKET) || (size < 3) || (size != 3 + packet[2])) {
+        return f_pstBase->send_packet(packet_type, packet, size);
+    }
+    opcode = little_endian_read_16(packet, 0);
+    switch (opcode) {
+    case CRYP_OPCODE_LE_ENCRYPT:
+    case CRYP_OPCODE_LE_READ_LOCAL_P256_PUBLIC_KEY:
+    case CRYP_OPCODE_LE_GENERATE_DHKEY:
+        break;
+    default:
+        return f_pstBase->send_packet(packet_type, packet, size);
+    }
+    if (((f_jobTail - f_jobHead) >= CRYP_JOB_MAX) || (packet[2] > sizeof(pstJob->aucData))) {
+        f_stStat.forward_cnt++;
+        return f_pstBase->send_packet(packet_type, packet, size);
+    }
+
+    pstJob = &f_astJob[f_jobTail % CRYP_JOB_MAX];
+    pstJob->opcode = opcode;
+    pstJob->status = CRYP_STATUS_SUCCESS;
+    pstJob->bAcked = false;
+    pstJob->submitUs = time_us_32();
+    memcpy(pstJob->aucData, &packet[3], packet[2]);
+    CMN_EntrySpinLock();
+    f_jobTail++;
+    CMN_ExitSpinLock();
+    cryp_post();
+
+    return 0;
+}
+
+/**
+ * @brief CYW43 HCI transport with the crypto commands answered on core0 (linked with --wrap).
+ *
+ * @return Transport for hci_init
+ */
+const hci_transport_t *__wrap_hci_transport_cyw43_instance(void)
+{
+    f_pstBase = ACLF_Transport(__real_hci_transport_cyw43_instance());
+    f_stTransport = *f_pstBase;
+    f_stTransport.register_packet_handler = &cryp_register_packet_handler;
+    f_stTransport.send_packet = &cryp_send_packet;
+    f_stDeliver.callback = &cryp_deliver;
+    f_stDeliver.context = NULL;
+
+    return &f_stTransport;
+}
+
+//--------------------------------------------------------------------+
+// Core1: results
+//--------------------------------------------------------------------+
+// Accepts a queued command the way the controller does
+static void cryp_ack(ST_CRYP_JOB *pstJob)
+{
+    UCHAR aucEvt[6];
+
+    // An asynchronous transport reports every packet sent, so that hci.c releases its buffer
+    if (f_pstBase->can_send_packet_now != NULL) {
+        aucEvt[0] = HCI_EVENT_TRANSPORT_PACKET_SENT;
+        aucEvt[1] = 0;
+        f_pfnHandler(HCI_EVENT_PACKET, aucEvt, 2);
+    }
+    // The ECC commands return a Command Status at once, which frees the HCI command credit
+    if (pstJob->opcode != CRYP_OPCODE_LE_ENCRYPT) {
+        aucEvt[0] = HCI_EVENT_COMMAND_STATUS;
+        aucEvt[1] = 4;
+        aucEvt[2] = CRYP_STATUS_SUCCESS;
+        aucEvt[3] = 1; // Num_HCI_Command_Packets
+        aucEvt[4] = (UCHAR)pstJob->opcode;
+        aucEvt[5] = (UCHAR)(pstJob->opcode >> 8);
+        f_pfnHandler(HCI_EVENT_PACKET, aucEvt, 6);
+    }
+    pstJob->bAcked = true;
+}
+
+// Sends the result event of a computed command
+static void cryp_complete(ST_CRYP_JOB *pstJob)
+{
+    UCHAR aucEvt[4 + 2 * CRYP_P256_SIZE];
+    ULONG len;
+
+    switch (pstJob->opcode) {
+    case CRYP_OPCODE_LE_ENCRYPT:
+        aucEvt[0] = HCI_EVENT_COMMAND_COMPLETE;
+        aucEvt[1] = 4 + AES_BLOCK_SIZE;
+        aucEvt[2] = 1; // Num_HCI_Command_Packets
+        aucEvt[3] = (UCHAR)pstJob->opcode;
+        aucEvt[4] = (UCHAR)(pstJob->opcode >> 8);
+        aucEvt[5] = pstJob->status;
+        memcpy(&aucEvt[6], pstJob->aucData, AES_BLOCK_SIZE);
+        len = 6 + AES_BLOCK_SIZE;
+        f_stStat.aes_cnt++;
+        if ((f_stStat.aes_cnt % CRYP_AES_LOG_BLOCKS) == 0) {
+            LOG_INFO("AES cycles per block: min %lu avg %lu max %lu (%lu blocks)\n", f_stStat.aes_cycles.min,
+                (ULONG)(f_stStat.aes_cycles.sum / f_stStat.aes_cycles.cnt), f_stStat.aes_cycles.max, f_stStat.aes_cycles.cnt);
+        }
+        break;
+    case CRYP_OPCODE_LE_READ_LOCAL_P256_PUBLIC_KEY:
+        aucEvt[0] = HCI_EVENT_LE_META;
+        aucEvt[1] = 2 + 2 * CRYP_P256_SIZE;
+        aucEvt[2] = CRYP_SUBEVENT_READ_LOCAL_P256_PUBLIC_KEY_COMPLETE;
+        aucEvt[3] = pstJob->status;
+        memcpy(&aucEvt[4], pstJob->aucData, 2 * CRYP_P256_SIZE);
+        len = 4 + 2 * CRYP_P256_SIZE;
+        f_stStat.p256_cnt++;
+        break;
+    default: // CRYP_OPCODE_LE_GENERATE_DHKEY
+        aucEvt[0] = HCI_EVENT_LE_META;
+        aucEvt[1] = 2 + CRYP_P256_SIZE;
+        aucEvt[2] = CRYP_SUBEVENT_GENERATE_DHKEY_COMPLETE;
+        aucEvt[3] = pstJob->status;
+        memcpy(&aucEvt[4], pstJob->aucData, CRYP_P256_SIZE);
+        len = 4 + CRYP_P256_SIZE;
+        f_stStat.dhkey_cnt++;
+        LOG_INFO("DHKey: %lu us on core0 in steps of max %lu us, status 0x%02lx (AES blocks %lu, avg %lu us per command)\n",
+            f_stStat.dhkey.last, f_stStat.step.max, pstJob->status, f_stStat.aes_cnt,
+            (f_stStat.turnaround.cnt > 0) ? (ULONG)(f_stStat.turnaround.sum / f_stStat.turnaround.cnt) : 0);
+        break;
+    }
+    CMN_StatAdd(&f_stStat.turnaround, time_us_32() - pstJob->submitUs);
+    f_pfnHandler(HCI_EVENT_PACKET, aucEvt, (uint16_t)len);
+}
+
+// Answers the queued commands in order (core1 run loop)
+static void cryp_deliver(void *pCtx)
+{
+    ULONG done;
+    ULONG i;
+
+    (void)pCtx;
+    CMN_EntrySpinLock();
+    f_bPosted = false;
+    done = f_jobDone;
+    CMN_ExitSpinLock();
+
+    for (i = f_jobHead; i != f_jobTail; i++) {
+        if (!f_astJob[i % CRYP_JOB_MAX].bAcked) {
+            cryp_ack(&f_astJob[i % CRYP_JOB_MAX]);
+        }
+    }
+    while (f_jobHead != done) {
+        cryp_complete(&f_astJob[f_jobHead % CRYP_JOB_MAX]);
+        f_jobHead++;
+    }
+}
+
+/**
+ * @brief Set the local key pair (before HCI_POWER_ON).
+ *
+ * @param pPublicKey Public key (64 bytes, uECC format)
+ * @param pPrivateKey Private key (32 bytes, uECC format)
+ */
+void CRYP_SetKey(const UCHAR *pPublicKey, const UCHAR *pPrivateKey)
+{
+    memcpy(f_aucPublicKey, pPublicKey, sizeof(f_aucPublicKey));
+    memcpy(f_aucPrivateKey, pPrivateKey, sizeof(f_aucPrivateKey));
+    f_bKey = true;
+}
+
+/**
+ * @brief Answer the computed commands (poll-mode CYW43 architecture, core1 loop).
+ */
+void CRYP_Poll(void)
+{
+    if (f_jobHead != f_jobTail) {
+        cryp_deliver(NULL);
+    }
+}
+
+//--------------------------------------------------------------------+
+// Core0: computation
+//--------------------------------------------------------------------+
+// LE Encrypt: Key and Plaintext_Data in, Encrypted_Data out
+static void cryp_encrypt(ST_CRYP_JOB *pstJob)
+{
+    UCHAR aucKey[AES_KEY_SIZE];
+    UCHAR aucBlock[AES_BLOCK_SIZE];
+
+    ULONG start;
+
+    cryp_reverse(aucKey, &pstJob->aucData[0], AES_KEY_SIZE);
+    cryp_reverse(aucBlock, &pstJob->aucData[AES_KEY_SIZE], AES_BLOCK_SIZE);
+    start = CMN_CycNow();
+    AES_Encrypt(aucKey, aucBlock, aucBlock);
+    CMN_StatAdd(&f_stStat.aes_cycles, CMN_CycSince(start));
+    cryp_reverse(pstJob->aucData, aucBlock, AES_BLOCK_SIZE);
+}
+
+// Runs one step of the multiplication of the current job, started by pPoint and pScalar if
+// it is not running yet. Returns true with the result once it is complete.
+static bool cryp_mult(const UCHAR *pPoint, const UCHAR *pScalar, UCHAR *pResult, bool *pbValid)
+{
+    uint32_t start_us = time_us_32();
+    bool bDone;
+
+    if (!f_bMult) {
+        P256_MultStart(&f_stMult, pPoint, pScalar);
+        f_bMult = true;
+        f_multUs = start_us;
+    }
+    bDone = P256_MultStep(&f_stMult);
+    CMN_StatAdd(&f_stStat.step, time_us_32() - start_us);
+    if (!bDone) {
+        return false;
+    }
+    *pbValid = P256_MultResult(&f_stMult, pResult);
+    f_bMult = false;
+
+    return true;
+}
+
+// LE Read Local P-256 Public Key: the key pair is generated if EccKey.h did not provide one
+static bool cryp_read_public_key(ST_CRYP_JOB *pstJob)
+{
+    bool bValid;
+
+    if (!f_bKey) {
+        if (!f_bMult) {
+            do {
+                CMN_Random(f_aucPrivateKey, sizeof(f_aucPrivateKey));
+            } while (!P256_ValidScalar(f_aucPrivateKey));
+        }
+        if (!cryp_mult(NULL, f_aucPrivateKey, f_aucPublicKey, &bValid)) {
+            return false;
+        }
+        if (!bValid) {
+            // One of the few scalars whose ladder meets the point at infinity: try another one
+            return false;
+        }
+        f_bKey = true;
+    }
+    cryp_reverse(&pstJob->aucData[0], &f_aucPublicKey[0], CRYP_P256_SIZE);
+    cryp_reverse(&pstJob->aucData[CRYP_P256_SIZE], &f_aucPublicKey[CRYP_P256_SIZE], CRYP_P256_SIZE);
+    return true;
+}
+
+// LE Generate DHKey: remote public key in, DHKey (X of the shared point) out. An invalid remote key is rejected.
+static bool cryp_dhkey(ST_CRYP_JOB *pstJob)
+{
+    UCHAR aucPoint[2 * CRYP_P256_SIZE];
+    bool bValid;
+
+    if (!f_bMult) {
+        cryp_reverse(&aucPoint[0], &pstJob->aucData[0], CRYP_P256_SIZE);
+        cryp_reverse(&aucPoint[CRYP_P256_SIZE], &pstJob->aucData[CRYP_P256_SIZE], CRYP_P256_SIZE);
+        if (!f_bKey) {
+            pstJob->status = CRYP_STATUS_DISALLOWED;
+        }
+        else if (!P256_ValidPoint(aucPoint)) {
+            pstJob->status = CRYP_STATUS_INVALID_PARAMETERS;
+        }
+        if (pstJob->status != CRYP_STATUS_SUCCESS) {
+            memset(pstJob->aucData, 0, CRYP_P256_SIZE);
+            return true;
+        }
+    }
+    if (!cryp_mult(aucPoint, f_aucPrivateKey, aucPoint, &bValid)) {
+        return false;
+    }
+    if (bValid) {
+        cryp_reverse(pstJob->aucData, aucPoint, CRYP_P256_SIZE);
+    }
+    else {
+        pstJob->status = CRYP_STATUS_INVALID_PARAMETERS;
+        memset(pstJob->aucData, 0, CRYP_P256_SIZE);
+    }
+    memset(aucPoint, 0, sizeof(aucPoint));
+    CMN_StatAdd(&f_stStat.dhkey, time_us_32() - f_multUs);
+    return true;
+}
+
+/**
+ * @brief Run one step of the next queued crypto command (core0 loop, after WDG_Feed).
+ *
+ * An LE Encrypt is one step. A P-256 multiplication (key pair, DHKey) is split into
+ * P256_STEPS steps of one call each, so that the USB tasks run and the watchdog is fed
+ * between them.
+ */
+void CRYP_Task(void)
+{
+    ST_CRYP_JOB *pstJob;
+    bool bDone;
+
+    if (f_jobDone == f_jobTail) {
+        return;
+    }
+    pstJob = &f_astJob[f_jobDone % CRYP_JOB_MAX];
+    switch (pstJob->opcode) {
+    case CRYP_OPCODE_LE_ENCRYPT:
+        cryp_encrypt(pstJob);
+        bDone = true;
+        break;
+    case CRYP_OPCODE_LE_READ_LOCAL_P256_PUBLIC_KEY:
+        bDone = cryp_read_public_key(pstJob);
+        break;
+    default: // CRYP_OPCODE_LE_GENERATE_DHKEY
+        bDone = cryp_dhkey(pstJob);
+        break;
+    }
+    if (!bDone) {
+        return;
+    }
+    CMN_EntrySpinLock();
+    f_jobDone++;
+    CMN_ExitSpinLock();
+    cryp_post();
+}
+
+/**
+ * @brief Get the local public key.
+ *
+ * @return Public key (64 bytes, uECC format), or NULL if there is none yet
+ */
+const UCHAR* CRYP_GetPublicKey(void)
+{
+    return f_bKey ? f_aucPublicKey : NULL;
+}
+
+/**
+ * @brief Get the statistics.
+ *
+ * @return Statistics
+ */
+const ST_CRYP_STAT* CRYP_GetStat(void)
+{
+    return &f_stStat;
+}
+
+#endif
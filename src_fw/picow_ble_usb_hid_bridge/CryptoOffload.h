@@ -0,0 +1,60 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef CRYPTOOFFLOAD_H
+#define CRYPTOOFFLOAD_H
+
+#include "Common.h"
+
+// Security Manager crypto on core0.
+// BTstack is built without its software AES-128 and ECC (btstack_config.h), so it asks the
+// controller with HCI LE Encrypt, LE Read Local P-256 Public Key and LE Generate DHKey.
+// The CYW43 HCI transport is wrapped (--wrap=hci_transport_cyw43_instance): these commands
+// are queued to core0 instead of the controller, computed between the USB tasks (CRYP_Task)
+// and answered with the events the controller would send, from core1's run loop. Core1 keeps
+// handling HCI events while a DHKey is computed, and AES blocks never cross the CYW43 bus.
+// The P-256 multiplications run in bounded steps (P256.h), one per pass of the core0 loop,
+// so that tud_task and hid_task keep running during a pairing.
+// The local key pair comes from EccKey.h (CRYP_SetKey) or is generated at the first request.
+// The answers stand in for the controller's (Command Status, LE Meta events, Supported
+// Commands octet 34): opt-in until validated on the CYW43 (CMake BRIDGE_CRYPTO_OFFLOAD).
+
+// [Definitions]
+// Set to 1 to compute the crypto on core0 (0: on core1 in BTstack, software AES-128 and micro-ecc)
+#ifndef CRYP_ENABLE
+#define CRYP_ENABLE 0
+#endif
+
+// Crypto commands queued to core0 (further commands go to the controller)
+#define CRYP_JOB_MAX 4
+
+// The AES cycles are logged every this many LE Encrypt commands
+#define CRYP_AES_LOG_BLOCKS 64
+
+// [Structures]
+// Statistics (cumulative)
+typedef struct _ST_CRYP_STAT {
+    ULONG aes_cnt;                      // LE Encrypt commands answered
+    ULONG p256_cnt;                     // LE Read Local P-256 Public Key commands answered
+    ULONG dhkey_cnt;                    // LE Generate DHKey commands answered
+    ULONG forward_cnt;                  // Crypto commands sent to the controller (queue full)
+    ST_CMN_STAT turnaround;             // Command to result event (us)
+    ST_CMN_STAT dhkey;                  // DHKey from its first to its last step on core0 (us)
+    ST_CMN_STAT step;                   // One step of a P-256 multiplication (CRYP_Task, us)
+    ST_CMN_STAT aes_cycles;             // AES_Encrypt on core0, with the key expansion if the key changed (cycles)
+} ST_CRYP_STAT;
+
+// [Function Prototypes]
+#if CRYP_ENABLE
+// Core1
+void CRYP_SetKey(const UCHAR *pPublicKey, const UCHAR *pPrivateKey);
+void CRYP_Poll(void);
+// Core0
+void CRYP_Task(void);
+// Any core
+const UCHAR* CRYP_GetPublicKey(void);
+const ST_CRYP_STAT* CRYP_GetStat(void);
+#else
+#define CRYP_Poll() ((void)0)
+#define CRYP_Task() ((void)0)
+#endif
+
+#endif
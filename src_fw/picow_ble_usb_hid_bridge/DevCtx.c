@@ -0,0 +1,88 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "hardware/sync.h"
+#include "DevCtx.h"
+#include "Log.h"
+
+// [File Scope Variables]
+static ST_DCTX f_astCtx[2];                     // Published (f_seq & 1) and next contexts
+static volatile ULONG f_seq = 0;                // Sequence number of the last publication
+static volatile ULONG f_retryCnt = 0;           // Reads retried because of a publication (core0)
+
+/**
+ * @brief Publish the device context (core1, at each change of the READY state).
+ *
+ * @param bReady true if the device is READY
+ * @param pDesc Report map (ignored unless bReady)
+ * @param len Length of the report map
+ * @param pstDevi Identity of the device (ignored unless bReady)
+ */
+void DCTX_Publish(bool bReady, const UCHAR *pDesc, ULONG len, const ST_DEVI *pstDevi)
+{
+    ULONG seq = f_seq + 1;
+    ST_DCTX *pstCtx = &f_astCtx[seq & 1];
+
+    if (bReady && ((pDesc == NULL) || (len > DCTX_DESC_MAX))) {
+        LOG_ERROR("Device context: report map of %lu bytes not published\n", len);
+        bReady = false;
+    }
+    pstCtx->seq = seq;
+    pstCtx->bReady = bReady;
+    pstCtx->desc_len = 0;
+    if (bReady) {
+        pstCtx->desc_len = (USHORT)len;
+        pstCtx->stDevi = *pstDevi;
+        memcpy(pstCtx->aucDesc, pDesc, len);
+    }
+    __dmb(); // Complete the context before publishing it
+    f_seq = seq;
+}
+
+/**
+ * @brief Get the sequence number of the last publication (any core).
+ *
+ * @return Sequence number, compared with ST_DCTX.seq to skip an unchanged context
+ */
+ULONG DCTX_GetSeq(void)
+{
+    return f_seq;
+}
+
+/**
+ * @brief Copy the published device context (core0).
+ *
+ * @param pstDst Copy of the context (only the valid part of the report map is copied)
+ * @return true if the device is READY
+ */
+bool DCTX_Read(ST_DCTX *pstDst)
+{
+    const ST_DCTX *pstCtx;
+    ULONG seq;
+    ULONG len;
+
+    for (;;) {
+        seq = f_seq;
+        __dmb(); // Read the sequence number before the context
+        pstCtx = &f_astCtx[seq & 1];
+        memcpy(pstDst, pstCtx, offsetof(ST_DCTX, aucDesc));
+        len = (pstDst->desc_len <= DCTX_DESC_MAX) ? pstDst->desc_len : 0;
+        memcpy(pstDst->aucDesc, pstCtx->aucDesc, len);
+        __dmb(); // Finish reading the context before checking the sequence number
+        if (f_seq == seq) {
+            break;
+        }
+        f_retryCnt++;
+    }
+    pstDst->seq = seq;
+
+    return pstDst->bReady;
+}
+
+/**
+ * @brief Get the number of reads retried because core1 published meanwhile.
+ *
+ * @return Number of retries
+ */
+ULONG DCTX_GetRetryCount(void)
+{
+    return f_retryCnt;
+}
@@ -0,0 +1,38 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef DEVCTX_H
+#define DEVCTX_H
+
+#include "Common.h"
+#include "DevInfo.h"
+
+// Device context published by core1 for the USB descriptors of core0.
+// The report map lives in the hids_client descriptor storage and the identity in DevInfo,
+// both owned by core1 and torn down on a disconnection at any time. Core1 copies them with
+// the READY state into one of two buffers at each change (DCTX_Publish) and then advances a
+// sequence number, whose parity selects the published buffer. Core0 copies the published
+// buffer without a lock and retries if the sequence number moved meanwhile (seqlock), so a
+// descriptor callback always sees the state, report map and identity of one publication.
+// The writer never touches the published buffer, so a retry only happens if core1 publishes
+// during the copy.
+
+// [Definitions]
+// Maximum report map length (hids_client descriptor storage)
+#define DCTX_DESC_MAX 500
+
+// [Structures]
+// Device context
+typedef struct _ST_DCTX {
+    ULONG seq;                          // Sequence number of the publication (0 = never published)
+    bool bReady;                        // The device is READY; the other fields are only valid then
+    USHORT desc_len;                    // Length of the report map
+    ST_DEVI stDevi;                     // Identity of the device
+    UCHAR aucDesc[DCTX_DESC_MAX];       // Report map
+} ST_DCTX;
+
+// [Function Prototypes]
+void DCTX_Publish(bool bReady, const UCHAR *pDesc, ULONG len, const ST_DEVI *pstDevi);
+ULONG DCTX_GetSeq(void);
+bool DCTX_Read(ST_DCTX *pstDst);
+ULONG DCTX_GetRetryCount(void);
+
+#endif
@@ -0,0 +1,117 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "btstack.h"
+#include "DevInfo.h"
+#include "Log.h"
+
+// [Definitions]
+// TLV tag of the device identity
+#define DEVI_TLV_TAG ((((uint32_t) 'H') << 24 ) | (((uint32_t) 'O') << 16) | (((uint32_t) 'G') << 8) | 'I')
+
+// [File Scope Variables]
+static ST_DEVI f_stDevi = {0}; // Identity of the connected device
+
+// Copies a string of the Device Information Service.
+// USB string descriptors are built by widening each char, so only printable ASCII is kept.
+static void devi_copy_str(char *pszDst, const char *pszSrc)
+{
+    ULONG i;
+
+    for (i = 0; (i < DEVI_STR_MAX) && (pszSrc[i] != '\0'); i++) {
+        pszDst[i] = ((pszSrc[i] >= 0x20) && (pszSrc[i] <= 0x7e)) ? pszSrc[i] : '?';
+    }
+    pszDst[i] = '\0';
+}
+
+/**
+ * @brief Start the identity of a connected device and load it from the TLV if it is cached.
+ *
+ * @param pTlvImpl TLV implementation (NULL = no TLV)
+ * @param pTlvCtx TLV context
+ * @param pAddr BD address of the device
+ * @return true if the identity of this device was cached.
+ *         Otherwise the record only holds the address until the service has been read.
+ */
+bool DEVI_Load(const btstack_tlv_t *pTlvImpl, void *pTlvCtx, const UCHAR *pAddr)
+{
+    ST_DEVI stDevi;
+    int len;
+
+    memset(&f_stDevi, 0, sizeof(f_stDevi));
+    memcpy(f_stDevi.addr, pAddr, sizeof(f_stDevi.addr));
+    if (pTlvImpl == NULL) {
+        return false;
+    }
+
+    // Only the identity of the last bonded device is kept
+    len = pTlvImpl->get_tag(pTlvCtx, DEVI_TLV_TAG, (uint8_t *)&stDevi, sizeof(stDevi));
+    if ((len != sizeof(stDevi)) || (memcmp(stDevi.addr, pAddr, sizeof(stDevi.addr)) != 0)) {
+        return false;
+    }
+    stDevi.manufacturer[DEVI_STR_MAX] = '\0';
+    stDevi.model[DEVI_STR_MAX] = '\0';
+    f_stDevi = stDevi;
+    LOG_INFO("Device information cached: PnP %lu %04lx:%04lx\n", (ULONG)f_stDevi.vid_src, (ULONG)f_stDevi.vid, (ULONG)f_stDevi.pid);
+    return true;
+}
+
+/**
+ * @brief Handle an event of the Device Information Service client.
+ *
+ * @param pPacket HCI_EVENT_GATTSERVICE_META event
+ * @return true when the query is complete
+ */
+bool DEVI_HandleEvent(const UCHAR *pPacket)
+{
+    switch (hci_event_gattservice_meta_get_subevent_code(pPacket)) {
+    case GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_MANUFACTURER_NAME:
+        if (gattservice_subevent_device_information_manufacturer_name_get_att_status(pPacket) == ATT_ERROR_SUCCESS) {
+            devi_copy_str(f_stDevi.manufacturer, gattservice_subevent_device_information_manufacturer_name_get_value(pPacket));
+        }
+        break;
+    case GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_MODEL_NUMBER:
+        if (gattservice_subevent_device_information_model_number_get_att_status(pPacket) == ATT_ERROR_SUCCESS) {
+            devi_copy_str(f_stDevi.model, gattservice_subevent_device_information_model_number_get_value(pPacket));
+        }
+        break;
+    case GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_PNP_ID:
+        if (gattservice_subevent_device_information_pnp_id_get_att_status(pPacket) == ATT_ERROR_SUCCESS) {
+            f_stDevi.vid_src = gattservice_subevent_device_information_pnp_id_get_vendor_source_id(pPacket);
+            f_stDevi.vid = gattservice_subevent_device_information_pnp_id_get_vendor_id(pPacket);
+            f_stDevi.pid = gattservice_subevent_device_information_pnp_id_get_product_id(pPacket);
+            f_stDevi.version = gattservice_subevent_device_information_pnp_id_get_product_version(pPacket);
+        }
+        break;
+    case GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_DONE:
+        // A device without the service completes with an error status and an empty identity
+        LOG_INFO("Device information: status 0x%02lx, PnP %lu %04lx:%04lx\n",
+            (ULONG)gattservice_subevent_device_information_done_get_att_status(pPacket),
+            (ULONG)f_stDevi.vid_src, (ULONG)f_stDevi.vid, (ULONG)f_stDevi.pid);
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+/**
+ * @brief Store the identity of the connected device in the TLV.
+ *
+ * @param pTlvImpl TLV implementation (NULL = no TLV)
+ * @param pTlvCtx TLV context
+ */
+void DEVI_Store(const btstack_tlv_t *pTlvImpl, void *pTlvCtx)
+{
+    if (pTlvImpl != NULL) {
+        (void)pTlvImpl->store_tag(pTlvCtx, DEVI_TLV_TAG, (const uint8_t *)&f_stDevi, sizeof(f_stDevi));
+    }
+}
+
+/**
+ * @brief Get the identity of the connected device (core0, only while the BLE application state is READY).
+ *
+ * @return Device identity
+ */
+const ST_DEVI* DEVI_Get(void)
+{
+    return &f_stDevi;
+}
@@ -0,0 +1,54 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef DEVINFO_H
+#define DEVINFO_H
+
+#include "btstack_tlv.h"
+#include "Common.h"
+
+// Identity of the connected BLE device, presented in the USB device and string descriptors.
+// The Device Information Service (PnP ID, manufacturer and model) is read once after
+// bonding and cached in the TLV next to the bond, so a reconnection enumerates at once
+// with the same identity.
+// Core1 writes the record only before the BLE application state becomes READY;
+// core0 reads it only while the state is READY.
+
+// [Definitions]
+// Set to 0 to keep the bridge's own VID/PID even if the device has a USB-IF PnP ID
+#ifndef DEVI_USE_PNP_ID
+#define DEVI_USE_PNP_ID 1
+#endif
+
+// Time to wait for the Device Information Service before going READY without it
+#define DEVI_QUERY_TIMEOUT_MS 2000 // ms
+
+// Maximum length of the manufacturer and model strings (without the terminator)
+#define DEVI_STR_MAX 19
+
+// Vendor ID sources of the PnP ID
+#define DEVI_VID_SRC_NONE      0 // No PnP ID
+#define DEVI_VID_SRC_BLUETOOTH 1 // Bluetooth SIG company identifier
+#define DEVI_VID_SRC_USB       2 // USB-IF vendor ID
+
+#pragma pack(1)
+
+// [Structures]
+// Device identity (TLV record)
+typedef struct _ST_DEVI {
+    UCHAR addr[6];                      // BD address of the device (BTstack byte order)
+    UCHAR vid_src;                      // Vendor ID source of the PnP ID (DEVI_VID_SRC_xxx)
+    USHORT vid;                         // Vendor ID
+    USHORT pid;                         // Product ID
+    USHORT version;                     // Product version
+    char manufacturer[DEVI_STR_MAX + 1];// Manufacturer Name String ("" = not provided)
+    char model[DEVI_STR_MAX + 1];       // Model Number String ("" = not provided)
+} ST_DEVI;
+
+#pragma pack()
+
+// [Function Prototypes]
+bool DEVI_Load(const btstack_tlv_t *pTlvImpl, void *pTlvCtx, const UCHAR *pAddr);
+bool DEVI_HandleEvent(const UCHAR *pPacket);
+void DEVI_Store(const btstack_tlv_t *pTlvImpl, void *pTlvCtx);
+const ST_DEVI* DEVI_Get(void);
+
+#endif
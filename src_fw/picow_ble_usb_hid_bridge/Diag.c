@@ -0,0 +1,118 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "Diag.h"
+#include "Log.h"
+
+// All functions run on core0 (TinyUSB control request callbacks and main loop).
+
+// [File Scope Variables]
+static const ST_DIAG_SOURCE *f_apstSrc[DIAG_SRC_NUM] = {0}; // Registered sources
+static ULONG f_iOpenSrc = DIAG_SRC_NONE;                     // Source currently open
+static ULONG f_totalSize = 0;                                // Snapshot size of the open source
+static ULONG f_offset = 0;                                   // Read offset
+static UCHAR f_status = DIAG_STS_NOT_OPEN;                   // Status while no source is open
+static ULONG f_lastCmdUs = 0;                                // Time of the last command to the open source
+
+// Closes the open source
+static void diag_close(void)
+{
+    if ((f_iOpenSrc != DIAG_SRC_NONE) && (f_apstSrc[f_iOpenSrc]->pfnClose != NULL)) {
+        f_apstSrc[f_iOpenSrc]->pfnClose();
+    }
+    f_iOpenSrc = DIAG_SRC_NONE;
+    f_totalSize = 0;
+    f_offset = 0;
+    f_status = DIAG_STS_NOT_OPEN;
+}
+
+// Registers a data source
+void DIAG_RegisterSource(ULONG iSrc, const ST_DIAG_SOURCE *pstSrc)
+{
+    if ((iSrc > DIAG_SRC_NONE) && (iSrc < DIAG_SRC_NUM)) {
+        f_apstSrc[iSrc] = pstSrc;
+    }
+}
+
+// Handles GET_REPORT(Feature): returns the next chunk of the open source
+uint16_t DIAG_GetReport(uint8_t report_id, UCHAR *pBuf, uint16_t reqlen)
+{
+    ULONG len = 0;
+    UCHAR status = DIAG_STS_OK;
+
+    if ((report_id != DIAG_REPORT_ID) || (reqlen < DIAG_RSP_HDR_SIZE)) {
+        return 0; // STALL
+    }
+    if (reqlen > DIAG_REPORT_SIZE) {
+        reqlen = DIAG_REPORT_SIZE;
+    }
+
+    f_lastCmdUs = time_us_32();
+    if (f_iOpenSrc == DIAG_SRC_NONE) {
+        status = f_status;
+    }
+    else if (f_offset < f_totalSize) {
+        len = f_apstSrc[f_iOpenSrc]->pfnRead(f_offset, &pBuf[DIAG_RSP_HDR_SIZE], reqlen - DIAG_RSP_HDR_SIZE);
+    }
+
+    pBuf[0] = status;
+    pBuf[1] = (UCHAR)f_iOpenSrc;
+    pBuf[2] = (UCHAR)len;
+    pBuf[3] = 0;
+    memcpy(&pBuf[4], &f_totalSize, sizeof(ULONG));
+    memcpy(&pBuf[8], &f_offset, sizeof(ULONG));
+    memset(&pBuf[DIAG_RSP_HDR_SIZE + len], 0, reqlen - DIAG_RSP_HDR_SIZE - len);
+
+    f_offset += len;
+
+    return reqlen;
+}
+
+// Handles SET_REPORT(Feature): executes a command
+void DIAG_SetReport(uint8_t report_id, const UCHAR *pBuf, uint16_t bufsize)
+{
+    ULONG iSrc;
+
+    if ((report_id != DIAG_REPORT_ID) || (bufsize < 8)) {
+        return;
+    }
+    f_lastCmdUs = time_us_32();
+
+    switch (pBuf[0]) {
+    case DIAG_CMD_OPEN:
+        diag_close();
+        iSrc = pBuf[1];
+        if ((iSrc > DIAG_SRC_NONE) && (iSrc < DIAG_SRC_NUM) && (f_apstSrc[iSrc] != NULL)) {
+            f_iOpenSrc = iSrc;
+            f_totalSize = f_apstSrc[iSrc]->pfnOpen();
+        }
+        else {
+            f_status = DIAG_STS_BAD_SOURCE;
+        }
+        break;
+    case DIAG_CMD_SEEK:
+        memcpy(&f_offset, &pBuf[4], sizeof(ULONG));
+        break;
+    case DIAG_CMD_CLOSE:
+        diag_close();
+        break;
+    default:
+        break;
+    }
+}
+
+// Closes a source the host stopped reading (called from the main loop)
+void DIAG_Task(void)
+{
+    if ((f_iOpenSrc != DIAG_SRC_NONE) && (time_us_32() - f_lastCmdUs >= DIAG_IDLE_TIMEOUT_MS * 1000)) {
+        LOG_ERROR("Diagnostics: source %lu closed, no command for %lu ms\n", f_iOpenSrc, (ULONG)DIAG_IDLE_TIMEOUT_MS);
+        diag_close();
+    }
+}
+
+// Closes the open source (USB unmounted or re-initialized: the host will not close it)
+void DIAG_Reset(void)
+{
+    if (f_iOpenSrc != DIAG_SRC_NONE) {
+        LOG_INFO("Diagnostics: source %lu closed by USB reset\n", f_iOpenSrc);
+    }
+    diag_close();
+}
@@ -0,0 +1,68 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef DIAG_H
+#define DIAG_H
+
+#include "Common.h"
+
+// Diagnostics channel on the vendor-defined HID interface.
+// The host selects a data source with a SET_REPORT(Feature) command and then reads
+// the source image in chunks with GET_REPORT(Feature). See tools/bridge_diag.py.
+//
+// SET_REPORT payload: [cmd][source][0][0][offset (u32 LE)]
+// GET_REPORT payload: [status][source][data len][0][total size (u32 LE)][offset (u32 LE)][data ...]
+// A source left open (tool killed, cable pulled) is closed after DIAG_IDLE_TIMEOUT_MS without
+// a command, and on USB unmount or re-initialization, so that its snapshot is released.
+
+// [Definitions]
+// Report ID of the diagnostics feature report
+#define DIAG_REPORT_ID 1
+
+// Payload size of the diagnostics feature report (CFG_TUD_HID_EP_BUFSIZE - report ID)
+#define DIAG_REPORT_SIZE 63
+
+// Size of the GET_REPORT header
+#define DIAG_RSP_HDR_SIZE 12
+
+// An open source is closed after this time without a command (ms)
+#define DIAG_IDLE_TIMEOUT_MS 5000
+
+// [Enumerations]
+// Commands
+typedef enum _E_DIAG_CMD {
+    DIAG_CMD_OPEN = 1,  // Open a source (take a snapshot) and rewind
+    DIAG_CMD_SEEK,      // Set the read offset
+    DIAG_CMD_CLOSE,     // Close the source (release the snapshot)
+} E_DIAG_CMD;
+
+// Status
+typedef enum _E_DIAG_STS {
+    DIAG_STS_OK = 0,       // Data follows
+    DIAG_STS_NOT_OPEN,     // No source is open
+    DIAG_STS_BAD_SOURCE,   // Unknown source
+} E_DIAG_STS;
+
+// Data sources
+typedef enum _E_DIAG_SRC {
+    DIAG_SRC_NONE = 0,
+    DIAG_SRC_FREC,      // Flight recorder
+    DIAG_SRC_BOOT,      // Boot milestone profile
+    DIAG_SRC_PROF,      // Per-core task-time profile
+    DIAG_SRC_NUM        // Number of sources
+} E_DIAG_SRC;
+
+// [Structures]
+// Data source
+typedef struct _ST_DIAG_SOURCE {
+    ULONG (*pfnOpen)(void);                                 // Takes a snapshot, returns its size
+    ULONG (*pfnRead)(ULONG offset, UCHAR *pBuf, ULONG len); // Reads from the snapshot, returns the length read
+    void  (*pfnClose)(void);                                // Releases the snapshot (may be NULL)
+} ST_DIAG_SOURCE;
+
+// [Function Prototypes]
+void DIAG_RegisterSource(ULONG iSrc, const ST_DIAG_SOURCE *pstSrc);
+uint16_t DIAG_GetReport(uint8_t report_id, UCHAR *pBuf, uint16_t reqlen);
+void DIAG_SetReport(uint8_t report_id, const UCHAR *pBuf, uint16_t bufsize);
+void DIAG_Task(void);
+void DIAG_Reset(void);
+
+#endif
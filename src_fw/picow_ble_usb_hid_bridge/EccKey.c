@@ -0,0 +1,112 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "btstack.h"
+#include "btstack_crypto.h"
+#include "uECC.h"
+#include "EccKey.h"
+#include "CryptoOffload.h"
+#include "Log.h"
+
+#if ECCK_ENABLE
+
+// [Definitions]
+// TLV tags of the key pair and of the pairings made with it
+#define ECCK_TLV_TAG_KEY ((((uint32_t) 'E') << 24 ) | (((uint32_t) 'C') << 16) | (((uint32_t) 'C') << 8) | 'K')
+#define ECCK_TLV_TAG_USE ((((uint32_t) 'E') << 24 ) | (((uint32_t) 'C') << 16) | (((uint32_t) 'C') << 8) | 'U')
+
+// [File Scope Variables]
+static const btstack_tlv_t *f_pTlvImpl = NULL; // TLV implementation
+static void *f_pTlvCtx = NULL;                 // TLV context
+static ULONG f_useCnt = 0;                     // Pairings made with the current key pair
+
+// Random source of uECC
+static int ecck_rng(uint8_t *pDest, unsigned size)
+{
+    CMN_Random(pDest, size);
+    return 1;
+}
+
+// Loads the stored key pair. Returns false if there is none or it is damaged.
+static bool ecck_load(ST_ECCK_KEY *pstKey)
+{
+    int len = f_pTlvImpl->get_tag(f_pTlvCtx, ECCK_TLV_TAG_KEY, (uint8_t *)pstKey, sizeof(ST_ECCK_KEY));
+
+    if (len != (int)sizeof(ST_ECCK_KEY)) {
+        return false;
+    }
+    if (pstKey->crc != CMN_Crc32(pstKey, offsetof(ST_ECCK_KEY, crc))) {
+        LOG_ERROR("ECC key pair damaged\n");
+        return false;
+    }
+    return uECC_valid_public_key(pstKey->public_key, uECC_secp256r1()) != 0;
+}
+
+// Generates a new key pair and stores it
+static bool ecck_generate(ST_ECCK_KEY *pstKey)
+{
+    uint32_t start_us = time_us_32();
+
+    if (!uECC_make_key(pstKey->public_key, pstKey->private_key, uECC_secp256r1())) {
+        LOG_ERROR("ECC key pair generation failed\n");
+        return false;
+    }
+    pstKey->crc = CMN_Crc32(pstKey, offsetof(ST_ECCK_KEY, crc));
+    LOG_INFO("ECC key pair generated in %lu ms\n", (time_us_32() - start_us) / 1000);
+
+    (void)f_pTlvImpl->store_tag(f_pTlvCtx, ECCK_TLV_TAG_KEY, (const uint8_t *)pstKey, sizeof(ST_ECCK_KEY));
+    f_pTlvImpl->delete_tag(f_pTlvCtx, ECCK_TLV_TAG_USE);
+    f_useCnt = 0;
+    return true;
+}
+
+/**
+ * @brief Load or generate the local key pair and hand it to BTstack or to CryptoOffload.h (before HCI_POWER_ON).
+ *
+ * @param pTlvImpl TLV implementation (NULL = no TLV, BTstack generates the key pair)
+ * @param pTlvCtx TLV context
+ */
+void ECCK_Init(const btstack_tlv_t *pTlvImpl, void *pTlvCtx)
+{
+    ST_ECCK_KEY stKey;
+    ULONG use_cnt = 0;
+
+    f_pTlvImpl = pTlvImpl;
+    f_pTlvCtx = pTlvCtx;
+    f_useCnt = 0;
+    if (f_pTlvImpl == NULL) {
+        return;
+    }
+    uECC_set_rng(&ecck_rng);
+
+    if (ecck_load(&stKey)) {
+        if (f_pTlvImpl->get_tag(f_pTlvCtx, ECCK_TLV_TAG_USE, (uint8_t *)&use_cnt, sizeof(use_cnt)) != (int)sizeof(use_cnt)) {
+            use_cnt = 0;
+        }
+        f_useCnt = use_cnt;
+        if ((f_useCnt >= ECCK_ROTATE_PAIRINGS) && !ecck_generate(&stKey)) {
+            return;
+        }
+    }
+    else if (!ecck_generate(&stKey)) {
+        return;
+    }
+#if CRYP_ENABLE
+    CRYP_SetKey(stKey.public_key, stKey.private_key);
+#else
+    btstack_crypto_ecc_p256_set_key(stKey.public_key, stKey.private_key);
+#endif
+    memset(&stKey, 0, sizeof(stKey));
+}
+
+/**
+ * @brief Count a pairing made with the current key pair (SM_EVENT_PAIRING_COMPLETE, success).
+ */
+void ECCK_OnPairing(void)
+{
+    if (f_pTlvImpl == NULL) {
+        return;
+    }
+    f_useCnt++;
+    (void)f_pTlvImpl->store_tag(f_pTlvCtx, ECCK_TLV_TAG_USE, (const uint8_t *)&f_useCnt, sizeof(f_useCnt));
+}
+
+#endif
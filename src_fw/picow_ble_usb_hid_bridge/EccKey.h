@@ -0,0 +1,50 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef ECCKEY_H
+#define ECCKEY_H
+
+#include "btstack_tlv.h"
+#include "Common.h"
+
+// Local P-256 key pair of LE Secure Connections, kept in the TLV.
+// With ENABLE_MICRO_ECC_FOR_LE_SECURE_CONNECTIONS, BTstack generates the key pair in software
+// after every boot and a first pairing waits until it is done. Instead the key pair is
+// generated once, stored in flash next to the bonds (which hold the LTKs it protects) and
+// handed to BTstack before the controller is powered on, so the SM is ready for pairing at once.
+// The key pair is replaced at boot after ECCK_ROTATE_PAIRINGS pairings.
+// All functions run on core1 (BTstack context).
+
+// [Definitions]
+// Set to 0 to let BTstack generate the key pair after every boot
+#ifndef ECCK_ENABLE
+#define ECCK_ENABLE 1
+#endif
+
+// Pairings with one key pair before it is replaced at the next boot
+#define ECCK_ROTATE_PAIRINGS 8
+
+// Sizes of the keys (uECC format, big endian)
+#define ECCK_PUBLIC_KEY_SIZE  64
+#define ECCK_PRIVATE_KEY_SIZE 32
+
+#pragma pack(1)
+
+// [Structures]
+// Key pair (TLV record)
+typedef struct _ST_ECCK_KEY {
+    UCHAR public_key[ECCK_PUBLIC_KEY_SIZE];   // Public key (X, Y)
+    UCHAR private_key[ECCK_PRIVATE_KEY_SIZE]; // Private key
+    ULONG crc;                                // CMN_Crc32 of the keys
+} ST_ECCK_KEY;
+
+#pragma pack()
+
+// [Function Prototypes]
+#if ECCK_ENABLE
+void ECCK_Init(const btstack_tlv_t *pTlvImpl, void *pTlvCtx);
+void ECCK_OnPairing(void);
+#else
+#define ECCK_Init(pTlvImpl, pTlvCtx) ((void)(pTlvImpl), (void)(pTlvCtx))
+#define ECCK_OnPairing() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "hardware/sync.h"
+#include "FlightRec.h"
+#include "Diag.h"
+
+#if FREC_ENABLE
+
+// [Definitions]
+#define FREC_CORE_NUM 2
+#define FREC_REC_MASK (FREC_REC_NUM - 1)
+#define FREC_MAGIC 0x43455246 // 'FREC'
+
+// [File Scope Variables]
+static ST_FREC_REC f_astRec[FREC_CORE_NUM][FREC_REC_NUM] = {0}; // Records of each core
+static volatile ULONG f_aWidx[FREC_CORE_NUM] = {0};             // Write counter of each core
+static volatile bool f_bFrozen = false;                         // Recording paused while a dump is read
+static volatile bool f_abWriting[FREC_CORE_NUM] = {0};          // A record is being written by the core
+static volatile ULONG f_aSkipCnt[FREC_CORE_NUM] = {0};          // Records not written while frozen, per core
+static ST_FREC_HDR f_stDumpHdr = {0};                           // Header of the dump being read
+
+// Writes one record into the buffer of the calling core.
+// Lock-free: each core only writes its own buffer.
+void __time_critical_func(FREC_Record)(UCHAR kind, const void *pData, ULONG len)
+{
+    ULONG core = get_core_num();
+    ULONG widx;
+    ST_FREC_REC *pstRec;
+
+    // Announced before the frozen flag is checked: frec_open waits for the record to complete
+    f_abWriting[core] = true;
+    __dmb();
+    if (f_bFrozen) {
+        f_abWriting[core] = false;
+        f_aSkipCnt[core]++;
+        return;
+    }
+    if (len > FREC_DATA_SIZE) {
+        len = FREC_DATA_SIZE;
+    }
+
+    widx = f_aWidx[core];
+    pstRec = &f_astRec[core][widx & FREC_REC_MASK];
+    pstRec->time_us = time_us_32();
+    pstRec->kind = kind;
+    pstRec->len = (UCHAR)len;
+    if (len > 0) {
+        memcpy(pstRec->data, pData, len);
+    }
+    f_aWidx[core] = widx + 1;
+    __dmb();
+    f_abWriting[core] = false;
+}
+
+// Diagnostics source: freezes the recorder and returns the dump size (core0)
+static ULONG frec_open(void)
+{
+    ULONG core = get_core_num();
+
+    f_bFrozen = true;
+    __dmb();
+    // A record being written on the other core completes; the next ones see the flag
+    while (f_abWriting[core ^ 1]) {
+        tight_loop_contents();
+    }
+    __dmb();
+
+    f_stDumpHdr.magic = FREC_MAGIC;
+    f_stDumpHdr.version = FREC_VERSION;
+    f_stDumpHdr.rec_size = sizeof(ST_FREC_REC);
+    f_stDumpHdr.rec_num = FREC_REC_NUM;
+    f_stDumpHdr.core_num = FREC_CORE_NUM;
+    f_stDumpHdr.now_us = time_us_32();
+    f_stDumpHdr.skip_cnt = f_aSkipCnt[0] + f_aSkipCnt[1];
+    f_stDumpHdr.widx[0] = f_aWidx[0];
+    f_stDumpHdr.widx[1] = f_aWidx[1];
+
+    return sizeof(ST_FREC_HDR) + sizeof(f_astRec);
+}
+
+// Diagnostics source: reads the dump (header followed by the raw buffers)
+static ULONG frec_read(ULONG offset, UCHAR *pBuf, ULONG len)
+{
+    ULONG total = sizeof(ST_FREC_HDR) + sizeof(f_astRec);
+    ULONG done = 0;
+    ULONG n;
+
+    if (offset >= total) {
+        return 0;
+    }
+    if (len > total - offset) {
+        len = total - offset;
+    }
+
+    if (offset < sizeof(ST_FREC_HDR)) {
+        n = sizeof(ST_FREC_HDR) - offset;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(pBuf, (const UCHAR *)&f_stDumpHdr + offset, n);
+        done = n;
+    }
+    if (done < len) {
+        memcpy(&pBuf[done], (const UCHAR *)f_astRec + (offset + done - sizeof(ST_FREC_HDR)), len - done);
+    }
+
+    return len;
+}
+
+// Diagnostics source: resumes recording (also when Diag.c closes a dump left open)
+static void frec_close(void)
+{
+    f_bFrozen = false;
+}
+
+static const ST_DIAG_SOURCE f_stDiagSrc = {
+    &frec_open,
+    &frec_read,
+    &frec_close,
+};
+
+// Initializes the flight recorder
+void FREC_Init(void)
+{
+    DIAG_RegisterSource(DIAG_SRC_FREC, &f_stDiagSrc);
+}
+
+#endif
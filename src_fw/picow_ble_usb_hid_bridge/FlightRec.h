@@ -0,0 +1,87 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef FLIGHTREC_H
+#define FLIGHTREC_H
+
+#include "Common.h"
+
+// Always-on flight recorder.
+// Each core writes compact timestamped records into its own circular buffer in SRAM
+// (oldest records are overwritten). The buffers are dumped over the diagnostics
+// HID interface (DIAG_SRC_FREC) and decoded on the host with tools/bridge_diag.py.
+// Do not record from interrupt handlers that can preempt another recording site on the same core.
+
+// [Definitions]
+// Set to 0 to remove the flight recorder at compile time
+#ifndef FREC_ENABLE
+#define FREC_ENABLE 1
+#endif
+
+// Number of records per core (must be a power of 2)
+#ifndef FREC_REC_NUM
+#define FREC_REC_NUM 128
+#endif
+
+// Payload size of one record
+#define FREC_DATA_SIZE 10
+
+// Dump format version
+#define FREC_VERSION 1
+
+// [Enumerations]
+// Record kinds (keep in sync with tools/bridge_diag.py)
+typedef enum _E_FREC_KIND {
+    FREC_KIND_NONE = 0,
+    FREC_KIND_HCI_EVT,      // HCI event: first bytes of the event packet
+    FREC_KIND_GATT_EVT,     // GATT service subevent: first bytes of the meta event
+    FREC_KIND_APP_STATE,    // BLE application state: [old][new]
+    FREC_KIND_QUE_ENQ,      // Report queued: [report ID][len (u16)][queue count]
+    FREC_KIND_QUE_DROP,     // Report dropped (queue full): [report ID][len (u16)]
+    FREC_KIND_QUE_CLEAR,    // Queue cleared
+    FREC_KIND_USB_SUBMIT,   // Report handed to the USB stack: [report ID][len (u16)]
+    FREC_KIND_USB_DONE,     // Report transfer completed: [instance][len (u16)]
+    FREC_KIND_USB_MOUNT,    // USB mounted
+    FREC_KIND_USB_UMOUNT,   // USB unmounted
+    FREC_KIND_USB_SUSPEND,  // USB suspended: [remote wakeup enabled]
+    FREC_KIND_USB_RESUME,   // USB resumed
+    FREC_KIND_USB_REINIT,   // USB re-initialization (re-enumeration) started
+    FREC_KIND_RPT_REJECT,   // Report does not match the report map: [report ID][len (u16)][expected len (u16), 0 = unknown ID]
+    FREC_KIND_WDG_RESET,    // Boot after a watchdog reset: [reason (WDG_REASON_xxx)][uptime at the reset in ms (u32)]
+    FREC_KIND_NUM
+} E_FREC_KIND;
+
+#pragma pack(1)
+
+// [Structures]
+// Record
+typedef struct _ST_FREC_REC {
+    ULONG time_us;               // Timestamp
+    UCHAR kind;                  // E_FREC_KIND
+    UCHAR len;                   // Valid bytes in data
+    UCHAR data[FREC_DATA_SIZE];  // Payload
+} ST_FREC_REC;
+
+// Dump header
+typedef struct _ST_FREC_HDR {
+    ULONG magic;                 // 'FREC'
+    USHORT version;              // FREC_VERSION
+    USHORT rec_size;             // sizeof(ST_FREC_REC)
+    USHORT rec_num;              // FREC_REC_NUM
+    UCHAR core_num;              // Number of per-core buffers
+    UCHAR rsv;
+    ULONG now_us;                // Time of the snapshot
+    ULONG skip_cnt;              // Records not written while the recorder was frozen
+    ULONG widx[2];               // Write counter of each core
+} ST_FREC_HDR;
+
+#pragma pack()
+
+// [Function Prototypes]
+#if FREC_ENABLE
+void FREC_Record(UCHAR kind, const void *pData, ULONG len);
+void FREC_Init(void);
+#else
+#define FREC_Record(kind, pData, len) ((void)(kind), (void)(pData), (void)(len))
+#define FREC_Init() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,504 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "HidRptDesc.h"
+
+// HID report descriptor parser (HID 1.11, 6.2.2).
+// Only what the report path needs is kept: report IDs, report sizes and the input fields.
+// Physical values, units, designators and strings are skipped.
+// Runs on core1 once per connection; the result is read-only until the next parse.
+
+// [Definitions]
+// Item types
+#define HRD_TYPE_MAIN   0
+#define HRD_TYPE_GLOBAL 1
+#define HRD_TYPE_LOCAL  2
+
+// Main item tags
+#define HRD_MAIN_INPUT          0x8
+#define HRD_MAIN_OUTPUT         0x9
+#define HRD_MAIN_COLLECTION     0xA
+#define HRD_MAIN_FEATURE        0xB
+#define HRD_MAIN_END_COLLECTION 0xC
+
+// Global item tags
+#define HRD_GLOBAL_USAGE_PAGE   0x0
+#define HRD_GLOBAL_LOGICAL_MIN  0x1
+#define HRD_GLOBAL_LOGICAL_MAX  0x2
+#define HRD_GLOBAL_REPORT_SIZE  0x7
+#define HRD_GLOBAL_REPORT_ID    0x8
+#define HRD_GLOBAL_REPORT_COUNT 0x9
+#define HRD_GLOBAL_PUSH         0xA
+#define HRD_GLOBAL_POP          0xB
+
+// Local item tags
+#define HRD_LOCAL_USAGE         0x0
+#define HRD_LOCAL_USAGE_MIN     0x1
+#define HRD_LOCAL_USAGE_MAX     0x2
+
+// Prefix of a long item
+#define HRD_LONG_ITEM 0xFE
+
+// Maximum report sizes in bits
+#define HRD_IN_BITS_MAX    (CMN_HID_RPT_DATA_SIZE * 8) // Input reports are queued in ST_HID_RPT
+#define HRD_OTHER_BITS_MAX 0xFFFF
+
+// [Structures]
+// Global item state
+typedef struct _ST_HRD_GLOBAL {
+    uint16_t usage_page;
+    int32_t  logical_min;
+    int32_t  logical_max;
+    ULONG    logical_max_raw; // Logical Maximum as an unsigned value
+    ULONG    report_size;
+    ULONG    report_count;
+    UCHAR    report_id;
+} ST_HRD_GLOBAL;
+
+// Local item state (cleared after each main item)
+typedef struct _ST_HRD_LOCAL {
+    ULONG usage_first;  // First Usage (extended: page << 16 | id)
+    ULONG usage_last;   // Last Usage
+    ULONG usage_min;    // Usage Minimum
+    ULONG usage_max;    // Usage Maximum
+    bool  bUsage;       // A Usage was given
+    bool  bUsageMin;    // A Usage Minimum was given
+    bool  bUsageMax;    // A Usage Maximum was given
+    UCHAR usage_size;   // Data size of the last usage item (4 = extended usage)
+} ST_HRD_LOCAL;
+
+// Returns the item data as an unsigned value
+static ULONG __time_critical_func(hrd_get_udata)(const UCHAR *pData, ULONG size)
+{
+    ULONG value = 0;
+    ULONG i;
+
+    for (i = 0; i < size; i++) {
+        value |= (ULONG)pData[i] << (8 * i);
+    }
+    return value;
+}
+
+// Returns the item data as a signed value
+static int32_t __time_critical_func(hrd_get_sdata)(const UCHAR *pData, ULONG size)
+{
+    switch (size) {
+    case 1:
+        return (int8_t)pData[0];
+    case 2:
+        return (int16_t)hrd_get_udata(pData, 2);
+    case 4:
+        return (int32_t)hrd_get_udata(pData, 4);
+    default:
+        return 0;
+    }
+}
+
+// Finds the report for a report ID, adding it if it is new
+static ST_HRD_REPORT* hrd_get_report(ST_HRD_MAP *pstMap, UCHAR report_id)
+{
+    ST_HRD_REPORT *pstReport;
+
+    if (pstMap->aucIndex[report_id] != 0) {
+        return &pstMap->astReport[pstMap->aucIndex[report_id] - 1];
+    }
+    if (pstMap->report_cnt >= HRD_REPORT_MAX) {
+        return NULL;
+    }
+    pstReport = &pstMap->astReport[pstMap->report_cnt++];
+    memset(pstReport, 0, sizeof(ST_HRD_REPORT));
+    pstReport->report_id = report_id;
+    pstReport->field_idx = pstMap->field_cnt;
+    pstMap->aucIndex[report_id] = pstMap->report_cnt;
+    return pstReport;
+}
+
+// Adds an input field to a report.
+// Fields of one report are kept contiguous, so the fields of a report whose
+// Input items are interleaved with those of another report are moved up.
+static E_HRD_RESULT hrd_add_field(ST_HRD_MAP *pstMap, ST_HRD_REPORT *pstReport, const ST_HRD_GLOBAL *pstGlobal, const ST_HRD_LOCAL *pstLocal, UCHAR flags)
+{
+    ST_HRD_FIELD *pstField;
+    ULONG usage_min, usage_max;
+    ULONG pos, i;
+
+    if (pstMap->field_cnt >= HRD_FIELD_MAX) {
+        return HRD_ERR_FIELD_OVERFLOW;
+    }
+    if ((pstGlobal->report_size > 32) || (pstReport->field_cnt == UINT8_MAX)) {
+        return HRD_ERR_REPORT_SIZE;
+    }
+
+    // Insert after the last field of this report
+    pos = (ULONG)pstReport->field_idx + pstReport->field_cnt;
+    if (pos < pstMap->field_cnt) {
+        memmove(&pstMap->astField[pos + 1], &pstMap->astField[pos], (pstMap->field_cnt - pos) * sizeof(ST_HRD_FIELD));
+        for (i = 0; i < pstMap->report_cnt; i++) {
+            if ((&pstMap->astReport[i] != pstReport) && (pstMap->astReport[i].field_idx >= pos)) {
+                pstMap->astReport[i].field_idx++;
+            }
+        }
+    }
+    pstMap->field_cnt++;
+    pstReport->field_cnt++;
+
+    // Usage range: Usage Minimum/Maximum take precedence over a Usage list
+    usage_min = pstLocal->bUsageMin ? pstLocal->usage_min : pstLocal->usage_first;
+    usage_max = pstLocal->bUsageMax ? pstLocal->usage_max : pstLocal->usage_last;
+
+    pstField = &pstMap->astField[pos];
+    pstField->bit_off = pstReport->in_bits;
+    pstField->bit_size = (uint8_t)pstGlobal->report_size;
+    pstField->count = (uint16_t)pstGlobal->report_count;
+    pstField->flags = flags & (HRD_FIELD_CONSTANT | HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE);
+    pstField->usage_page = (pstLocal->usage_size == 4) ? (uint16_t)(usage_min >> 16) : pstGlobal->usage_page;
+    pstField->usage_min = (uint16_t)usage_min;
+    pstField->usage_max = (uint16_t)usage_max;
+    pstField->logical_min = pstGlobal->logical_min;
+    pstField->logical_max = pstGlobal->logical_max;
+    // A positive maximum is often encoded without a sign byte, e.g. 0xFF for 255
+    if ((pstField->logical_min >= 0) && (pstField->logical_max < 0)) {
+        pstField->logical_max = (int32_t)pstGlobal->logical_max_raw;
+    }
+    if (pstField->logical_min < 0) {
+        pstField->flags |= HRD_FIELD_SIGNED;
+    }
+    if ((pstField->flags & (HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE)) == (HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE)) {
+        pstReport->rel_cnt++;
+    }
+    return HRD_OK;
+}
+
+// Handles a main item that defines report data
+static E_HRD_RESULT hrd_main_data(ST_HRD_MAP *pstMap, const ST_HRD_GLOBAL *pstGlobal, const ST_HRD_LOCAL *pstLocal, ULONG tag, ULONG data)
+{
+    ST_HRD_REPORT *pstReport;
+    ULONG bits = pstGlobal->report_size * pstGlobal->report_count;
+    E_HRD_RESULT eRet;
+
+    if ((pstGlobal->report_size > HRD_OTHER_BITS_MAX) || (pstGlobal->report_count > HRD_OTHER_BITS_MAX)) {
+        return HRD_ERR_REPORT_SIZE;
+    }
+    pstReport = hrd_get_report(pstMap, pstGlobal->report_id);
+    if (pstReport == NULL) {
+        return HRD_ERR_REPORT_OVERFLOW;
+    }
+
+    switch (tag) {
+    case HRD_MAIN_INPUT:
+        if (pstReport->in_bits + bits > HRD_IN_BITS_MAX) {
+            return HRD_ERR_REPORT_SIZE;
+        }
+        // Padding (constant) fields carry no data and are not kept
+        if ((bits > 0) && !(data & HRD_FIELD_CONSTANT)) {
+            eRet = hrd_add_field(pstMap, pstReport, pstGlobal, pstLocal, (UCHAR)data);
+            if (eRet != HRD_OK) {
+                return eRet;
+            }
+        }
+        pstReport->in_bits += (uint16_t)bits;
+        break;
+    case HRD_MAIN_OUTPUT:
+        if (pstReport->out_bits + bits > HRD_OTHER_BITS_MAX) {
+            return HRD_ERR_REPORT_SIZE;
+        }
+        pstReport->out_bits += (uint16_t)bits;
+        break;
+    default: // HRD_MAIN_FEATURE
+        if (pstReport->feat_bits + bits > HRD_OTHER_BITS_MAX) {
+            return HRD_ERR_REPORT_SIZE;
+        }
+        pstReport->feat_bits += (uint16_t)bits;
+        break;
+    }
+    return HRD_OK;
+}
+
+// Handles a local item
+static void hrd_local(ST_HRD_LOCAL *pstLocal, const ST_HRD_GLOBAL *pstGlobal, ULONG tag, ULONG data, ULONG size)
+{
+    // Usages shorter than 4 bytes are on the current Usage Page
+    if (size < 4) {
+        data |= (ULONG)pstGlobal->usage_page << 16;
+    }
+
+    switch (tag) {
+    case HRD_LOCAL_USAGE:
+        if (!pstLocal->bUsage) {
+            pstLocal->usage_first = data;
+            pstLocal->bUsage = true;
+        }
+        pstLocal->usage_last = data;
+        pstLocal->usage_size = (UCHAR)size;
+        break;
+    case HRD_LOCAL_USAGE_MIN:
+        pstLocal->usage_min = data;
+        pstLocal->bUsageMin = true;
+        pstLocal->usage_size = (UCHAR)size;
+        break;
+    case HRD_LOCAL_USAGE_MAX:
+        pstLocal->usage_max = data;
+        pstLocal->bUsageMax = true;
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Compile a HID report descriptor into a per-report-ID table.
+ *
+ * @param pDesc  Report descriptor (report map)
+ * @param len    Length of the report descriptor
+ * @param pstMap Compiled map. Cleared (bValid = false) on error.
+ * @return HRD_OK, or the reason the map was rejected.
+ */
+E_HRD_RESULT HRD_Parse(const UCHAR *pDesc, ULONG len, ST_HRD_MAP *pstMap)
+{
+    ST_HRD_GLOBAL astStack[HRD_GLOBAL_STACK_MAX];
+    ST_HRD_GLOBAL stGlobal;
+    ST_HRD_LOCAL stLocal;
+    ULONG stack_depth = 0;
+    ULONG coll_depth = 0;
+    bool bDataWithoutId = false;
+    E_HRD_RESULT eRet = HRD_OK;
+    ULONG pos = 0;
+    ULONG prefix, size, type, tag, data;
+
+    memset(pstMap, 0, sizeof(ST_HRD_MAP));
+    memset(&stGlobal, 0, sizeof(stGlobal));
+    memset(&stLocal, 0, sizeof(stLocal));
+
+    while ((pos < len) && (eRet == HRD_OK)) {
+        prefix = pDesc[pos++];
+
+        // Long items are reserved and carry no report data
+        if (prefix == HRD_LONG_ITEM) {
+            if (pos + 2 > len) {
+                eRet = HRD_ERR_TRUNCATED;
+                break;
+            }
+            pos += 2 + pDesc[pos];
+            if (pos > len) {
+                eRet = HRD_ERR_TRUNCATED;
+            }
+            continue;
+        }
+
+        size = prefix & 0x03;
+        size = (size == 3) ? 4 : size;
+        type = (prefix >> 2) & 0x03;
+        tag = prefix >> 4;
+        if (pos + size > len) {
+            eRet = HRD_ERR_TRUNCATED;
+            break;
+        }
+        data = hrd_get_udata(&pDesc[pos], size);
+
+        switch (type) {
+        case HRD_TYPE_MAIN:
+            switch (tag) {
+            case HRD_MAIN_INPUT:
+            case HRD_MAIN_OUTPUT:
+            case HRD_MAIN_FEATURE:
+                if (stGlobal.report_id == HRD_NO_REPORT_ID) {
+                    bDataWithoutId = true;
+                }
+                eRet = hrd_main_data(pstMap, &stGlobal, &stLocal, tag, data);
+                break;
+            case HRD_MAIN_COLLECTION:
+                coll_depth++;
+                break;
+            case HRD_MAIN_END_COLLECTION:
+                if (coll_depth == 0) {
+                    eRet = HRD_ERR_STACK;
+                }
+                else {
+                    coll_depth--;
+                }
+                break;
+            default:
+                break;
+            }
+            memset(&stLocal, 0, sizeof(stLocal));
+            break;
+
+        case HRD_TYPE_GLOBAL:
+            switch (tag) {
+            case HRD_GLOBAL_USAGE_PAGE:
+                stGlobal.usage_page = (uint16_t)data;
+                break;
+            case HRD_GLOBAL_LOGICAL_MIN:
+                stGlobal.logical_min = hrd_get_sdata(&pDesc[pos], size);
+                break;
+            case HRD_GLOBAL_LOGICAL_MAX:
+                stGlobal.logical_max = hrd_get_sdata(&pDesc[pos], size);
+                stGlobal.logical_max_raw = data;
+                break;
+            case HRD_GLOBAL_REPORT_SIZE:
+                stGlobal.report_size = data;
+                break;
+            case HRD_GLOBAL_REPORT_COUNT:
+                stGlobal.report_count = data;
+                break;
+            case HRD_GLOBAL_REPORT_ID:
+                // IDs are 1-255, and a map either uses them for all reports or for none
+                if ((data == 0) || (data > UINT8_MAX) || bDataWithoutId) {
+                    eRet = HRD_ERR_REPORT_ID;
+                }
+                stGlobal.report_id = (UCHAR)data;
+                pstMap->bUseId = true;
+                break;
+            case HRD_GLOBAL_PUSH:
+                if (stack_depth >= HRD_GLOBAL_STACK_MAX) {
+                    eRet = HRD_ERR_STACK;
+                }
+                else {
+                    astStack[stack_depth++] = stGlobal;
+                }
+                break;
+            case HRD_GLOBAL_POP:
+                if (stack_depth == 0) {
+                    eRet = HRD_ERR_STACK;
+                }
+                else {
+                    stGlobal = astStack[--stack_depth];
+                }
+                break;
+            default:
+                break;
+            }
+            break;
+
+        case HRD_TYPE_LOCAL:
+            hrd_local(&stLocal, &stGlobal, tag, data, size);
+            break;
+
+        default:
+            break;
+        }
+        pos += size;
+    }
+
+    if ((eRet == HRD_OK) && (pstMap->report_cnt == 0)) {
+        eRet = HRD_ERR_NO_REPORT;
+    }
+    if (eRet != HRD_OK) {
+        memset(pstMap, 0, sizeof(ST_HRD_MAP));
+        return eRet;
+    }
+    pstMap->bValid = true;
+    return HRD_OK;
+}
+
+/**
+ * @brief Extract one element of an input field from report data.
+ *
+ * @param pstField Field
+ * @param pData    Report data (without the report ID)
+ * @param len      Length of the report data
+ * @param index    Element index (0 to count - 1)
+ * @return Element value, sign-extended for fields with a negative logical minimum.
+ *         0 if the element is outside the report data.
+ */
+int32_t __time_critical_func(HRD_GetFieldValue)(const ST_HRD_FIELD *pstField, const UCHAR *pData, ULONG len, ULONG index)
+{
+    ULONG bit_pos = (ULONG)pstField->bit_off + index * pstField->bit_size;
+    ULONG byte_pos = bit_pos >> 3;
+    ULONG shift = bit_pos & 7;
+    ULONG nbytes = (shift + pstField->bit_size + 7) >> 3;
+    uint64_t value = 0;
+    ULONG i;
+
+    if ((index >= pstField->count) || (pstField->bit_size == 0) || (byte_pos + nbytes > len)) {
+        return 0;
+    }
+    for (i = 0; i < nbytes; i++) {
+        value |= (uint64_t)pData[byte_pos + i] << (8 * i);
+    }
+    value = (value >> shift) & ((1ULL << pstField->bit_size) - 1);
+
+    // Sign extension
+    if ((pstField->flags & HRD_FIELD_SIGNED) && (value & (1ULL << (pstField->bit_size - 1)))) {
+        value |= ~((1ULL << pstField->bit_size) - 1);
+    }
+    return (int32_t)value;
+}
+
+/**
+ * @brief Store one element of an input field into report data.
+ *
+ * @param pstField Field
+ * @param pData    Report data (without the report ID)
+ * @param len      Length of the report data
+ * @param index    Element index (0 to count - 1)
+ * @param value    Element value. Only the low bit_size bits are stored; the caller clamps
+ *                 it to the logical range. Nothing is stored outside the report data.
+ */
+void __time_critical_func(HRD_SetFieldValue)(const ST_HRD_FIELD *pstField, UCHAR *pData, ULONG len, ULONG index, int32_t value)
+{
+    ULONG bit_pos = (ULONG)pstField->bit_off + index * pstField->bit_size;
+    ULONG byte_pos = bit_pos >> 3;
+    ULONG shift = bit_pos & 7;
+    ULONG nbytes = (shift + pstField->bit_size + 7) >> 3;
+    uint64_t mask, bits;
+    ULONG i;
+
+    if ((index >= pstField->count) || (pstField->bit_size == 0) || (byte_pos + nbytes > len)) {
+        return;
+    }
+    mask = ((1ULL << pstField->bit_size) - 1) << shift;
+    bits = ((uint64_t)(uint32_t)value << shift) & mask;
+    for (i = 0; i < nbytes; i++) {
+        pData[byte_pos + i] = (UCHAR)((pData[byte_pos + i] & ~(mask >> (8 * i))) | (bits >> (8 * i)));
+    }
+}
+
+/**
+ * @brief Merge a report into an earlier report of the same ID that has not been sent yet.
+ *
+ * Relative variable fields (movement) are added. All other fields must be equal,
+ * so no button, key or absolute value change is lost by the merge.
+ *
+ * @param pstMap    Compiled report map
+ * @param pstReport Report of both reports
+ * @param pDst      Earlier report data (without the report ID); updated if merged
+ * @param pSrc      Later report data
+ * @param len       Length of both reports
+ * @return true if merged. false if the reports differ in other fields, a sum is out of
+ *         the logical range, or the report has no movement; pDst is then unchanged.
+ */
+bool __time_critical_func(HRD_MergeReport)(const ST_HRD_MAP *pstMap, const ST_HRD_REPORT *pstReport, UCHAR *pDst, const UCHAR *pSrc, ULONG len)
+{
+    const ST_HRD_FIELD *pstField;
+    int64_t sum;
+    ULONG i, k;
+
+    if (pstReport->rel_cnt == 0) {
+        return false;
+    }
+    // Check every element before changing anything
+    for (i = 0; i < pstReport->field_cnt; i++) {
+        pstField = &pstMap->astField[pstReport->field_idx + i];
+        for (k = 0; k < pstField->count; k++) {
+            if ((pstField->flags & (HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE)) == (HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE)) {
+                sum = (int64_t)HRD_GetFieldValue(pstField, pDst, len, k) + HRD_GetFieldValue(pstField, pSrc, len, k);
+                if ((sum < pstField->logical_min) || (sum > pstField->logical_max)) {
+                    return false;
+                }
+            }
+            else if (HRD_GetFieldValue(pstField, pDst, len, k) != HRD_GetFieldValue(pstField, pSrc, len, k)) {
+                return false;
+            }
+        }
+    }
+    for (i = 0; i < pstReport->field_cnt; i++) {
+        pstField = &pstMap->astField[pstReport->field_idx + i];
+        if ((pstField->flags & (HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE)) != (HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE)) {
+            continue;
+        }
+        for (k = 0; k < pstField->count; k++) {
+            HRD_SetFieldValue(pstField, pDst, len, k,
+                HRD_GetFieldValue(pstField, pDst, len, k) + HRD_GetFieldValue(pstField, pSrc, len, k));
+        }
+    }
+    return true;
+}
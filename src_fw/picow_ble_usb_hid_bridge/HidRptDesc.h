@@ -0,0 +1,105 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef HIDRPTDESC_H
+#define HIDRPTDESC_H
+
+#include "Common.h"
+
+// Compiled HID report descriptor (report map).
+// HRD_Parse walks the report map once per connection and builds a table per report ID
+// with the expected report lengths and the offsets, sizes and usages of the input fields.
+// The report path then uses O(1) lookups (HRD_GetReport) and never parses the map again.
+
+// [Definitions]
+// Maximum number of report IDs in one report map
+#ifndef HRD_REPORT_MAX
+#define HRD_REPORT_MAX 16
+#endif
+
+// Maximum number of input fields in one report map
+#ifndef HRD_FIELD_MAX
+#define HRD_FIELD_MAX 64
+#endif
+
+// Depth of the PUSH/POP stack of the global items
+#define HRD_GLOBAL_STACK_MAX 4
+
+// Report ID of a report map without Report ID items
+#define HRD_NO_REPORT_ID 0
+
+// Field flags (data bits of the Input item)
+#define HRD_FIELD_CONSTANT 0x01
+#define HRD_FIELD_VARIABLE 0x02
+#define HRD_FIELD_RELATIVE 0x04
+#define HRD_FIELD_SIGNED   0x80 // Logical minimum is negative
+
+// [Enumerations]
+// Parse results
+typedef enum _E_HRD_RESULT {
+    HRD_OK = 0,
+    HRD_ERR_TRUNCATED,        // Item runs past the end of the map
+    HRD_ERR_REPORT_ID,        // Report ID 0, or items before the first Report ID in a map that uses IDs
+    HRD_ERR_REPORT_OVERFLOW,  // More than HRD_REPORT_MAX report IDs
+    HRD_ERR_FIELD_OVERFLOW,   // More than HRD_FIELD_MAX input fields
+    HRD_ERR_REPORT_SIZE,      // Report larger than CMN_HID_RPT_DATA_SIZE, or field larger than 32 bits
+    HRD_ERR_STACK,            // PUSH/POP or collection nesting error
+    HRD_ERR_NO_REPORT,        // No Input, Output or Feature item
+    HRD_RESULT_NUM
+} E_HRD_RESULT;
+
+// [Structures]
+// Input field
+typedef struct _ST_HRD_FIELD {
+    uint16_t bit_off;     // Offset of the first element in the report data (without the report ID)
+    uint8_t  bit_size;    // Report Size
+    uint8_t  flags;       // HRD_FIELD_xxx
+    uint16_t count;       // Report Count
+    uint16_t usage_page;  // Usage Page
+    uint16_t usage_min;   // First usage (Usage or Usage Minimum)
+    uint16_t usage_max;   // Last usage (Usage Maximum, or the last Usage of the list)
+    int32_t  logical_min; // Logical Minimum
+    int32_t  logical_max; // Logical Maximum
+} ST_HRD_FIELD;
+
+// Report
+typedef struct _ST_HRD_REPORT {
+    uint8_t  report_id;   // Report ID (HRD_NO_REPORT_ID if the map does not use IDs)
+    uint8_t  field_cnt;   // Number of input fields
+    uint16_t field_idx;   // Index of the first input field in ST_HRD_MAP.astField
+    uint16_t in_bits;     // Input report size in bits (without the report ID)
+    uint16_t out_bits;    // Output report size in bits
+    uint16_t feat_bits;   // Feature report size in bits
+    uint8_t  rel_cnt;     // Number of relative variable input fields (movement)
+} ST_HRD_REPORT;
+
+// Compiled report map
+typedef struct _ST_HRD_MAP {
+    bool bValid;                              // Parsed successfully
+    bool bUseId;                              // Map uses Report ID items
+    uint8_t report_cnt;                       // Number of reports
+    uint16_t field_cnt;                       // Number of input fields
+    uint8_t aucIndex[256];                    // Report ID -> report index + 1 (0 = unknown ID)
+    ST_HRD_REPORT astReport[HRD_REPORT_MAX];  // Reports in the order of their first appearance
+    ST_HRD_FIELD astField[HRD_FIELD_MAX];     // Input fields, grouped by report
+} ST_HRD_MAP;
+
+// [Function Prototypes]
+E_HRD_RESULT HRD_Parse(const UCHAR *pDesc, ULONG len, ST_HRD_MAP *pstMap);
+int32_t HRD_GetFieldValue(const ST_HRD_FIELD *pstField, const UCHAR *pData, ULONG len, ULONG index);
+void HRD_SetFieldValue(const ST_HRD_FIELD *pstField, UCHAR *pData, ULONG len, ULONG index, int32_t value);
+bool HRD_MergeReport(const ST_HRD_MAP *pstMap, const ST_HRD_REPORT *pstReport, UCHAR *pDst, const UCHAR *pSrc, ULONG len);
+
+// Returns the report for a report ID, or NULL if the ID is not in the map
+static inline const ST_HRD_REPORT* HRD_GetReport(const ST_HRD_MAP *pstMap, UCHAR report_id)
+{
+    UCHAR idx = pstMap->aucIndex[report_id];
+
+    return (idx != 0) ? &pstMap->astReport[idx - 1] : NULL;
+}
+
+// Returns the input report length in bytes (without the report ID)
+static inline ULONG HRD_GetInputLen(const ST_HRD_REPORT *pstReport)
+{
+    return ((ULONG)pstReport->in_bits + 7) / 8;
+}
+
+#endif
@@ -0,0 +1,154 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "hardware/uart.h"
+#include "hardware/sync.h"
+#include "Log.h"
+
+// [Definitions]
+#define LOG_CORE_NUM 2 // One ring per CPU core
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+
+// [Structures]
+// Log record
+typedef struct _ST_LOG_REC {
+    const char *pFmt;        // Format string
+    ULONG time_us;           // Timestamp
+    ULONG level;             // Log level
+    ULONG arg[LOG_ARG_MAX];  // Arguments
+} ST_LOG_REC;
+
+// Per-core ring (single producer: the owning core, single consumer: LOG_Drain)
+typedef struct _ST_LOG_RING {
+    volatile ULONG head;     // Read count (written by the consumer)
+    volatile ULONG tail;     // Write count (written by the producer)
+    volatile ULONG drop;     // Records lost because the ring was full
+    ST_LOG_REC rec[LOG_RING_SIZE];
+} ST_LOG_RING;
+
+// [File Scope Variables]
+static ST_LOG_RING f_astRing[LOG_CORE_NUM] = {0}; // Rings
+static char f_szLine[LOG_LINE_SIZE];             // Line being written to the UART
+static ULONG f_lineLen = 0;                      // Length of the line
+static ULONG f_linePos = 0;                      // Characters of the line already written
+static bool f_bCrSent = false;                   // CR of the current LF already written
+static ULONG f_dropReported = 0;                 // Drop count already reported
+
+// Stores a log record (called through the LOG_xxx macros, also from the report path)
+void __time_critical_func(LOG_Write)(ULONG level, const char *pFmt, ULONG a0, ULONG a1, ULONG a2, ULONG a3,
+               ULONG a4, ULONG a5, ULONG a6, ULONG a7)
+{
+    ST_LOG_RING *pstRing = &f_astRing[get_core_num()];
+    ULONG tail = pstRing->tail;
+    ST_LOG_REC *pstRec;
+
+    if ((tail - pstRing->head) >= LOG_RING_SIZE) {
+        // Ring is full
+        pstRing->drop++;
+        return;
+    }
+
+    pstRec = &pstRing->rec[tail & LOG_RING_MASK];
+    pstRec->pFmt = pFmt;
+    pstRec->time_us = time_us_32();
+    pstRec->level = level;
+    pstRec->arg[0] = a0;
+    pstRec->arg[1] = a1;
+    pstRec->arg[2] = a2;
+    pstRec->arg[3] = a3;
+    pstRec->arg[4] = a4;
+    pstRec->arg[5] = a5;
+    pstRec->arg[6] = a6;
+    pstRec->arg[7] = a7;
+
+    __dmb(); // Publish the record before the index
+    pstRing->tail = tail + 1;
+}
+
+// Formats the oldest record (or a drop notice) into the line buffer.
+// Returns false if there is nothing to output.
+static bool log_format_next(void)
+{
+    static const char acLevel[] = { '-', 'E', 'I', 'D' };
+    ST_LOG_RING *pstRing = NULL;
+    ST_LOG_REC *pstRec;
+    ULONG drop = LOG_GetDropCount();
+    ULONG i;
+    int len;
+
+    if (drop != f_dropReported) {
+        len = snprintf(f_szLine, sizeof(f_szLine), "[log] %lu records dropped\n", (unsigned long)(drop - f_dropReported));
+        f_dropReported = drop;
+    }
+    else {
+        // Select the oldest record of all rings
+        for (i = 0; i < LOG_CORE_NUM; i++) {
+            if (f_astRing[i].head == f_astRing[i].tail) {
+                continue;
+            }
+            if ((pstRing == NULL) ||
+                ((int32_t)(f_astRing[i].rec[f_astRing[i].head & LOG_RING_MASK].time_us -
+                           pstRing->rec[pstRing->head & LOG_RING_MASK].time_us) < 0)) {
+                pstRing = &f_astRing[i];
+            }
+        }
+        if (pstRing == NULL) {
+            return false;
+        }
+
+        __dmb(); // Read the index before the record
+        pstRec = &pstRing->rec[pstRing->head & LOG_RING_MASK];
+        len = snprintf(f_szLine, sizeof(f_szLine), "%10lu %c ",
+                       (unsigned long)pstRec->time_us, acLevel[pstRec->level & 3]);
+        len += snprintf(&f_szLine[len], sizeof(f_szLine) - len, pstRec->pFmt,
+                        (unsigned long)pstRec->arg[0], (unsigned long)pstRec->arg[1],
+                        (unsigned long)pstRec->arg[2], (unsigned long)pstRec->arg[3],
+                        (unsigned long)pstRec->arg[4], (unsigned long)pstRec->arg[5],
+                        (unsigned long)pstRec->arg[6], (unsigned long)pstRec->arg[7]);
+        __dmb(); // Finish reading the record before releasing it
+        pstRing->head++;
+    }
+
+    if (len < 0) {
+        len = 0;
+    }
+    f_lineLen = ((ULONG)len < sizeof(f_szLine)) ? (ULONG)len : sizeof(f_szLine) - 1;
+    f_linePos = 0;
+
+    return (f_lineLen > 0);
+}
+
+// Formats stored records and writes them to the UART.
+// Never blocks: stops as soon as the UART TX FIFO is full and continues on the next call.
+// Intended to be called repeatedly from the idle loop of a core.
+void LOG_Drain(void)
+{
+    if (f_linePos >= f_lineLen) {
+        if (!log_format_next()) {
+            return;
+        }
+    }
+
+    while (f_linePos < f_lineLen) {
+        if (!uart_is_writable(uart_default)) {
+            return;
+        }
+        if ((f_szLine[f_linePos] == '\n') && !f_bCrSent) {
+            uart_putc_raw(uart_default, '\r');
+            f_bCrSent = true;
+            continue;
+        }
+        uart_putc_raw(uart_default, f_szLine[f_linePos++]);
+        f_bCrSent = false;
+    }
+}
+
+// Returns the total number of records lost because a ring was full
+ULONG LOG_GetDropCount(void)
+{
+    ULONG drop = 0;
+    ULONG i;
+
+    for (i = 0; i < LOG_CORE_NUM; i++) {
+        drop += f_astRing[i].drop;
+    }
+    return drop;
+}
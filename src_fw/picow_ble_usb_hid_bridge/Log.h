@@ -0,0 +1,69 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef LOG_H
+#define LOG_H
+
+#include "Common.h"
+
+// Deferred binary logging.
+// A log site only stores the format pointer, a timestamp and the arguments into a per-core ring.
+// LOG_Drain() formats the records later and writes them to the UART without blocking.
+//
+// Rules for log sites:
+// - The format string must be a string literal (it is stored by pointer).
+// - Up to LOG_ARG_MAX integer arguments. They are passed to the formatter as unsigned long,
+//   so use the 'l' length modifier (%lu, %ld, %lx, %02lX ...). %s is not supported.
+// - Do not log from interrupt handlers that can preempt another log site on the same core.
+
+// [Definitions]
+// Log levels
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_DEBUG 3
+
+// Compile-time log level. Log sites above this level are removed.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Number of records per core (must be a power of 2)
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 32
+#endif
+
+// Maximum number of arguments per record
+#define LOG_ARG_MAX 8
+
+// Maximum length of one formatted line
+#define LOG_LINE_SIZE 128
+
+// [Macros]
+#define LOG_WRITE_(level, fmt, a0, a1, a2, a3, a4, a5, a6, a7, ...) \
+    LOG_Write((level), (fmt), (ULONG)(a0), (ULONG)(a1), (ULONG)(a2), (ULONG)(a3), \
+              (ULONG)(a4), (ULONG)(a5), (ULONG)(a6), (ULONG)(a7))
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_WRITE_(LOG_LEVEL_ERROR, __VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_WRITE_(LOG_LEVEL_INFO, __VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_WRITE_(LOG_LEVEL_DEBUG, __VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+// [Function Prototypes]
+void LOG_Write(ULONG level, const char *pFmt, ULONG a0, ULONG a1, ULONG a2, ULONG a3,
+               ULONG a4, ULONG a5, ULONG a6, ULONG a7);
+void LOG_Drain(void);
+ULONG LOG_GetDropCount(void);
+
+#endif
@@ -0,0 +1,302 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "NotifyPath.h"
+#include "Log.h"
+
+#if NTFP_ENABLE
+
+// [Definitions]
+// Report Reference descriptor: report ID, report type
+#define NTFP_REPORT_TYPE_INPUT 1
+
+// States of the discovery of the value handles
+typedef enum _E_NTFP_DISC {
+    E_NTFP_DISC_IDLE = 0,               // Not started
+    E_NTFP_DISC_SERVICE,                // HID service
+    E_NTFP_DISC_CHARACTERISTICS,        // Report characteristics of the service
+    E_NTFP_DISC_REFERENCES,             // Report Reference descriptors of the service
+    E_NTFP_DISC_DONE,                   // Table complete (or discovery failed)
+} E_NTFP_DISC;
+
+// [Structures]
+// Input report characteristic of the table
+typedef struct _ST_NTFP_ENTRY {
+    USHORT value_handle;                // Value handle of the characteristic
+    USHORT end_handle;                  // Last handle of the characteristic (its descriptors)
+    const ST_HRD_REPORT *pstReport;     // Report of the compiled map (NULL until its Report Reference is read)
+    UCHAR report_id;                    // Report ID of its Report Reference (as in the events of hids_client)
+} ST_NTFP_ENTRY;
+
+// [File Scope Variables]
+static gatt_client_notification_t f_stListener;     // Value listener of the connection
+static bool f_bListening = false;                   // f_stListener is registered
+static hci_con_handle_t f_conHandle = HCI_CON_HANDLE_INVALID; // Connection of the HID device
+static const ST_HRD_MAP *f_pstMap = NULL;           // Report map of the connection
+static NTFP_REPORT_FUNC f_pfnReport = NULL;         // Handler of the direct path
+static E_NTFP_DISC f_eDisc = E_NTFP_DISC_IDLE;      // Discovery of the value handles
+static gatt_client_service_t f_stService;           // First HID service of the device
+static bool f_bService = false;                     // f_stService is valid
+static ST_NTFP_ENTRY f_astEntry[NTFP_HANDLE_MAX];   // Input report characteristics
+static ULONG f_entryCnt = 0;                        // Entries of f_astEntry used by the direct path (discovery complete)
+static ULONG f_discCnt = 0;                         // Entries of f_astEntry being discovered
+static ST_NTFP_STAT f_stStat = {0};                 // Statistics of the connection
+
+// Finds a characteristic of the table (a few entries: linear search)
+static inline const ST_NTFP_ENTRY* ntfp_find(USHORT value_handle)
+{
+    ULONG i;
+
+    for (i = 0; i < f_entryCnt; i++) {
+        if (f_astEntry[i].value_handle == value_handle) {
+            return &f_astEntry[i];
+        }
+    }
+    return NULL;
+}
+
+// Value listener: queues the reports of the table, leaves the others to hids_client
+static void __time_critical_func(ntfp_handler)(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size)
+{
+    ULONG cyc = CMN_CycNow();
+    const ST_NTFP_ENTRY *pstEntry;
+    const ST_CMN_STAT *pstFast = &f_stStat.fast_cycles;
+
+    UNUSED(packet_type);
+    UNUSED(channel);
+    UNUSED(size);
+
+    if (hci_event_packet_get_type(packet) != GATT_EVENT_NOTIFICATION) {
+        return;
+    }
+    pstEntry = ntfp_find(gatt_event_notification_get_value_handle(packet));
+    if (pstEntry == NULL) {
+        return;
+    }
+    f_pfnReport(pstEntry->pstReport, gatt_event_notification_get_value(packet),
+        gatt_event_notification_get_value_length(packet));
+    f_stStat.fast_cnt++;
+
+    // Timing every report would cost as much as the path itself
+    if ((f_stStat.fast_cnt & (NTFP_TIME_EVERY - 1)) != 0) {
+        return;
+    }
+    CMN_StatAdd(&f_stStat.fast_cycles, CMN_CycSince(cyc));
+    if ((pstFast->cnt % NTFP_LOG_SAMPLES) == 0) {
+        LOG_INFO("Report cycles, direct path: min %lu avg %lu max %lu\n",
+            pstFast->min, (ULONG)(pstFast->sum / pstFast->cnt), pstFast->max);
+    }
+}
+
+// Ends the discovery: the characteristics with an input Report Reference form the table
+static void ntfp_disc_done(uint8_t att_status)
+{
+    ULONG cnt = 0;
+    ULONG i;
+
+    f_eDisc = E_NTFP_DISC_DONE;
+    if (att_status != ATT_ERROR_SUCCESS) {
+        LOG_ERROR("Notification path: discovery failed, ATT status 0x%02lx\n", (ULONG)att_status);
+        return;
+    }
+    for (i = 0; i < f_discCnt; i++) {
+        if (f_astEntry[i].pstReport != NULL) {
+            f_astEntry[cnt++] = f_astEntry[i];
+        }
+    }
+    f_discCnt = cnt;
+    f_entryCnt = cnt;
+    f_stStat.handle_cnt = cnt;
+    LOG_INFO("Notification path: %lu input report characteristics\n", cnt);
+}
+
+// Input Report Reference of a characteristic of the table: report of the compiled map
+static void ntfp_disc_reference(USHORT handle, const uint8_t *pValue, uint16_t len)
+{
+    ULONG i;
+
+    if ((len < 2) || (pValue[1] != NTFP_REPORT_TYPE_INPUT)) {
+        return;
+    }
+    for (i = 0; i < f_discCnt; i++) {
+        if ((handle > f_astEntry[i].value_handle) && (handle <= f_astEntry[i].end_handle)) {
+            f_astEntry[i].pstReport = HRD_GetReport(f_pstMap, f_pstMap->bUseId ? pValue[0] : HRD_NO_REPORT_ID);
+            f_astEntry[i].report_id = pValue[0];
+            if (f_astEntry[i].pstReport != NULL) {
+                LOG_INFO("Notification path: value handle 0x%04lx is report ID %lu\n",
+                    (ULONG)f_astEntry[i].value_handle, (ULONG)pValue[0]);
+            }
+            return;
+        }
+    }
+}
+
+// GATT client events of the discovery
+static void ntfp_disc_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size)
+{
+    gatt_client_characteristic_t stChr;
+    uint8_t att_status;
+    uint8_t status;
+
+    UNUSED(packet_type);
+    UNUSED(channel);
+    UNUSED(size);
+
+    // A late event of the previous connection
+    if (!f_bListening) {
+        return;
+    }
+    switch (hci_event_packet_get_type(packet)) {
+    case GATT_EVENT_SERVICE_QUERY_RESULT:
+        if (!f_bService) {
+            gatt_event_service_query_result_get_service(packet, &f_stService);
+            f_bService = true;
+        }
+        break;
+
+    case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+        gatt_event_characteristic_query_result_get_characteristic(packet, &stChr);
+        if (((stChr.properties & ATT_PROPERTY_NOTIFY) != 0) && (f_discCnt < NTFP_HANDLE_MAX)) {
+            f_astEntry[f_discCnt].value_handle = stChr.value_handle;
+            f_astEntry[f_discCnt].end_handle = stChr.end_handle;
+            f_astEntry[f_discCnt].pstReport = NULL;
+            f_discCnt++;
+        }
+        break;
+
+    case GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT:
+        ntfp_disc_reference(gatt_event_characteristic_value_query_result_get_value_handle(packet),
+            gatt_event_characteristic_value_query_result_get_value(packet),
+            gatt_event_characteristic_value_query_result_get_value_length(packet));
+        break;
+
+    case GATT_EVENT_QUERY_COMPLETE:
+        att_status = gatt_event_query_complete_get_att_status(packet);
+        if ((att_status != ATT_ERROR_SUCCESS) || (f_eDisc == E_NTFP_DISC_REFERENCES)) {
+            ntfp_disc_done(att_status);
+            break;
+        }
+        if (f_eDisc == E_NTFP_DISC_SERVICE) {
+            if (!f_bService) {
+                ntfp_disc_done(ATT_ERROR_SUCCESS);
+                break;
+            }
+            f_eDisc = E_NTFP_DISC_CHARACTERISTICS;
+            status = gatt_client_discover_characteristics_for_service_by_uuid16(&ntfp_disc_handler, f_conHandle,
+                &f_stService, ORG_BLUETOOTH_CHARACTERISTIC_REPORT);
+        }
+        else {
+            if (f_discCnt == 0) {
+                ntfp_disc_done(ATT_ERROR_SUCCESS);
+                break;
+            }
+            // All the Report References of the service in one Read By Type
+            f_eDisc = E_NTFP_DISC_REFERENCES;
+            status = gatt_client_read_value_of_characteristics_by_uuid16(&ntfp_disc_handler, f_conHandle,
+                f_stService.start_group_handle, f_stService.end_group_handle, ORG_BLUETOOTH_DESCRIPTOR_REPORT_REFERENCE);
+        }
+        if (status != ERROR_CODE_SUCCESS) {
+            f_eDisc = E_NTFP_DISC_DONE;
+            LOG_ERROR("Notification path: GATT query failed, status 0x%02lx\n", (ULONG)status);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Listen to the notifications of a connection (HID service connected, report map compiled).
+ *
+ * @param con_handle Connection of the HID device
+ * @param pstMap Compiled report map, valid until NTFP_Stop
+ * @param pfnReport Handler of the reports on the direct path
+ */
+void NTFP_Start(hci_con_handle_t con_handle, const ST_HRD_MAP *pstMap, NTFP_REPORT_FUNC pfnReport)
+{
+    NTFP_Stop();
+    memset(&f_stStat, 0, sizeof(f_stStat));
+    f_conHandle = con_handle;
+    f_pstMap = pstMap;
+    f_pfnReport = pfnReport;
+    gatt_client_listen_for_characteristic_value_updates(&f_stListener, &ntfp_handler, con_handle, NULL);
+    f_bListening = true;
+}
+
+/**
+ * @brief Build the table of the input report value handles (connection READY, GATT client idle).
+ */
+void NTFP_Discover(void)
+{
+    uint8_t status;
+
+    if (!f_bListening || (f_eDisc != E_NTFP_DISC_IDLE)) {
+        return;
+    }
+    f_eDisc = E_NTFP_DISC_SERVICE;
+    status = gatt_client_discover_primary_services_by_uuid16(&ntfp_disc_handler, f_conHandle,
+        ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE);
+    if (status != ERROR_CODE_SUCCESS) {
+        f_eDisc = E_NTFP_DISC_DONE;
+        LOG_ERROR("Notification path: GATT query failed, status 0x%02lx\n", (ULONG)status);
+    }
+}
+
+/**
+ * @brief Stop listening and forget the table (disconnection).
+ */
+void NTFP_Stop(void)
+{
+    if (!f_bListening) {
+        return;
+    }
+    gatt_client_stop_listening_for_characteristic_value_updates(&f_stListener);
+    f_bListening = false;
+    LOG_INFO("Notification path: reports direct %lu (hids_client events dropped %lu), through hids_client %lu, characteristics %lu\n",
+        f_stStat.fast_cnt, f_stStat.drop_cnt, f_stStat.slow_cnt, f_stStat.handle_cnt);
+
+    f_conHandle = HCI_CON_HANDLE_INVALID;
+    f_eDisc = E_NTFP_DISC_IDLE;
+    f_bService = false;
+    f_entryCnt = 0;
+    f_discCnt = 0;
+}
+
+/**
+ * @brief Check a report event of hids_client (GATTSERVICE_SUBEVENT_HID_REPORT).
+ *
+ * hids_client builds the event from the same notification as the direct path, before or after
+ * it: the reports of the characteristics of the table are dropped, whatever the order.
+ *
+ * @param service_index HID service given by hids_client (the table is of the first one)
+ * @param report_id Report ID given by hids_client
+ * @return true if the report is queued on the direct path (drop the event)
+ */
+bool __time_critical_func(NTFP_OnHidReport)(uint8_t service_index, uint8_t report_id)
+{
+    ULONG i;
+
+    if (service_index == 0) {
+        for (i = 0; i < f_entryCnt; i++) {
+            if (f_astEntry[i].report_id == report_id) {
+                f_stStat.drop_cnt++;
+                return true;
+            }
+        }
+    }
+    if (f_bListening) {
+        f_stStat.slow_cnt++;
+    }
+    return false;
+}
+
+/**
+ * @brief Get the statistics of the current connection.
+ *
+ * @return Statistics
+ */
+const ST_NTFP_STAT* NTFP_GetStat(void)
+{
+    return &f_stStat;
+}
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef NOTIFYPATH_H
+#define NOTIFYPATH_H
+
+#include "btstack.h"
+#include "Common.h"
+#include "HidRptDesc.h"
+
+// Direct path of the input report notifications (core1).
+// For each notification, hids_client searches the characteristic among those of the service,
+// copies the value behind the report ID into a GATTSERVICE_SUBEVENT_HID_REPORT event and
+// dispatches it to the bridge, which then looks the report ID up in the report map again.
+// Once the HID service is connected, the bridge listens to the notifications of the
+// connection itself: a table of the input report value handles gives the report of the
+// compiled map, and the value is queued from the notification. hids_client still gets the
+// notification and builds its report event; the bridge drops the events of the report IDs of
+// the table (NTFP_OnHidReport). The events are not changed, so the order in which BTstack
+// calls the value listeners does not matter and the other listeners see them unchanged.
+// hids_client does not expose the value handles: the table is built once the connection is
+// READY (after the Device Information queries, as the GATT client runs one query at a time)
+// from a discovery of the Report characteristics of the first HID service and one read of
+// their Report Reference descriptors. Until it is complete, and for the characteristics it
+// did not find, the reports take the hids_client path.
+// The cycles of both paths are compared on the same traffic by bridge_bench (ntf_direct,
+// ntf_hids); the firmware only times the direct path.
+
+// [Definitions]
+// Set to 0 to handle every report through hids_client
+#ifndef NTFP_ENABLE
+#define NTFP_ENABLE 1
+#endif
+
+// Input report characteristics of the table
+#define NTFP_HANDLE_MAX 8
+
+// One in this many reports of the direct path is timed (power of 2)
+#define NTFP_TIME_EVERY 64
+
+// Timed reports per log of the cycles of the direct path
+#define NTFP_LOG_SAMPLES 16
+
+// [Structures]
+// Statistics of the current connection
+typedef struct _ST_NTFP_STAT {
+    ULONG fast_cnt;                     // Reports queued from the notification
+    ULONG slow_cnt;                     // Reports handled through hids_client (characteristics not in the table)
+    ULONG drop_cnt;                     // Report events of hids_client dropped (queued from the notification)
+    ULONG handle_cnt;                   // Input report characteristics of the table
+    ST_CMN_STAT fast_cycles;            // Notification to queued, direct path (cycles, one in NTFP_TIME_EVERY)
+} ST_NTFP_STAT;
+
+// Handler of a report on the direct path: value of the notification (without the report ID)
+typedef void (*NTFP_REPORT_FUNC)(const ST_HRD_REPORT *pstReport, const uint8_t *pValue, uint16_t len);
+
+// [Function Prototypes]
+#if NTFP_ENABLE
+void NTFP_Start(hci_con_handle_t con_handle, const ST_HRD_MAP *pstMap, NTFP_REPORT_FUNC pfnReport);
+void NTFP_Discover(void);
+void NTFP_Stop(void);
+bool NTFP_OnHidReport(uint8_t service_index, uint8_t report_id);
+const ST_NTFP_STAT* NTFP_GetStat(void);
+#else
+#define NTFP_Start(con_handle, pstMap, pfnReport) ((void)(con_handle), (void)(pstMap), (void)(pfnReport))
+#define NTFP_Discover() ((void)0)
+#define NTFP_Stop() ((void)0)
+#define NTFP_OnHidReport(service_index, report_id) ((void)(service_index), (void)(report_id), false)
+#endif
+
+#endif
@@ -0,0 +1,447 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "P256.h"
+
+// [Definitions]
+// States of a multiplication
+typedef enum _E_P256_STATE {
+    E_P256_STATE_LADDER = 0,            // Montgomery ladder, bit by bit
+    E_P256_STATE_INVERT,                // 1 / Z = Z^(p - 2), P256_INV_BITS bits per step
+    E_P256_STATE_AFFINE,                // R0 to affine coordinates
+    E_P256_STATE_DONE,
+} E_P256_STATE;
+
+// [File Scope Variables]
+// Curve parameters (little-endian words)
+static const ULONG f_aulP[P256_WORDS] = {
+    0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff,
+};
+static const ULONG f_aulN[P256_WORDS] = {
+    0xfc632551, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff,
+};
+static const ULONG f_aulB[P256_WORDS] = {
+    0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0, 0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8,
+};
+static const ULONG f_aulGx[P256_WORDS] = {
+    0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81, 0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2,
+};
+static const ULONG f_aulGy[P256_WORDS] = {
+    0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357, 0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2,
+};
+// Exponent of the inversion (p - 2)
+static const ULONG f_aulPm2[P256_WORDS] = {
+    0xfffffffd, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff,
+};
+
+//--------------------------------------------------------------------+
+// Multi-word integers and the field
+//--------------------------------------------------------------------+
+// Big-endian bytes to little-endian words
+static void p256_from_bytes(ULONG *pW, const UCHAR *pBytes)
+{
+    ULONG i;
+
+    for (i = 0; i < P256_WORDS; i++) {
+        pW[i] = ((ULONG)pBytes[P256_BYTES - 1 - 4 * i]) | ((ULONG)pBytes[P256_BYTES - 2 - 4 * i] << 8) |
+                ((ULONG)pBytes[P256_BYTES - 3 - 4 * i] << 16) | ((ULONG)pBytes[P256_BYTES - 4 - 4 * i] << 24);
+    }
+}
+
+// Little-endian words to big-endian bytes
+static void p256_to_bytes(UCHAR *pBytes, const ULONG *pW)
+{
+    ULONG i;
+
+    for (i = 0; i < P256_WORDS; i++) {
+        pBytes[P256_BYTES - 1 - 4 * i] = (UCHAR)pW[i];
+        pBytes[P256_BYTES - 2 - 4 * i] = (UCHAR)(pW[i] >> 8);
+        pBytes[P256_BYTES - 3 - 4 * i] = (UCHAR)(pW[i] >> 16);
+        pBytes[P256_BYTES - 4 - 4 * i] = (UCHAR)(pW[i] >> 24);
+    }
+}
+
+// Compares a and b: -1, 0 or 1
+static int p256_cmp(const ULONG *pA, const ULONG *pB)
+{
+    int i;
+
+    for (i = P256_WORDS - 1; i >= 0; i--) {
+        if (pA[i] != pB[i]) {
+            return (pA[i] > pB[i]) ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+static bool p256_is_zero(const ULONG *pA)
+{
+    ULONG acc = 0;
+    ULONG i;
+
+    for (i = 0; i < P256_WORDS; i++) {
+        acc |= pA[i];
+    }
+    return acc == 0;
+}
+
+// r = a + b, returns the carry
+static ULONG p256_add(ULONG *pR, const ULONG *pA, const ULONG *pB)
+{
+    uint64_t t = 0;
+    ULONG i;
+
+    for (i = 0; i < P256_WORDS; i++) {
+        t += (uint64_t)pA[i] + pB[i];
+        pR[i] = (ULONG)t;
+        t >>= 32;
+    }
+    return (ULONG)t;
+}
+
+// r = a - b, returns the borrow
+static ULONG p256_sub(ULONG *pR, const ULONG *pA, const ULONG *pB)
+{
+    int64_t t = 0;
+    ULONG i;
+
+    for (i = 0; i < P256_WORDS; i++) {
+        t += (int64_t)pA[i] - pB[i];
+        pR[i] = (ULONG)t;
+        t >>= 32;
+    }
+    return (t < 0) ? 1 : 0;
+}
+
+// r = a + b mod p (a, b < p)
+static void fe_add(ULONG *pR, const ULONG *pA, const ULONG *pB)
+{
+    if (p256_add(pR, pA, pB) || (p256_cmp(pR, f_aulP) >= 0)) {
+        (void)p256_sub(pR, pR, f_aulP);
+    }
+}
+
+// r = a - b mod p (a, b < p)
+static void fe_sub(ULONG *pR, const ULONG *pA, const ULONG *pB)
+{
+    if (p256_sub(pR, pA, pB)) {
+        (void)p256_add(pR, pR, f_aulP);
+    }
+}
+
+// r = c mod p for a product c of 16 words (FIPS 186-4 D.2.3: c = T + 2 S1 + 2 S2 + S3 + S4 - D1 - D2 - D3 - D4)
+static void fe_reduce(ULONG *pR, const ULONG *c)
+{
+    int64_t aw[P256_WORDS];
+    int64_t t;
+    ULONG i;
+
+    aw[0] = (int64_t)c[0] + c[8] + c[9] - c[11] - c[12] - c[13] - c[14];
+    aw[1] = (int64_t)c[1] + c[9] + c[10] - c[12] - c[13] - c[14] - c[15];
+    aw[2] = (int64_t)c[2] + c[10] + c[11] - c[13] - c[14] - c[15];
+    aw[3] = (int64_t)c[3] + 2 * (int64_t)c[11] + 2 * (int64_t)c[12] + c[13] - c[15] - c[8] - c[9];
+    aw[4] = (int64_t)c[4] + 2 * (int64_t)c[12] + 2 * (int64_t)c[13] + c[14] - c[9] - c[10];
+    aw[5] = (int64_t)c[5] + 2 * (int64_t)c[13] + 2 * (int64_t)c[14] + c[15] - c[10] - c[11];
+    aw[6] = (int64_t)c[6] + 3 * (int64_t)c[14] + 2 * (int64_t)c[15] + c[13] - c[8] - c[9];
+    aw[7] = (int64_t)c[7] + 3 * (int64_t)c[15] + c[8] - c[10] - c[11] - c[12] - c[13];
+
+    // Folds the carry out of 256 bits: 2^256 = 2^224 - 2^192 - 2^96 + 1 (mod p)
+    t = 0;
+    for (;;) {
+        for (i = 0; i < P256_WORDS; i++) {
+            t += aw[i];
+            aw[i] = (int64_t)(ULONG)t;
+            t >>= 32;
+        }
+        if (t == 0) {
+            break;
+        }
+        aw[0] += t;
+        aw[3] -= t;
+        aw[6] -= t;
+        aw[7] += t;
+        t = 0;
+    }
+    for (i = 0; i < P256_WORDS; i++) {
+        pR[i] = (ULONG)aw[i];
+    }
+    while (p256_cmp(pR, f_aulP) >= 0) {
+        (void)p256_sub(pR, pR, f_aulP);
+    }
+}
+
+// r = a * b mod p
+static void fe_mul(ULONG *pR, const ULONG *pA, const ULONG *pB)
+{
+    ULONG c[2 * P256_WORDS] = {0};
+    uint64_t t;
+    ULONG i, j;
+
+    for (i = 0; i < P256_WORDS; i++) {
+        t = 0;
+        for (j = 0; j < P256_WORDS; j++) {
+            t += (uint64_t)pA[i] * pB[j] + c[i + j];
+            c[i + j] = (ULONG)t;
+            t >>= 32;
+        }
+        c[i + P256_WORDS] = (ULONG)t;
+    }
+    fe_reduce(pR, c);
+}
+
+//--------------------------------------------------------------------+
+// Points
+//--------------------------------------------------------------------+
+// Checks y^2 = x^3 - 3x + b with x, y < p
+static bool p256_on_curve(const ULONG *pX, const ULONG *pY)
+{
+    static const ULONG aulThree[P256_WORDS] = { 3 };
+    ULONG aulL[P256_WORDS];
+    ULONG aulR[P256_WORDS];
+
+    if ((p256_cmp(pX, f_aulP) >= 0) || (p256_cmp(pY, f_aulP) >= 0)) {
+        return false;
+    }
+    fe_mul(aulL, pY, pY);
+    fe_mul(aulR, pX, pX);
+    fe_sub(aulR, aulR, aulThree);
+    fe_mul(aulR, aulR, pX);             // x (x^2 - 3)
+    fe_add(aulR, aulR, f_aulB);
+
+    return p256_cmp(aulL, aulR) == 0;
+}
+
+// Co-Z addition (P1 + P2, P1 with the new Z): (X2, Y2) = P1 + P2, (X1, Y1) = P1, Z *= X2 - X1
+static void p256_zaddu(ULONG *pX1, ULONG *pY1, ULONG *pX2, ULONG *pY2, ULONG *pZ)
+{
+    ULONG aulA[P256_WORDS];
+    ULONG aulD[P256_WORDS];
+    ULONG aulT[P256_WORDS];
+
+    fe_sub(aulT, pX2, pX1);             // X2 - X1
+    fe_mul(pZ, pZ, aulT);
+    fe_mul(aulA, aulT, aulT);           // A = (X2 - X1)^2
+    fe_mul(pX1, pX1, aulA);             // B = X1 A
+    fe_mul(pX2, pX2, aulA);             // C = X2 A
+    fe_sub(aulT, pY2, pY1);             // Y2 - Y1
+    fe_mul(aulD, aulT, aulT);           // D = (Y2 - Y1)^2
+    fe_sub(aulA, pX2, pX1);             // C - B
+    fe_mul(pY1, pY1, aulA);             // E = Y1 (C - B)
+    fe_sub(aulD, aulD, pX1);
+    fe_sub(aulD, aulD, pX2);            // X3 = D - B - C
+    fe_sub(aulA, pX1, aulD);            // B - X3
+    fe_mul(pY2, aulT, aulA);
+    fe_sub(pY2, pY2, pY1);              // Y3 = (Y2 - Y1)(B - X3) - E
+    memcpy(pX2, aulD, sizeof(aulD));
+}
+
+// Conjugate co-Z addition: (X2, Y2) = P1 + P2, (X1, Y1) = P1 - P2, Z *= X2 - X1
+static void p256_zaddc(ULONG *pX1, ULONG *pY1, ULONG *pX2, ULONG *pY2, ULONG *pZ)
+{
+    ULONG aulA[P256_WORDS];
+    ULONG aulD[P256_WORDS];
+    ULONG aulF[P256_WORDS];
+    ULONG aulT[P256_WORDS];
+    ULONG aulS[P256_WORDS];
+
+    fe_sub(aulT, pX2, pX1);             // X2 - X1
+    fe_mul(pZ, pZ, aulT);
+    fe_mul(aulA, aulT, aulT);           // A = (X2 - X1)^2
+    fe_mul(pX1, pX1, aulA);             // B = X1 A
+    fe_mul(pX2, pX2, aulA);             // C = X2 A
+    fe_add(aulS, pY1, pY2);             // Y1 + Y2
+    fe_sub(aulT, pY2, pY1);             // Y2 - Y1
+    fe_sub(aulA, pX2, pX1);             // C - B
+    fe_mul(pY1, pY1, aulA);             // E = Y1 (C - B)
+    fe_mul(aulD, aulT, aulT);           // D = (Y2 - Y1)^2
+    fe_sub(aulD, aulD, pX1);
+    fe_sub(aulD, aulD, pX2);            // X3 = D - B - C
+    fe_mul(aulF, aulS, aulS);           // F = (Y1 + Y2)^2
+    fe_sub(aulF, aulF, pX1);
+    fe_sub(aulF, aulF, pX2);            // X3' = F - B - C
+    fe_sub(aulA, pX1, aulD);            // B - X3
+    fe_mul(pY2, aulT, aulA);
+    fe_sub(pY2, pY2, pY1);              // Y3 = (Y2 - Y1)(B - X3) - E
+    fe_sub(aulA, aulF, pX1);            // X3' - B
+    fe_mul(aulS, aulS, aulA);
+    fe_sub(pY1, aulS, pY1);             // Y3' = (Y1 + Y2)(X3' - B) - E
+    memcpy(pX1, aulF, sizeof(aulF));
+    memcpy(pX2, aulD, sizeof(aulD));
+}
+
+// R0 = P, R1 = 2P with a common Z = 2y (P affine, a = -3)
+static void p256_initial_double(ST_P256_MULT *pstMult, const ULONG *pX, const ULONG *pY)
+{
+    static const ULONG aulOne[P256_WORDS] = { 1 };
+    ULONG aulB[P256_WORDS];
+    ULONG aulE[P256_WORDS];
+    ULONG aulL[P256_WORDS];
+    ULONG aulS[P256_WORDS];
+
+    fe_mul(aulB, pX, pX);
+    fe_sub(aulB, aulB, aulOne);
+    fe_add(aulS, aulB, aulB);
+    fe_add(aulB, aulS, aulB);           // B = 3 (x^2 - 1)
+    fe_mul(aulE, pY, pY);               // E = y^2
+    fe_mul(aulL, aulE, aulE);           // L = E^2
+    fe_mul(aulS, pX, aulE);
+    fe_add(aulS, aulS, aulS);
+    fe_add(aulS, aulS, aulS);           // S = 4 x E
+    fe_add(aulL, aulL, aulL);
+    fe_add(aulL, aulL, aulL);
+    fe_add(aulL, aulL, aulL);           // 8 L
+
+    fe_mul(pstMult->aulX[1], aulB, aulB);
+    fe_sub(pstMult->aulX[1], pstMult->aulX[1], aulS);
+    fe_sub(pstMult->aulX[1], pstMult->aulX[1], aulS); // X(2P) = B^2 - 2S
+    fe_sub(aulE, aulS, pstMult->aulX[1]);
+    fe_mul(pstMult->aulY[1], aulB, aulE);
+    fe_sub(pstMult->aulY[1], pstMult->aulY[1], aulL); // Y(2P) = B (S - X(2P)) - 8L
+    memcpy(pstMult->aulX[0], aulS, sizeof(aulS));     // P = (S, 8L)
+    memcpy(pstMult->aulY[0], aulL, sizeof(aulL));
+    fe_add(pstMult->aulZ, pY, pY);                    // Z = 2y
+}
+
+//--------------------------------------------------------------------+
+// API
+//--------------------------------------------------------------------+
+/**
+ * @brief Check a public key (on the curve, coordinates below p).
+ *
+ * @param pPoint Point (64 bytes, uECC format)
+ * @return true if valid
+ */
+bool P256_ValidPoint(const UCHAR *pPoint)
+{
+    ULONG aulX[P256_WORDS];
+    ULONG aulY[P256_WORDS];
+
+    p256_from_bytes(aulX, &pPoint[0]);
+    p256_from_bytes(aulY, &pPoint[P256_BYTES]);
+
+    return p256_on_curve(aulX, aulY);
+}
+
+/**
+ * @brief Check a private key (1 to n - 1).
+ *
+ * @param pScalar Scalar (32 bytes, uECC format)
+ * @return true if valid
+ */
+bool P256_ValidScalar(const UCHAR *pScalar)
+{
+    ULONG aulK[P256_WORDS];
+
+    p256_from_bytes(aulK, pScalar);
+
+    return !p256_is_zero(aulK) && (p256_cmp(aulK, f_aulN) < 0);
+}
+
+/**
+ * @brief Start a multiplication k P.
+ *
+ * @param pstMult Multiplication
+ * @param pPoint  Point P (64 bytes, uECC format, checked with P256_ValidPoint), or NULL for the base point G
+ * @param pScalar Scalar k (32 bytes, uECC format, checked with P256_ValidScalar)
+ */
+void P256_MultStart(ST_P256_MULT *pstMult, const UCHAR *pPoint, const UCHAR *pScalar)
+{
+    ULONG aulX[P256_WORDS];
+    ULONG aulY[P256_WORDS];
+    ULONG aulK[P256_WORDS];
+    ULONG aulK2[P256_WORDS];
+    ULONG carry;
+
+    if (pPoint != NULL) {
+        p256_from_bytes(aulX, &pPoint[0]);
+        p256_from_bytes(aulY, &pPoint[P256_BYTES]);
+    }
+    else {
+        memcpy(aulX, f_aulGx, sizeof(aulX));
+        memcpy(aulY, f_aulGy, sizeof(aulY));
+    }
+
+    // k + n, or k + 2n if that has no bit 256: the ladder always starts at bit 256
+    p256_from_bytes(aulK, pScalar);
+    carry = p256_add(aulK2, aulK, f_aulN);
+    if (carry == 0) {
+        carry = p256_add(aulK2, aulK2, f_aulN);
+    }
+    memcpy(pstMult->aulK, aulK2, sizeof(aulK2));
+    pstMult->aulK[P256_WORDS] = carry;
+    memset(aulK, 0, sizeof(aulK));
+    memset(aulK2, 0, sizeof(aulK2));
+
+    p256_initial_double(pstMult, aulX, aulY);
+    pstMult->state = E_P256_STATE_LADDER;
+    pstMult->bit = 256;
+}
+
+/**
+ * @brief Run one step of a multiplication (16 to 24 field multiplications).
+ *
+ * @param pstMult Multiplication
+ * @return true if the multiplication is complete (P256_MultResult)
+ */
+bool P256_MultStep(ST_P256_MULT *pstMult)
+{
+    ULONG b;
+    ULONG i;
+
+    switch (pstMult->state) {
+    case E_P256_STATE_LADDER:
+        // R[b] = 2 R[b], R[1 - b] = R0 + R1
+        pstMult->bit--;
+        b = (pstMult->aulK[pstMult->bit / 32] >> (pstMult->bit % 32)) & 1;
+        p256_zaddc(pstMult->aulX[b], pstMult->aulY[b], pstMult->aulX[1 - b], pstMult->aulY[1 - b], pstMult->aulZ);
+        p256_zaddu(pstMult->aulX[1 - b], pstMult->aulY[1 - b], pstMult->aulX[b], pstMult->aulY[b], pstMult->aulZ);
+        if (pstMult->bit == 0) {
+            memset(pstMult->aulK, 0, sizeof(pstMult->aulK));
+            memset(pstMult->aulInv, 0, sizeof(pstMult->aulInv));
+            pstMult->aulInv[0] = 1;
+            pstMult->bit = 256;
+            pstMult->state = E_P256_STATE_INVERT;
+        }
+        break;
+    case E_P256_STATE_INVERT:
+        for (i = 0; i < P256_INV_BITS; i++) {
+            pstMult->bit--;
+            fe_mul(pstMult->aulInv, pstMult->aulInv, pstMult->aulInv);
+            if ((f_aulPm2[pstMult->bit / 32] >> (pstMult->bit % 32)) & 1) {
+                fe_mul(pstMult->aulInv, pstMult->aulInv, pstMult->aulZ);
+            }
+        }
+        if (pstMult->bit == 0) {
+            pstMult->state = E_P256_STATE_AFFINE;
+        }
+        break;
+    case E_P256_STATE_AFFINE:
+        // x = X / Z^2, y = Y / Z^3
+        fe_mul(pstMult->aulZ, pstMult->aulInv, pstMult->aulInv);
+        fe_mul(pstMult->aulX[0], pstMult->aulX[0], pstMult->aulZ);
+        fe_mul(pstMult->aulZ, pstMult->aulZ, pstMult->aulInv);
+        fe_mul(pstMult->aulY[0], pstMult->aulY[0], pstMult->aulZ);
+        pstMult->state = E_P256_STATE_DONE;
+        break;
+    default:
+        break;
+    }
+
+    return pstMult->state == E_P256_STATE_DONE;
+}
+
+/**
+ * @brief Get the result of a completed multiplication and clear the state.
+ *
+ * @param pstMult Multiplication
+ * @param pPoint  k P (64 bytes, uECC format)
+ * @return true if the result is a valid point (false for the point at infinity)
+ */
+bool P256_MultResult(ST_P256_MULT *pstMult, UCHAR *pPoint)
+{
+    bool bValid = (pstMult->state == E_P256_STATE_DONE) && p256_on_curve(pstMult->aulX[0], pstMult->aulY[0]);
+
+    p256_to_bytes(&pPoint[0], pstMult->aulX[0]);
+    p256_to_bytes(&pPoint[P256_BYTES], pstMult->aulY[0]);
+    memset(pstMult, 0, sizeof(*pstMult));
+
+    return bValid;
+}
@@ -0,0 +1,50 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef P256_H
+#define P256_H
+
+#include "Common.h"
+
+// P-256 (secp256r1) scalar multiplication in bounded steps, for the crypto offload on core0.
+// micro-ecc computes a multiplication in one call of a few hundred ms on the M0+, which would
+// stop the USB tasks of the core0 loop for that long. Here a multiplication is a state machine:
+// one step is one bit of a Montgomery ladder (co-Z Jacobian coordinates, as micro-ecc) or
+// P256_INV_BITS bits of the final inversion, 16 to 24 field multiplications (roughly
+// 0.5 ms on the M0+ at 125 MHz; the longest step is logged with the DHKey), so that the loop runs the USB
+// tasks and feeds the watchdog between the steps.
+// A few scalars near 0 and n (1, n - 2, n - 1) meet the point at infinity on the ladder, like
+// micro-ecc's: P256_MultResult rejects them (a random key hits one with negligible probability).
+// bridge_test (host) checks the results against a reference implementation.
+// The scalar is regularized to 257 bits (k + n or k + 2n) and every bit costs the same.
+// Points and scalars are in uECC format (big endian, point = X then Y).
+// The state keeps no pointers and one multiplication runs at a time per ST_P256_MULT.
+
+// [Definitions]
+#define P256_WORDS 8                    // Field element / scalar (32-bit words)
+#define P256_BYTES 32                   // Field element / scalar (bytes)
+
+// Exponent bits of the inversion per step
+#define P256_INV_BITS 16
+
+// Steps of a multiplication: 256 ladder bits, the inversion and the conversion to affine
+#define P256_STEPS (256 + (256 / P256_INV_BITS) + 1)
+
+// [Structures]
+// Multiplication in progress
+typedef struct _ST_P256_MULT {
+    ULONG state;                        // E_P256_STATE (P256.c)
+    ULONG bit;                          // Next bit of the scalar, or of the exponent of the inversion
+    ULONG aulK[P256_WORDS + 1];         // Regularized scalar (257 bits)
+    ULONG aulX[2][P256_WORDS];          // Ladder R0, R1 (co-Z), then the result
+    ULONG aulY[2][P256_WORDS];
+    ULONG aulZ[P256_WORDS];             // Common Z of R0 and R1
+    ULONG aulInv[P256_WORDS];           // 1 / Z being computed
+} ST_P256_MULT;
+
+// [Function Prototypes]
+bool P256_ValidPoint(const UCHAR *pPoint);
+bool P256_ValidScalar(const UCHAR *pScalar);
+void P256_MultStart(ST_P256_MULT *pstMult, const UCHAR *pPoint, const UCHAR *pScalar);
+bool P256_MultStep(ST_P256_MULT *pstMult);
+bool P256_MultResult(ST_P256_MULT *pstMult, UCHAR *pPoint);
+
+#endif
@@ -0,0 +1,193 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "hardware/clocks.h"
+#include "RpaCache.h"
+#include "Aes.h"
+#include "Log.h"
+
+#if RPAC_ENABLE
+
+// [Definitions]
+// Size of prand and of hash in an RPA (Core Vol 6 Part B 1.3.2.2)
+#define RPAC_PART_SIZE 3
+
+// [Structures]
+// Cached result of one address
+typedef struct _ST_RPAC_ENTRY {
+    bd_addr_t addr;                     // RPA
+    bool bValid;                        // The entry is in use
+    int index;                          // Device DB index, or RPAC_NO_MATCH
+    ULONG time_ms;                      // First time the address was resolved
+} ST_RPAC_ENTRY;
+
+// IRK of a bonded device
+typedef struct _ST_RPAC_IRK {
+    int index;                          // Device DB index
+    UCHAR aucIrk[AES_KEY_SIZE];         // IRK
+    ULONG aulRk[AES_RK_WORDS];          // Its round keys
+} ST_RPAC_IRK;
+
+// [File Scope Variables]
+static ST_RPAC_ENTRY f_astCache[RPAC_CACHE_SIZE]; // Results by address
+static ST_RPAC_IRK f_astIrk[RPAC_IRK_MAX];        // Bonded IRKs
+static ULONG f_irkCnt = 0;                        // Valid entries of f_astIrk
+static ULONG f_startMs = 0;                       // Start of the scan
+static ST_RPAC_STAT f_stStat = {0};               // Statistics of the scan
+
+// The hash of an RPA is an AES output: its low bits spread the addresses evenly
+static inline ULONG rpac_slot(const bd_addr_t addr)
+{
+    return (ULONG)(addr[5] ^ addr[2]) & (RPAC_CACHE_SIZE - 1);
+}
+
+// ah(IRK, prand) of every bonded IRK against the hash of the address
+static int rpac_lookup(const bd_addr_t addr)
+{
+    UCHAR aucBlock[AES_BLOCK_SIZE];
+    ULONG i;
+
+    for (i = 0; i < f_irkCnt; i++) {
+        // r' = padding || prand, most significant octet first
+        memset(aucBlock, 0, AES_BLOCK_SIZE - RPAC_PART_SIZE);
+        memcpy(&aucBlock[AES_BLOCK_SIZE - RPAC_PART_SIZE], &addr[0], RPAC_PART_SIZE);
+        AES_EncryptBlock(f_astIrk[i].aulRk, aucBlock, aucBlock);
+        f_stStat.ah_cnt++;
+        if (memcmp(&aucBlock[AES_BLOCK_SIZE - RPAC_PART_SIZE], &addr[RPAC_PART_SIZE], RPAC_PART_SIZE) == 0) {
+            return f_astIrk[i].index;
+        }
+    }
+    return RPAC_NO_MATCH;
+}
+
+/**
+ * @brief Take the IRKs of the bonded devices and start the statistics of a scan.
+ *
+ * The cache is dropped if the bonded IRKs changed since the last scan.
+ */
+void RPAC_StartScan(void)
+{
+    static const UCHAR aucNoIrk[AES_KEY_SIZE] = {0};
+    ST_RPAC_IRK *pstIrk;
+    sm_key_t irk;
+    int addr_type;
+    bool bChanged = false;
+    ULONG cnt = 0;
+    int i;
+
+    for (i = 0; (i < le_device_db_max_count()) && (cnt < RPAC_IRK_MAX); i++) {
+        addr_type = BD_ADDR_TYPE_UNKNOWN;
+        le_device_db_info(i, &addr_type, NULL, irk);
+        if ((addr_type == BD_ADDR_TYPE_UNKNOWN) || (memcmp(irk, aucNoIrk, AES_KEY_SIZE) == 0)) {
+            continue;
+        }
+        pstIrk = &f_astIrk[cnt++];
+        if ((cnt > f_irkCnt) || (pstIrk->index != i) || (memcmp(pstIrk->aucIrk, irk, AES_KEY_SIZE) != 0)) {
+            pstIrk->index = i;
+            memcpy(pstIrk->aucIrk, irk, AES_KEY_SIZE);
+            AES_ExpandKey(pstIrk->aulRk, pstIrk->aucIrk);
+            bChanged = true;
+        }
+    }
+    if (bChanged || (cnt != f_irkCnt)) {
+        f_irkCnt = cnt;
+        memset(f_astCache, 0, sizeof(f_astCache));
+        LOG_INFO("RPA cache: %lu bonded IRKs\n", f_irkCnt);
+    }
+
+    memset(&f_stStat, 0, sizeof(f_stStat));
+    f_startMs = btstack_run_loop_get_time_ms();
+}
+
+/**
+ * @brief Log the resolution work of the scan and the core1 time it took.
+ */
+void RPAC_StopScan(void)
+{
+    ULONG elapsed_ms = btstack_run_loop_get_time_ms() - f_startMs;
+    ULONG busy_us = (ULONG)(f_stStat.cycles.sum / (clock_get_hz(clk_sys) / 1000000));
+
+    LOG_INFO("Scan %lu ms: reports %lu, RPAs %lu, cache hits %lu, ah %lu, bonded %lu\n",
+        elapsed_ms, f_stStat.report_cnt, f_stStat.rpa_cnt, f_stStat.hit_cnt, f_stStat.ah_cnt, f_stStat.match_cnt);
+    LOG_INFO("Scan: resolution cycles per report avg %lu max %lu, core1 %lu us (%lu per mille)\n",
+        (f_stStat.cycles.cnt > 0) ? (ULONG)(f_stStat.cycles.sum / f_stStat.cycles.cnt) : 0, f_stStat.cycles.max,
+        busy_us, (elapsed_ms > 0) ? busy_us / elapsed_ms : 0);
+}
+
+/**
+ * @brief Resolve the address of an advertising report (core1, while scanning).
+ *
+ * @param addr Address of the report
+ * @param addr_type Address type of the report
+ * @return Device DB index of the bonded device, or RPAC_NO_MATCH
+ */
+int RPAC_Resolve(const bd_addr_t addr, uint8_t addr_type)
+{
+    ULONG start = CMN_CycNow();
+    ST_RPAC_ENTRY *pstEntry;
+    int index = RPAC_NO_MATCH;
+    ULONG now;
+
+    f_stStat.report_cnt++;
+    // Random address with the two most significant bits 0b01
+    if ((addr_type == BD_ADDR_TYPE_LE_RANDOM) && ((addr[0] & 0xc0) == 0x40)) {
+        f_stStat.rpa_cnt++;
+        if (f_irkCnt > 0) {
+            now = btstack_run_loop_get_time_ms();
+            pstEntry = &f_astCache[rpac_slot(addr)];
+            if (pstEntry->bValid && (memcmp(pstEntry->addr, addr, sizeof(bd_addr_t)) == 0) &&
+                ((now - pstEntry->time_ms) < RPAC_TTL_MS)) {
+                f_stStat.hit_cnt++;
+                index = pstEntry->index;
+            }
+            else {
+                index = rpac_lookup(addr);
+                memcpy(pstEntry->addr, addr, sizeof(bd_addr_t));
+                pstEntry->bValid = true;
+                pstEntry->index = index;
+                pstEntry->time_ms = now;
+            }
+        }
+    }
+    if (index != RPAC_NO_MATCH) {
+        f_stStat.match_cnt++;
+    }
+    CMN_StatAdd(&f_stStat.cycles, CMN_CycSince(start));
+
+    return index;
+}
+
+/**
+ * @brief Find the bond of a known device among the IRKs taken by RPAC_StartScan (core1).
+ *
+ * @param addr Address the device was connected with: its identity address, or an RPA
+ * @param addr_type Address type
+ * @return Device DB index of the bond, or RPAC_NO_MATCH
+ */
+int RPAC_FindBond(const bd_addr_t addr, uint8_t addr_type)
+{
+    bd_addr_t db_addr;
+    int db_addr_type;
+    ULONG i;
+
+    if ((addr_type == BD_ADDR_TYPE_LE_RANDOM) && ((addr[0] & 0xc0) == 0x40)) {
+        return rpac_lookup(addr);
+    }
+    for (i = 0; i < f_irkCnt; i++) {
+        le_device_db_info(f_astIrk[i].index, &db_addr_type, db_addr, NULL);
+        if ((db_addr_type == addr_type) && (memcmp(db_addr, addr, sizeof(bd_addr_t)) == 0)) {
+            return f_astIrk[i].index;
+        }
+    }
+    return RPAC_NO_MATCH;
+}
+
+/**
+ * @brief Get the statistics of the current or last scan.
+ *
+ * @return Statistics
+ */
+const ST_RPAC_STAT* RPAC_GetStat(void)
+{
+    return &f_stStat;
+}
+
+#endif
@@ -0,0 +1,63 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef RPACACHE_H
+#define RPACACHE_H
+
+#include "btstack.h"
+#include "Common.h"
+
+// Resolution of the resolvable private addresses (RPA) seen while scanning (core1).
+// A bonded device that advertises with an RPA is only recognised by computing
+// ah(IRK, prand) for every bonded IRK (one AES block each, up to MAX_NR_LE_DEVICE_DB_ENTRIES).
+// In a crowded place most RPAs belong to other devices and repeat at every advertising
+// interval, so the result of each RPA (bond index or no match) is kept in a small
+// direct-mapped cache: a repeated address costs one lookup instead of the AES blocks.
+// Entries expire after RPAC_TTL_MS, the longest time a device keeps one RPA, and the whole
+// cache is dropped when the bonded IRKs change. The IRKs are copied from the device DB at
+// the start of each scan, so the TLV is not read per advertisement.
+// Only the bond of the stored HID device (RPAC_FindBond) may skip the HID service check of
+// the advertisement: the device DB may hold other bonds.
+
+// [Definitions]
+// Set to 0 to only connect to devices that advertise the HID service
+#ifndef RPAC_ENABLE
+#define RPAC_ENABLE 1
+#endif
+
+// Cached addresses (power of 2)
+#define RPAC_CACHE_SIZE 128
+
+// Lifetime of a cached result (RPA rotation: 15 min recommended by Core Vol 3 Part C Appendix A)
+#define RPAC_TTL_MS (15 * 60 * 1000) // ms
+
+// Bonded IRKs checked
+#define RPAC_IRK_MAX 16
+
+// Result of RPAC_Resolve when the address belongs to no bonded device
+#define RPAC_NO_MATCH (-1)
+
+// [Structures]
+// Statistics of the current scan
+typedef struct _ST_RPAC_STAT {
+    ULONG report_cnt;                   // Advertising reports checked
+    ULONG rpa_cnt;                      // Reports with an RPA
+    ULONG hit_cnt;                      // RPAs found in the cache
+    ULONG ah_cnt;                       // ah() computations (AES blocks)
+    ULONG match_cnt;                    // Reports of a bonded device
+    ST_CMN_STAT cycles;                 // RPAC_Resolve per report (cycles)
+} ST_RPAC_STAT;
+
+// [Function Prototypes]
+#if RPAC_ENABLE
+void RPAC_StartScan(void);
+void RPAC_StopScan(void);
+int RPAC_Resolve(const bd_addr_t addr, uint8_t addr_type);
+int RPAC_FindBond(const bd_addr_t addr, uint8_t addr_type);
+const ST_RPAC_STAT* RPAC_GetStat(void);
+#else
+#define RPAC_StartScan() ((void)0)
+#define RPAC_StopScan() ((void)0)
+#define RPAC_Resolve(addr, addr_type) ((void)(addr), (void)(addr_type), RPAC_NO_MATCH)
+#define RPAC_FindBond(addr, addr_type) ((void)(addr), (void)(addr_type), RPAC_NO_MATCH)
+#endif
+
+#endif
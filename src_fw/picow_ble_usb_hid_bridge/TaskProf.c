@@ -0,0 +1,260 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "TaskProf.h"
+#include "Log.h"
+#include "Diag.h"
+
+#if TPRF_ENABLE
+
+// [Definitions]
+#define TPRF_MAGIC 0x46525054 // 'TPRF'
+
+// [Structures]
+// Task being run
+typedef struct _ST_TPRF_FRAME {
+    ULONG task;                         // E_TPRF_TASK
+    ULONG cyc;                          // Start (CMN_CycNow)
+    ULONG us;                           // Start (time_us_32)
+    ULONG child;                        // Run time of the nested tasks (cycles)
+} ST_TPRF_FRAME;
+
+// State of a core
+typedef struct _ST_TPRF_CORE {
+    ULONG depth;                        // Tasks being run (may exceed TPRF_DEPTH_MAX)
+    ULONG loop_us;                      // Start of the current loop iteration (0 = none yet)
+    ST_TPRF_FRAME astFrame[TPRF_DEPTH_MAX];
+} ST_TPRF_CORE;
+
+// [File Scope Variables]
+static ST_TPRF_CORE f_astCore[TPRF_CORE_NUM] = {0};     // Written by its own core only
+static ST_TPRF_TASK f_astTask[TPRF_TASK_NUM] = {0};     // Written by the core running the task only
+static ST_TPRF_LOOP f_astLoop[TPRF_CORE_NUM] = {0};     // Written by its own core only
+static volatile ULONG f_overflowCnt = 0;                // Runs nested too deep
+static ULONG f_cycPerUs = 1;                            // SysTick cycles per microsecond
+static ULONG f_logUs = 0;                               // Time of the last load log (core0)
+static ULONG f_aulLogCyc[TPRF_TASK_NUM] = {0};          // Run time of each task at the last load log
+static ST_TPRF_IMAGE f_stImage = {0};                   // Profile being read
+
+// Load of a task since the last log, in per mille of the elapsed time
+static inline ULONG tprf_per_mille(ULONG task, uint64_t elapsedCyc)
+{
+    ULONG cyc = f_astTask[task].cyc - f_aulLogCyc[task];
+
+    f_aulLogCyc[task] = f_astTask[task].cyc;
+    return (ULONG)(((uint64_t)cyc * 1000) / elapsedCyc);
+}
+
+// Longest run of a task in us
+static inline ULONG tprf_max_us(ULONG task)
+{
+    return f_astTask[task].max / f_cycPerUs;
+}
+
+// Logs the load of both cores since the last log (core0)
+static void tprf_log(ULONG now)
+{
+    uint64_t elapsedCyc = (uint64_t)(now - f_logUs) * f_cycPerUs;
+    ULONG aulLoad[TPRF_TASK_NUM];
+    ULONG i;
+
+    f_logUs = now;
+    for (i = 0; i < TPRF_TASK_NUM; i++) {
+        aulLoad[i] = tprf_per_mille(i, elapsedCyc);
+    }
+    LOG_INFO("Load core0 (per mille): tud %lu, hid %lu, led %lu, misc %lu, crypto %lu, usb irq %lu\n",
+        aulLoad[TPRF_TASK_TUD], aulLoad[TPRF_TASK_HID], aulLoad[TPRF_TASK_LED], aulLoad[TPRF_TASK_MISC],
+        aulLoad[TPRF_TASK_CRYPTO], aulLoad[TPRF_TASK_USB_IRQ]);
+    LOG_INFO("Load core1 (per mille): hci %lu, sm %lu, gatt %lu, notify %lu, timer %lu, poll %lu, cyw43 irq %lu\n",
+        aulLoad[TPRF_TASK_BT_HCI], aulLoad[TPRF_TASK_BT_SM], aulLoad[TPRF_TASK_BT_GATT], aulLoad[TPRF_TASK_BT_NOTIFY],
+        aulLoad[TPRF_TASK_BT_TIMER], aulLoad[TPRF_TASK_BT_POLL], aulLoad[TPRF_TASK_CYW43_IRQ]);
+    LOG_INFO("Max run core0 (us): tud %lu, hid %lu, led %lu, misc %lu, crypto %lu, usb irq %lu, loop %lu\n",
+        tprf_max_us(TPRF_TASK_TUD), tprf_max_us(TPRF_TASK_HID), tprf_max_us(TPRF_TASK_LED), tprf_max_us(TPRF_TASK_MISC),
+        tprf_max_us(TPRF_TASK_CRYPTO), tprf_max_us(TPRF_TASK_USB_IRQ), f_astLoop[0].max_us);
+    LOG_INFO("Max run core1 (us): hci %lu, sm %lu, gatt %lu, notify %lu, timer %lu, poll %lu, cyw43 irq %lu\n",
+        tprf_max_us(TPRF_TASK_BT_HCI), tprf_max_us(TPRF_TASK_BT_SM), tprf_max_us(TPRF_TASK_BT_GATT),
+        tprf_max_us(TPRF_TASK_BT_NOTIFY), tprf_max_us(TPRF_TASK_BT_TIMER), tprf_max_us(TPRF_TASK_BT_POLL),
+        tprf_max_us(TPRF_TASK_CYW43_IRQ));
+}
+
+/**
+ * @brief Start a task on the calling core.
+ *
+ * @param task Task (E_TPRF_TASK). Every TPRF_Begin must be paired with a TPRF_End on the same core.
+ */
+void __time_critical_func(TPRF_Begin)(ULONG task)
+{
+    ST_TPRF_CORE *pstCore = &f_astCore[get_core_num()];
+    ST_TPRF_FRAME *pstFrame;
+    uint32_t irq = save_and_disable_interrupts();
+
+    if ((pstCore->depth < TPRF_DEPTH_MAX) && (task < TPRF_TASK_NUM)) {
+        pstFrame = &pstCore->astFrame[pstCore->depth];
+        pstFrame->task = task;
+        pstFrame->child = 0;
+        pstFrame->us = time_us_32();
+        pstFrame->cyc = CMN_CycNow();
+    }
+    else {
+        f_overflowCnt++;
+    }
+    pstCore->depth++;
+    restore_interrupts(irq);
+}
+
+/**
+ * @brief End the last task started on the calling core.
+ */
+void __time_critical_func(TPRF_End)(void)
+{
+    ST_TPRF_CORE *pstCore = &f_astCore[get_core_num()];
+    ST_TPRF_FRAME *pstFrame;
+    ST_TPRF_TASK *pstTask;
+    ULONG elapsed;
+    ULONG us;
+    uint32_t irq = save_and_disable_interrupts();
+
+    if (pstCore->depth == 0) {
+        restore_interrupts(irq);
+        return;
+    }
+    pstCore->depth--;
+    if (pstCore->depth >= TPRF_DEPTH_MAX) {
+        restore_interrupts(irq);
+        return;
+    }
+    pstFrame = &pstCore->astFrame[pstCore->depth];
+    elapsed = CMN_CycSince(pstFrame->cyc);
+    us = time_us_32() - pstFrame->us;
+    if (us >= TPRF_LONG_US) {
+        // The SysTick may have wrapped
+        elapsed = us * f_cycPerUs;
+    }
+
+    pstTask = &f_astTask[pstFrame->task];
+    pstTask->cnt++;
+    pstTask->cyc += (elapsed > pstFrame->child) ? (elapsed - pstFrame->child) : 0;
+    if (elapsed > pstTask->max) {
+        pstTask->max = elapsed;
+    }
+    if (pstCore->depth > 0) {
+        pstCore->astFrame[pstCore->depth - 1].child += elapsed;
+    }
+    restore_interrupts(irq);
+}
+
+/**
+ * @brief Mark the start of an iteration of the main loop of the calling core.
+ */
+void TPRF_Loop(void)
+{
+    ULONG core = get_core_num();
+    ST_TPRF_CORE *pstCore = &f_astCore[core];
+    ST_TPRF_LOOP *pstLoop = &f_astLoop[core];
+    ULONG now = time_us_32();
+    ULONG period;
+    ULONG bucket;
+
+    if (pstCore->loop_us != 0) {
+        period = now - pstCore->loop_us;
+        bucket = (period < 2) ? 0 : (31 - __builtin_clz(period));
+        if (bucket >= TPRF_HIST_NUM) {
+            bucket = TPRF_HIST_NUM - 1;
+        }
+        pstLoop->aulHist[bucket]++;
+        pstLoop->cnt++;
+        if (period > pstLoop->max_us) {
+            pstLoop->max_us = period;
+        }
+    }
+    pstCore->loop_us = (now != 0) ? now : 1;
+
+    if ((TPRF_LOG_MS > 0) && (core == 0) && ((ULONG)(now - f_logUs) >= (ULONG)TPRF_LOG_MS * 1000)) {
+        tprf_log(now);
+    }
+}
+
+// Diagnostics source: copies the profile and returns its size
+static ULONG tprf_open(void)
+{
+    f_stImage.magic = TPRF_MAGIC;
+    f_stImage.version = TPRF_VERSION;
+    f_stImage.task_num = TPRF_TASK_NUM;
+    f_stImage.hist_num = TPRF_HIST_NUM;
+    f_stImage.now_us = time_us_32();
+    f_stImage.cyc_per_us = f_cycPerUs;
+    f_stImage.overflow_cnt = f_overflowCnt;
+    memcpy(f_stImage.astTask, f_astTask, sizeof(f_stImage.astTask));
+    memcpy(f_stImage.astLoop, f_astLoop, sizeof(f_stImage.astLoop));
+
+    return sizeof(f_stImage);
+}
+
+// Diagnostics source: reads the profile
+static ULONG tprf_read(ULONG offset, UCHAR *pBuf, ULONG len)
+{
+    if (offset >= sizeof(f_stImage)) {
+        return 0;
+    }
+    if (len > sizeof(f_stImage) - offset) {
+        len = sizeof(f_stImage) - offset;
+    }
+    memcpy(pBuf, (const UCHAR *)&f_stImage + offset, len);
+
+    return len;
+}
+
+static const ST_DIAG_SOURCE f_stDiagSrc = {
+    &tprf_open,
+    &tprf_read,
+    NULL,
+};
+
+// USBCTRL_IRQ: first and last shared handlers (core0)
+static void __time_critical_func(tprf_usb_irq_enter)(void)
+{
+    TPRF_Begin(TPRF_TASK_USB_IRQ);
+}
+
+static void __time_critical_func(tprf_usb_irq_exit)(void)
+{
+    TPRF_End();
+}
+
+// IO_IRQ_BANK0: first and last shared handlers (core1)
+static void __time_critical_func(tprf_gpio_irq_enter)(void)
+{
+    TPRF_Begin(TPRF_TASK_CYW43_IRQ);
+}
+
+static void __time_critical_func(tprf_gpio_irq_exit)(void)
+{
+    TPRF_End();
+}
+
+/**
+ * @brief Initialize the profiler and time the USB IRQ (core0, after tud_init).
+ */
+void TPRF_Init(void)
+{
+    f_cycPerUs = clock_get_hz(clk_sys) / 1000000;
+    if (f_cycPerUs == 0) {
+        f_cycPerUs = 1;
+    }
+    f_logUs = time_us_32();
+    irq_add_shared_handler(USBCTRL_IRQ, &tprf_usb_irq_enter, PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY);
+    irq_add_shared_handler(USBCTRL_IRQ, &tprf_usb_irq_exit, PICO_SHARED_IRQ_HANDLER_LOWEST_ORDER_PRIORITY);
+    DIAG_RegisterSource(DIAG_SRC_PROF, &f_stDiagSrc);
+}
+
+/**
+ * @brief Time the CYW43 host wake IRQ (core1, after its handler has been added).
+ */
+void TPRF_InitCore1(void)
+{
+    irq_add_shared_handler(IO_IRQ_BANK0, &tprf_gpio_irq_enter, PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY);
+    irq_add_shared_handler(IO_IRQ_BANK0, &tprf_gpio_irq_exit, PICO_SHARED_IRQ_HANDLER_LOWEST_ORDER_PRIORITY);
+}
+
+#endif
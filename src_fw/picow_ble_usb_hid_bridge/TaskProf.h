@@ -0,0 +1,113 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef TASKPROF_H
+#define TASKPROF_H
+
+#include "Common.h"
+
+// Per-core task-time profiler.
+// The work of each core is split into tasks: the calls of the core0 main loop and the USB
+// IRQ on core0, the BTstack handlers of the bridge and the CYW43 host wake IRQ on core1.
+// TPRF_Begin/TPRF_End around a task add its run time to the task, less the time of the tasks
+// and IRQs nested in it, so the tasks of a core add up to the busy time of the core. The
+// IRQs are timed by shared handlers added before and after the other handlers of the IRQ.
+// Time is counted in SysTick cycles of the core (CMN_CycNow), in microseconds for a run
+// longer than the SysTick period. The counters are 32-bit and wrap: the load is the
+// difference of two snapshots taken less than 30 s apart (the TPRF_LOG_MS log, or
+// tools/bridge_diag.py load over the diagnostics interface, DIAG_SRC_PROF).
+// The period of the main loop of each core is kept in a log2 histogram. Core1 only has a
+// loop with the poll-mode CYW43 architecture; with the background one, BTstack and the CYW43
+// driver run from IRQs and only the bridge handlers are counted on core1.
+
+// [Definitions]
+// Set to 0 to remove the profiler at compile time
+#ifndef TPRF_ENABLE
+#define TPRF_ENABLE 1
+#endif
+
+// Profile format version
+#define TPRF_VERSION 1
+
+// Cores
+#define TPRF_CORE_NUM 2
+
+// Nested tasks per core (task, IRQ, IRQ of a higher priority)
+#define TPRF_DEPTH_MAX 4
+
+// Buckets of the loop period histogram: < 2 us, then [2^i, 2^(i+1)) us, the last one from 2048 us
+#define TPRF_HIST_NUM 12
+
+// A run longer than this is timed in microseconds (the 24-bit SysTick wraps after 134 ms at 125 MHz)
+#define TPRF_LONG_US 100000 // us
+
+// Period of the load log (core0), 0 for none
+#ifndef TPRF_LOG_MS
+#define TPRF_LOG_MS 10000 // ms
+#endif
+
+// [Enumerations]
+// Tasks (keep in sync with tools/bridge_diag.py)
+typedef enum _E_TPRF_TASK {
+    TPRF_TASK_TUD = 0,      // tud_task                                                core0
+    TPRF_TASK_HID,          // hid_task                                                core0
+    TPRF_TASK_LED,          // led_blinking_task                                       core0
+    TPRF_TASK_MISC,         // USB re-initialization, ACLF_Task, LOG_Drain, WDG_Feed    core0
+    TPRF_TASK_CRYPTO,       // CRYP_Task                                               core0
+    TPRF_TASK_USB_IRQ,      // USBCTRL_IRQ (TinyUSB)                                   core0
+    TPRF_TASK_BT_HCI,       // packet_handler (HCI and GAP events)                     core1
+    TPRF_TASK_BT_SM,        // sm_packet_handler                                       core1
+    TPRF_TASK_BT_GATT,      // handle_gatt_client_event (hids_client events)           core1
+    TPRF_TASK_BT_NOTIFY,    // Input reports queued from the notification (NotifyPath) core1
+    TPRF_TASK_BT_TIMER,     // Heartbeat and link timers                               core1
+    TPRF_TASK_BT_POLL,      // cyw43_arch_poll outside the handlers (poll mode)        core1
+    TPRF_TASK_CYW43_IRQ,    // IO_IRQ_BANK0 (CYW43 host wake)                          core1
+    TPRF_TASK_NUM
+} E_TPRF_TASK;
+
+#pragma pack(1)
+
+// [Structures]
+// Counters of a task
+typedef struct _ST_TPRF_TASK {
+    ULONG cnt;                          // Runs
+    ULONG cyc;                          // Run time without the nested tasks (cycles, wraps)
+    ULONG max;                          // Longest run, nested tasks included (cycles)
+} ST_TPRF_TASK;
+
+// Main loop of a core
+typedef struct _ST_TPRF_LOOP {
+    ULONG cnt;                          // Iterations
+    ULONG max_us;                       // Longest period (us)
+    ULONG aulHist[TPRF_HIST_NUM];       // Periods per bucket
+} ST_TPRF_LOOP;
+
+// Profile read over the diagnostics interface
+typedef struct _ST_TPRF_IMAGE {
+    ULONG magic;                        // 'TPRF'
+    USHORT version;                     // TPRF_VERSION
+    UCHAR task_num;                     // TPRF_TASK_NUM
+    UCHAR hist_num;                     // TPRF_HIST_NUM
+    ULONG now_us;                       // Time of the snapshot
+    ULONG cyc_per_us;                   // SysTick cycles per microsecond
+    ULONG overflow_cnt;                 // Runs not timed (nested deeper than TPRF_DEPTH_MAX)
+    ST_TPRF_TASK astTask[TPRF_TASK_NUM];
+    ST_TPRF_LOOP astLoop[TPRF_CORE_NUM];
+} ST_TPRF_IMAGE;
+
+#pragma pack()
+
+// [Function Prototypes]
+#if TPRF_ENABLE
+void TPRF_Init(void);
+void TPRF_InitCore1(void);
+void TPRF_Begin(ULONG task);
+void TPRF_End(void);
+void TPRF_Loop(void);
+#else
+#define TPRF_Init() ((void)0)
+#define TPRF_InitCore1() ((void)0)
+#define TPRF_Begin(task) ((void)(task))
+#define TPRF_End() ((void)0)
+#define TPRF_Loop() ((void)0)
+#endif
+
+#endif
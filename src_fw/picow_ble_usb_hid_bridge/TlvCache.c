@@ -0,0 +1,253 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "btstack.h"
+#include "TlvCache.h"
+#include "Log.h"
+#include "Watchdog.h"
+
+// Write-back cache in front of the BTstack flash TLV.
+// Reads are served from RAM after the first access and only changed values are written back.
+// Every flash write locks out core0 (flash_safe_execute), so writes are deferred
+// until the USB side reports that it is idle, or until TLVC_FLUSH_DEADLINE_MS has passed.
+// Values that must survive a power cut (the bond of the HID device) are written at once by
+// calling TLVC_Flush after storing them.
+// All functions run on core1 (BTstack context).
+
+// [Structures]
+// Cache entry
+typedef struct _ST_TLVC_ENTRY {
+    ULONG tag;                     // Tag (0 = unused entry)
+    ULONG len;                     // Value length (0 = tag does not exist)
+    bool  bDirty;                  // Value differs from flash
+    UCHAR data[TLVC_DATA_SIZE];    // Value
+} ST_TLVC_ENTRY;
+
+// [Function Prototypes]
+static int tlvc_get_tag(void *pCtx, uint32_t tag, uint8_t *pBuf, uint32_t size);
+static int tlvc_store_tag(void *pCtx, uint32_t tag, const uint8_t *pData, uint32_t size);
+static void tlvc_delete_tag(void *pCtx, uint32_t tag);
+
+// [File Scope Variables]
+static ST_TLVC_ENTRY f_astEntry[TLVC_ENTRY_MAX] = {0}; // Cache entries
+static ST_TLVC_STAT f_stStat = {0};                    // Statistics
+static const btstack_tlv_t *f_pTlvImpl = NULL;         // Flash TLV implementation
+static void *f_pTlvCtx = NULL;                         // Flash TLV context
+static bool (*f_pfnIsFlushAllowed)(void) = NULL;       // Returns true when flash may be written now
+static uint32_t f_dirtySinceMs = 0;                    // Time the oldest unwritten change was made
+static btstack_timer_source_t f_stFlushTimer;          // Flush timer
+static bool f_bTimerActive = false;                    // Flush timer is running
+
+// TLV interface of the cache
+static const btstack_tlv_t f_stTlvcImpl = {
+    &tlvc_get_tag,
+    &tlvc_store_tag,
+    &tlvc_delete_tag,
+};
+
+// Finds the entry for a tag
+static ST_TLVC_ENTRY* tlvc_find(uint32_t tag)
+{
+    ULONG i;
+
+    for (i = 0; i < TLVC_ENTRY_MAX; i++) {
+        if (f_astEntry[i].tag == tag) {
+            return &f_astEntry[i];
+        }
+    }
+    return NULL;
+}
+
+// Finds the entry for a tag, loading it from flash if it is not cached yet.
+// Returns NULL if the value does not fit into the cache.
+static ST_TLVC_ENTRY* tlvc_load(uint32_t tag)
+{
+    ST_TLVC_ENTRY *pstEntry = tlvc_find(tag);
+    int len;
+
+    if (pstEntry != NULL) {
+        return pstEntry;
+    }
+
+    // Check the stored size first
+    len = f_pTlvImpl->get_tag(f_pTlvCtx, tag, NULL, 0);
+    if ((len < 0) || (len > TLVC_DATA_SIZE)) {
+        return NULL;
+    }
+
+    pstEntry = tlvc_find(0); // Free entry
+    if (pstEntry == NULL) {
+        return NULL;
+    }
+
+    pstEntry->tag = tag;
+    pstEntry->bDirty = false;
+    pstEntry->len = (len > 0) ? (ULONG)f_pTlvImpl->get_tag(f_pTlvCtx, tag, pstEntry->data, TLVC_DATA_SIZE) : 0;
+    f_stStat.read_cnt++;
+
+    return pstEntry;
+}
+
+// Writes one dirty entry to flash and measures the core0 lockout
+static void tlvc_write_entry(ST_TLVC_ENTRY *pstEntry)
+{
+    uint32_t start_us = time_us_32();
+
+    WDG_Refresh();
+    if (pstEntry->len > 0) {
+        (void)f_pTlvImpl->store_tag(f_pTlvCtx, pstEntry->tag, pstEntry->data, pstEntry->len);
+    } else {
+        f_pTlvImpl->delete_tag(f_pTlvCtx, pstEntry->tag);
+    }
+    pstEntry->bDirty = false;
+
+    CMN_StatAdd(&f_stStat.lockout, time_us_32() - start_us);
+    LOG_INFO("TLV tag %08lx written, core0 lockout %lu us\n", pstEntry->tag, f_stStat.lockout.last);
+}
+
+// Returns true if any entry has not been written to flash
+static bool tlvc_is_dirty(void)
+{
+    ULONG i;
+
+    for (i = 0; i < TLVC_ENTRY_MAX; i++) {
+        if (f_astEntry[i].bDirty) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Flush timer: writes dirty entries when USB is idle or the deadline has passed
+static void tlvc_flush_timer_handler(btstack_timer_source_t *ts)
+{
+    bool bAllowed = f_pfnIsFlushAllowed();
+    bool bDeadline = (btstack_run_loop_get_time_ms() - f_dirtySinceMs) >= TLVC_FLUSH_DEADLINE_MS;
+
+    if (bAllowed || bDeadline) {
+        if (!bAllowed) {
+            f_stStat.deadline_cnt++;
+        }
+        TLVC_Flush();
+    }
+
+    if (tlvc_is_dirty()) {
+        btstack_run_loop_set_timer(ts, TLVC_FLUSH_POLL_MS);
+        btstack_run_loop_add_timer(ts);
+    } else {
+        f_bTimerActive = false;
+    }
+}
+
+// Marks an entry as changed and starts the flush timer
+static void tlvc_mark_dirty(ST_TLVC_ENTRY *pstEntry)
+{
+    if (!tlvc_is_dirty()) {
+        f_dirtySinceMs = btstack_run_loop_get_time_ms();
+    }
+    pstEntry->bDirty = true;
+
+    if (!f_bTimerActive) {
+        f_bTimerActive = true;
+        btstack_run_loop_set_timer_handler(&f_stFlushTimer, &tlvc_flush_timer_handler);
+        btstack_run_loop_set_timer(&f_stFlushTimer, TLVC_FLUSH_POLL_MS);
+        btstack_run_loop_add_timer(&f_stFlushTimer);
+    }
+}
+
+// btstack_tlv_t: get_tag
+static int tlvc_get_tag(void *pCtx, uint32_t tag, uint8_t *pBuf, uint32_t size)
+{
+    ST_TLVC_ENTRY *pstEntry = tlvc_load(tag);
+    (void)pCtx;
+
+    if (pstEntry == NULL) {
+        // Not cacheable, read through
+        return f_pTlvImpl->get_tag(f_pTlvCtx, tag, pBuf, size);
+    }
+    if ((pBuf != NULL) && (pstEntry->len > 0)) {
+        memcpy(pBuf, pstEntry->data, (pstEntry->len < size) ? pstEntry->len : size);
+    }
+    return (int)pstEntry->len;
+}
+
+// btstack_tlv_t: store_tag
+static int tlvc_store_tag(void *pCtx, uint32_t tag, const uint8_t *pData, uint32_t size)
+{
+    ST_TLVC_ENTRY *pstEntry = NULL;
+    (void)pCtx;
+
+    if ((size > 0) && (size <= TLVC_DATA_SIZE)) {
+        pstEntry = tlvc_load(tag);
+    }
+    if (pstEntry == NULL) {
+        // Not cacheable, write through
+        pstEntry = tlvc_find(tag);
+        if (pstEntry != NULL) {
+            pstEntry->tag = 0; // Drop the stale entry
+            pstEntry->bDirty = false;
+        }
+        return f_pTlvImpl->store_tag(f_pTlvCtx, tag, pData, size);
+    }
+
+    if ((pstEntry->len == size) && (memcmp(pstEntry->data, pData, size) == 0)) {
+        // Unchanged, nothing to write
+        f_stStat.skip_cnt++;
+        return 0;
+    }
+
+    memcpy(pstEntry->data, pData, size);
+    pstEntry->len = size;
+    tlvc_mark_dirty(pstEntry);
+
+    return 0;
+}
+
+// btstack_tlv_t: delete_tag
+static void tlvc_delete_tag(void *pCtx, uint32_t tag)
+{
+    ST_TLVC_ENTRY *pstEntry = tlvc_load(tag);
+    (void)pCtx;
+
+    if (pstEntry == NULL) {
+        f_pTlvImpl->delete_tag(f_pTlvCtx, tag);
+        return;
+    }
+    if (pstEntry->len == 0) {
+        // Already deleted
+        f_stStat.skip_cnt++;
+        return;
+    }
+
+    pstEntry->len = 0;
+    tlvc_mark_dirty(pstEntry);
+}
+
+// Writes all dirty entries to flash immediately (e.g. right after a bond is stored)
+void TLVC_Flush(void)
+{
+    ULONG i;
+
+    for (i = 0; i < TLVC_ENTRY_MAX; i++) {
+        if (f_astEntry[i].bDirty) {
+            tlvc_write_entry(&f_astEntry[i]);
+        }
+    }
+}
+
+// Returns the TLV cache statistics (read by the report path on both cores)
+const ST_TLVC_STAT* __time_critical_func(TLVC_GetStat)(void)
+{
+    return &f_stStat;
+}
+
+// Initializes the TLV cache and installs it as the BTstack TLV singleton.
+// pfnIsFlushAllowed is polled from core1 and should return true while USB is idle or suspended.
+void TLVC_Init(const btstack_tlv_t *pTlvImpl, void *pTlvCtx, bool (*pfnIsFlushAllowed)(void))
+{
+    memset(f_astEntry, 0, sizeof(f_astEntry));
+    memset(&f_stStat, 0, sizeof(f_stStat));
+    f_pTlvImpl = pTlvImpl;
+    f_pTlvCtx = pTlvCtx;
+    f_pfnIsFlushAllowed = pfnIsFlushAllowed;
+
+    btstack_tlv_set_instance(&f_stTlvcImpl, NULL);
+}
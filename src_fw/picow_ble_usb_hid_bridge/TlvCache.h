@@ -0,0 +1,35 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef TLVCACHE_H
+#define TLVCACHE_H
+
+#include "btstack_tlv.h"
+#include "Common.h"
+
+// [Definitions]
+// Number of tags held in the cache
+#define TLVC_ENTRY_MAX 4
+
+// Maximum value size held in the cache (larger values are written through)
+#define TLVC_DATA_SIZE 64
+
+// Interval for checking whether dirty values can be written to flash
+#define TLVC_FLUSH_POLL_MS 100 // ms
+
+// Dirty values are written even while USB is busy after this time
+#define TLVC_FLUSH_DEADLINE_MS 10000 // ms
+
+// [Structures]
+// TLV cache statistics
+typedef struct _ST_TLVC_STAT {
+    ULONG read_cnt;       // Number of values read from flash
+    ULONG skip_cnt;       // Number of stores skipped because the value was unchanged
+    ULONG deadline_cnt;   // Number of flushes forced by TLVC_FLUSH_DEADLINE_MS
+    ST_CMN_STAT lockout;  // Duration of each flash write (us). Core0 is locked out during this time.
+} ST_TLVC_STAT;
+
+// [Function Prototypes]
+void TLVC_Init(const btstack_tlv_t *pTlvImpl, void *pTlvCtx, bool (*pfnIsFlushAllowed)(void));
+void TLVC_Flush(void);
+const ST_TLVC_STAT* TLVC_GetStat(void);
+
+#endif
@@ -0,0 +1,177 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "tusb.h"
+#include "UsbSof.h"
+#include "Log.h"
+
+// [File Scope Variables]
+// Only used by core0 (scratch Y)
+static ST_USOF_STAT CMN_CORE0_DATA("usof") f_stStat = {0};           // Statistics
+static bool CMN_CORE0_DATA("usof") f_bAlign = USOF_ALIGN_DEFAULT;    // Align movement reports to the host poll
+static bool CMN_CORE0_DATA("usof") f_bSof = false;                   // An SOF has been seen
+static uint32_t CMN_CORE0_DATA("usof") f_sofUs = 0;                  // Time of the last SOF
+static uint32_t CMN_CORE0_DATA("usof") f_submitUs = 0;               // Time of the submission in flight
+static bool CMN_CORE0_DATA("usof") f_bInflight = false;              // A submission is in flight
+static bool CMN_CORE0_DATA("usof") f_bHeld = false;                  // The report at the head of the queue is being held
+static uint32_t CMN_CORE0_DATA("usof") f_phaseMin = UINT32_MAX;      // Minimum poll phase of the current window
+static ULONG CMN_CORE0_DATA("usof") f_phaseCnt = 0;                  // Completions in the current window
+static ULONG CMN_CORE0_DATA("usof") f_logCnt = 0;                    // Completions since the last log line
+
+// Returns the time since the last SOF, or UINT32_MAX if SOF tracking is lost
+static uint32_t __time_critical_func(usof_since_sof)(uint32_t now)
+{
+    if (!f_bSof || ((now - f_sofUs) > USOF_SOF_TIMEOUT_US)) {
+        return UINT32_MAX;
+    }
+    return (now - f_sofUs) % USOF_FRAME_US;
+}
+
+/**
+ * @brief Initialize the frame alignment and enable the SOF callback of TinyUSB.
+ */
+void USOF_Init(void)
+{
+    USOF_SetAlign(USOF_ALIGN_DEFAULT);
+    tud_sof_cb_enable(true);
+}
+
+/**
+ * @brief Enable or disable the alignment of movement reports and clear the statistics.
+ *
+ * @param bAlign true to hold and merge movement reports, false to send every report at once
+ */
+void USOF_SetAlign(bool bAlign)
+{
+    memset(&f_stStat, 0, sizeof(f_stStat));
+    f_bAlign = bAlign;
+    f_bHeld = false;
+    f_phaseMin = UINT32_MAX;
+    f_phaseCnt = 0;
+    f_logCnt = 0;
+}
+
+/**
+ * @brief Record the start of a frame (tud_sof_cb).
+ */
+void __time_critical_func(USOF_OnSof)(void)
+{
+    f_sofUs = time_us_32();
+    f_bSof = true;
+    f_stStat.sof_cnt++;
+}
+
+/**
+ * @brief Decide whether the report at the head of the queue is submitted now.
+ *
+ * @param pstHidRpt Report at the head of the queue. Reports queued behind it are merged in.
+ * @param pstMap    Compiled report map of the connected device (NULL = not available)
+ * @param pMergeCnt Number of queued reports merged into pstHidRpt (advance the queue by 1 + this)
+ * @return true to submit now, false to hold the report (it stays at the head of the queue)
+ */
+bool __time_critical_func(USOF_PrepareSubmit)(ST_HID_RPT *pstHidRpt, const ST_HRD_MAP *pstMap, ULONG *pMergeCnt)
+{
+    static ST_HID_RPT CMN_CORE0_RPT("usof") stNext; // Static to keep the report off the stack
+    const ST_HRD_REPORT *pstReport;
+    uint32_t now = time_us_32();
+    uint32_t since, to_poll;
+
+    *pMergeCnt = 0;
+    if (!f_bAlign || (pstMap == NULL)) {
+        return true;
+    }
+    pstReport = HRD_GetReport(pstMap, pstHidRpt->report_id);
+    if ((pstReport == NULL) || (pstReport->rel_cnt == 0)) {
+        return true;
+    }
+
+    // Hold a lone movement report until just before the next poll:
+    // movement that arrives meanwhile goes out with it
+    since = usof_since_sof(now);
+    if ((since != UINT32_MAX) && (f_stStat.poll_phase != 0) && (CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) == 1)) {
+        to_poll = (since < f_stStat.poll_phase) ? (f_stStat.poll_phase - since) : (USOF_FRAME_US + f_stStat.poll_phase - since);
+        if (to_poll > USOF_GUARD_US) {
+            f_bHeld = true;
+            return false;
+        }
+    }
+
+    while (CMN_PeekQueueAt(CMN_QUE_KIND_HID_RPT, *pMergeCnt + 1, &stNext) &&
+           (stNext.report_id == pstHidRpt->report_id) && (stNext.report_len == pstHidRpt->report_len) &&
+           HRD_MergeReport(pstMap, pstReport, pstHidRpt->report, stNext.report, pstHidRpt->report_len)) {
+        (*pMergeCnt)++;
+    }
+    return true;
+}
+
+/**
+ * @brief Record a submitted report.
+ *
+ * @param merge_cnt Number of queued reports merged into it
+ */
+void __time_critical_func(USOF_OnSubmit)(ULONG merge_cnt)
+{
+    uint32_t now = time_us_32();
+    uint32_t since = usof_since_sof(now);
+
+    if (since != UINT32_MAX) {
+        CMN_StatAdd(&f_stStat.submit_phase, since);
+    }
+    if (f_bHeld) {
+        f_bHeld = false;
+        f_stStat.hold_cnt++;
+    }
+    f_stStat.merge_cnt += merge_cnt;
+    f_submitUs = now;
+    f_bInflight = true;
+}
+
+/**
+ * @brief Record the completion of a transfer (the host poll) and update the poll phase.
+ */
+void __time_critical_func(USOF_OnComplete)(void)
+{
+    uint32_t now = time_us_32();
+    uint32_t since = usof_since_sof(now);
+    uint32_t wait;
+    ULONG bin;
+
+    if (!f_bInflight) {
+        return;
+    }
+    f_bInflight = false;
+    wait = now - f_submitUs;
+    bin = wait / USOF_HIST_BIN_US;
+    CMN_StatAdd(&f_stStat.submit_wait, wait);
+    f_stStat.aulWaitHist[(bin < USOF_HIST_BINS) ? bin : USOF_HIST_BINS - 1]++;
+
+    // The earliest completion after SOF of a window is the poll phase
+    if (since != UINT32_MAX) {
+        if (since < f_phaseMin) {
+            f_phaseMin = since;
+        }
+        if (++f_phaseCnt >= USOF_PHASE_WINDOW) {
+            f_stStat.poll_phase = (f_phaseMin > 0) ? f_phaseMin : 1;
+            f_phaseMin = UINT32_MAX;
+            f_phaseCnt = 0;
+        }
+    }
+
+    if (++f_logCnt >= USOF_LOG_CNT) {
+        f_logCnt = 0;
+        LOG_INFO("SOF: poll phase %lu us, submit phase avg %lu us, held %lu, merged %lu\n", f_stStat.poll_phase,
+            (ULONG)(f_stStat.submit_phase.cnt ? f_stStat.submit_phase.sum / f_stStat.submit_phase.cnt : 0),
+            f_stStat.hold_cnt, f_stStat.merge_cnt);
+        LOG_INFO("SOF: submit-to-poll %lu %lu %lu %lu %lu %lu %lu %lu (125 us bins)\n",
+            f_stStat.aulWaitHist[0], f_stStat.aulWaitHist[1], f_stStat.aulWaitHist[2], f_stStat.aulWaitHist[3],
+            f_stStat.aulWaitHist[4], f_stStat.aulWaitHist[5], f_stStat.aulWaitHist[6], f_stStat.aulWaitHist[7]);
+    }
+}
+
+/**
+ * @brief Get the statistics.
+ *
+ * @return Statistics
+ */
+const ST_USOF_STAT* USOF_GetStat(void)
+{
+    return &f_stStat;
+}
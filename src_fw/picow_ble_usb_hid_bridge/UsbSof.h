@@ -0,0 +1,65 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef USBSOF_H
+#define USBSOF_H
+
+#include "Common.h"
+#include "HidRptDesc.h"
+
+// Alignment of report submission to the USB frame (core0).
+// The host polls the interrupt endpoint once per frame at a fixed point after the SOF.
+// The SOF callback and the completion of each transfer give the phase of that poll.
+// A report that only carries movement is then held until just before the next poll,
+// and the movement that arrives meanwhile is merged into it (HRD_MergeReport) instead
+// of waiting a frame per report. Other reports are sent at once.
+// Until the phase is known, or without SOFs (suspend), every report is sent at once.
+
+// [Definitions]
+// Align movement reports to the host poll by default (USOF_SetAlign)
+#ifndef USOF_ALIGN_DEFAULT
+#define USOF_ALIGN_DEFAULT 1
+#endif
+
+// Full-speed frame
+#define USOF_FRAME_US 1000 // us
+
+// A held report is submitted this long before the predicted poll.
+// Covers the core0 loop period and the deferral of the USB events to tud_task.
+#ifndef USOF_GUARD_US
+#define USOF_GUARD_US 150 // us
+#endif
+
+// Completions per poll phase estimate (minimum of the window)
+#define USOF_PHASE_WINDOW 32
+
+// SOF tracking is lost if no SOF was seen for this long
+#define USOF_SOF_TIMEOUT_US 3000 // us
+
+// Histogram of the submit-to-completion time
+#define USOF_HIST_BINS   8
+#define USOF_HIST_BIN_US (USOF_FRAME_US / USOF_HIST_BINS) // The last bin also counts longer times
+
+// Completions between two log lines of the statistics
+#define USOF_LOG_CNT 1000
+
+// [Structures]
+// Statistics (cumulative since USOF_Init or USOF_SetAlign)
+typedef struct _ST_USOF_STAT {
+    ULONG sof_cnt;                      // SOF callbacks
+    ULONG poll_phase;                   // Estimated poll phase after SOF (us, 0 = unknown)
+    ST_CMN_STAT submit_phase;           // SOF-to-submit time (us)
+    ST_CMN_STAT submit_wait;            // Submit-to-completion time (us)
+    ULONG aulWaitHist[USOF_HIST_BINS];  // Histogram of submit_wait
+    ULONG hold_cnt;                     // Reports held for the poll
+    ULONG merge_cnt;                    // Reports merged into an earlier report
+} ST_USOF_STAT;
+
+// [Function Prototypes]
+void USOF_Init(void);
+void USOF_SetAlign(bool bAlign);
+void USOF_OnSof(void);
+bool USOF_PrepareSubmit(ST_HID_RPT *pstHidRpt, const ST_HRD_MAP *pstMap, ULONG *pMergeCnt);
+void USOF_OnSubmit(ULONG merge_cnt);
+void USOF_OnComplete(void);
+const ST_USOF_STAT* USOF_GetStat(void);
+
+#endif
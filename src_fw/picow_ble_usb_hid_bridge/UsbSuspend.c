@@ -0,0 +1,208 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "tusb.h"
+#include "UsbSuspend.h"
+#include "Log.h"
+
+// [File Scope Variables]
+static ST_USPD_STAT f_stStat = {0};              // Statistics
+static ST_HID_RPT CMN_CORE0_RPT("uspd") f_astHeld[USPD_HELD_MAX]; // Merged movement of each report ID, in order of arrival
+static volatile ULONG f_heldCnt = 0;             // Valid entries of f_astHeld
+static ULONG f_heldIdx = 0;                      // Next held report to send after the resume
+static volatile bool f_bSuspended = false;       // The host has suspended the bus (read by core1)
+static bool f_bWakeupEn = false;                 // The host allows remote wakeup
+static bool f_bWakeupSent = false;               // A remote wakeup was requested in this suspend
+static uint32_t f_suspendUs = 0;                 // Time of the suspend
+static uint32_t f_wakeupUs = 0;                  // Time of the last remote wakeup
+static uint32_t f_firstUs = 0;                   // Time of the first report in this suspend (0 = none)
+static ULONG f_wakeupCnt = 0;                    // Remote wakeups in this suspend
+
+// Copies the valid part of a report
+static void uspd_copy(ST_HID_RPT *pstDst, const ST_HID_RPT *pstSrc)
+{
+    pstDst->report_id = pstSrc->report_id;
+    pstDst->report_len = pstSrc->report_len;
+    memcpy(pstDst->report, pstSrc->report, pstSrc->report_len);
+}
+
+// Moves the held reports not sent yet to the start of the table
+static void uspd_compact(void)
+{
+    ULONG i;
+
+    if (f_heldIdx == 0) {
+        return;
+    }
+    for (i = f_heldIdx; i < f_heldCnt; i++) {
+        uspd_copy(&f_astHeld[i - f_heldIdx], &f_astHeld[i]);
+    }
+    f_heldCnt -= f_heldIdx;
+    f_heldIdx = 0;
+}
+
+/**
+ * @brief Enter the suspend mode (tud_suspend_cb).
+ *
+ * @param bRemoteWakeupEn true if the host allows remote wakeup
+ */
+void USPD_OnSuspend(bool bRemoteWakeupEn)
+{
+    f_bWakeupEn = bRemoteWakeupEn;
+    f_bWakeupSent = false;
+    f_suspendUs = time_us_32();
+    f_firstUs = 0;
+    f_wakeupCnt = 0;
+    f_stStat.suspend_cnt++;
+    f_bSuspended = true;
+}
+
+/**
+ * @brief Leave the suspend mode (tud_resume_cb) and measure the wakeup.
+ */
+void USPD_OnResume(void)
+{
+    ULONG latency;
+
+    f_bSuspended = false;
+    if (f_firstUs != 0) {
+        latency = time_us_32() - f_firstUs;
+        f_firstUs = 0;
+        CMN_StatAdd(&f_stStat.wake_latency, latency);
+        LOG_INFO("USB resumed %lu us after the first report (remote wakeups %lu, held reports %lu)\n",
+            latency, f_wakeupCnt, f_heldCnt - f_heldIdx);
+    }
+}
+
+/**
+ * @brief Merge the queued movement into the held reports and request a remote wakeup (core0 loop, while suspended).
+ *
+ * Only the reports HRD_MergeReport can merge are taken from the queue. The first other report
+ * (a key, a button or an absolute value change) stops the drain and stays in the queue with the
+ * ones behind it, so that none is lost; once the queue is full, the link backpressure (AclFlow.h)
+ * keeps the next ones on the BLE link.
+ *
+ * @param pstMap Report map of the connected device, or NULL (all reports then stay in the queue)
+ */
+void USPD_Collect(const ST_HRD_MAP *pstMap)
+{
+    static ST_HID_RPT stHidRpt; // Static to keep the report off the stack
+    const ST_HRD_REPORT *pstReport;
+    ST_HID_RPT *pstHeld;
+    uint32_t now = time_us_32();
+    bool bPending;
+    ULONG i;
+
+    uspd_compact();
+    while (CMN_PeekQueue(CMN_QUE_KIND_HID_RPT, &stHidRpt)) {
+        pstReport = (pstMap != NULL) ? HRD_GetReport(pstMap, stHidRpt.report_id) : NULL;
+        if ((pstReport == NULL) || (pstReport->rel_cnt == 0)) {
+            break;
+        }
+        for (i = 0; i < f_heldCnt; i++) {
+            if (f_astHeld[i].report_id == stHidRpt.report_id) {
+                break;
+            }
+        }
+        if (i < f_heldCnt) {
+            // Only the movement is summed; any other change waits in the queue
+            pstHeld = &f_astHeld[i];
+            if ((pstHeld->report_len != stHidRpt.report_len) ||
+                !HRD_MergeReport(pstMap, pstReport, pstHeld->report, stHidRpt.report, stHidRpt.report_len)) {
+                break;
+            }
+            f_stStat.collapse_cnt++;
+        }
+        else if (f_heldCnt < USPD_HELD_MAX) {
+            uspd_copy(&f_astHeld[f_heldCnt], &stHidRpt);
+            f_heldCnt++;
+        }
+        else {
+            // No room for another report ID: it waits in the queue
+            break;
+        }
+        CMN_AdvanceQueue(CMN_QUE_KIND_HID_RPT);
+    }
+    bPending = (f_heldCnt > 0) || (CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) > 0);
+    if (bPending && (f_firstUs == 0)) {
+        f_firstUs = (now != 0) ? now : 1;
+    }
+
+    // One remote wakeup once the bus has been idle long enough, repeated only if the host does not resume
+    if (bPending && f_bWakeupEn && ((now - f_suspendUs) >= USPD_WAKEUP_DELAY_US) &&
+        (!f_bWakeupSent || ((now - f_wakeupUs) >= (USPD_WAKEUP_RETRY_MS * 1000)))) {
+        (void)tud_remote_wakeup();
+        f_bWakeupSent = true;
+        f_wakeupUs = now;
+        f_wakeupCnt++;
+        f_stStat.wakeup_cnt++;
+    }
+}
+
+/**
+ * @brief Get the next held report to send after the resume.
+ *
+ * @return Held report, or NULL if all have been sent
+ */
+const ST_HID_RPT* __time_critical_func(USPD_PeekHeld)(void)
+{
+    return (f_heldIdx < f_heldCnt) ? &f_astHeld[f_heldIdx] : NULL;
+}
+
+/**
+ * @brief Remove the held report returned by USPD_PeekHeld once it has been sent.
+ */
+void __time_critical_func(USPD_AdvanceHeld)(void)
+{
+    if (++f_heldIdx >= f_heldCnt) {
+        f_heldIdx = 0;
+        f_heldCnt = 0;
+    }
+}
+
+/**
+ * @brief Get the number of held reports not sent yet.
+ *
+ * @return Number of held reports
+ */
+ULONG __time_critical_func(USPD_GetHeldCount)(void)
+{
+    return f_heldCnt - f_heldIdx;
+}
+
+/**
+ * @brief Drop the held reports and leave the suspend mode (USB unmount or re-initialization).
+ */
+void USPD_Clear(void)
+{
+    f_bSuspended = false;
+    f_firstUs = 0;
+    f_heldIdx = 0;
+    f_heldCnt = 0;
+}
+
+/**
+ * @brief Check if the USB host has suspended the bus (any core).
+ *
+ * @return true while suspended
+ */
+bool __time_critical_func(USPD_IsSuspended)(void)
+{
+    return f_bSuspended;
+}
+
+/**
+ * @brief Clear the statistics.
+ */
+void USPD_ClearStat(void)
+{
+    memset(&f_stStat, 0, sizeof(f_stStat));
+}
+
+/**
+ * @brief Get the statistics.
+ *
+ * @return Statistics
+ */
+const ST_USPD_STAT* USPD_GetStat(void)
+{
+    return &f_stStat;
+}
@@ -0,0 +1,51 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef USBSUSPEND_H
+#define USBSUSPEND_H
+
+#include "Common.h"
+#include "HidRptDesc.h"
+
+// Report handling while the USB host is suspended (core0).
+// The queued movement reports are drained into one held report per report ID, with the
+// movement of relative fields summed (HRD_MergeReport) while the other fields are unchanged.
+// A report that cannot be merged (key, button or absolute value change) stays in the queue
+// with the ones behind it, so that no input is lost; once the queue is full, the link
+// backpressure (ACLF_ENABLE) holds the next reports on the BLE link. One remote wakeup is requested,
+// repeated at most every USPD_WAKEUP_RETRY_MS while the bus stays suspended. After the
+// resume, the held reports are sent first as one short burst, then the queue.
+// The suspend state is also read by core1 (USPD_IsSuspended) to relax the BLE link.
+
+// [Definitions]
+// Report IDs held while suspended; reports of further IDs stay in the queue
+#ifndef USPD_HELD_MAX
+#define USPD_HELD_MAX 4
+#endif
+
+// Bus idle time before the first remote wakeup (USB 2.0 7.1.7.7: at least 5 ms after suspend)
+#define USPD_WAKEUP_DELAY_US 5000 // us
+
+// A remote wakeup is repeated while the host has not resumed after this long
+#define USPD_WAKEUP_RETRY_MS 1000 // ms
+
+// [Structures]
+// Statistics (cumulative since USPD_ClearStat)
+typedef struct _ST_USPD_STAT {
+    ULONG suspend_cnt;                  // Suspends
+    ULONG wakeup_cnt;                   // Remote wakeups requested
+    ULONG collapse_cnt;                 // Reports merged into a held report
+    ST_CMN_STAT wake_latency;           // First report while suspended to resume (us)
+} ST_USPD_STAT;
+
+// [Function Prototypes]
+void USPD_OnSuspend(bool bRemoteWakeupEn);
+void USPD_OnResume(void);
+void USPD_Collect(const ST_HRD_MAP *pstMap);
+const ST_HID_RPT* USPD_PeekHeld(void);
+void USPD_AdvanceHeld(void);
+ULONG USPD_GetHeldCount(void);
+void USPD_Clear(void);
+bool USPD_IsSuspended(void);
+void USPD_ClearStat(void);
+const ST_USPD_STAT* USPD_GetStat(void);
+
+#endif
@@ -0,0 +1,246 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "hardware/watchdog.h"
+#include "Watchdog.h"
+#include "Log.h"
+#include "FlightRec.h"
+
+#if WDG_ENABLE
+
+// [Definitions]
+#define WDG_SNAP_MAGIC 0x50414e53 // 'SNAP'
+
+// Watchdog scratch registers (4 to 7 are used by the SDK and the boot ROM)
+#define WDG_SCRATCH_STATE  0 // Magic, reset reason and USB attachment
+#define WDG_SCRATCH_UPTIME 1 // Uptime at the last feed (ms)
+
+// Fields of WDG_SCRATCH_STATE
+#define WDG_STATE_MAGIC        0x57440000 // 'WD'
+#define WDG_STATE_MAGIC_MASK   0xffff0000
+#define WDG_STATE_REASON_SHIFT 8
+#define WDG_STATE_REASON_MASK  0x0000ff00
+#define WDG_STATE_USB_MOUNTED  0x00000001
+
+// [Structures]
+// Connected device kept for a warm restart
+typedef struct _ST_WDG_SNAP {
+    ULONG magic;                        // WDG_SNAP_MAGIC if valid
+    ULONG crc;                          // CRC-32 from addr to the end of the report map
+    UCHAR addr[6];                      // BD address (BTstack byte order)
+    UCHAR addr_type;                    // BD address type
+    UCHAR reserved;
+    USHORT desc_len;                    // Report map length
+    ST_DEVI stDevi;                     // Device identity
+    UCHAR aucDesc[WDG_DESC_MAX];        // Report map
+} ST_WDG_SNAP;
+
+// [File Scope Variables]
+static ST_WDG_SNAP __uninitialized_ram(f_stSnap); // Connected device (core1), survives the reset
+static ST_WDG_SNAP f_stBoot;                      // Device restored at boot (read-only after WDG_Init)
+static volatile bool f_bWarmAddr = false;         // Core1 reconnects to the restored device
+static volatile bool f_bWarmUsb = false;          // The USB device presents the restored device
+static volatile bool f_bCore1Alive = false;       // Core1 has sent a heartbeat
+static volatile uint32_t f_core1Us = 0;           // Time of the last core1 heartbeat
+static volatile ULONG f_mountMs = 0;              // Uptime at the first USB mount (0 = not mounted yet)
+
+// Returns the CRC of a snapshot
+static ULONG wdg_snap_crc(const ST_WDG_SNAP *pstSnap)
+{
+    return CMN_Crc32(pstSnap->addr, (ULONG)(offsetof(ST_WDG_SNAP, aucDesc) - offsetof(ST_WDG_SNAP, addr)) + pstSnap->desc_len);
+}
+
+// Resets the chip through the watchdog, recording the reason for the next boot
+static void wdg_reset(ULONG reason)
+{
+    watchdog_hw->scratch[WDG_SCRATCH_STATE] = (watchdog_hw->scratch[WDG_SCRATCH_STATE] & ~WDG_STATE_REASON_MASK) |
+                                              (reason << WDG_STATE_REASON_SHIFT);
+    watchdog_hw->scratch[WDG_SCRATCH_UPTIME] = (ULONG)(time_us_64() / 1000);
+    watchdog_reboot(0, 0, 0);
+    for (;;) {
+        tight_loop_contents();
+    }
+}
+
+/**
+ * @brief Restore the connected device after a watchdog reset and start the watchdog (core0, before core1 starts).
+ */
+void WDG_Init(void)
+{
+    ULONG state = watchdog_hw->scratch[WDG_SCRATCH_STATE];
+    ULONG uptime = watchdog_hw->scratch[WDG_SCRATCH_UPTIME];
+    UCHAR aucData[5];
+
+    if (watchdog_caused_reboot() && ((state & WDG_STATE_MAGIC_MASK) == WDG_STATE_MAGIC)) {
+        if ((f_stSnap.magic == WDG_SNAP_MAGIC) && (f_stSnap.desc_len > 0) && (f_stSnap.desc_len <= WDG_DESC_MAX) &&
+            (wdg_snap_crc(&f_stSnap) == f_stSnap.crc)) {
+            f_stBoot = f_stSnap;
+            f_bWarmAddr = true;
+            // Present the device at once only if the USB host had it enumerated
+            f_bWarmUsb = ((state & WDG_STATE_USB_MOUNTED) != 0);
+        }
+        LOG_ERROR("Watchdog reset (reason %lu) at %lu ms: restored device %lu, USB %lu\n",
+            (state & WDG_STATE_REASON_MASK) >> WDG_STATE_REASON_SHIFT, uptime, (ULONG)f_bWarmAddr, (ULONG)f_bWarmUsb);
+        aucData[0] = (UCHAR)((state & WDG_STATE_REASON_MASK) >> WDG_STATE_REASON_SHIFT);
+        memcpy(&aucData[1], &uptime, sizeof(uptime));
+        FREC_Record(FREC_KIND_WDG_RESET, aucData, sizeof(aucData));
+    }
+    else {
+        f_stSnap.magic = 0;
+    }
+
+    // Unless core0 records another reason, a watchdog reset means that core0 stopped feeding it
+    watchdog_hw->scratch[WDG_SCRATCH_STATE] = WDG_STATE_MAGIC | (WDG_REASON_CORE0 << WDG_STATE_REASON_SHIFT);
+    watchdog_hw->scratch[WDG_SCRATCH_UPTIME] = 0;
+    f_core1Us = time_us_32();
+    watchdog_enable(WDG_TIMEOUT_MS, true);
+}
+
+/**
+ * @brief Feed the watchdog while core1 is alive (core0 main loop).
+ */
+void WDG_Feed(void)
+{
+    uint32_t last = f_core1Us; // Read before the current time: core1 may update it meanwhile
+    uint32_t now = time_us_32();
+    uint32_t timeout_us = f_bCore1Alive ? (WDG_CORE1_TIMEOUT_MS * 1000) : (WDG_CORE1_BOOT_TIMEOUT_MS * 1000);
+
+    if ((now - last) > timeout_us) {
+        wdg_reset(WDG_REASON_CORE1);
+    }
+    watchdog_hw->scratch[WDG_SCRATCH_UPTIME] = (ULONG)(time_us_64() / 1000);
+    watchdog_update();
+}
+
+/**
+ * @brief Record the USB attachment for a warm restart (tud_mount_cb / tud_umount_cb).
+ *
+ * @param bMounted true if the USB host has configured the device
+ */
+void WDG_SetUsbMounted(bool bMounted)
+{
+    if (bMounted) {
+        watchdog_hw->scratch[WDG_SCRATCH_STATE] |= WDG_STATE_USB_MOUNTED;
+        if (f_mountMs == 0) {
+            f_mountMs = (ULONG)(time_us_64() / 1000);
+        }
+    }
+    else {
+        watchdog_hw->scratch[WDG_SCRATCH_STATE] &= ~WDG_STATE_USB_MOUNTED;
+    }
+}
+
+/**
+ * @brief Get the device restored by a warm restart, until it has reconnected (core0, USB descriptors).
+ *
+ * @param pLen     Report map length
+ * @param ppstDevi Device identity
+ * @return Report map, or NULL if the USB device does not present a restored device
+ */
+const UCHAR* WDG_GetWarmDevice(USHORT *pLen, const ST_DEVI **ppstDevi)
+{
+    if (!f_bWarmUsb) {
+        return NULL;
+    }
+    *pLen = f_stBoot.desc_len;
+    *ppstDevi = &f_stBoot.stDevi;
+    return f_stBoot.aucDesc;
+}
+
+/**
+ * @brief Send the core1 heartbeat (BTstack timer, every WDG_HEARTBEAT_MS).
+ *
+ * @return true if the restored device did not reconnect in time and the USB device must
+ *         stop presenting it (re-enumerate)
+ */
+bool WDG_Heartbeat(void)
+{
+    f_core1Us = time_us_32();
+    f_bCore1Alive = true;
+
+    if (f_bWarmAddr && ((time_us_64() / 1000) >= WDG_WARM_TIMEOUT_MS)) {
+        LOG_INFO("Warm restart: device not back within %lu ms\n", WDG_WARM_TIMEOUT_MS);
+        f_bWarmAddr = false;
+        f_stSnap.magic = 0;
+        if (f_bWarmUsb) {
+            f_bWarmUsb = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Restart the watchdog count right before a flash write (core1).
+ *
+ * The write locks out core0, which cannot feed the watchdog until it is done.
+ */
+void WDG_Refresh(void)
+{
+    watchdog_update();
+}
+
+/**
+ * @brief Get the address of the device restored by a warm restart (core1, before connecting).
+ *
+ * @param pAddr     BD address
+ * @param pAddrType BD address type
+ * @return true until the device has reconnected or WDG_WARM_TIMEOUT_MS has passed
+ */
+bool WDG_GetWarmAddr(UCHAR *pAddr, UCHAR *pAddrType)
+{
+    if (!f_bWarmAddr) {
+        return false;
+    }
+    memcpy(pAddr, f_stBoot.addr, sizeof(f_stBoot.addr));
+    *pAddrType = f_stBoot.addr_type;
+    return true;
+}
+
+/**
+ * @brief Keep the connected device for a warm restart (core1, when the BLE application state becomes READY).
+ *
+ * @param pAddr     BD address
+ * @param addr_type BD address type
+ * @param pDesc     Report map
+ * @param len       Report map length
+ * @return true if the USB device already presents this device (restored by a warm restart),
+ *         false if it must re-enumerate
+ */
+bool WDG_SaveDevice(const UCHAR *pAddr, UCHAR addr_type, const UCHAR *pDesc, ULONG len)
+{
+    bool bPresented = false;
+
+    f_stSnap.magic = 0;
+    if ((pDesc == NULL) || (len == 0) || (len > WDG_DESC_MAX)) {
+        LOG_ERROR("Warm restart: report map of %lu bytes not kept\n", len);
+    }
+    else {
+        memcpy(f_stSnap.addr, pAddr, sizeof(f_stSnap.addr));
+        f_stSnap.addr_type = addr_type;
+        f_stSnap.reserved = 0;
+        f_stSnap.desc_len = (USHORT)len;
+        f_stSnap.stDevi = *DEVI_Get();
+        memcpy(f_stSnap.aucDesc, pDesc, len);
+        f_stSnap.crc = wdg_snap_crc(&f_stSnap);
+        f_stSnap.magic = WDG_SNAP_MAGIC;
+    }
+
+    if (f_bWarmAddr) {
+        f_bWarmAddr = false;
+        bPresented = f_bWarmUsb && (f_stSnap.magic == WDG_SNAP_MAGIC) && (f_stSnap.crc == f_stBoot.crc) &&
+                     (memcmp(f_stSnap.addr, f_stBoot.addr, offsetof(ST_WDG_SNAP, aucDesc) - offsetof(ST_WDG_SNAP, addr) + len) == 0);
+        f_bWarmUsb = false;
+        LOG_INFO("Warm restart: USB mounted at %lu ms, READY at %lu ms, re-enumeration skipped %lu\n",
+            f_mountMs, (ULONG)(time_us_64() / 1000), (ULONG)bPresented);
+    }
+    return bPresented;
+}
+
+/**
+ * @brief Forget the connected device (core1, on disconnection).
+ */
+void WDG_ClearDevice(void)
+{
+    f_stSnap.magic = 0;
+}
+
+#endif
@@ -0,0 +1,83 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "Common.h"
+#include "DevInfo.h"
+
+// Hardware watchdog supervisor and warm restart.
+// Core0 feeds the watchdog from its main loop (WDG_Feed) only while core1 sends heartbeats
+// from a BTstack timer (WDG_Heartbeat). If core1 stops (BTstack assert, stuck CYW43 bus),
+// core0 resets the chip; if core0 stops, the watchdog does.
+// The connected device (BD address, report map, identity) is kept in uninitialized RAM and
+// the USB attachment in the watchdog scratch registers, which both survive the reset.
+// After it, the USB device enumerates at once with the restored descriptors and core1
+// reconnects to the restored address. If the device comes back unchanged, the USB
+// re-enumeration at READY is skipped.
+// A watchdog reset always resets the USB controller: the host sees the device detach and
+// enumerates it again at boot. Only the second enumeration (at READY) can be avoided, so
+// "no re-enumeration" is approximated by one enumeration that already presents the device.
+// Long work is fed around rather than covered by the timeouts: the crypto offload runs in
+// steps between the feeds (CryptoOffload.h), and core1 restarts the count right before each
+// flash write (WDG_Refresh), which locks out core0.
+
+// [Definitions]
+// Set to 0 to build without the watchdog
+#ifndef WDG_ENABLE
+#define WDG_ENABLE 1
+#endif
+
+// Hardware watchdog timeout. Must cover the core0 lockout of one TLV write after WDG_Refresh:
+// a 4 KB sector erase (400 ms max for the W25Q16JV) and the page programs of a flash bank
+// migration (TlvCache.h logs each "core0 lockout").
+#define WDG_TIMEOUT_MS 1000 // ms
+
+// Period of the core1 heartbeat
+#define WDG_HEARTBEAT_MS 100 // ms
+
+// Core1 is stalled if no heartbeat was seen for this long. Must cover the longest run of
+// BTstack on core1: without the crypto offload (the default), micro-ecc computes the P-256
+// key pair and the DHKey there in one call each, a few hundred ms apiece on the M0+, and a
+// first pairing may run both back to back ("Max run core1 (us): ... sm" of TaskProf.h).
+#define WDG_CORE1_TIMEOUT_MS 3000 // ms
+
+// Time for core1 to send its first heartbeat (CYW43 firmware load, BTstack start)
+#define WDG_CORE1_BOOT_TIMEOUT_MS 5000 // ms
+
+// After a warm restart, time the USB device keeps the restored descriptors for the device to reconnect
+#define WDG_WARM_TIMEOUT_MS 10000 // ms
+
+// Maximum report map length kept for a warm restart (hids_client descriptor storage)
+#define WDG_DESC_MAX 500
+
+// Reset reasons
+#define WDG_REASON_NONE  0 // Power-on or other reset
+#define WDG_REASON_CORE0 1 // The watchdog expired (core0 stopped feeding it)
+#define WDG_REASON_CORE1 2 // Core1 heartbeat lost
+
+// [Function Prototypes]
+#if WDG_ENABLE
+// Core0
+void WDG_Init(void);
+void WDG_Feed(void);
+void WDG_SetUsbMounted(bool bMounted);
+const UCHAR* WDG_GetWarmDevice(USHORT *pLen, const ST_DEVI **ppstDevi);
+// Core1
+bool WDG_Heartbeat(void);
+void WDG_Refresh(void);
+bool WDG_GetWarmAddr(UCHAR *pAddr, UCHAR *pAddrType);
+bool WDG_SaveDevice(const UCHAR *pAddr, UCHAR addr_type, const UCHAR *pDesc, ULONG len);
+void WDG_ClearDevice(void);
+#else
+#define WDG_Init() ((void)0)
+#define WDG_Feed() ((void)0)
+#define WDG_SetUsbMounted(bMounted) ((void)(bMounted))
+#define WDG_GetWarmDevice(pLen, ppstDevi) ((void)(pLen), (void)(ppstDevi), (const UCHAR *)NULL)
+#define WDG_Heartbeat() (false)
+#define WDG_Refresh() ((void)0)
+#define WDG_GetWarmAddr(pAddr, pAddrType) ((void)(pAddr), (void)(pAddrType), false)
+#define WDG_SaveDevice(pAddr, addr_type, pDesc, len) ((void)(pAddr), (void)(addr_type), (void)(pDesc), (void)(len), false)
+#define WDG_ClearDevice() ((void)0)
+#endif
+
+#endif
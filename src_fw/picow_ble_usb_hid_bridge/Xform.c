@@ -0,0 +1,256 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "Xform.h"
+#include "Log.h"
+
+#if XFM_ENABLE
+
+// [Definitions]
+#define XFM_OFF_NONE 0xFFFF // No field at this offset
+
+// HID usages
+#define XFM_PAGE_DESKTOP  0x01
+#define XFM_PAGE_KEYBOARD 0x07
+#define XFM_USAGE_X       0x30
+#define XFM_USAGE_Y       0x31
+#define XFM_USAGE_WHEEL   0x38
+#define XFM_USAGE_LCTRL   0xE0
+
+// [Structures]
+// Pointer element to scale
+typedef struct _ST_XFM_PTR {
+    const ST_HRD_FIELD *pstField; // Field in the compiled report map
+    UCHAR index;                  // Element of the field
+    UCHAR axis;                   // E_XFM_AXIS
+} ST_XFM_PTR;
+
+// Transform plan of one report
+typedef struct _ST_XFM_PLAN {
+    uint16_t mod_off;                  // Byte offset of the modifier byte (XFM_OFF_NONE = none)
+    uint16_t key_off;                  // Byte offset of the first key code
+    UCHAR key_cnt;                     // Number of key codes (0 = none)
+    UCHAR ptr_cnt;                     // Number of pointer elements
+    ST_XFM_PTR astPtr[XFM_PTR_MAX];    // Pointer elements
+} ST_XFM_PLAN;
+
+// [File Scope Variables]
+static UCHAR f_aucKeyMap[256];                       // Key code -> key code
+static UCHAR f_aucModMap[256];                       // Modifier byte -> modifier byte
+static int16_t f_asGain[XFM_AXIS_NUM];               // Pointer gain (8.8 fixed point)
+static int32_t f_alResidual[XFM_AXIS_NUM];           // Fraction carried to the next report (8.8)
+static bool f_bKey = false;                          // Key map is not the identity
+static bool f_bMod = false;                          // Modifier map is not the identity
+static bool f_bPtr = false;                          // A gain is not 1.0
+static const ST_HRD_MAP *f_pstMap = NULL;            // Compiled report map of the connection
+static ST_XFM_PLAN f_astPlan[HRD_REPORT_MAX];        // Plan per report (index of ST_HRD_MAP.astReport)
+
+/**
+ * @brief Expand the configuration blob into the lookup tables.
+ *
+ * @param pCfg Configuration blob (flash)
+ * @param size Size of the area holding the blob
+ * @return true if a valid blob was loaded. Otherwise all transforms are disabled.
+ */
+bool XFM_Init(const UCHAR *pCfg, ULONG size)
+{
+    ST_XFM_CFG_HDR stHdr;
+    const UCHAR *pEntry;
+    ULONG pos, end, type, len, i;
+    UCHAR mod_bit[8];
+
+    // Identity tables
+    for (i = 0; i < 256; i++) {
+        f_aucKeyMap[i] = (UCHAR)i;
+        f_aucModMap[i] = (UCHAR)i;
+    }
+    for (i = 0; i < XFM_AXIS_NUM; i++) {
+        f_asGain[i] = XFM_GAIN_ONE;
+        f_alResidual[i] = 0;
+    }
+    for (i = 0; i < 8; i++) {
+        mod_bit[i] = (UCHAR)i;
+    }
+    f_bKey = f_bMod = f_bPtr = false;
+
+    memcpy(&stHdr, pCfg, sizeof(stHdr));
+    if ((stHdr.magic != XFM_CFG_MAGIC) || (stHdr.version != XFM_CFG_VERSION) ||
+        (stHdr.size < sizeof(stHdr)) || (stHdr.size > size)) {
+        LOG_INFO("Transform: no configuration\n");
+        return false;
+    }
+    pEntry = pCfg + sizeof(stHdr);
+    end = stHdr.size - sizeof(stHdr);
+    if (CMN_Crc32(pEntry, end) != stHdr.crc) {
+        LOG_ERROR("Transform: configuration CRC error\n");
+        return false;
+    }
+
+    for (pos = 0; pos + 2 <= end; pos += 2 + len) {
+        type = pEntry[pos];
+        len = pEntry[pos + 1];
+        if ((type == XFM_CFG_END) || (pos + 2 + len > end)) {
+            break;
+        }
+        switch (type) {
+        case XFM_CFG_KEY_MAP:
+            for (i = 0; i + 1 < len; i += 2) {
+                f_aucKeyMap[pEntry[pos + 2 + i]] = pEntry[pos + 3 + i];
+                f_bKey = true;
+            }
+            break;
+        case XFM_CFG_MOD_MAP:
+            for (i = 0; i + 1 < len; i += 2) {
+                mod_bit[pEntry[pos + 2 + i] & 7] = pEntry[pos + 3 + i] & 7;
+                f_bMod = true;
+            }
+            break;
+        case XFM_CFG_PTR_GAIN:
+            for (i = 0; (i < XFM_AXIS_NUM) && (2 * i + 1 < len); i++) {
+                f_asGain[i] = (int16_t)(pEntry[pos + 2 + 2 * i] | (pEntry[pos + 3 + 2 * i] << 8));
+                f_bPtr |= (f_asGain[i] != XFM_GAIN_ONE);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Modifier byte table: move every bit to its target bit
+    if (f_bMod) {
+        for (i = 0; i < 256; i++) {
+            f_aucModMap[i] = 0;
+            for (pos = 0; pos < 8; pos++) {
+                if (i & (1u << pos)) {
+                    f_aucModMap[i] |= (UCHAR)(1u << mod_bit[pos]);
+                }
+            }
+        }
+    }
+
+    LOG_INFO("Transform: key map %lu, modifier map %lu, gain %lu/%lu/%lu (256 = 1.0)\n",
+        (ULONG)f_bKey, (ULONG)f_bMod, (ULONG)f_asGain[XFM_AXIS_X], (ULONG)f_asGain[XFM_AXIS_Y], (ULONG)f_asGain[XFM_AXIS_WHEEL]);
+    return true;
+}
+
+// Returns the pointer axis of a field element, or XFM_AXIS_NUM.
+// Elements of a Usage list are assumed consecutive except the last one (X, Y, Wheel).
+static ULONG xfm_get_axis(const ST_HRD_FIELD *pstField, ULONG index)
+{
+    ULONG usage = (index + 1 == pstField->count) ? pstField->usage_max : (ULONG)pstField->usage_min + index;
+
+    switch (usage) {
+    case XFM_USAGE_X:
+        return XFM_AXIS_X;
+    case XFM_USAGE_Y:
+        return XFM_AXIS_Y;
+    case XFM_USAGE_WHEEL:
+        return XFM_AXIS_WHEEL;
+    default:
+        return XFM_AXIS_NUM;
+    }
+}
+
+/**
+ * @brief Compile the transform plan of each report of the connected device.
+ *
+ * @param pstMap Compiled report map. Must stay unchanged until the next call.
+ */
+void XFM_Compile(const ST_HRD_MAP *pstMap)
+{
+    const ST_HRD_REPORT *pstReport;
+    const ST_HRD_FIELD *pstField;
+    ST_XFM_PLAN *pstPlan;
+    ULONG axis, i, j, k;
+
+    f_pstMap = pstMap->bValid ? pstMap : NULL;
+    for (i = 0; i < XFM_AXIS_NUM; i++) {
+        f_alResidual[i] = 0;
+    }
+    for (i = 0; i < pstMap->report_cnt; i++) {
+        pstReport = &pstMap->astReport[i];
+        pstPlan = &f_astPlan[i];
+        memset(pstPlan, 0, sizeof(ST_XFM_PLAN));
+        pstPlan->mod_off = XFM_OFF_NONE;
+
+        for (j = 0; j < pstReport->field_cnt; j++) {
+            pstField = &pstMap->astField[pstReport->field_idx + j];
+
+            if (pstField->usage_page == XFM_PAGE_KEYBOARD) {
+                if ((pstField->bit_off & 7) || (pstField->bit_size != (pstField->flags & HRD_FIELD_VARIABLE ? 1 : 8))) {
+                    continue;
+                }
+                if ((pstField->flags & HRD_FIELD_VARIABLE) && (pstField->count == 8) && (pstField->usage_min == XFM_USAGE_LCTRL)) {
+                    pstPlan->mod_off = pstField->bit_off / 8;
+                }
+                else if (!(pstField->flags & HRD_FIELD_VARIABLE) && (pstField->usage_min == 0) && (pstPlan->key_cnt == 0)) {
+                    pstPlan->key_off = pstField->bit_off / 8;
+                    pstPlan->key_cnt = (UCHAR)((pstField->count < XFM_KEY_MAX) ? pstField->count : XFM_KEY_MAX);
+                }
+            }
+            else if ((pstField->usage_page == XFM_PAGE_DESKTOP) &&
+                     ((pstField->flags & (HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE)) == (HRD_FIELD_VARIABLE | HRD_FIELD_RELATIVE))) {
+                for (k = 0; (k < pstField->count) && (pstPlan->ptr_cnt < XFM_PTR_MAX); k++) {
+                    axis = xfm_get_axis(pstField, k);
+                    if (axis < XFM_AXIS_NUM) {
+                        pstPlan->astPtr[pstPlan->ptr_cnt].pstField = pstField;
+                        pstPlan->astPtr[pstPlan->ptr_cnt].index = (UCHAR)k;
+                        pstPlan->astPtr[pstPlan->ptr_cnt].axis = (UCHAR)axis;
+                        pstPlan->ptr_cnt++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Transform a report in place.
+ *
+ * @param pstHidRpt Report checked against the compiled map (report ID of the map, data without the ID)
+ */
+void __time_critical_func(XFM_Apply)(ST_HID_RPT *pstHidRpt)
+{
+    const ST_HRD_REPORT *pstReport;
+    const ST_XFM_PLAN *pstPlan;
+    const ST_XFM_PTR *pstPtr;
+    UCHAR *pData = pstHidRpt->report;
+    int32_t value, scaled;
+    int64_t acc;
+    ULONG i;
+
+    if ((f_pstMap == NULL) || !(f_bKey || f_bMod || f_bPtr)) {
+        return;
+    }
+    pstReport = HRD_GetReport(f_pstMap, pstHidRpt->report_id);
+    if (pstReport == NULL) {
+        return;
+    }
+    pstPlan = &f_astPlan[pstReport - f_pstMap->astReport];
+
+    if (f_bMod && (pstPlan->mod_off < pstHidRpt->report_len)) {
+        pData[pstPlan->mod_off] = f_aucModMap[pData[pstPlan->mod_off]];
+    }
+    if (f_bKey) {
+        for (i = 0; (i < pstPlan->key_cnt) && (pstPlan->key_off + i < pstHidRpt->report_len); i++) {
+            pData[pstPlan->key_off + i] = f_aucKeyMap[pData[pstPlan->key_off + i]];
+        }
+    }
+    if (f_bPtr) {
+        for (i = 0; i < pstPlan->ptr_cnt; i++) {
+            pstPtr = &pstPlan->astPtr[i];
+            value = HRD_GetFieldValue(pstPtr->pstField, pData, pstHidRpt->report_len, pstPtr->index);
+            // Fixed-point gain; the fraction is carried so slow movements are not lost
+            acc = (int64_t)value * f_asGain[pstPtr->axis] + f_alResidual[pstPtr->axis];
+            scaled = (int32_t)(acc >> 8);
+            f_alResidual[pstPtr->axis] = (int32_t)(acc - (int64_t)scaled * 256);
+            if (scaled < pstPtr->pstField->logical_min) {
+                scaled = pstPtr->pstField->logical_min;
+            }
+            else if (scaled > pstPtr->pstField->logical_max) {
+                scaled = pstPtr->pstField->logical_max;
+            }
+            HRD_SetFieldValue(pstPtr->pstField, pData, pstHidRpt->report_len, pstPtr->index, scaled);
+        }
+    }
+}
+
+#endif
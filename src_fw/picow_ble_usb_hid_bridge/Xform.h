@@ -0,0 +1,91 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef XFORM_H
+#define XFORM_H
+
+#include "Common.h"
+#include "HidRptDesc.h"
+#if XFM_ENABLE
+#include "pico/btstack_flash_bank.h"
+#endif
+
+// Report transform stage (key remapping, modifier swap, pointer gain).
+// A configuration blob in flash is expanded at boot into lookup tables, and the
+// report map is compiled once per connection into a per-report plan of the byte
+// offsets to rewrite. XFM_Apply then only does table lookups and fixed-point
+// multiplies on the fields of the plan: no allocation, no descriptor parsing,
+// and a bounded amount of work per report (XFM_KEY_MAX + XFM_PTR_MAX elements).
+// Runs on core1 between hid_handle_input_report and the report queue.
+//
+// Supported report layouts:
+//   modifier byte : Keyboard page, 8 x 1 bit variable, usages 0xE0-0xE7, byte aligned
+//   key codes     : Keyboard page, 8 bit array starting at usage 0, byte aligned
+//   pointer       : Generic Desktop X, Y, Wheel, relative variable (any size up to 32 bits)
+// Bitmap (NKRO) keyboards are passed through unchanged.
+
+// [Definitions]
+// Set to 1 to build the transform stage (BRIDGE_XFORM in CMakeLists.txt)
+#ifndef XFM_ENABLE
+#define XFM_ENABLE 0
+#endif
+
+// Configuration blob: the flash sector below the BTstack flash bank.
+// Written with tools/xform_cfg.py. Erased flash (no valid blob) disables all transforms.
+#define XFM_CFG_SIZE 4096
+#ifndef XFM_CFG_ADDR
+#define XFM_CFG_ADDR ((const UCHAR *)(XIP_BASE + PICO_FLASH_BANK_STORAGE_OFFSET - XFM_CFG_SIZE))
+#endif
+
+// Blob header
+#define XFM_CFG_MAGIC   0x434D4658 // 'XFMC'
+#define XFM_CFG_VERSION 1
+
+// Maximum number of key codes and pointer elements rewritten in one report
+#define XFM_KEY_MAX 32
+#define XFM_PTR_MAX 4
+
+// Gain of 1.0 in 8.8 fixed point
+#define XFM_GAIN_ONE 256
+
+// [Enumerations]
+// Blob entry types (keep in sync with tools/xform_cfg.py)
+typedef enum _E_XFM_CFG_TYPE {
+    XFM_CFG_END = 0,       // End of entries
+    XFM_CFG_KEY_MAP,       // Pairs of [from key code][to key code]
+    XFM_CFG_MOD_MAP,       // Pairs of [from modifier bit][to modifier bit] (0 = Left Ctrl ... 7 = Right GUI)
+    XFM_CFG_PTR_GAIN,      // [X gain (s16)][Y gain (s16)][wheel gain (s16)], 8.8 fixed point
+    XFM_CFG_TYPE_NUM
+} E_XFM_CFG_TYPE;
+
+// Pointer axes
+typedef enum _E_XFM_AXIS {
+    XFM_AXIS_X = 0,
+    XFM_AXIS_Y,
+    XFM_AXIS_WHEEL,
+    XFM_AXIS_NUM
+} E_XFM_AXIS;
+
+#pragma pack(1)
+
+// [Structures]
+// Blob header. Followed by entries of [type][len][data], up to size bytes in total.
+typedef struct _ST_XFM_CFG_HDR {
+    ULONG magic;           // XFM_CFG_MAGIC
+    USHORT version;        // XFM_CFG_VERSION
+    USHORT size;           // Size of the blob including the header
+    ULONG crc;             // CRC-32 of the entries (size - sizeof(ST_XFM_CFG_HDR) bytes)
+} ST_XFM_CFG_HDR;
+
+#pragma pack()
+
+// [Function Prototypes]
+#if XFM_ENABLE
+bool XFM_Init(const UCHAR *pCfg, ULONG size);
+void XFM_Compile(const ST_HRD_MAP *pstMap);
+void XFM_Apply(ST_HID_RPT *pstHidRpt);
+#else
+#define XFM_Init(pCfg, size)  (false)
+#define XFM_Compile(pstMap)   ((void)(pstMap))
+#define XFM_Apply(pstHidRpt)  ((void)(pstHidRpt))
+#endif
+
+#endif
@@ -2,10 +2,19 @@
 #define _PICO_BTSTACK_BTSTACK_CONFIG_H
 
 // BTstack features that can be enabled
-#define ENABLE_LOG_INFO
+// The BTstack info log and hexdumps are written with blocking printf on core1 for every packet
+// and would interleave with the deferred log (Log.h) drained on core0 in the middle of a line.
+// Build with BTSTACK_LOG=1 (BRIDGE_BTSTACK_LOG) only to debug BTstack itself.
+// The error log is rare and is always kept.
 #define ENABLE_LOG_ERROR
+#if defined(BTSTACK_LOG) && BTSTACK_LOG
+#define ENABLE_LOG_INFO
 #define ENABLE_PRINTF_HEXDUMP
+#endif
+
+#ifdef ENABLE_CLASSIC
 #define ENABLE_SCO_OVER_HCI
+#endif
 
 #ifdef ENABLE_BLE
 #define ENABLE_GATT_CLIENT_PAIRING
@@ -28,43 +37,63 @@
 
 // BTstack configuration. buffers, sizes, ...
 #define HCI_OUTGOING_PRE_BUFFER_SIZE 4
+#ifdef ENABLE_CLASSIC
 #define HCI_ACL_PAYLOAD_SIZE (1691 + 4)
+#else
+// LE only: one ATT PDU of the maximum LE data length (251 bytes) = ATT MTU 247 + L2CAP header
+#define HCI_ACL_PAYLOAD_SIZE (247 + 4)
+#endif
 #define HCI_ACL_CHUNK_SIZE_ALIGNMENT 4
+#define MAX_NR_GATT_CLIENTS 1
+#define MAX_NR_HIDS_CLIENTS 1
+#define MAX_NR_L2CAP_CHANNELS  4
+#define MAX_NR_L2CAP_SERVICES  3
+#define MAX_NR_SM_LOOKUP_ENTRIES 3
+#define MAX_NR_WHITELIST_ENTRIES 16
+#define MAX_NR_LE_DEVICE_DB_ENTRIES 16
+#ifdef ENABLE_CLASSIC
 #define MAX_NR_AVDTP_CONNECTIONS 1
 #define MAX_NR_AVDTP_STREAM_ENDPOINTS 1
 #define MAX_NR_AVRCP_CONNECTIONS 2
 #define MAX_NR_BNEP_CHANNELS 1
 #define MAX_NR_BNEP_SERVICES 1
 #define MAX_NR_BTSTACK_LINK_KEY_DB_MEMORY_ENTRIES  2
-#define MAX_NR_GATT_CLIENTS 1
 #define MAX_NR_HCI_CONNECTIONS 2
 #define MAX_NR_HID_HOST_CONNECTIONS 1
-#define MAX_NR_HIDS_CLIENTS 1
 #define MAX_NR_HFP_CONNECTIONS 1
-#define MAX_NR_L2CAP_CHANNELS  4
-#define MAX_NR_L2CAP_SERVICES  3
 #define MAX_NR_RFCOMM_CHANNELS 1
 #define MAX_NR_RFCOMM_MULTIPLEXERS 1
 #define MAX_NR_RFCOMM_SERVICES 1
 #define MAX_NR_SERVICE_RECORD_ITEMS 4
-#define MAX_NR_SM_LOOKUP_ENTRIES 3
-#define MAX_NR_WHITELIST_ENTRIES 16
-#define MAX_NR_LE_DEVICE_DB_ENTRIES 16
+#else
+// LE only: the bridge connects to a single HID device
+#define MAX_NR_HCI_CONNECTIONS 1
+#endif
 
 // Limit number of ACL/SCO Buffer to use by stack to avoid cyw43 shared bus overrun
 #define MAX_NR_CONTROLLER_ACL_BUFFERS 3
+#ifdef ENABLE_CLASSIC
 #define MAX_NR_CONTROLLER_SCO_PACKETS 3
+#endif
 
 // Enable and configure HCI Controller to Host Flow Control to avoid cyw43 shared bus overrun
 #define ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
+#ifdef ENABLE_CLASSIC
 #define HCI_HOST_ACL_PACKET_LEN 1024
+#else
+// LE only: must not exceed HCI_ACL_PAYLOAD_SIZE, the controller may send packets up to this size
+#define HCI_HOST_ACL_PACKET_LEN HCI_ACL_PAYLOAD_SIZE
+#endif
 #define HCI_HOST_ACL_PACKET_NUM 3
+// Reported to the controller by HCI Host Buffer Size even in LE-only builds (no host memory is reserved)
 #define HCI_HOST_SCO_PACKET_LEN 120
 #define HCI_HOST_SCO_PACKET_NUM 3
 
 // Link Key DB and LE Device DB using TLV on top of Flash Sector interface
 #define NVM_NUM_DEVICE_DB_ENTRIES 16
+#ifdef ENABLE_CLASSIC
 #define NVM_NUM_LINK_KEYS 16
+#endif
 
 // We don't give btstack a malloc, so use a fixed-size ATT DB.
 #define MAX_ATT_DB_SIZE 512
@@ -78,8 +107,12 @@
 // Some USB dongles take longer to respond to HCI reset (e.g. BCM20702A).
 #define HCI_RESET_RESEND_TIMEOUT_MS 1000
 
+// BTstack computes the SM crypto on core1, unless it is answered on core0 by CryptoOffload.h
+// in place of the controller (CRYP_ENABLE=1, CMake BRIDGE_CRYPTO_OFFLOAD).
+#if !defined(CRYP_ENABLE) || !CRYP_ENABLE
 #define ENABLE_SOFTWARE_AES128
 #define ENABLE_MICRO_ECC_FOR_LE_SECURE_CONNECTIONS
+#endif
 
 #define HAVE_BTSTACK_STDIN
 
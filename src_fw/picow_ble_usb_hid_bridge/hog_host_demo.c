@@ -65,6 +65,23 @@
 #include "picow_bt_example_common.h"
 #include "pico/cyw43_arch.h"
 #include "Common.h"
+#include "TlvCache.h"
+#include "Log.h"
+#include "FlightRec.h"
+#include "HidRptDesc.h"
+#include "Xform.h"
+#include "DevInfo.h"
+#include "Watchdog.h"
+#include "BootProf.h"
+#include "UsbSuspend.h"
+#include "EccKey.h"
+#include "CryptoOffload.h"
+#include "AclFlow.h"
+#include "RpaCache.h"
+#include "NotifyPath.h"
+#include "DevCtx.h"
+#include "AdvFilter.h"
+#include "TaskProf.h"
 // <=====
 
 // @@add
@@ -74,6 +91,18 @@
 #define SCAN_TIMEOUT_MS       5000  // 5 seconds for scanning
 // <=====
 
+// @@add
+// =====>
+// Reports per logged window of the notification-to-enqueue latency
+#define RX_LATENCY_WINDOW 1000
+
+// Connection parameters while the USB host is suspended (the BLE link is relaxed)
+#define SUSPEND_CONN_INTERVAL       40  // 50 ms (1.25 ms units)
+#define SUSPEND_CONN_LATENCY        4   // Connection events the device may skip
+#define SUSPEND_SUPERVISION_TIMEOUT 300 // 3 s (10 ms units)
+#define SUSPEND_POLL_MS             100 // Period of the check of the USB suspend state
+// <=====
+
 // TAG to store remote device address and type in TLV
 #define TLV_TAG_HOGD ((((uint32_t) 'H') << 24 ) | (((uint32_t) 'O') << 16) | (((uint32_t) 'G') << 8) | 'D')
 
@@ -91,6 +120,10 @@ static enum {
     READY,
     W4_TIMEOUT_THEN_SCAN,
     W4_TIMEOUT_THEN_RECONNECT,
+    // @@add
+    // =====>
+    W4_DEVICE_INFORMATION,
+    // <=====
 } app_state;
 
 static le_device_addr_t remote_device;
@@ -115,12 +148,46 @@ static void * btstack_tlv_singleton_context;
 // @@add
 // =====>
 extern volatile bool g_usb_reinit_request;
+extern volatile bool g_led_state;
+extern bool is_usb_idle(void);
+// <=====
+
+// @@add
+// =====>
+// Report map of the connected device, compiled once per connection
+static ST_HRD_MAP f_stHrdMap;
+
+// Device DB index of the bond of the stored HID device (TLV_TAG_HOGD), taken at scan start
+static int hogd_bond_index = RPAC_NO_MATCH;
+
+// Notification-to-enqueue latency: from the CYW43 host wake interrupt to CMN_Enqueue (us),
+// and the cycles of hid_handle_input_report. Only used by core1 (scratch X).
+static volatile uint32_t CMN_CORE1_DATA("hid_rx") f_hostWakeUs = 0;
+static ST_CMN_STAT CMN_CORE1_DATA("hid_rx") f_stRxLatency;
+static ST_CMN_STAT CMN_CORE1_DATA("hid_rx") f_stRxCycles;
+static ULONG CMN_CORE1_DATA("hid_rx") f_rxFlashCnt = 0; // Flash writes seen by the RX cycle measurement
+
+// Heartbeat of core1 for the watchdog supervisor on core0
+static btstack_timer_source_t f_stHeartbeatTimer;
+
+// Connection parameters negotiated with the device, restored when the USB host resumes
+static struct {
+    uint16_t interval;          // 1.25 ms units
+    uint16_t latency;           // Connection events
+    uint16_t timeout;           // 10 ms units
+} f_stConnParam;
+static bool f_bLinkRelaxed = false; // The suspend connection parameters were requested
+static btstack_timer_source_t f_stLinkTimer;
+
+// Start of the pairing or re-encryption (LE connection complete)
+static uint32_t f_securityStartMs = 0;
 // <=====
 
 // @@add
 // =====>
 void ble_host_main(void);
 bool is_ble_app_state_ready(void);
+const ST_HRD_MAP* get_ble_hid_report_map(void);
 const uint8_t* get_ble_hid_report_descriptor_data(void);
 uint16_t get_ble_hid_report_descriptor_len(void);
 // <=====
@@ -130,12 +197,264 @@ uint16_t get_ble_hid_report_descriptor_len(void);
 // Forward declarations
 static void hog_start_scan(void);
 static void hog_start_connect(void);
+
+// Change the application state and record the transition in the flight recorder
+static void hog_set_app_state(uint8_t new_state){
+    UCHAR aucData[2];
+
+    aucData[0] = (UCHAR)app_state;
+    aucData[1] = new_state;
+    FREC_Record(FREC_KIND_APP_STATE, aucData, sizeof(aucData));
+    // The USB descriptors of core0 only see the device through the published context
+    if (new_state == READY) {
+        DCTX_Publish(true, get_ble_hid_report_descriptor_data(), get_ble_hid_report_descriptor_len(), DEVI_Get());
+    }
+    else if (app_state == READY) {
+        DCTX_Publish(false, NULL, 0, NULL);
+    }
+    app_state = new_state;
+}
+
+// Enter READY and make the USB host re-acquire the descriptors of the device
+static void hog_enter_ready(void){
+    LOG_INFO("Ready - please start typing or mousing..\n");
+    hog_set_app_state(READY);
+    BPRF_Mark(BPRF_MS_READY);
+    // The GATT client is idle now: find the input report value handles for the direct path
+    NTFP_Discover();
+    // Keep the device for a warm restart. After one, the USB device already presents
+    // this device if it came back unchanged, and the re-enumeration is skipped.
+    if (WDG_SaveDevice(remote_device.addr, remote_device.addr_type,
+            get_ble_hid_report_descriptor_data(), get_ble_hid_report_descriptor_len())){
+        return;
+    }
+    // Re-initialize the USB device to make the USB host re-acquire the descriptor.
+    // This flag is referenced by USB task.
+    g_usb_reinit_request = true;
+}
+
+// Core1 heartbeat for the watchdog supervisor (stops if the run loop is stuck)
+static void hog_heartbeat(btstack_timer_source_t * ts){
+    TPRF_Begin(TPRF_TASK_BT_TIMER);
+    // The device restored by a warm restart did not come back: drop its descriptors
+    if (WDG_Heartbeat()){
+        g_usb_reinit_request = true;
+    }
+    btstack_run_loop_set_timer(ts, WDG_HEARTBEAT_MS);
+    btstack_run_loop_add_timer(ts);
+    TPRF_End();
+}
+
+// Relax the BLE link while the USB host is suspended and restore it once the host resumes
+static void hog_update_link(void){
+    bool bSuspended = USPD_IsSuspended();
+
+    if ((bSuspended == f_bLinkRelaxed) || (app_state != READY) || (connection_handle == HCI_CON_HANDLE_INVALID)){
+        return;
+    }
+    if (bSuspended){
+        (void)gap_update_connection_parameters(connection_handle, SUSPEND_CONN_INTERVAL, SUSPEND_CONN_INTERVAL,
+            SUSPEND_CONN_LATENCY, SUSPEND_SUPERVISION_TIMEOUT);
+    } else {
+        (void)gap_update_connection_parameters(connection_handle, f_stConnParam.interval, f_stConnParam.interval,
+            f_stConnParam.latency, f_stConnParam.timeout);
+    }
+    f_bLinkRelaxed = bSuspended;
+    LOG_INFO("USB suspended %lu: BLE connection interval %lu x 1.25 ms, latency %lu\n", (ULONG)bSuspended,
+        (ULONG)(bSuspended ? SUSPEND_CONN_INTERVAL : f_stConnParam.interval),
+        (ULONG)(bSuspended ? SUSPEND_CONN_LATENCY : f_stConnParam.latency));
+}
+
+static void hog_link_timer(btstack_timer_source_t * ts){
+    TPRF_Begin(TPRF_TASK_BT_TIMER);
+    hog_update_link();
+    btstack_run_loop_set_timer(ts, SUSPEND_POLL_MS);
+    btstack_run_loop_add_timer(ts);
+    TPRF_End();
+}
+// <=====
+
+// @@add
+// =====>
+// Record a report passed to the USB task in the flight recorder
+static void __time_critical_func(hid_handle_input_report_record)(UCHAR kind, const ST_HID_RPT *pstHidRpt){
+    UCHAR aucData[4];
+
+    aucData[0] = pstHidRpt->report_id;
+    memcpy(&aucData[1], &pstHidRpt->report_len, sizeof(pstHidRpt->report_len));
+    aucData[3] = (UCHAR)CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT);
+    FREC_Record(kind, aucData, (kind == FREC_KIND_QUE_ENQ) ? 4 : 3);
+}
+// <=====
+
+// @@add
+// =====>
+// Compile the report map of the connected device.
+// If the map cannot be parsed, reports are forwarded unchecked.
+static void hid_compile_report_map(void){
+    E_HRD_RESULT eRet;
+
+    eRet = HRD_Parse(get_ble_hid_report_descriptor_data(), get_ble_hid_report_descriptor_len(), &f_stHrdMap);
+    if (eRet != HRD_OK) {
+        LOG_ERROR("Report map rejected (%lu), reports are forwarded unchecked\n", (ULONG)eRet);
+    }
+    else {
+        LOG_INFO("Report map: %lu reports, %lu input fields\n", (ULONG)f_stHrdMap.report_cnt, (ULONG)f_stHrdMap.field_cnt);
+    }
+    // Also on a rejected map (cleared by HRD_Parse): the plans of the previous device must not stay
+    XFM_Compile(&f_stHrdMap);
+}
+
+// Record a report that does not match the report map in the flight recorder
+static void hid_handle_input_report_reject(uint8_t report_id, uint16_t report_len, uint16_t expected_len){
+    UCHAR aucData[5];
+
+    aucData[0] = report_id;
+    memcpy(&aucData[1], &report_len, sizeof(report_len));
+    memcpy(&aucData[3], &expected_len, sizeof(expected_len));
+    FREC_Record(FREC_KIND_RPT_REJECT, aucData, sizeof(aucData));
+}
+// <=====
+
+// @@add
+// =====>
+// Handle events of the Device Information Service client
+static void handle_device_information_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+
+    if ((packet_type != HCI_EVENT_PACKET) || (hci_event_packet_get_type(packet) != HCI_EVENT_GATTSERVICE_META)){
+        return;
+    }
+    FREC_Record(FREC_KIND_GATT_EVT, packet, size);
+    if (!DEVI_HandleEvent(packet) || (app_state != W4_DEVICE_INFORMATION)){
+        return;
+    }
+    btstack_run_loop_remove_timer(&connection_timer);
+    // Cache the identity with the bond
+    DEVI_Store(btstack_tlv_singleton_impl, btstack_tlv_singleton_context);
+    hog_enter_ready();
+}
+
+// The device did not answer the Device Information Service query in time.
+// The identity is not cached, so the service is read again on the next connection.
+static void hog_device_information_timeout(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    if (app_state != W4_DEVICE_INFORMATION) return;
+    LOG_ERROR("Device information timeout\n");
+    hog_enter_ready();
+}
+
+// Read the Device Information Service unless the identity of the device is cached.
+// Returns true if the query was started (READY follows on its completion or timeout).
+static bool hog_query_device_information(void){
+    if (DEVI_Load(btstack_tlv_singleton_impl, btstack_tlv_singleton_context, remote_device.addr)){
+        return false;
+    }
+    if (device_information_service_client_query(connection_handle, handle_device_information_event) != ERROR_CODE_SUCCESS){
+        LOG_ERROR("Device information query failed\n");
+        return false;
+    }
+    hog_set_app_state(W4_DEVICE_INFORMATION);
+    btstack_run_loop_set_timer(&connection_timer, DEVI_QUERY_TIMEOUT_MS);
+    btstack_run_loop_set_timer_handler(&connection_timer, &hog_device_information_timeout);
+    btstack_run_loop_add_timer(&connection_timer);
+    return true;
+}
+// <=====
+
+// @@add
+// =====>
+// Time stamp of the CYW43 host wake interrupt.
+// Runs before the driver's handler, which masks the interrupt until the CYW43 has been polled,
+// so the stamp is the start of the poll that delivers the next notification.
+static void __not_in_flash_func(hog_host_wake_irq_handler)(void){
+    if (gpio_get_irq_event_mask(CYW43_PIN_WL_HOST_WAKE) & GPIO_IRQ_LEVEL_HIGH){
+        f_hostWakeUs = time_us_32();
+    }
+}
+
+// Add the latency and cycles of an enqueued report and log min/avg/max per window.
+// Jitter (max - min) shows how the run loop mode (threadsafe background or poll) schedules BTstack.
+// The cycles show the contention with core0 on the SRAM banks (compare with CMN_BANK_PLACEMENT=0).
+static void __time_critical_func(hid_rx_latency_add)(ULONG cycles){
+    CMN_StatAdd(&f_stRxLatency, time_us_32() - f_hostWakeUs);
+    CMN_StatAdd(&f_stRxCycles, cycles);
+    // The first report after a flash write runs with the XIP cache flushed
+    if (f_rxFlashCnt != TLVC_GetStat()->lockout.cnt) {
+        f_rxFlashCnt = TLVC_GetStat()->lockout.cnt;
+        LOG_INFO("RX cycles after flash write: %lu, latency %lu us\n", cycles, f_stRxLatency.last);
+    }
+    if (f_stRxLatency.cnt < RX_LATENCY_WINDOW) return;
+    LOG_INFO("RX latency (us): min %lu avg %lu max %lu jitter %lu\n", f_stRxLatency.min,
+        (ULONG)(f_stRxLatency.sum / f_stRxLatency.cnt), f_stRxLatency.max, f_stRxLatency.max - f_stRxLatency.min);
+    LOG_INFO("RX cycles: min %lu avg %lu max %lu\n", f_stRxCycles.min,
+        (ULONG)(f_stRxCycles.sum / f_stRxCycles.cnt), f_stRxCycles.max);
+    CMN_StatClear(&f_stRxLatency);
+    CMN_StatClear(&f_stRxCycles);
+}
+// <=====
+
+// @@add
+// =====>
+// Report being queued (core1). Static to use static memory (data area) instead of stack, preventing stack overflow.
+static ST_HID_RPT CMN_CORE1_RPT("hid_rx") f_stHidRpt;
+
+// Fills f_stHidRpt with a report of the compiled map (report data without the report ID)
+static void __time_critical_func(hid_fill_mapped_report)(const ST_HRD_REPORT *pstReport, uint8_t report_id, const uint8_t *report, uint16_t report_len){
+    uint16_t expected_len;
+
+    // Send the length the USB host expects from the report descriptor:
+    // a longer report is truncated, a shorter one is padded with zeros
+    expected_len = (uint16_t)HRD_GetInputLen(pstReport);
+    if (report_len != expected_len) {
+        hid_handle_input_report_reject(report_id, report_len, expected_len);
+        if (report_len < expected_len) {
+            memset(&f_stHidRpt.report[report_len], 0, expected_len - report_len);
+        }
+        else {
+            report_len = expected_len;
+        }
+    }
+    // TinyUSB puts the report ID in front of the data again
+    f_stHidRpt.report_id  = pstReport->report_id;
+    f_stHidRpt.report_len = expected_len;
+    memcpy(f_stHidRpt.report, report, report_len);
+    // Key remapping and pointer gain (if built with XFM_ENABLE)
+    XFM_Apply(&f_stHidRpt);
+}
+
+// Queues f_stHidRpt for the USB task
+static void __time_critical_func(hid_enqueue_report)(ULONG cyc){
+    if (!CMN_Enqueue(CMN_QUE_KIND_HID_RPT, &f_stHidRpt)) {
+        // Queue is full
+        hid_handle_input_report_record(FREC_KIND_QUE_DROP, &f_stHidRpt);
+    }
+    else {
+        hid_handle_input_report_record(FREC_KIND_QUE_ENQ, &f_stHidRpt);
+        hid_rx_latency_add(CMN_CycSince(cyc));
+    }
+}
+
+// Direct path: input report notification of a characteristic learned by NotifyPath
+static void __time_critical_func(hid_handle_notification)(const ST_HRD_REPORT *pstReport, const uint8_t *value, uint16_t value_len){
+    ULONG cyc = CMN_CycNow();
+
+    TPRF_Begin(TPRF_TASK_BT_NOTIFY);
+    // Restore the BLE link as soon as reports flow again after a USB resume
+    // (hog_update_link is in flash: only called when the suspend state has changed)
+    if (USPD_IsSuspended() != f_bLinkRelaxed) {
+        hog_update_link();
+    }
+    hid_fill_mapped_report(pstReport, pstReport->report_id, value, value_len);
+    hid_enqueue_report(cyc);
+    TPRF_End();
+}
 // <=====
 
 // @@chg
 // =====>
 //static void hid_handle_input_report(uint8_t service_index, const uint8_t * report, uint16_t report_len){
-static void hid_handle_input_report(uint8_t service_index, uint8_t report_id, const uint8_t * report, uint16_t report_len){
+static void __time_critical_func(hid_handle_input_report)(uint8_t service_index, uint8_t report_id, const uint8_t * report, uint16_t report_len){
 // <=====
     // check if HID Input Report
     
@@ -143,18 +462,35 @@ static void hid_handle_input_report(uint8_t service_index, uint8_t report_id, co
     // =====>
     // Enqueue the raw report for the USB task.
     // The USB HID task manages transmission to the host.
-    static ST_HID_RPT stHidRpt; // Change local variable to static to use static memory (data area) instead of stack, preventing stack overflow.
-
-    stHidRpt.report_id  = report_id;
-    stHidRpt.report_len = report_len;  
-    // Prevent buffer overflow if the report is larger than the buffer
-    if (stHidRpt.report_len > CMN_HID_RPT_DATA_SIZE) {
-        stHidRpt.report_len = CMN_HID_RPT_DATA_SIZE;
+    const ST_HRD_REPORT *pstReport;
+    ULONG cyc = CMN_CycNow();
+
+    UNUSED(service_index);
+    if (f_stHrdMap.bValid) {
+        // The HID service client puts the report ID in front of the report data
+        if (report_len > 0) {
+            report++;
+            report_len--;
+        }
+        // O(1) lookup of the compiled report map
+        pstReport = HRD_GetReport(&f_stHrdMap, f_stHrdMap.bUseId ? report_id : HRD_NO_REPORT_ID);
+        if (pstReport == NULL) {
+            hid_handle_input_report_reject(report_id, report_len, 0);
+            return;
+        }
+        hid_fill_mapped_report(pstReport, report_id, report, report_len);
     }
-    memcpy(stHidRpt.report, report, stHidRpt.report_len);
-    if (!CMN_Enqueue(CMN_QUE_KIND_HID_RPT, &stHidRpt)) {
-        // Queue is full
+    else {
+        // Unchecked: the data is sent as received, including the report ID byte
+        f_stHidRpt.report_id  = HRD_NO_REPORT_ID;
+        f_stHidRpt.report_len = report_len;  
+        // Prevent buffer overflow if the report is larger than the buffer
+        if (f_stHidRpt.report_len > CMN_HID_RPT_DATA_SIZE) {
+            f_stHidRpt.report_len = CMN_HID_RPT_DATA_SIZE;
+        }
+        memcpy(f_stHidRpt.report, report, f_stHidRpt.report_len);
     }
+    hid_enqueue_report(cyc);
     return;
     // <=====    
 }
@@ -179,8 +515,10 @@ static bool adv_event_contains_hid_service(const uint8_t * packet){
 static void hog_scan_timeout(btstack_timer_source_t * ts){
     UNUSED(ts);
     if (app_state != W4_HID_DEVICE_FOUND) return;
-    printf("Scan timeout. Switching to bonded connection attempt...\n");
+    LOG_INFO("Scan timeout. Switching to bonded connection attempt...\n");
     gap_stop_scan();
+    RPAC_StopScan();
+    ADVF_StopScan();
     hog_start_connect();
 }
 // <=====
@@ -191,8 +529,8 @@ static void hog_scan_timeout(btstack_timer_source_t * ts){
 static void hog_start_scan(void){
 	// @@chg
 	// =====>
-    printf("Scanning for LE HID devices (Timeout %dms)...\n", SCAN_TIMEOUT_MS);
-    app_state = W4_HID_DEVICE_FOUND;
+    LOG_INFO("Scanning for LE HID devices (Timeout %lums)...\n", SCAN_TIMEOUT_MS);
+    hog_set_app_state(W4_HID_DEVICE_FOUND);
 
     // Fix: Remove timer before adding to prevent assertion if scan is restarted during reconnection
     btstack_run_loop_remove_timer(&connection_timer);
@@ -201,6 +539,17 @@ static void hog_start_scan(void){
     btstack_run_loop_set_timer(&connection_timer, SCAN_TIMEOUT_MS);
     btstack_run_loop_set_timer_handler(&connection_timer, &hog_scan_timeout);
     btstack_run_loop_add_timer(&connection_timer);
+
+    // Bonded IRKs for the devices that advertise with a resolvable private address
+    RPAC_StartScan();
+    ADVF_StartScan();
+    // Only the bond of the stored HID device may skip the HID service check
+    hogd_bond_index = RPAC_NO_MATCH;
+    le_device_addr_t hogd_device;
+    if (btstack_tlv_singleton_impl &&
+        (btstack_tlv_singleton_impl->get_tag(btstack_tlv_singleton_context, TLV_TAG_HOGD, (uint8_t *) &hogd_device, sizeof(hogd_device)) == sizeof(hogd_device))){
+        hogd_bond_index = RPAC_FindBond(hogd_device.addr, hogd_device.addr_type);
+    }
 	// <=====
 
     // Passive scanning, 100% (scan interval = scan window)
@@ -216,7 +565,7 @@ static void hog_connection_timeout(btstack_timer_source_t * ts){
     UNUSED(ts);
     // @@chg
     // =====>
-    printf("Connection timeout. Switching to scan...\n");
+    LOG_INFO("Connection timeout. Switching to scan...\n");
     // <=====
     gap_connect_cancel();
     hog_start_scan();
@@ -229,7 +578,9 @@ static void hog_connection_timeout(btstack_timer_source_t * ts){
 static void hog_connect(void) {
 	// @@chg
 	// =====>
-    printf("Connecting to device %s (Timeout %dms)...\n", bd_addr_to_str(remote_device.addr), CONNECTION_TIMEOUT_MS);
+    LOG_INFO("Connecting to device %02lX:%02lX:%02lX:%02lX:%02lX:%02lX (Timeout %lums)...\n",
+        remote_device.addr[0], remote_device.addr[1], remote_device.addr[2],
+        remote_device.addr[3], remote_device.addr[4], remote_device.addr[5], CONNECTION_TIMEOUT_MS);
     
     // Fix: Remove timer before adding. If a previous timer (like scan timeout) is still active, 
     // btstack_run_loop_add_timer would trigger an assertion failure.
@@ -241,7 +592,10 @@ static void hog_connect(void) {
     btstack_run_loop_add_timer(&connection_timer);
     // <=====
     
-    app_state = W4_CONNECTED;
+    // @@chg
+    // =====>
+    hog_set_app_state(W4_CONNECTED);
+    // <=====
     gap_connect(remote_device.addr, remote_device.addr_type);
 }
 
@@ -249,6 +603,18 @@ static void hog_connect(void) {
  * Start connecting after boot up: connect to last used device if possible, start scan otherwise
  */
 static void hog_start_connect(void){
+    // @@add
+    // =====>
+    // After a warm restart, reconnect to the device connected before it
+    // (its bond may not have been written to flash yet)
+    UCHAR addr_type;
+    if (WDG_GetWarmAddr(remote_device.addr, &addr_type)){
+        remote_device.addr_type = (bd_addr_type_t)addr_type;
+        LOG_INFO("Restored device found, trying to connect...\n");
+        hog_connect();
+        return;
+    }
+    // <=====
     // check if we have a bonded device
     btstack_tlv_get_instance(&btstack_tlv_singleton_impl, &btstack_tlv_singleton_context);
     if (btstack_tlv_singleton_impl){
@@ -256,7 +622,7 @@ static void hog_start_connect(void){
         if (len == sizeof(remote_device)){
             // @@chg
             // =====>
-            printf("Bonded device found, trying to connect...\n");
+            LOG_INFO("Bonded device found, trying to connect...\n");
             // <=====
             hog_connect();
             return;
@@ -270,7 +636,10 @@ static void hog_start_connect(void){
  * In case of error, disconnect and start scanning again
  */
 static void handle_outgoing_connection_error(void){
-    printf("Error occurred, disconnect and start over\n");
+    // @@chg
+    // =====>
+    LOG_ERROR("Error occurred, disconnect and start over\n");
+    // <=====
     gap_disconnect(connection_handle);
     hog_start_scan();
 }
@@ -294,37 +663,68 @@ static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint
         return;
     }
     
+    // @@add
+    // =====>
+    // Input reports are recorded as QUE_ENQ/QUE_DROP
+    if (hci_event_gattservice_meta_get_subevent_code(packet) != GATTSERVICE_SUBEVENT_HID_REPORT){
+        FREC_Record(FREC_KIND_GATT_EVT, packet, size);
+    }
+    // <=====
+
     switch (hci_event_gattservice_meta_get_subevent_code(packet)){
         case GATTSERVICE_SUBEVENT_HID_SERVICE_CONNECTED:
             status = gattservice_subevent_hid_service_connected_get_status(packet);
             switch (status){
                 case ERROR_CODE_SUCCESS:
-                    printf("HID service client connected, found %d services\n", 
+                    // @@chg
+                    // =====>
+                    LOG_INFO("HID service client connected, found %lu services\n",
                         gattservice_subevent_hid_service_connected_get_num_instances(packet));
+                    BPRF_Mark(BPRF_MS_HID_CONNECTED);
+                    // <=====
+                    // @@add
+                    // =====>
+                    hid_compile_report_map();
+                    if (f_stHrdMap.bValid) {
+                        NTFP_Start(connection_handle, &f_stHrdMap, &hid_handle_notification);
+                    }
+                    // <=====
         
                     // store device as bonded
                     if (btstack_tlv_singleton_impl){
                         btstack_tlv_singleton_impl->store_tag(btstack_tlv_singleton_context, TLV_TAG_HOGD, (const uint8_t *) &remote_device, sizeof(remote_device));
+                        // @@add
+                        // =====>
+                        // Write the bond (and the SM keys of the pairing) now rather than when USB is idle:
+                        // it would be lost on a power cut before the deadline. Nothing is written if unchanged.
+                        TLVC_Flush();
+                        // <=====
                     }
                     // done
-                    printf("Ready - please start typing or mousing..\n");
-                    app_state = READY;
-                    // Re-initialize the USB device to make the USB host re-acquire the descriptor.
-                    // This flag is referenced by USB task.
-                    // @@add
+                    // @@chg
                     // =====>
-                    g_usb_reinit_request = true;
+                    // The USB identity comes from the Device Information Service
+                    if (!hog_query_device_information()){
+                        hog_enter_ready();
+                    }
                     // <=====
                     break;
                 default:
-                    printf("HID service client connection failed, status 0x%02x.\n", status);
+                    // @@chg
+                    // =====>
+                    LOG_ERROR("HID service client connection failed, status 0x%02lx.\n", status);
+                    // <=====
                     handle_outgoing_connection_error();
                     break;
             }
             break;
 
         case GATTSERVICE_SUBEVENT_HID_SERVICE_DISCONNECTED:
-            printf("HID service client disconnected\n");
+            // @@chg
+            // =====>
+            LOG_INFO("HID service client disconnected\n");
+            NTFP_Stop();
+            // <=====
             // @@del
             // =====>
             //hog_start_connect();
@@ -332,6 +732,14 @@ static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint
             break;
 
         case GATTSERVICE_SUBEVENT_HID_REPORT:
+            // @@add
+            // =====>
+            // Already queued from the notification (direct path)
+            if (NTFP_OnHidReport(gattservice_subevent_hid_report_get_service_index(packet),
+                                 gattservice_subevent_hid_report_get_report_id(packet))) break;
+            // Restore the BLE link as soon as reports flow again after a USB resume
+            hog_update_link();
+            // <=====
             hid_handle_input_report(
                 gattservice_subevent_hid_report_get_service_index(packet),
                 // @@add
@@ -347,20 +755,46 @@ static void handle_gatt_client_event(uint8_t packet_type, uint16_t channel, uint
     }
 }
 
+// @@add
+// =====>
+// hids_client events, timed by the task profiler
+static void hog_gatt_client_event_timed(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    TPRF_Begin(TPRF_TASK_BT_GATT);
+    handle_gatt_client_event(packet_type, channel, packet, size);
+    TPRF_End();
+}
+// <=====
+
 /* LISTING_START(packetHandler): Packet Handler */
 static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     /* LISTING_PAUSE */
     UNUSED(channel);
     UNUSED(size);
     uint8_t event;
+    // @@add
+    // =====>
+    bd_addr_t adv_addr;
+    int bond_index;
+    // <=====
     /* LISTING_RESUME */
     switch (packet_type) {
         case HCI_EVENT_PACKET:
             event = hci_event_packet_get_type(packet);
+            // @@add
+            // =====>
+            // Skip high-rate events that would flush the recorder
+            if ((event != GAP_EVENT_ADVERTISING_REPORT) && (event != HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS)){
+                FREC_Record(FREC_KIND_HCI_EVT, packet, size);
+            }
+            // <=====
             switch (event) {
                 case BTSTACK_EVENT_STATE:
                     if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) break;
                     btstack_assert(app_state == W4_WORKING);
+                    // @@add
+                    // =====>
+                    BPRF_Mark(BPRF_MS_HCI_WORKING);
+                    // <=====
                     
                     hog_start_connect();
                     break;
@@ -368,28 +802,44 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                 // =====>    
                 case GAP_EVENT_ADVERTISING_REPORT:
                     if (app_state != W4_HID_DEVICE_FOUND) break;
-                    if (adv_event_contains_hid_service(packet) == false) break;
+                    gap_event_advertising_report_get_address(packet, adv_addr);
+                    // The stored HID device is recognised by its resolvable private address, even if it
+                    // does not list the HID service while reconnecting. Other bonds must list it.
+                    bond_index = RPAC_Resolve(adv_addr, gap_event_advertising_report_get_address_type(packet));
+                    if (bond_index != hogd_bond_index) bond_index = RPAC_NO_MATCH;
+                    // The other advertisers are classified once per advertisement content
+                    if ((bond_index == RPAC_NO_MATCH) && !ADVF_Accept(packet, &adv_event_contains_hid_service)) break;
+                    BPRF_Mark(BPRF_MS_FIRST_ADV);
                     
                     // Stop scan timeout timer and stop scan
                     btstack_run_loop_remove_timer(&connection_timer);
                     gap_stop_scan();
+                    RPAC_StopScan();
+                    ADVF_StopScan();
 
                     // store remote device address and type
-                    gap_event_advertising_report_get_address(packet, remote_device.addr);
+                    memcpy(remote_device.addr, adv_addr, sizeof(bd_addr_t));
                     remote_device.addr_type = gap_event_advertising_report_get_address_type(packet);
                     
-                    printf("Found HID device, connecting...\n");
+                    if (bond_index != RPAC_NO_MATCH) {
+                        LOG_INFO("Found bonded HID device %lu (resolvable private address), connecting...\n", (ULONG)bond_index);
+                    }
+                    else {
+                        LOG_INFO("Found HID device, connecting...\n");
+                    }
                     hog_connect();
                     break;
                 case HCI_EVENT_DISCONNECTION_COMPLETE:
                     connection_handle = HCI_CON_HANDLE_INVALID;
-                    printf("\nDisconnected, starting over...\n");
+                    LOG_INFO("Disconnected, starting over...\n");
+                    WDG_ClearDevice();
+                    NTFP_Stop();
                     
                     // Fix: Ensure timer is cleared upon disconnection before starting over
                     btstack_run_loop_remove_timer(&connection_timer);
 
                     // Wait a moment before restarting the loop
-                    app_state = W4_WORKING;
+                    hog_set_app_state(W4_WORKING);
                     hog_start_connect();
                 // <=====    
                     break;
@@ -400,9 +850,29 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                     btstack_run_loop_remove_timer(&connection_timer);
                     connection_handle = gap_subevent_le_connection_complete_get_connection_handle(packet);
                     // request security
-                    app_state = W4_ENCRYPTED;
+                    // @@chg
+                    // =====>
+                    f_stConnParam.interval = gap_subevent_le_connection_complete_get_conn_interval(packet);
+                    f_stConnParam.latency = gap_subevent_le_connection_complete_get_conn_latency(packet);
+                    f_stConnParam.timeout = gap_subevent_le_connection_complete_get_supervision_timeout(packet);
+                    f_bLinkRelaxed = false;
+                    BPRF_Mark(BPRF_MS_CONNECTED);
+                    hog_set_app_state(W4_ENCRYPTED);
+                    f_securityStartMs = btstack_run_loop_get_time_ms();
+                    // <=====
                     sm_request_pairing(connection_handle);
                     break;
+                // @@add
+                // =====>
+                case HCI_EVENT_LE_META:
+                    // Keep the parameters the device negotiated, not the relaxed ones
+                    if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE) break;
+                    if (f_bLinkRelaxed || (hci_subevent_le_connection_update_complete_get_status(packet) != ERROR_CODE_SUCCESS)) break;
+                    f_stConnParam.interval = hci_subevent_le_connection_update_complete_get_conn_interval(packet);
+                    f_stConnParam.latency = hci_subevent_le_connection_update_complete_get_conn_latency(packet);
+                    f_stConnParam.timeout = hci_subevent_le_connection_update_complete_get_supervision_timeout(packet);
+                    break;
+                // <=====
                 default:
                     break;
             }
@@ -413,6 +883,16 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
 }
 /* LISTING_END */
 
+// @@add
+// =====>
+// HCI events, timed by the task profiler
+static void hog_packet_handler_timed(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    TPRF_Begin(TPRF_TASK_BT_HCI);
+    packet_handler(packet_type, channel, packet, size);
+    TPRF_End();
+}
+// <=====
+
 /* @section HCI packet handler
  *
  * @text The SM packet handler receives Security Manager Events required for pairing.
@@ -432,37 +912,53 @@ static void sm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *pa
 
     switch (hci_event_packet_get_type(packet)) {
         case SM_EVENT_JUST_WORKS_REQUEST:
-            printf("Just works requested\n");
+            // @@chg
+            // =====>
+            LOG_INFO("Just works requested\n");
+            // <=====
             sm_just_works_confirm(sm_event_just_works_request_get_handle(packet));
             break;
         case SM_EVENT_NUMERIC_COMPARISON_REQUEST:
-            printf("Confirming numeric comparison: %"PRIu32"\n", sm_event_numeric_comparison_request_get_passkey(packet));
+            // @@chg
+            // =====>
+            LOG_INFO("Confirming numeric comparison: %lu\n", sm_event_numeric_comparison_request_get_passkey(packet));
+            // <=====
             sm_numeric_comparison_confirm(sm_event_passkey_display_number_get_handle(packet));
             break;
         case SM_EVENT_PASSKEY_DISPLAY_NUMBER:
-            printf("Display Passkey: %"PRIu32"\n", sm_event_passkey_display_number_get_passkey(packet));
+            // @@chg
+            // =====>
+            LOG_INFO("Display Passkey: %lu\n", sm_event_passkey_display_number_get_passkey(packet));
+            // <=====
             break;
         case SM_EVENT_PAIRING_COMPLETE:
             switch (sm_event_pairing_complete_get_status(packet)){
                 case ERROR_CODE_SUCCESS:
-                    printf("Pairing complete, success\n");
+                    // @@chg
+                    // =====>
+                    LOG_INFO("Pairing complete, success (%lu ms)\n", btstack_run_loop_get_time_ms() - f_securityStartMs);
+                    ECCK_OnPairing();
+                    // <=====
                     connect_to_service = true;
                     break;
                 // @@chg
                 // =====>    
                 case ERROR_CODE_CONNECTION_TIMEOUT:
-                    printf("Pairing failed, timeout\n");
+                    LOG_ERROR("Pairing failed, timeout\n");
                     handle_outgoing_connection_error();
                     break;
                 default:
-                    printf("Pairing failed, status 0x%02x\n", sm_event_pairing_complete_get_status(packet));
+                    LOG_ERROR("Pairing failed, status 0x%02lx\n", sm_event_pairing_complete_get_status(packet));
                     handle_outgoing_connection_error();
                     break;
                 // <=====
             }
             break;
         case SM_EVENT_REENCRYPTION_COMPLETE:
-            printf("Re-encryption complete, success\n");
+            // @@chg
+            // =====>
+            LOG_INFO("Re-encryption complete, success (%lu ms)\n", btstack_run_loop_get_time_ms() - f_securityStartMs);
+            // <=====
             connect_to_service = true;
             break;
         default:
@@ -471,13 +967,30 @@ static void sm_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *pa
 
     if (connect_to_service){
         // continue - query primary services
-        printf("Search for HID service.\n");
-        app_state = W4_HID_CLIENT_CONNECTED;
-        hids_client_connect(connection_handle, handle_gatt_client_event, protocol_mode, &hids_cid);
+        // @@chg
+        // =====>
+        BPRF_Mark(BPRF_MS_ENCRYPTED);
+        LOG_INFO("Search for HID service.\n");
+        hog_set_app_state(W4_HID_CLIENT_CONNECTED);
+        // <=====
+        // @@chg
+        // =====>
+        hids_client_connect(connection_handle, hog_gatt_client_event_timed, protocol_mode, &hids_cid);
+        // <=====
     }
 }
 /* LISTING_END */
 
+// @@add
+// =====>
+// Security Manager events, timed by the task profiler
+static void hog_sm_packet_handler_timed(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    TPRF_Begin(TPRF_TASK_BT_SM);
+    sm_packet_handler(packet_type, channel, packet, size);
+    TPRF_End();
+}
+// <=====
+
 int btstack_main(int argc, const char * argv[]);
 int btstack_main(int argc, const char * argv[]){
 
@@ -500,13 +1013,23 @@ int btstack_main(int argc, const char * argv[]){
     att_server_init(profile_data, NULL, NULL);
 
     hids_client_init(hid_descriptor_storage, sizeof(hid_descriptor_storage));
+    // @@add
+    // =====>
+    device_information_service_client_init();
+    // <=====
 
     // register for events from HCI
-    hci_event_callback_registration.callback = &packet_handler;
+    // @@chg
+    // =====>
+    hci_event_callback_registration.callback = &hog_packet_handler_timed;
+    // <=====
     hci_add_event_handler(&hci_event_callback_registration);
 
     // register for events from Security Manager
-    sm_event_callback_registration.callback = &sm_packet_handler;
+    // @@chg
+    // =====>
+    sm_event_callback_registration.callback = &hog_sm_packet_handler_timed;
+    // <=====
     sm_add_event_handler(&sm_event_callback_registration);
     // @@del
     // =====>
@@ -515,10 +1038,34 @@ int btstack_main(int argc, const char * argv[]){
 
     /* LISTING_END */
 
+    // @@add
+    // =====>
+    // Serve TLV reads from RAM and defer flash writes (which lock out core0) until USB is idle
+    btstack_tlv_get_instance(&btstack_tlv_singleton_impl, &btstack_tlv_singleton_context);
+    TLVC_Init(btstack_tlv_singleton_impl, btstack_tlv_singleton_context, is_usb_idle);
+
+    // Hand the stored LE Secure Connections key pair to the SM, so pairing does not wait for its generation
+    btstack_tlv_get_instance(&btstack_tlv_singleton_impl, &btstack_tlv_singleton_context);
+    ECCK_Init(btstack_tlv_singleton_impl, btstack_tlv_singleton_context);
+
+    // Start the heartbeat for the watchdog supervisor on core0
+    btstack_run_loop_set_timer(&f_stHeartbeatTimer, WDG_HEARTBEAT_MS);
+    btstack_run_loop_set_timer_handler(&f_stHeartbeatTimer, &hog_heartbeat);
+    btstack_run_loop_add_timer(&f_stHeartbeatTimer);
+
+    // Follow the USB suspend state to relax the BLE link
+    btstack_run_loop_set_timer(&f_stLinkTimer, SUSPEND_POLL_MS);
+    btstack_run_loop_set_timer_handler(&f_stLinkTimer, &hog_link_timer);
+    btstack_run_loop_add_timer(&f_stLinkTimer);
+    // <=====
+
     // Disable stdout buffering
     setvbuf(stdin, NULL, _IONBF, 0);
 
-    app_state = W4_WORKING;
+    // @@chg
+    // =====>
+    hog_set_app_state(W4_WORKING);
+    // <=====
 
     // Turn on the device
     hci_power_control(HCI_POWER_ON);
@@ -531,15 +1078,48 @@ int btstack_main(int argc, const char * argv[]){
  * @brief Main function for the BLE host task (runs on Core1).
  * 
  * @note This function initializes and runs the BTstack event loop.
+ *       With the poll-mode CYW43 architecture (PICO_CYW43_ARCH_POLL), core1 busy-polls
+ *       the CYW43 driver and BTstack instead: no work is deferred to low-priority IRQs
+ *       and core0 never takes the CYW43 lock (the LED is driven from here).
  */
 void ble_host_main(void)
 {
-    // Initialize BTstack for PicoW
+    BPRF_Mark(BPRF_MS_CORE1_START);
+    CMN_CycInit();
+    // Initialize BTstack for PicoW (cyw43_arch_init downloads the CYW43 firmware)
     (void)picow_bt_example_init();
+    BPRF_Mark(BPRF_MS_CYW43_INIT);
+    // Measure the notification-to-enqueue latency from the CYW43 host wake interrupt
+    CMN_StatClear(&f_stRxLatency);
+    CMN_StatClear(&f_stRxCycles);
+    gpio_add_raw_irq_handler_with_order_priority(CYW43_PIN_WL_HOST_WAKE, hog_host_wake_irq_handler,
+        PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY);
+    TPRF_InitCore1();
     // Set up and start the main BTstack task
     picow_bt_example_main();
+#if PICO_CYW43_ARCH_POLL
+    bool led_state = false;
+
+    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_state);
+    while (true) {
+        TPRF_Loop();
+        // Runs the CYW43 driver, BTstack timers and data sources that are due
+        TPRF_Begin(TPRF_TASK_BT_POLL);
+        cyw43_arch_poll();
+        TPRF_End();
+        // Answers the SM crypto commands computed on core0
+        CRYP_Poll();
+        // Returns the BLE link credits held while the report queue was full
+        ACLF_Poll();
+        if (g_led_state != led_state) {
+            led_state = g_led_state;
+            cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_state);
+        }
+    }
+#else
     // Enter the BTstack run loop
     btstack_run_loop_execute();
+#endif
 }
 // <=====
 
@@ -553,6 +1133,16 @@ bool is_ble_app_state_ready(void)
     return (READY == app_state) ? true : false;
 }
 
+/**
+ * @brief Get the compiled report map of the connected device.
+ *
+ * @return Report map, or NULL if not READY or the report map could not be parsed.
+ */
+const ST_HRD_MAP* get_ble_hid_report_map(void)
+{
+    return ((READY == app_state) && f_stHrdMap.bValid) ? &f_stHrdMap : NULL;
+}
+
 /**
  * @brief Get the pointer to the HID Report Descriptor received via BLE.
  * 
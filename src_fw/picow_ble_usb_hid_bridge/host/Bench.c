@@ -0,0 +1,520 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Workstation benchmarks of the bridge core (host-native build, see CMakeLists.txt).
+//
+// The firmware sources are compiled unchanged against the stubs in stub/.
+// The BLE state machine is driven to READY through injected BTstack events,
+// then the report path is timed with the host clock:
+//   queue     : CMN_Enqueue + CMN_Dequeue of one report
+//   desc      : tud_descriptor_configuration_cb
+//   dctx_read : DCTX_Read of the device context published by core1
+//   hrd_parse : HRD_Parse of the report map of the simulated device
+//   hrd_field : HRD_GetReport + HRD_GetFieldValue of all input fields of a mouse report
+//   xform_kbd / xform_mouse : XFM_Apply of a keyboard / mouse report (if built with XFM_ENABLE)
+//   forward   : input report notification -> direct path (NotifyPath) -> queue -> send_hid_report -> tud_hid_report
+//   fwd_hids  : the same through hids_client and its GATT HID report event (if built with NTFP_ENABLE)
+//   ntf_direct / ntf_hids : core1 side of forward / fwd_hids only, notification to queued
+//               (ntf_direct includes the report event hids_client still builds, dropped by the bridge)
+//   aes_block / aes_key : AES_EncryptBlock of one block / AES_Encrypt with a new key each time (key expansion included)
+//   rpa_hit / rpa_miss / rpa_dense : RPAC_Resolve of a cached RPA / of a new RPA against 16 IRKs /
+//               of 100 devices advertising in turn (cache hit rate printed)
+//   adv_hit / adv_walk / adv_dense : ADVF_Accept of a known non-HID advertisement / of a new one (AD walk) /
+//               of 100 non-HID devices advertising in turn (rejection rate and time saved printed)
+//   crypto    : HCI LE Encrypt -> crypto offload queue -> CRYP_Task (core0) -> Command Complete (if built with CRYP_ENABLE)
+//   p256_step : one CRYP_Task step of an LE Generate DHKey (Core Vol 3 Part H 2.3.5.6.1 sample keys)
+//   prof      : TPRF_Begin + TPRF_End of a task (if built with TPRF_ENABLE)
+// The results of these paths are checked by bridge_test (Test.c), not here.
+//
+// Usage: bridge_bench [-n iterations] [-v]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Common.h"
+#include "Log.h"
+#include "TaskProf.h"
+#include "tusb.h"
+#include "btstack.h"
+#include "usb_descriptors.h"
+#include "HidRptDesc.h"
+#include "Xform.h"
+#include "Aes.h"
+#include "CryptoOffload.h"
+#include "P256.h"
+#include "RpaCache.h"
+#include "AdvFilter.h"
+#include "NotifyPath.h"
+#include "DevCtx.h"
+#include "HostBridge.h"
+
+// [Definitions]
+#define BENCH_ITER_DEFAULT 1000000
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_print(const char *pszName, uint64_t ns, uint32_t iter)
+{
+    printf("%-11s %10u iterations %10.1f ns/op\n", pszName, iter, (double)ns / iter);
+}
+
+// CMN_Enqueue + CMN_Dequeue of one report
+static void bench_queue(uint32_t iter)
+{
+    static ST_HID_RPT stIn, stOut;
+    uint64_t start;
+    uint32_t i;
+
+    memset(&stIn, 0x5a, sizeof(stIn));
+    stIn.report_len = 8;
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        stIn.report[0] = (uint8_t)i;
+        CMN_Enqueue(CMN_QUE_KIND_HID_RPT, &stIn);
+        CMN_Dequeue(CMN_QUE_KIND_HID_RPT, &stOut);
+    }
+    bench_print("queue", bench_now_ns() - start, iter);
+}
+
+// Configuration descriptor build and device context read
+static void bench_desc(uint32_t iter)
+{
+    static ST_DCTX stCtx;
+    uint64_t start;
+    uint32_t i;
+
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        (void)tud_descriptor_configuration_cb(0);
+    }
+    bench_print("desc", bench_now_ns() - start, iter);
+
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        DCTX_Read(&stCtx);
+    }
+    bench_print("dctx_read", bench_now_ns() - start, iter);
+}
+
+// Report map compile and field extraction
+static void bench_hrd(uint32_t iter)
+{
+    static ST_HRD_MAP stMap;
+    static const uint8_t aucMouse[4] = { 0x01, 0xFF, 0x02, 0x80 }; // Button 1, X -1, Y 2, wheel -128
+    const ST_HRD_REPORT *pstReport;
+    const ST_HRD_FIELD *pstField;
+    uint16_t ble_desc_len;
+    const uint8_t *pBleDesc = HOST_BridgeGetBleDesc(&ble_desc_len);
+    uint32_t parse_iter = (iter / 10 > 0) ? iter / 10 : 1;
+    volatile int32_t sum = 0;
+    uint64_t start;
+    uint32_t i, j;
+
+    start = bench_now_ns();
+    for (i = 0; i < parse_iter; i++) {
+        HRD_Parse(pBleDesc, ble_desc_len, &stMap);
+    }
+    bench_print("hrd_parse", bench_now_ns() - start, parse_iter);
+
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        pstReport = HRD_GetReport(&stMap, REPORT_ID_MOUSE);
+        pstField = &stMap.astField[pstReport->field_idx];
+        for (j = 0; j < pstReport->field_cnt; j++) {
+            sum += HRD_GetFieldValue(&pstField[j], aucMouse, sizeof(aucMouse), i % pstField[j].count);
+        }
+    }
+    bench_print("hrd_field", bench_now_ns() - start, iter);
+}
+
+#if XFM_ENABLE
+// Report transform stage
+static void bench_xform(uint32_t iter)
+{
+    static ST_HRD_MAP stMap;
+    static uint8_t aucCfg[64];
+    ST_HID_RPT stKbd, stMouse;
+    uint16_t ble_desc_len;
+    const uint8_t *pBleDesc = HOST_BridgeGetBleDesc(&ble_desc_len);
+    uint64_t start;
+    uint32_t i;
+
+    HOST_BridgeXformConfig(aucCfg, sizeof(aucCfg));
+    (void)XFM_Init(aucCfg, sizeof(aucCfg));
+    (void)HRD_Parse(pBleDesc, ble_desc_len, &stMap);
+    XFM_Compile(&stMap);
+
+    memset(&stKbd, 0, sizeof(stKbd));
+    stKbd.report_id = REPORT_ID_KEYBOARD;
+    stKbd.report_len = 8;
+    stKbd.report[0] = 0x01; // Left Ctrl
+    stKbd.report[3] = 0x04; // A
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        stKbd.report[2] = (uint8_t)i;
+        XFM_Apply(&stKbd);
+    }
+    bench_print("xform_kbd", bench_now_ns() - start, iter);
+
+    memset(&stMouse, 0, sizeof(stMouse));
+    stMouse.report_id = REPORT_ID_MOUSE;
+    stMouse.report_len = 4;
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        stMouse.report[1] = (uint8_t)(i & 0x0F);
+        stMouse.report[2] = (uint8_t)-(int)(i & 0x0F);
+        XFM_Apply(&stMouse);
+    }
+    bench_print("xform_mouse", bench_now_ns() - start, iter);
+
+    // Back to no transform for the other benchmarks
+    memset(aucCfg, 0xFF, sizeof(aucCfg));
+    (void)XFM_Init(aucCfg, sizeof(aucCfg));
+}
+#endif
+
+#if NTFP_ENABLE
+// Core1 side of the keyboard reports: notification to queued, the queue drained between batches (ns)
+static uint64_t bench_notify(const uint8_t *pReport, uint16_t len, uint32_t iter)
+{
+    uint64_t ns = 0;
+    uint64_t start;
+    uint32_t i, j;
+
+    for (i = 0; i < iter; i += 16) {
+        HOST_SetCoreNum(1);
+        start = bench_now_ns();
+        for (j = i; (j < iter) && (j < i + 16); j++) {
+            HOST_BtHidReport(REPORT_ID_KEYBOARD, pReport, len);
+        }
+        ns += bench_now_ns() - start;
+        HOST_SetCoreNum(0);
+        for (j = i; (j < iter) && (j < i + 16); j++) {
+            send_hid_report();
+        }
+    }
+    return ns;
+}
+#endif
+
+// BLE report event to USB transfer
+static void bench_forward(uint32_t iter)
+{
+    static const uint8_t aucKey[8] = { 0x02, 0x00, 0x04, 0, 0, 0, 0, 0 };
+    uint64_t start;
+    uint32_t i;
+
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        HOST_SetCoreNum(1);
+        HOST_BtHidReport(REPORT_ID_KEYBOARD, aucKey, sizeof(aucKey));
+        HOST_SetCoreNum(0);
+        send_hid_report();
+    }
+    bench_print("forward", bench_now_ns() - start, iter);
+
+#if NTFP_ENABLE
+    bench_print("ntf_direct", bench_notify(aucKey, sizeof(aucKey), iter), iter);
+
+    // Every report through hids_client, then the direct path again as after a reconnection
+    NTFP_Stop();
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        HOST_SetCoreNum(1);
+        HOST_BtHidReport(REPORT_ID_KEYBOARD, aucKey, sizeof(aucKey));
+        HOST_SetCoreNum(0);
+        send_hid_report();
+    }
+    bench_print("fwd_hids", bench_now_ns() - start, iter);
+    bench_print("ntf_hids", bench_notify(aucKey, sizeof(aucKey), iter), iter);
+    HOST_SetCoreNum(1);
+    HOST_BtHidServiceConnected(ERROR_CODE_SUCCESS);
+    HOST_BtRunTimers();
+    HOST_SetCoreNum(0);
+#endif
+}
+
+// AES-128 kernel of the Security Manager
+static void bench_aes(uint32_t iter)
+{
+    // SP 800-38A F.1.1 key
+    static const uint8_t aucKeyEcb[16] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+    };
+    static ULONG aulRk[AES_RK_WORDS];
+    static uint8_t aucKey[16];
+    static uint8_t aucBlock[16];
+    uint64_t start;
+    uint32_t i;
+
+    AES_ExpandKey(aulRk, aucKeyEcb);
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        AES_EncryptBlock(aulRk, aucBlock, aucBlock);
+    }
+    bench_print("aes_block", bench_now_ns() - start, iter);
+
+    memcpy(aucKey, aucKeyEcb, sizeof(aucKey));
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        aucKey[i % 16]++;
+        AES_Encrypt(aucKey, aucBlock, aucBlock);
+    }
+    bench_print("aes_key", bench_now_ns() - start, iter);
+}
+
+#if RPAC_ENABLE
+// Resolution of the private addresses seen while scanning
+static void bench_rpa(uint32_t iter)
+{
+    static const uint8_t aucRpa[6] = { 0x70, 0x81, 0x94, 0x0d, 0xfb, 0xaa };
+    static uint8_t aucIrk[16];
+    static uint8_t aucAddr[6];
+    const ST_RPAC_STAT *pstStat = RPAC_GetStat();
+    uint64_t start;
+    uint32_t i;
+
+    // 16 bonds, none of them matching: a miss computes ah() 16 times
+    for (i = 0; i < 16; i++) {
+        memset(aucIrk, (int)(i + 1), sizeof(aucIrk));
+        HOST_BtSetBond((int)i, aucRpa, aucIrk);
+    }
+    RPAC_StartScan();
+    RPAC_Resolve(aucRpa, BD_ADDR_TYPE_LE_RANDOM);
+
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        RPAC_Resolve(aucRpa, BD_ADDR_TYPE_LE_RANDOM);
+    }
+    bench_print("rpa_hit", bench_now_ns() - start, iter);
+
+    memcpy(aucAddr, aucRpa, sizeof(aucAddr));
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        aucAddr[3] = (uint8_t)i;
+        aucAddr[4] = (uint8_t)(i >> 8);
+        aucAddr[5] = (uint8_t)(i >> 16);
+        RPAC_Resolve(aucAddr, BD_ADDR_TYPE_LE_RANDOM);
+    }
+    bench_print("rpa_miss", bench_now_ns() - start, iter);
+
+    // 100 unbonded devices advertising in turn, each with its own RPA
+    RPAC_StartScan();
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        aucAddr[0] = 0x40 | (uint8_t)((i % 100) * 37);
+        aucAddr[5] = (uint8_t)((i % 100) * 151);
+        RPAC_Resolve(aucAddr, BD_ADDR_TYPE_LE_RANDOM);
+    }
+    bench_print("rpa_dense", bench_now_ns() - start, iter);
+    printf("rpa_dense   hit rate %.1f %%, %.2f ah per report\n",
+        100.0 * pstStat->hit_cnt / pstStat->rpa_cnt, (double)pstStat->ah_cnt / pstStat->rpa_cnt);
+    RPAC_StopScan();
+    for (i = 0; i < 16; i++) {
+        HOST_BtSetBond((int)i, NULL, NULL);
+    }
+}
+#endif
+
+#if ADVF_ENABLE
+// Classifier of the bridge (hog_host_demo.c)
+static bool bench_adv_accept(const uint8_t *packet)
+{
+    return ad_data_contains_uuid16(gap_event_advertising_report_get_data_length(packet),
+        gap_event_advertising_report_get_data(packet), ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE);
+}
+
+// Early rejection of the advertisers already classified
+static void bench_adv(uint32_t iter)
+{
+    // A beacon filling the 31 bytes: flags, manufacturer data, name, 16-bit UUIDs
+    static const uint8_t aucAd[] = {
+        0x02, 0x01, 0x06,
+        0x0b, 0xff, 0x4c, 0x00, 0x10, 0x06, 0x33, 0x1d, 0x2a, 0x81, 0x5c, 0x08,
+        0x08, 0x09, 'B', 'e', 'a', 'c', 'o', 'n', '1',
+        0x05, 0x03, 0x0f, 0x18, 0x0a, 0x18,
+    };
+    static uint8_t aucPacket[12 + 31];
+    static uint8_t aaucDense[100][12 + 31];
+    const ST_ADVF_STAT *pstStat = ADVF_GetStat();
+    uint64_t start, hit_ns, walk_ns;
+    uint32_t i;
+
+    aucPacket[0] = GAP_EVENT_ADVERTISING_REPORT;
+    aucPacket[1] = 10 + sizeof(aucAd);
+    aucPacket[3] = BD_ADDR_TYPE_LE_RANDOM;
+    memcpy(&aucPacket[4], "\x11\x22\x33\x44\x55\xc6", 6);
+    aucPacket[10] = 0xc0; // RSSI
+    aucPacket[11] = sizeof(aucAd);
+    memcpy(&aucPacket[12], aucAd, sizeof(aucAd));
+    ADVF_StartScan();
+    ADVF_Accept(aucPacket, &bench_adv_accept);
+
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        ADVF_Accept(aucPacket, &bench_adv_accept);
+    }
+    bench_print("adv_hit", bench_now_ns() - start, iter);
+
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        bench_adv_accept(aucPacket);
+    }
+    bench_print("adv_walk", bench_now_ns() - start, iter);
+
+    // 100 non-HID devices advertising in turn, filtered and walked (reports built beforehand,
+    // as they are by the controller)
+    for (i = 0; i < 100; i++) {
+        memcpy(aaucDense[i], aucPacket, sizeof(aucPacket));
+        aaucDense[i][4] = (uint8_t)(i * 37);
+        aaucDense[i][9] = 0xc0 | (uint8_t)i;
+    }
+    ADVF_StartScan();
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        ADVF_Accept(aaucDense[i % 100], &bench_adv_accept);
+    }
+    hit_ns = bench_now_ns() - start;
+    bench_print("adv_dense", hit_ns, iter);
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        bench_adv_accept(aaucDense[i % 100]);
+    }
+    walk_ns = bench_now_ns() - start;
+    printf("adv_dense   rejected early %.1f %%, %.1f us saved per %u reports\n",
+        100.0 * pstStat->hit_cnt / pstStat->report_cnt, ((double)walk_ns - (double)hit_ns) / 1000.0, iter);
+    ADVF_StopScan();
+}
+#endif
+
+#if CRYP_ENABLE
+// Security Manager crypto commands answered on core0 instead of the controller
+static void bench_crypto(uint32_t iter)
+{
+    // LE Secure Connections sample data (Core Vol 3 Part H 2.3.5.6.1), uECC format
+    static const uint8_t aucPrivateA[32] = {
+        0x3f, 0x49, 0xf6, 0xd4, 0xa3, 0xc5, 0x5f, 0x38, 0x74, 0xc9, 0xb3, 0xe3, 0xd2, 0x10, 0x3f, 0x50,
+        0x4a, 0xff, 0x60, 0x7b, 0xeb, 0x40, 0xb7, 0x99, 0x58, 0x99, 0xb8, 0xa6, 0xcd, 0x3c, 0x1a, 0xbd,
+    };
+    static const uint8_t aucPublicA[64] = {
+        0x20, 0xb0, 0x03, 0xd2, 0xf2, 0x97, 0xbe, 0x2c, 0x5e, 0x2c, 0x83, 0xa7, 0xe9, 0xf9, 0xa5, 0xb9,
+        0xef, 0xf4, 0x91, 0x11, 0xac, 0xf4, 0xfd, 0xdb, 0xcc, 0x03, 0x01, 0x48, 0x0e, 0x35, 0x9d, 0xe6,
+        0xdc, 0x80, 0x9c, 0x49, 0x65, 0x2a, 0xeb, 0x6d, 0x63, 0x32, 0x9a, 0xbf, 0x5a, 0x52, 0x15, 0x5c,
+        0x76, 0x63, 0x45, 0xc2, 0x8f, 0xed, 0x30, 0x24, 0x74, 0x1c, 0x8e, 0xd0, 0x15, 0x89, 0xd2, 0x8b,
+    };
+    static const uint8_t aucPublicB[64] = {
+        0x1e, 0xa1, 0xf0, 0xf0, 0x1f, 0xaf, 0x1d, 0x96, 0x09, 0x59, 0x22, 0x84, 0xf1, 0x9e, 0x4c, 0x00,
+        0x47, 0xb5, 0x8a, 0xfd, 0x86, 0x15, 0xa6, 0x9f, 0x55, 0x90, 0x77, 0xb2, 0x2f, 0xaa, 0xa1, 0x90,
+        0x4c, 0x55, 0xf3, 0x3e, 0x42, 0x9d, 0xad, 0x37, 0x73, 0x56, 0x70, 0x3a, 0x9a, 0xb8, 0x51, 0x60,
+        0x47, 0x2d, 0x11, 0x30, 0xe2, 0x8e, 0x36, 0x76, 0x5f, 0x89, 0xaf, 0xf9, 0x15, 0xb1, 0x21, 0x4a,
+    };
+    // FIPS-197 C.1 (AES-128), in HCI byte order: Key, Plaintext_Data
+    static const uint8_t aucEncrypt[3 + 32] = {
+        0x17, 0x20, 32,
+        0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00,
+        0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00,
+    };
+    static uint8_t aucDhKey[3 + 64] = { 0x26, 0x20, 64 };
+    static uint8_t aucSupported[6 + 64] = { HCI_EVENT_COMMAND_COMPLETE, 4 + 64, 1, 0x02, 0x10, 0 };
+    uint64_t start;
+    uint32_t i;
+
+    // The controller reports its supported commands (the offload adds the ECC ones)
+    HOST_SetCoreNum(1);
+    HOST_BtHciEvent(aucSupported, sizeof(aucSupported));
+
+    // DHKey of the sample keys, in P256_STEPS steps that each return to the loop
+    CRYP_SetKey(aucPublicA, aucPrivateA);
+    HOST_BridgeReverseKey(&aucDhKey[3], aucPublicB);
+    start = bench_now_ns();
+    for (i = 0; i < 4; i++) {
+        HOST_BtHciCommand(aucDhKey, sizeof(aucDhKey));
+        (void)HOST_BridgeRunCrypto();
+    }
+    bench_print("p256_step", bench_now_ns() - start, 4 * P256_STEPS);
+
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        HOST_BtHciCommand(aucEncrypt, sizeof(aucEncrypt));
+        HOST_SetCoreNum(0);
+        CRYP_Task();
+        HOST_SetCoreNum(1);
+        HOST_BtRunTimers();
+    }
+    bench_print("crypto", bench_now_ns() - start, iter);
+    HOST_SetCoreNum(0);
+}
+#endif
+
+#if TPRF_ENABLE
+// Task-time profiler
+static void bench_prof(uint32_t iter)
+{
+    uint64_t start;
+    uint32_t i;
+
+    HOST_SetCoreNum(0);
+    start = bench_now_ns();
+    for (i = 0; i < iter; i++) {
+        TPRF_Begin(TPRF_TASK_HID);
+        TPRF_End();
+    }
+    bench_print("prof", bench_now_ns() - start, iter);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    uint32_t iter = BENCH_ITER_DEFAULT;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            iter = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-v") == 0) {
+            HOST_SetUartEcho(true);
+        }
+        else {
+            fprintf(stderr, "usage: %s [-n iterations] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iter == 0) {
+        iter = 1;
+    }
+
+    HOST_BridgeInit();
+
+    printf("report slot %u bytes, queue %u entries\n", (unsigned)sizeof(ST_HID_RPT), CMN_QUE_DATA_MAX_HID_RPT);
+    bench_queue(iter);
+    bench_desc(iter);
+    bench_hrd(iter);
+#if XFM_ENABLE
+    bench_xform(iter);
+#endif
+    bench_forward(iter);
+    bench_aes(iter);
+#if RPAC_ENABLE
+    bench_rpa(iter);
+#endif
+#if ADVF_ENABLE
+    bench_adv(iter);
+#endif
+#if CRYP_ENABLE
+    bench_crypto(iter);
+#endif
+#if TPRF_ENABLE
+    bench_prof(iter);
+#endif
+
+    // Output the deferred log (visible with -v)
+    for (i = 0; i < 10000; i++) {
+        LOG_Drain();
+    }
+    return 0;
+}
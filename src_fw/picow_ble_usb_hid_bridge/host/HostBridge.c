@@ -0,0 +1,259 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#include "HostBridge.h"
+#include "FlightRec.h"
+#include "tusb.h"
+#include "btstack.h"
+#include "usb_descriptors.h"
+#include "DevInfo.h"
+#include "UsbSof.h"
+#include "Watchdog.h"
+#include "BootProf.h"
+#include "TaskProf.h"
+#include "EccKey.h"
+#include "CryptoOffload.h"
+#include "P256.h"
+#include "Xform.h"
+#include "NotifyPath.h"
+
+// [Definitions]
+#define HOST_BRIDGE_CON_HANDLE 0x0040
+
+// Key pair handed to the SM: kept by the crypto offload, or by BTstack on core1
+#if CRYP_ENABLE
+#define HOST_BRIDGE_SM_KEY_CNT(n) 0
+#define HOST_BRIDGE_SM_PUBLIC_KEY() CRYP_GetPublicKey()
+#else
+#define HOST_BRIDGE_SM_KEY_CNT(n) (n)
+#define HOST_BRIDGE_SM_PUBLIC_KEY() HOST_Bt()->ecc_public_key
+#endif
+
+// [File Scope Variables]
+// Report map of the simulated BLE device (keyboard, mouse and consumer control)
+static const uint8_t f_aucBleDesc[] = {
+    TUD_HID_REPORT_DESC_KEYBOARD( HID_REPORT_ID(REPORT_ID_KEYBOARD) ),
+    TUD_HID_REPORT_DESC_MOUSE   ( HID_REPORT_ID(REPORT_ID_MOUSE) ),
+    TUD_HID_REPORT_DESC_CONSUMER( HID_REPORT_ID(REPORT_ID_CONSUMER_CONTROL) )
+};
+
+// Returns the report map of the simulated BLE device
+const uint8_t *HOST_BridgeGetBleDesc(uint16_t *pLen)
+{
+    *pLen = sizeof(f_aucBleDesc);
+    return f_aucBleDesc;
+}
+
+#if XFM_ENABLE
+// CRC-32 of the transform configuration blob
+static uint32_t host_bridge_crc32(const uint8_t *pData, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint32_t i, j;
+
+    for (i = 0; i < len; i++) {
+        crc ^= pData[i];
+        for (j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// Builds the transform configuration blob of the tools: Caps Lock -> Escape,
+// Left Ctrl <-> Left GUI, pointer gain X, Y 1.5 and wheel 1.0 (the rest of the buffer is erased flash)
+void HOST_BridgeXformConfig(uint8_t *pCfg, uint32_t size)
+{
+    static const uint8_t aucEntry[] = {
+        XFM_CFG_KEY_MAP, 2, 0x39, 0x29,
+        XFM_CFG_MOD_MAP, 4, 0, 3, 3, 0,
+        XFM_CFG_PTR_GAIN, 6, 0x80, 0x01, 0x80, 0x01, 0x00, 0x01,
+        XFM_CFG_END, 0,
+    };
+    ST_XFM_CFG_HDR stHdr = { XFM_CFG_MAGIC, XFM_CFG_VERSION, sizeof(ST_XFM_CFG_HDR) + sizeof(aucEntry), 0 };
+
+    HOST_BRIDGE_CHECK(size >= sizeof(stHdr) + sizeof(aucEntry));
+    stHdr.crc = host_bridge_crc32(aucEntry, sizeof(aucEntry));
+    memset(pCfg, 0xFF, size);
+    memcpy(pCfg, &stHdr, sizeof(stHdr));
+    memcpy(&pCfg[sizeof(stHdr)], aucEntry, sizeof(aucEntry));
+}
+#endif
+
+#if CRYP_ENABLE
+// Runs CRYP_Task on core0 until the queued command is answered on core1, returns the steps.
+// Returns on core1.
+uint32_t HOST_BridgeRunCrypto(void)
+{
+    const ST_CRYP_STAT *pstStat = CRYP_GetStat();
+    uint32_t done_cnt = pstStat->aes_cnt + pstStat->p256_cnt + pstStat->dhkey_cnt;
+    uint32_t steps = 0;
+
+    while ((pstStat->aes_cnt + pstStat->p256_cnt + pstStat->dhkey_cnt == done_cnt) && (steps <= P256_STEPS)) {
+        HOST_SetCoreNum(0);
+        CRYP_Task();
+        HOST_SetCoreNum(1);
+        HOST_BtRunTimers();
+        steps++;
+    }
+    return steps;
+}
+
+// Copies a P-256 key reversing each coordinate (uECC format <-> HCI byte order)
+void HOST_BridgeReverseKey(uint8_t *pDst, const uint8_t *pSrc)
+{
+    uint32_t i;
+
+    for (i = 0; i < 32; i++) {
+        pDst[i] = pSrc[31 - i];
+        pDst[32 + i] = pSrc[63 - i];
+    }
+}
+#endif
+
+// Initializes the firmware modules and drives the BLE state machine from power on to READY,
+// reconnects once to check the cached device identity and once after a warm restart,
+// then handles the USB re-initialization request the way usb_dev_main does.
+// Returns on core0.
+void HOST_BridgeInit(void)
+{
+    static const uint8_t aucAddr[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+    static const uint8_t aucReportId[] = { REPORT_ID_KEYBOARD, REPORT_ID_MOUSE, REPORT_ID_CONSUMER_CONTROL };
+#if WDG_ENABLE
+    const ST_DEVI *pstDevi;
+    const UCHAR *pWarmDesc;
+    USHORT warm_len;
+#endif
+#if ECCK_ENABLE
+    const btstack_tlv_t *pTlvImpl;
+    void *pTlvCtx;
+    UCHAR aucPublicKey[ECCK_PUBLIC_KEY_SIZE];
+    ULONG i;
+#endif
+
+    CMN_Init();
+    FREC_Init();
+    BPRF_Init();
+    TPRF_Init();
+    USOF_Init();
+    WDG_Init();
+
+    HOST_SetCoreNum(1);
+    ble_host_main();
+    HOST_BRIDGE_CHECK(HOST_Bt()->power_on_cnt == 1);
+#if ECCK_ENABLE
+    // The key pair is generated and stored once, and given to the SM before power on
+    HOST_BRIDGE_CHECK((HOST_Bt()->ecc_gen_cnt == 1) && (HOST_Bt()->ecc_set_key_cnt == HOST_BRIDGE_SM_KEY_CNT(1)));
+    HOST_BRIDGE_CHECK(HOST_Bt()->tlv_store_cnt == 1);
+#endif
+
+    HOST_BtEventState(HCI_STATE_WORKING);
+    HOST_BRIDGE_CHECK(HOST_Bt()->scan_start_cnt == 1); // No bonded device yet
+
+    HOST_BtAdvReport(aucAddr, false);
+    HOST_BRIDGE_CHECK(HOST_Bt()->connect_cnt == 0);
+    HOST_BtAdvReport(aucAddr, true);
+    HOST_BRIDGE_CHECK(HOST_Bt()->connect_cnt == 1);
+
+    HOST_BtLeConnectionComplete(HOST_BRIDGE_CON_HANDLE);
+    HOST_BRIDGE_CHECK(HOST_Bt()->pairing_cnt == 1);
+
+    HOST_BtPairingComplete(HOST_BRIDGE_CON_HANDLE, ERROR_CODE_SUCCESS);
+    HOST_BRIDGE_CHECK(HOST_Bt()->hids_connect_cnt == 1);
+
+    HOST_BtSetHidDescriptor(f_aucBleDesc, sizeof(f_aucBleDesc));
+    HOST_BtSetHidReports(aucReportId, sizeof(aucReportId));
+    HOST_BtHidServiceConnected(ERROR_CODE_SUCCESS);
+    HOST_BRIDGE_CHECK(HOST_Bt()->dis_query_cnt == 1);
+    // The bond is written at once, without waiting for USB to be idle
+    HOST_BRIDGE_CHECK(HOST_Bt()->tlv_store_cnt == (ECCK_ENABLE ? 3 : 1));
+    HOST_BRIDGE_CHECK(!is_ble_app_state_ready());
+
+    HOST_BtDeviceInformation(HOST_BRIDGE_MANUFACTURER, HOST_BRIDGE_MODEL, DEVI_VID_SRC_USB, HOST_BRIDGE_VID, HOST_BRIDGE_PID);
+    HOST_BRIDGE_CHECK(is_ble_app_state_ready());
+    HOST_BRIDGE_CHECK(g_usb_reinit_request);
+
+    // The device identity is written by the TLV cache once USB is idle.
+    // The input report value handles of the direct path are discovered in the meantime.
+    HOST_AdvanceUs(200 * 1000);
+    HOST_BtRunTimers();
+    HOST_BRIDGE_CHECK(HOST_Bt()->tlv_store_cnt == (ECCK_ENABLE ? 4 : 2));
+#if NTFP_ENABLE
+    HOST_BRIDGE_CHECK((HOST_Bt()->gatt_query_cnt == 3) && (NTFP_GetStat()->handle_cnt == sizeof(aucReportId)));
+#endif
+
+    // Reconnection: the identity comes from the cache, nothing is written
+    g_usb_reinit_request = false;
+    HOST_BtDisconnectionComplete(HOST_BRIDGE_CON_HANDLE);
+    HOST_BRIDGE_CHECK(HOST_Bt()->connect_cnt == 2);
+    HOST_BtLeConnectionComplete(HOST_BRIDGE_CON_HANDLE);
+    HOST_BtReencryptionComplete(HOST_BRIDGE_CON_HANDLE, ERROR_CODE_SUCCESS);
+    HOST_BtHidServiceConnected(ERROR_CODE_SUCCESS);
+    HOST_BRIDGE_CHECK(HOST_Bt()->dis_query_cnt == 1);
+    HOST_BRIDGE_CHECK(is_ble_app_state_ready());
+    HOST_BRIDGE_CHECK(g_usb_reinit_request);
+    HOST_AdvanceUs(200 * 1000);
+    HOST_BtRunTimers();
+    HOST_BRIDGE_CHECK(HOST_Bt()->tlv_store_cnt == (ECCK_ENABLE ? 4 : 2));
+
+#if ECCK_ENABLE
+    // Next boot: the stored key pair is used as is until ECCK_ROTATE_PAIRINGS pairings were made with it
+    btstack_tlv_get_instance(&pTlvImpl, &pTlvCtx);
+    memcpy(aucPublicKey, HOST_BRIDGE_SM_PUBLIC_KEY(), sizeof(aucPublicKey));
+    ECCK_Init(pTlvImpl, pTlvCtx);
+    HOST_BRIDGE_CHECK((HOST_Bt()->ecc_gen_cnt == 1) && (HOST_Bt()->ecc_set_key_cnt == HOST_BRIDGE_SM_KEY_CNT(2)));
+    HOST_BRIDGE_CHECK(memcmp(aucPublicKey, HOST_BRIDGE_SM_PUBLIC_KEY(), sizeof(aucPublicKey)) == 0);
+    for (i = 1; i < ECCK_ROTATE_PAIRINGS; i++) {
+        ECCK_OnPairing();
+    }
+    ECCK_Init(pTlvImpl, pTlvCtx);
+    HOST_BRIDGE_CHECK((HOST_Bt()->ecc_gen_cnt == 2) && (HOST_Bt()->ecc_set_key_cnt == HOST_BRIDGE_SM_KEY_CNT(3)));
+    HOST_BRIDGE_CHECK(memcmp(aucPublicKey, HOST_BRIDGE_SM_PUBLIC_KEY(), sizeof(aucPublicKey)) != 0);
+#endif
+
+#if WDG_ENABLE
+    // Warm restart: the device connected at the watchdog reset is presented on USB from boot.
+    // The disconnection stands in for the restart of the BLE side; the device comes back
+    // unchanged, so the USB device is not re-enumerated.
+    HOST_SetCoreNum(0);
+    tud_mount_cb();
+    HOST_Wdg()->bCausedReboot = true;
+    WDG_Init();
+    HOST_Wdg()->bCausedReboot = false;
+    HOST_BRIDGE_CHECK(HOST_Wdg()->bEnabled);
+    pWarmDesc = WDG_GetWarmDevice(&warm_len, &pstDevi);
+    HOST_BRIDGE_CHECK((pWarmDesc != NULL) && (warm_len == sizeof(f_aucBleDesc)) && (memcmp(pWarmDesc, f_aucBleDesc, warm_len) == 0));
+    HOST_BRIDGE_CHECK(strcmp(pstDevi->model, HOST_BRIDGE_MODEL) == 0);
+    HOST_SetCoreNum(1);
+    g_usb_reinit_request = false;
+    HOST_BtDisconnectionComplete(HOST_BRIDGE_CON_HANDLE);
+    HOST_BRIDGE_CHECK(HOST_Bt()->connect_cnt == 3);
+    HOST_BtLeConnectionComplete(HOST_BRIDGE_CON_HANDLE);
+    HOST_BtReencryptionComplete(HOST_BRIDGE_CON_HANDLE, ERROR_CODE_SUCCESS);
+    HOST_BtHidServiceConnected(ERROR_CODE_SUCCESS);
+    HOST_BRIDGE_CHECK(is_ble_app_state_ready());
+    HOST_BRIDGE_CHECK(!g_usb_reinit_request);
+    HOST_BRIDGE_CHECK(WDG_GetWarmDevice(&warm_len, &pstDevi) == NULL);
+#endif
+
+    // USB suspend: core1 relaxes the BLE link, then restores the parameters the device negotiated
+    HOST_BtConnectionUpdateComplete(HOST_BRIDGE_CON_HANDLE, HOST_BT_CONN_INTERVAL * 2, 0);
+    HOST_SetCoreNum(0);
+    tud_suspend_cb(true);
+    HOST_SetCoreNum(1);
+    HOST_AdvanceUs(200 * 1000);
+    HOST_BtRunTimers();
+    HOST_BRIDGE_CHECK((HOST_Bt()->conn_update_cnt == 1) && (HOST_Bt()->conn_interval > HOST_BT_CONN_INTERVAL * 2));
+    HOST_BtConnectionUpdateComplete(HOST_BRIDGE_CON_HANDLE, HOST_Bt()->conn_interval, HOST_Bt()->conn_latency);
+    HOST_SetCoreNum(0);
+    tud_resume_cb();
+    HOST_SetCoreNum(1);
+    HOST_AdvanceUs(200 * 1000);
+    HOST_BtRunTimers();
+    HOST_BRIDGE_CHECK((HOST_Bt()->conn_update_cnt == 2) && (HOST_Bt()->conn_interval == HOST_BT_CONN_INTERVAL * 2) &&
+                      (HOST_Bt()->conn_latency == 0));
+
+    // What usb_dev_main does on core0
+    HOST_SetCoreNum(0);
+    g_usb_reinit_request = false;
+    CMN_ClearQueue(CMN_QUE_KIND_HID_RPT);
+    tud_connect();
+}
@@ -0,0 +1,43 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef HOSTBRIDGE_H
+#define HOSTBRIDGE_H
+
+#include "Common.h"
+#include "HostStub.h"
+
+// Harness shared by the host-native tools: brings the firmware into the
+// state it has after a BLE HID device has connected.
+
+// [Definitions]
+#define HOST_BRIDGE_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+// Device Information Service of the simulated BLE device
+#define HOST_BRIDGE_MANUFACTURER "Shiomachi"
+#define HOST_BRIDGE_MODEL        "Host Keyboard"
+#define HOST_BRIDGE_VID          0x1234
+#define HOST_BRIDGE_PID          0x5678
+
+// [Firmware symbols without a header]
+extern volatile bool g_usb_reinit_request;
+extern bool send_hid_report(void);
+extern bool is_ble_app_state_ready(void);
+extern void ble_host_main(void);
+
+// [Function Prototypes]
+const uint8_t *HOST_BridgeGetBleDesc(uint16_t *pLen);
+void HOST_BridgeInit(void);
+#if XFM_ENABLE
+void HOST_BridgeXformConfig(uint8_t *pCfg, uint32_t size);
+#endif
+#if CRYP_ENABLE
+uint32_t HOST_BridgeRunCrypto(void);
+void HOST_BridgeReverseKey(uint8_t *pDst, const uint8_t *pSrc);
+#endif
+
+#endif
@@ -0,0 +1,261 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Fuzz driver of the report map parser (host-native build, see CMakeLists.txt).
+//
+// Feeds mutated report maps (bit flips, byte changes, inserted and removed bytes,
+// spliced items, random data) to HRD_Parse and checks the invariants of the
+// compiled map. Each input is parsed from a heap copy of exactly its length, so
+// out-of-bounds reads are caught when built with -DBRIDGE_HOST_SANITIZE=ON.
+// Exits with 1 and writes the failing input to hrd_fuzz_fail.bin on a violation.
+//
+// Usage: bridge_hrd_fuzz [-n iterations] [-s seed]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HidRptDesc.h"
+#include "tusb.h"
+#include "usb_descriptors.h"
+#include "HostBridge.h"
+
+// [Definitions]
+#define FUZZ_ITER_DEFAULT 1000000
+#define FUZZ_LEN_MAX      600  // Larger than the BTstack descriptor storage
+#define FUZZ_FAIL_FILE    "hrd_fuzz_fail.bin"
+
+// [File Scope Variables]
+// Seed report maps
+static const uint8_t f_aucSeedNoId[] = {
+    TUD_HID_REPORT_DESC_KEYBOARD()
+};
+static const uint8_t f_aucSeedGamepad[] = {
+    TUD_HID_REPORT_DESC_GAMEPAD( HID_REPORT_ID(REPORT_ID_GAMEPAD) )
+};
+static const uint8_t f_aucSeedPush[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x05,  // Desktop, Mouse, Application, Report ID 5
+    0xA4, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95,  // Push, 0..1, 1 bit x 3
+    0x03, 0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x81,  // Buttons 1-3, Input
+    0x02, 0xB4, 0x75, 0x05, 0x95, 0x01, 0x81, 0x01,  // Pop, 5 bit padding
+    0x16, 0x01, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10,  // -32767..32767, 16 bit x 2
+    0x95, 0x02, 0x0B, 0x30, 0x00, 0x01, 0x00, 0x0B,  // Extended usages X, Y
+    0x31, 0x00, 0x01, 0x00, 0x81, 0x06, 0xFE, 0x02,  // Input (relative), long item
+    0x10, 0xAA, 0xBB, 0x75, 0x08, 0x95, 0x02, 0xB1,  // Feature 2 bytes
+    0x02, 0xC0,
+};
+
+static uint64_t f_rnd;
+
+static uint32_t fuzz_rand(void)
+{
+    f_rnd = f_rnd * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(f_rnd >> 33);
+}
+
+static void fuzz_fail(const char *pszWhat, const uint8_t *pDesc, uint32_t len, uint32_t iter)
+{
+    FILE *fp = fopen(FUZZ_FAIL_FILE, "wb");
+
+    if (fp != NULL) {
+        fwrite(pDesc, 1, len, fp);
+        fclose(fp);
+    }
+    fprintf(stderr, "iteration %u: %s (input written to %s)\n", iter, pszWhat, FUZZ_FAIL_FILE);
+    exit(1);
+}
+
+#define FUZZ_CHECK(cond) \
+    do { if (!(cond)) fuzz_fail(#cond, pDesc, len, iter); } while (0)
+
+// Checks the invariants of a compiled map
+static void fuzz_check(const uint8_t *pDesc, uint32_t len, uint32_t iter, E_HRD_RESULT eRet, const ST_HRD_MAP *pstMap)
+{
+    static uint8_t aucData[CMN_HID_RPT_DATA_SIZE];
+    static uint8_t aucDst[CMN_HID_RPT_DATA_SIZE];
+    const ST_HRD_REPORT *pstReport;
+    const ST_HRD_FIELD *pstField;
+    uint32_t field_sum = 0;
+    uint32_t id_cnt = 0;
+    uint32_t end, i, j, k;
+
+    FUZZ_CHECK(eRet < HRD_RESULT_NUM);
+    if (eRet != HRD_OK) {
+        FUZZ_CHECK(!pstMap->bValid && (pstMap->report_cnt == 0) && (pstMap->field_cnt == 0));
+        return;
+    }
+
+    FUZZ_CHECK(pstMap->bValid);
+    FUZZ_CHECK((pstMap->report_cnt >= 1) && (pstMap->report_cnt <= HRD_REPORT_MAX));
+    FUZZ_CHECK(pstMap->field_cnt <= HRD_FIELD_MAX);
+    FUZZ_CHECK(pstMap->bUseId || ((pstMap->report_cnt == 1) && (pstMap->astReport[0].report_id == HRD_NO_REPORT_ID)));
+    for (i = 0; i < 256; i++) {
+        if (pstMap->aucIndex[i] != 0) {
+            id_cnt++;
+            FUZZ_CHECK(pstMap->aucIndex[i] <= pstMap->report_cnt);
+            FUZZ_CHECK(pstMap->astReport[pstMap->aucIndex[i] - 1].report_id == i);
+        }
+    }
+    FUZZ_CHECK(id_cnt == pstMap->report_cnt);
+
+    for (i = 0; i < pstMap->report_cnt; i++) {
+        pstReport = &pstMap->astReport[i];
+        FUZZ_CHECK(HRD_GetReport(pstMap, pstReport->report_id) == pstReport);
+        FUZZ_CHECK(pstReport->in_bits <= CMN_HID_RPT_DATA_SIZE * 8);
+        FUZZ_CHECK((uint32_t)pstReport->field_idx + pstReport->field_cnt <= pstMap->field_cnt);
+        FUZZ_CHECK(pstReport->rel_cnt <= pstReport->field_cnt);
+        field_sum += pstReport->field_cnt;
+
+        // Fields are in report order and inside the report
+        end = 0;
+        for (j = 0; j < pstReport->field_cnt; j++) {
+            pstField = &pstMap->astField[pstReport->field_idx + j];
+            FUZZ_CHECK((pstField->bit_size >= 1) && (pstField->bit_size <= 32) && (pstField->count >= 1));
+            FUZZ_CHECK(pstField->bit_off >= end);
+            end = (uint32_t)pstField->bit_off + (uint32_t)pstField->bit_size * pstField->count;
+            FUZZ_CHECK(end <= pstReport->in_bits);
+        }
+
+        // Every element can be extracted from a report of the expected length
+        for (k = 0; k < HRD_GetInputLen(pstReport); k++) {
+            aucData[k] = (uint8_t)fuzz_rand();
+        }
+        for (j = 0; j < pstReport->field_cnt; j++) {
+            pstField = &pstMap->astField[pstReport->field_idx + j];
+            for (k = 0; k < pstField->count; k++) {
+                (void)HRD_GetFieldValue(pstField, aucData, HRD_GetInputLen(pstReport), k);
+            }
+            FUZZ_CHECK(HRD_GetFieldValue(pstField, aucData, HRD_GetInputLen(pstReport), pstField->count) == 0);
+        }
+
+        // A report merged into itself: unchanged unless it has movement that fits
+        memcpy(aucDst, aucData, HRD_GetInputLen(pstReport));
+        if (!HRD_MergeReport(pstMap, pstReport, aucDst, aucData, HRD_GetInputLen(pstReport))) {
+            FUZZ_CHECK(memcmp(aucDst, aucData, HRD_GetInputLen(pstReport)) == 0);
+        }
+        else {
+            FUZZ_CHECK(pstReport->rel_cnt > 0);
+        }
+    }
+    FUZZ_CHECK(field_sum == pstMap->field_cnt);
+}
+
+// Builds the next input from a seed
+static uint32_t fuzz_mutate(uint8_t *pBuf, const uint8_t *pSeed, uint32_t seed_len)
+{
+    uint32_t len = seed_len;
+    uint32_t n, i, pos, cnt;
+
+    memcpy(pBuf, pSeed, seed_len);
+
+    // Random data now and then
+    if ((fuzz_rand() % 16) == 0) {
+        len = fuzz_rand() % FUZZ_LEN_MAX;
+        for (i = 0; i < len; i++) {
+            pBuf[i] = (uint8_t)fuzz_rand();
+        }
+        return len;
+    }
+
+    n = 1 + fuzz_rand() % 8;
+    for (i = 0; (i < n) && (len > 0); i++) {
+        pos = fuzz_rand() % len;
+        switch (fuzz_rand() % 6) {
+        case 0: // Bit flip
+            pBuf[pos] ^= (uint8_t)(1u << (fuzz_rand() % 8));
+            break;
+        case 1: // Interesting value
+            pBuf[pos] = (uint8_t[]){ 0x00, 0x01, 0x7F, 0x80, 0xFF, 0xFE, 0xC0, 0x85 }[fuzz_rand() % 8];
+            break;
+        case 2: // Random byte
+            pBuf[pos] = (uint8_t)fuzz_rand();
+            break;
+        case 3: // Insert bytes
+            cnt = 1 + fuzz_rand() % 4;
+            if (len + cnt <= FUZZ_LEN_MAX) {
+                memmove(&pBuf[pos + cnt], &pBuf[pos], len - pos);
+                while (cnt-- > 0) {
+                    pBuf[pos + cnt] = (uint8_t)fuzz_rand();
+                    len++;
+                }
+            }
+            break;
+        case 4: // Remove bytes
+            cnt = 1 + fuzz_rand() % 4;
+            cnt = (cnt > len - pos) ? len - pos : cnt;
+            memmove(&pBuf[pos], &pBuf[pos + cnt], len - pos - cnt);
+            len -= cnt;
+            break;
+        default: // Duplicate a block (repeats items and collections)
+            cnt = 1 + fuzz_rand() % 16;
+            cnt = (cnt > len - pos) ? len - pos : cnt;
+            if (len + cnt <= FUZZ_LEN_MAX) {
+                memmove(&pBuf[pos + cnt], &pBuf[pos], len - pos);
+                len += cnt;
+            }
+            break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t aucBuf[FUZZ_LEN_MAX];
+    static ST_HRD_MAP stMap, stMap2;
+    const uint8_t *apSeed[4];
+    uint16_t aSeedLen[4];
+    uint32_t aResult[HRD_RESULT_NUM] = {0};
+    uint32_t iter = FUZZ_ITER_DEFAULT;
+    uint32_t seed = 1;
+    uint32_t len, s, i;
+    uint8_t *pDesc;
+    E_HRD_RESULT eRet;
+
+    for (i = 1; i < (uint32_t)argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < (uint32_t)argc)) {
+            iter = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < (uint32_t)argc)) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else {
+            fprintf(stderr, "usage: %s [-n iterations] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+    f_rnd = seed;
+
+    apSeed[0] = HOST_BridgeGetBleDesc(&aSeedLen[0]);
+    apSeed[1] = f_aucSeedNoId;    aSeedLen[1] = sizeof(f_aucSeedNoId);
+    apSeed[2] = f_aucSeedGamepad; aSeedLen[2] = sizeof(f_aucSeedGamepad);
+    apSeed[3] = f_aucSeedPush;    aSeedLen[3] = sizeof(f_aucSeedPush);
+
+    // The seeds themselves are valid
+    for (s = 0; s < 4; s++) {
+        if (HRD_Parse(apSeed[s], aSeedLen[s], &stMap) != HRD_OK) {
+            fprintf(stderr, "seed %u rejected\n", s);
+            return 1;
+        }
+    }
+
+    for (i = 0; i < iter; i++) {
+        s = fuzz_rand() % 4;
+        len = fuzz_mutate(aucBuf, apSeed[s], aSeedLen[s]);
+
+        pDesc = malloc((len > 0) ? len : 1);
+        memcpy(pDesc, aucBuf, len);
+        eRet = HRD_Parse(pDesc, len, &stMap);
+        aResult[eRet < HRD_RESULT_NUM ? eRet : 0]++;
+        fuzz_check(pDesc, len, i, eRet, &stMap);
+
+        // Parsing is deterministic
+        if ((HRD_Parse(pDesc, len, &stMap2) != eRet) || (memcmp(&stMap, &stMap2, sizeof(stMap)) != 0)) {
+            fuzz_fail("parse is not deterministic", pDesc, len, i);
+        }
+        free(pDesc);
+    }
+
+    printf("%u inputs:", iter);
+    for (i = 0; i < HRD_RESULT_NUM; i++) {
+        printf(" %u", aResult[i]);
+    }
+    printf(" (by E_HRD_RESULT)\n");
+    return 0;
+}
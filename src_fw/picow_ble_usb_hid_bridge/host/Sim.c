@@ -0,0 +1,541 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Trace-replay simulator of the report pipeline (host-native build, see CMakeLists.txt).
+//
+// Replays a trace (Trace.h) through the real firmware path in virtual time:
+//   BLE report (core1) -> hid_handle_input_report -> report queue
+//   -> send_hid_report (core0 loop) -> tud_hid_report -> USB IN transfer
+// The USB host starts each 1 ms frame with an SOF (tud_sof_cb) and polls the interrupt
+// endpoint at a fixed phase after it (-f); a submitted report stays in flight
+// (tud_hid_ready() is false) until the next poll. Movement reports are aligned to the
+// poll and merged by UsbSof.c unless -u is given.
+// Suspend windows from the trace stop the SOFs and polls until the host resumes on its own
+// or after a remote wakeup request. Movement reports merged by UsbSuspend.c while suspended
+// are delivered with the last held report sent after the resume; the others wait in the queue.
+// The controller delivers a report only while it has one of the HCI_HOST_ACL_PACKET_NUM
+// buffer credits of controller-to-host flow control; otherwise the report waits on the link
+// (the device retransmits it) and is delivered as soon as a credit is returned, with the
+// waiting counted in its latency. AclFlow.c holds the credits back while the queue is full.
+//
+// Usage:
+//   bridge_sim gen <conn|barcode|mouse> -o trace.bin [-d ms] [-i us] [-b n] [-s start_ms:len_ms]
+//   bridge_sim run trace.bin [-l loop_us] [-w wake_ms] [-p poll_skip_pct] [-f phase_us] [-u] [-v]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Common.h"
+#include "Log.h"
+#include "tusb.h"
+#include "UsbSof.h"
+#include "UsbSuspend.h"
+#include "AclFlow.h"
+#include "HostBridge.h"
+#include "Trace.h"
+
+// [Definitions]
+#define SIM_FRAME_US        1000        // Full-speed frame
+#define SIM_TIME_NONE       UINT64_MAX
+#define SIM_LOOP_US_DEFAULT 20          // Period of the core0 main loop
+#define SIM_WAKE_MS_DEFAULT 20          // Remote wakeup to resume (resume signaling + host recovery)
+#define SIM_LINK_MAX        1024        // Reports the device can keep while the link is stalled
+
+// [Structures]
+// Generator parameters
+typedef struct _ST_SIM_GEN {
+    uint32_t duration_ms;    // Length of the trace
+    uint32_t interval_us;    // Connection interval / report period
+    uint32_t burst;          // Reports per connection event
+    uint32_t suspend_ms;     // Start of the suspend window (0: none)
+    uint32_t suspend_len_ms; // Length of the suspend window
+} ST_SIM_GEN;
+
+// Simulation parameters
+typedef struct _ST_SIM_CFG {
+    uint32_t loop_us;        // Period of the core0 main loop
+    uint32_t wake_ms;        // Remote wakeup to resume
+    uint32_t poll_skip_pct;  // Probability that the host skips a poll (busy host controller)
+    uint32_t poll_phase_us;  // Poll time after the SOF of each frame
+    bool bAlign;             // Align movement reports to the poll (USOF_SetAlign)
+} ST_SIM_CFG;
+
+// Reports waiting on the BLE link (kept by the device) and reports in the bridge queue
+typedef struct _ST_SIM_LINK {
+    ST_TRACE_REC astRec[SIM_LINK_MAX];
+    uint8_t aucData[SIM_LINK_MAX][TRACE_DATA_MAX];
+    uint64_t aTime[SIM_LINK_MAX];                     // Time each waiting report was generated
+    uint32_t head, tail;
+    uint64_t aArrival[CMN_QUE_DATA_MAX_HID_RPT];      // Time each queued report was generated
+    uint32_t arr_head, arr_tail;
+} ST_SIM_LINK;
+
+// Results of one run
+typedef struct _ST_SIM_RESULT {
+    uint32_t report_cnt;     // Reports in the trace
+    uint32_t drop_cnt;       // Reports dropped because the queue was full (or the device could not keep them)
+    uint32_t wait_cnt;       // Reports that waited for a controller credit
+    uint32_t wait_max;       // Maximum reports waiting on the link
+    uint32_t done_cnt;       // Reports delivered to the host
+    uint32_t *pLatency;      // Latency of each delivered report (us)
+    uint32_t depth_max;      // Maximum queue depth
+    uint64_t depth_sum;      // Sum of the queue depth at each enqueue
+    uint32_t wakeup_cnt;     // tud_remote_wakeup() calls
+    uint32_t poll_skip_cnt;  // Polls skipped by the host
+    uint32_t xfer_cnt;       // IN transfers (reports merged by UsbSof.c share one)
+} ST_SIM_RESULT;
+
+//--------------------------------------------------------------------+
+// Trace generators
+//--------------------------------------------------------------------+
+static void sim_put(FILE *fp, uint32_t *pCnt, uint32_t time_us, uint8_t kind, uint8_t report_id, const uint8_t *pData, uint16_t len)
+{
+    ST_TRACE_REC stRec = { time_us, kind, report_id, len };
+
+    fwrite(&stRec, sizeof(stRec), 1, fp);
+    if (len > 0) {
+        fwrite(pData, 1, len, fp);
+    }
+    (*pCnt)++;
+}
+
+static int sim_gen(const char *pszProfile, const char *pszOut, const ST_SIM_GEN *pstGen)
+{
+    ST_TRACE_HDR stHdr = { TRACE_MAGIC, TRACE_VERSION, 0, 0 };
+    uint32_t end_us = pstGen->duration_ms * 1000;
+    uint32_t susp_us = pstGen->suspend_ms * 1000;
+    bool bSuspPut = (pstGen->suspend_ms == 0);
+    uint8_t aucRpt[8] = {0};
+    uint32_t t, i, n = 0;
+    FILE *fp;
+
+    fp = fopen(pszOut, "wb");
+    if (fp == NULL) {
+        perror(pszOut);
+        return 1;
+    }
+    fwrite(&stHdr, sizeof(stHdr), 1, fp);
+
+    for (t = 0; t < end_us; t += pstGen->interval_us) {
+        if (!bSuspPut && (t >= susp_us)) {
+            sim_put(fp, &stHdr.rec_cnt, susp_us, TRACE_KIND_SUSPEND, 0, NULL, 0);
+            sim_put(fp, &stHdr.rec_cnt, susp_us + pstGen->suspend_len_ms * 1000, TRACE_KIND_RESUME, 0, NULL, 0);
+            bSuspPut = true;
+        }
+        if (strcmp(pszProfile, "mouse") == 0) {
+            // Relative reports, one per period (more with -b)
+            for (i = 0; i < pstGen->burst; i++) {
+                aucRpt[0] = 0;
+                aucRpt[1] = (uint8_t)(n % 7) - 3;
+                aucRpt[2] = 1;
+                aucRpt[3] = 0;
+                sim_put(fp, &stHdr.rec_cnt, t + i * 150, TRACE_KIND_REPORT, 2, aucRpt, 4);
+                n++;
+            }
+        }
+        else {
+            // Keyboard reports packed into connection events, alternating key down / key up.
+            // conn: a few reports per event, barcode: as many as the link carries.
+            for (i = 0; i < pstGen->burst; i++) {
+                memset(aucRpt, 0, sizeof(aucRpt));
+                if ((n & 1) == 0) {
+                    aucRpt[2] = (uint8_t)(0x04 + (n / 2) % 26);
+                }
+                sim_put(fp, &stHdr.rec_cnt, t + i * 150, TRACE_KIND_REPORT, 1, aucRpt, 8);
+                n++;
+            }
+        }
+    }
+
+    fseek(fp, 0, SEEK_SET);
+    fwrite(&stHdr, sizeof(stHdr), 1, fp);
+    fclose(fp);
+    printf("%s: %u records\n", pszOut, stHdr.rec_cnt);
+    return 0;
+}
+
+//--------------------------------------------------------------------+
+// Replay
+//--------------------------------------------------------------------+
+static int sim_cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t sim_percentile(const uint32_t *pSorted, uint32_t cnt, uint32_t pct)
+{
+    if (cnt == 0) {
+        return 0;
+    }
+    return pSorted[((uint64_t)cnt * pct + 99) / 100 - 1];
+}
+
+static uint64_t sim_min(uint64_t a, uint64_t b)
+{
+    return (a < b) ? a : b;
+}
+
+// Controller buffers the host has not returned yet
+static uint32_t sim_acl_credits(void)
+{
+    uint32_t used = HOST_Bt()->acl_rx_cnt - HOST_Bt()->acl_done_cnt;
+
+    return (used < HCI_HOST_ACL_PACKET_NUM) ? HCI_HOST_ACL_PACKET_NUM - used : 0;
+}
+
+// Delivers the reports waiting on the link while the controller has credits
+static void sim_link_deliver(ST_SIM_LINK *pstLink, ST_SIM_RESULT *pstRes)
+{
+    uint32_t slot, cnt;
+
+    while ((pstLink->head != pstLink->tail) && (sim_acl_credits() > 0)) {
+        slot = pstLink->head % SIM_LINK_MAX;
+        HOST_SetCoreNum(1);
+        cnt = CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT);
+        HOST_BtHidReport(pstLink->astRec[slot].report_id, pstLink->aucData[slot], pstLink->astRec[slot].len);
+        HOST_SetCoreNum(0);
+        if (CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) > cnt) {
+            pstLink->aArrival[pstLink->arr_tail] = pstLink->aTime[slot];
+            pstLink->arr_tail = (pstLink->arr_tail + 1) % CMN_QUE_DATA_MAX_HID_RPT;
+            cnt++;
+            pstRes->depth_sum += cnt;
+            if (cnt > pstRes->depth_max) {
+                pstRes->depth_max = cnt;
+            }
+        }
+        else {
+            pstRes->drop_cnt++;
+        }
+        pstLink->head++;
+    }
+}
+
+static int sim_run(const char *pszTrace, const ST_SIM_CFG *pstCfg, ST_SIM_RESULT *pstRes)
+{
+    static uint8_t aucData[TRACE_DATA_MAX];
+    static ST_SIM_LINK stLink;
+    uint64_t *pInflight;                                  // Arrival time of each report of the transfer in flight
+    uint64_t *pHeld;                                      // Arrival time of each report held while suspended
+    uint32_t held_cnt = 0;
+    ST_HOST_USB *pstUsb = HOST_Usb();
+    ST_TRACE_HDR stHdr;
+    ST_TRACE_REC stRec;
+    uint32_t rec_left;
+    uint64_t base_us, now;
+    uint64_t next_trace = SIM_TIME_NONE;
+    uint64_t next_core0 = SIM_TIME_NONE;
+    uint64_t wake_at = SIM_TIME_NONE;
+    uint64_t resume_at = SIM_TIME_NONE;
+    uint64_t next_sof, next_poll;
+    uint32_t inflight_cnt = 0;
+    uint32_t rnd = 12345;
+    uint32_t cnt, usb_cnt, wakeup_cnt, xfer_cnt, i;
+    FILE *fp;
+
+    fp = fopen(pszTrace, "rb");
+    if (fp == NULL) {
+        perror(pszTrace);
+        return 1;
+    }
+    if ((fread(&stHdr, sizeof(stHdr), 1, fp) != 1) || (stHdr.magic != TRACE_MAGIC) || (stHdr.version != TRACE_VERSION)) {
+        fprintf(stderr, "%s: not a trace file\n", pszTrace);
+        fclose(fp);
+        return 1;
+    }
+
+    memset(pstRes, 0, sizeof(*pstRes));
+    stLink.head = stLink.tail = 0;
+    stLink.arr_head = stLink.arr_tail = 0;
+    pstRes->pLatency = calloc(stHdr.rec_cnt + 1, sizeof(uint32_t));
+    pInflight = calloc(stHdr.rec_cnt + 1, sizeof(uint64_t));
+    pHeld = calloc(stHdr.rec_cnt + 1, sizeof(uint64_t));
+    rec_left = stHdr.rec_cnt;
+
+    // Transfers complete on the frame polls, not immediately
+    pstUsb->bAutoComplete = false;
+    pstUsb->bReady = true;
+    USOF_SetAlign(pstCfg->bAlign);
+    USPD_ClearStat();
+    usb_cnt = pstUsb->report_cnt;
+    base_us = HOST_GetTimeUs();
+
+    for (;;) {
+        // Read the next record
+        if ((next_trace == SIM_TIME_NONE) && (rec_left > 0)) {
+            if ((fread(&stRec, sizeof(stRec), 1, fp) != 1) || (stRec.len > TRACE_DATA_MAX) ||
+                (fread(aucData, 1, stRec.len, fp) != stRec.len)) {
+                fprintf(stderr, "%s: truncated\n", pszTrace);
+                break;
+            }
+            rec_left--;
+            next_trace = base_us + stRec.time_us;
+        }
+
+        // Next SOF while the bus is running and there is still work, next poll while a transfer is in flight
+        now = HOST_GetTimeUs();
+        next_sof = (!pstUsb->bSuspended && ((next_trace != SIM_TIME_NONE) || (next_core0 != SIM_TIME_NONE) || (inflight_cnt > 0) ||
+                                            (stLink.head != stLink.tail))) ?
+                   ((now / SIM_FRAME_US) + 1) * SIM_FRAME_US : SIM_TIME_NONE;
+        next_poll = ((inflight_cnt > 0) && !pstUsb->bSuspended) ?
+                    ((now + SIM_FRAME_US - pstCfg->poll_phase_us) / SIM_FRAME_US) * SIM_FRAME_US + pstCfg->poll_phase_us : SIM_TIME_NONE;
+
+        now = sim_min(sim_min(sim_min(next_trace, next_core0), sim_min(next_sof, next_poll)), sim_min(wake_at, resume_at));
+        if (now == SIM_TIME_NONE) {
+            break;
+        }
+        HOST_AdvanceUs(now - HOST_GetTimeUs());
+
+        // Host resumes the bus
+        if ((now == wake_at) || (now == resume_at)) {
+            wake_at = SIM_TIME_NONE;
+            resume_at = SIM_TIME_NONE;
+            pstUsb->bSuspended = false;
+            tud_resume_cb();
+            next_core0 = sim_min(next_core0, now + pstCfg->loop_us);
+        }
+
+        // Start of frame
+        if (now == next_sof) {
+            tud_sof_cb((uint32_t)(now / SIM_FRAME_US) & 0x7ff);
+        }
+
+        // Host polls the interrupt endpoint
+        if (now == next_poll) {
+            rnd = rnd * 1103515245 + 12345;
+            if ((pstCfg->poll_skip_pct > 0) && (((rnd >> 16) % 100) < pstCfg->poll_skip_pct)) {
+                pstRes->poll_skip_cnt++;
+            }
+            else {
+                HOST_UsbCompleteTransfer();
+                for (i = 0; i < inflight_cnt; i++) {
+                    pstRes->pLatency[pstRes->done_cnt++] = (uint32_t)(now - pInflight[i]);
+                }
+                inflight_cnt = 0;
+                next_core0 = sim_min(next_core0, now + pstCfg->loop_us);
+            }
+        }
+
+        // Trace event
+        if (now == next_trace) {
+            next_trace = SIM_TIME_NONE;
+            switch (stRec.kind) {
+            case TRACE_KIND_REPORT:
+                pstRes->report_cnt++;
+                if ((stLink.tail - stLink.head) >= SIM_LINK_MAX) {
+                    pstRes->drop_cnt++;
+                    break;
+                }
+                if ((stLink.head != stLink.tail) || (sim_acl_credits() == 0)) {
+                    pstRes->wait_cnt++;
+                }
+                stLink.astRec[stLink.tail % SIM_LINK_MAX] = stRec;
+                memcpy(stLink.aucData[stLink.tail % SIM_LINK_MAX], aucData, stRec.len);
+                stLink.aTime[stLink.tail % SIM_LINK_MAX] = now;
+                stLink.tail++;
+                if ((stLink.tail - stLink.head) > pstRes->wait_max) {
+                    pstRes->wait_max = stLink.tail - stLink.head;
+                }
+                sim_link_deliver(&stLink, pstRes);
+                next_core0 = sim_min(next_core0, now + pstCfg->loop_us);
+                break;
+            case TRACE_KIND_SUSPEND:
+                pstUsb->bSuspended = true;
+                tud_suspend_cb(true);
+                break;
+            case TRACE_KIND_RESUME:
+                // Handled below together with the resume after a remote wakeup
+                if (pstUsb->bSuspended) {
+                    resume_at = now + 1;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        // One iteration of the core0 main loop
+        if (now == next_core0) {
+            next_core0 = SIM_TIME_NONE;
+            cnt = CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT);
+            wakeup_cnt = pstUsb->wakeup_cnt;
+            xfer_cnt = pstUsb->report_cnt;
+            send_hid_report();
+            ACLF_Task();
+            for (cnt -= CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT); cnt > 0; cnt--) {
+                if (pstUsb->report_cnt != xfer_cnt) {
+                    // One transfer carries the report at the head of the queue and the reports merged into it
+                    pInflight[inflight_cnt++] = stLink.aArrival[stLink.arr_head];
+                }
+                else {
+                    // Collapsed into a held report while suspended
+                    pHeld[held_cnt++] = stLink.aArrival[stLink.arr_head];
+                }
+                stLink.arr_head = (stLink.arr_head + 1) % CMN_QUE_DATA_MAX_HID_RPT;
+            }
+            // Core1's run loop returns the credits, and the waiting reports follow
+            HOST_SetCoreNum(1);
+            HOST_BtRunTimers();
+            HOST_SetCoreNum(0);
+            sim_link_deliver(&stLink, pstRes);
+            if ((pstUsb->report_cnt != xfer_cnt) && (held_cnt > 0) && (USPD_GetHeldCount() == 0)) {
+                // The last held report is sent: the state of every collapsed report has reached the host
+                for (i = 0; i < held_cnt; i++) {
+                    pInflight[inflight_cnt++] = pHeld[i];
+                }
+                held_cnt = 0;
+            }
+            if ((inflight_cnt == 0) && ((CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) > 0) || (USPD_GetHeldCount() > 0))) {
+                // A report is held for the poll, or the loop waits for the bus idle time before the remote wakeup
+                next_core0 = now + pstCfg->loop_us;
+            }
+            if (pstUsb->wakeup_cnt != wakeup_cnt) {
+                if (wake_at == SIM_TIME_NONE) {
+                    wake_at = now + (uint64_t)pstCfg->wake_ms * 1000;
+                }
+            }
+        }
+    }
+
+    fclose(fp);
+    free(pInflight);
+    free(pHeld);
+    pstRes->wakeup_cnt = pstUsb->wakeup_cnt;
+    pstRes->xfer_cnt = pstUsb->report_cnt - usb_cnt;
+    return 0;
+}
+
+static void sim_print_suspend(void)
+{
+    const ST_USPD_STAT *pstStat = USPD_GetStat();
+
+    if (pstStat->suspend_cnt == 0) {
+        return;
+    }
+    printf("suspend      %u, collapsed reports %u, first report to resume us avg %u max %u\n",
+           pstStat->suspend_cnt, pstStat->collapse_cnt,
+           (pstStat->wake_latency.cnt > 0) ? (uint32_t)(pstStat->wake_latency.sum / pstStat->wake_latency.cnt) : 0,
+           pstStat->wake_latency.max);
+}
+
+static void sim_print(const char *pszTrace, ST_SIM_RESULT *pstRes)
+{
+    qsort(pstRes->pLatency, pstRes->done_cnt, sizeof(uint32_t), sim_cmp_u32);
+
+    printf("trace        %s\n", pszTrace);
+    printf("reports      %u (delivered %u, dropped %u)\n", pstRes->report_cnt, pstRes->done_cnt, pstRes->drop_cnt);
+    printf("link         reports waiting for a credit %u (at most %u at once)", pstRes->wait_cnt, pstRes->wait_max);
+#if ACLF_ENABLE
+    printf(", credits held %u times, us avg %u max %u", ACLF_GetStat()->hold_cnt,
+           (ACLF_GetStat()->hold_us.cnt > 0) ? (uint32_t)(ACLF_GetStat()->hold_us.sum / ACLF_GetStat()->hold_us.cnt) : 0,
+           ACLF_GetStat()->hold_us.max);
+#endif
+    printf("\n");
+    printf("latency us   p50 %u  p99 %u  max %u\n",
+           sim_percentile(pstRes->pLatency, pstRes->done_cnt, 50),
+           sim_percentile(pstRes->pLatency, pstRes->done_cnt, 99),
+           (pstRes->done_cnt > 0) ? pstRes->pLatency[pstRes->done_cnt - 1] : 0);
+    printf("queue depth  max %u  avg %.2f (capacity %u)\n", pstRes->depth_max,
+           (pstRes->report_cnt > pstRes->drop_cnt) ? (double)pstRes->depth_sum / (pstRes->report_cnt - pstRes->drop_cnt) : 0.0,
+           CMN_QUE_DATA_MAX_HID_RPT - 1);
+    printf("usb          transfers %u, remote wakeup calls %u, skipped polls %u\n", pstRes->xfer_cnt, pstRes->wakeup_cnt, pstRes->poll_skip_cnt);
+    sim_print_suspend();
+}
+
+static void sim_print_sof(void)
+{
+    const ST_USOF_STAT *pstStat = USOF_GetStat();
+    uint32_t i;
+
+    printf("sof          %u, poll phase %u us, submit phase us min %u avg %u max %u\n",
+           pstStat->sof_cnt, pstStat->poll_phase, pstStat->submit_phase.min,
+           (pstStat->submit_phase.cnt > 0) ? (uint32_t)(pstStat->submit_phase.sum / pstStat->submit_phase.cnt) : 0,
+           pstStat->submit_phase.max);
+    printf("align        held %u, merged %u\n", pstStat->hold_cnt, pstStat->merge_cnt);
+    printf("submit->poll");
+    for (i = 0; i < USOF_HIST_BINS; i++) {
+        printf(" %u", pstStat->aulWaitHist[i]);
+    }
+    printf(" (%u us bins)\n", USOF_HIST_BIN_US);
+}
+
+static void sim_usage(const char *pszProg)
+{
+    fprintf(stderr,
+            "usage: %s gen <conn|barcode|mouse> -o trace.bin [-d ms] [-i us] [-b n] [-s start_ms:len_ms]\n"
+            "       %s run trace.bin [-l loop_us] [-w wake_ms] [-p poll_skip_pct] [-f phase_us] [-u] [-v]\n", pszProg, pszProg);
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    ST_SIM_GEN stGen = { 1000, 7500, 3, 0, 0 };
+    ST_SIM_CFG stCfg = { SIM_LOOP_US_DEFAULT, SIM_WAKE_MS_DEFAULT, 0, 0, true };
+    ST_SIM_RESULT stRes;
+    const char *pszOut = NULL;
+    int i;
+
+    if (argc < 3) {
+        sim_usage(argv[0]);
+    }
+
+    if (strcmp(argv[1], "gen") == 0) {
+        if (strcmp(argv[2], "mouse") == 0) {
+            stGen.interval_us = 7519; // 133 Hz
+            stGen.burst = 1;
+        }
+        else if (strcmp(argv[2], "barcode") == 0) {
+            stGen.burst = 8;
+        }
+        else if (strcmp(argv[2], "conn") != 0) {
+            sim_usage(argv[0]);
+        }
+        for (i = 3; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "-o") == 0) pszOut = argv[i + 1];
+            else if (strcmp(argv[i], "-d") == 0) stGen.duration_ms = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+            else if (strcmp(argv[i], "-i") == 0) stGen.interval_us = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+            else if (strcmp(argv[i], "-b") == 0) stGen.burst = (uint32_t)strtoul(argv[i + 1], NULL, 0);
+            else if (strcmp(argv[i], "-s") == 0) {
+                if (sscanf(argv[i + 1], "%u:%u", &stGen.suspend_ms, &stGen.suspend_len_ms) != 2) sim_usage(argv[0]);
+            }
+            else sim_usage(argv[0]);
+        }
+        if ((pszOut == NULL) || (i != argc) || (stGen.interval_us == 0)) {
+            sim_usage(argv[0]);
+        }
+        return sim_gen(argv[2], pszOut, &stGen);
+    }
+
+    if (strcmp(argv[1], "run") == 0) {
+        for (i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "-v") == 0) HOST_SetUartEcho(true);
+            else if (strcmp(argv[i], "-u") == 0) stCfg.bAlign = false;
+            else if (i + 1 >= argc) sim_usage(argv[0]);
+            else if (strcmp(argv[i], "-l") == 0) stCfg.loop_us = (uint32_t)strtoul(argv[++i], NULL, 0);
+            else if (strcmp(argv[i], "-w") == 0) stCfg.wake_ms = (uint32_t)strtoul(argv[++i], NULL, 0);
+            else if (strcmp(argv[i], "-p") == 0) stCfg.poll_skip_pct = (uint32_t)strtoul(argv[++i], NULL, 0);
+            else if (strcmp(argv[i], "-f") == 0) stCfg.poll_phase_us = (uint32_t)strtoul(argv[++i], NULL, 0);
+            else sim_usage(argv[0]);
+        }
+        if (stCfg.loop_us == 0) {
+            stCfg.loop_us = 1;
+        }
+        if (stCfg.poll_phase_us >= SIM_FRAME_US) {
+            sim_usage(argv[0]);
+        }
+
+        HOST_BridgeInit();
+        if (sim_run(argv[2], &stCfg, &stRes) != 0) {
+            return 1;
+        }
+        sim_print(argv[2], &stRes);
+        sim_print_sof();
+        free(stRes.pLatency);
+
+        for (i = 0; i < 100000; i++) {
+            LOG_Drain();
+        }
+        return 0;
+    }
+
+    sim_usage(argv[0]);
+    return 2;
+}
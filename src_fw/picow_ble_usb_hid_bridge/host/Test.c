@@ -0,0 +1,1280 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Unit tests of the bridge core (host-native build, see CMakeLists.txt; run by ctest).
+//
+// The firmware sources are compiled unchanged against the stubs in stub/.
+// The BLE state machine is driven to READY through injected BTstack events, then:
+//   queue     : CMN_Enqueue / CMN_Dequeue, full queue, wrap-around
+//   desc      : device, string and configuration descriptors, device context published by core1
+//   hrd       : HRD_Parse of the report map of the simulated device, field extraction, report merge
+//   xform     : XFM_Init of a configuration blob and XFM_Apply of keyboard / mouse reports (if built with XFM_ENABLE)
+//   forward   : input report to tud_hid_report, unknown and short reports, suspended host,
+//               direct path of the notifications (NotifyPath) and hids_client path
+//   aes       : AES-128 kernel against FIPS-197 and SP 800-38A
+//   rpa       : resolution of private addresses against 16 IRKs (Core Vol 3 Part H D.7), cache, bonds
+//   adv       : early rejection of the advertisers already classified, aging
+//   p256      : P256.c multiplication against a reference implementation: random key pairs and DHKeys,
+//               scalars near 0 and n, a point with x = 0, invalid points
+//   crypto    : HCI LE Encrypt / Read Local P-256 Public Key / Generate DHKey answered on core0
+//               (Core Vol 3 Part H 2.3.5.6.1 sample keys) (if built with CRYP_ENABLE)
+//   diag / boot / prof : flight recorder, boot profile and task profile read through the
+//               diagnostics feature report (if built with CFG_BRIDGE_DIAG)
+// Exits with 1 at the first failed check.
+//
+// Usage: bridge_test [-v]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Common.h"
+#include "Log.h"
+#include "FlightRec.h"
+#include "BootProf.h"
+#include "TaskProf.h"
+#include "Diag.h"
+#include "tusb.h"
+#include "btstack.h"
+#include "usb_descriptors.h"
+#include "HidRptDesc.h"
+#include "UsbSuspend.h"
+#include "Xform.h"
+#include "DevInfo.h"
+#include "Aes.h"
+#include "CryptoOffload.h"
+#include "P256.h"
+#include "RpaCache.h"
+#include "AdvFilter.h"
+#include "NotifyPath.h"
+#include "DevCtx.h"
+#include "HostBridge.h"
+
+// [Definitions]
+#define TEST_CHECK HOST_BRIDGE_CHECK
+#define TEST_REPORTS 1000 // Reports forwarded by test_forward
+
+// Queue: one report in and out, full queue, wrap-around
+static void test_queue(void)
+{
+    static ST_HID_RPT stIn, stOut;
+    uint32_t i;
+
+    memset(&stIn, 0x5a, sizeof(stIn));
+    stIn.report_len = 8;
+    TEST_CHECK(CMN_Enqueue(CMN_QUE_KIND_HID_RPT, &stIn));
+    TEST_CHECK(CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) == 1);
+    TEST_CHECK(CMN_Dequeue(CMN_QUE_KIND_HID_RPT, &stOut));
+    TEST_CHECK(memcmp(&stIn, &stOut, sizeof(stIn)) == 0);
+
+    // Queue holds max - 1 entries
+    for (i = 0; i < CMN_QUE_DATA_MAX_HID_RPT - 1; i++) {
+        TEST_CHECK(CMN_Enqueue(CMN_QUE_KIND_HID_RPT, &stIn));
+    }
+    TEST_CHECK(!CMN_Enqueue(CMN_QUE_KIND_HID_RPT, &stIn));
+    CMN_ClearQueue(CMN_QUE_KIND_HID_RPT);
+    TEST_CHECK(!CMN_Dequeue(CMN_QUE_KIND_HID_RPT, &stOut));
+
+    // Reports come out in order across the end of the ring (half full)
+    for (i = 0; i < 3 * CMN_QUE_DATA_MAX_HID_RPT; i++) {
+        stIn.report[0] = (uint8_t)i;
+        TEST_CHECK(CMN_Enqueue(CMN_QUE_KIND_HID_RPT, &stIn));
+        if (i < CMN_QUE_DATA_MAX_HID_RPT / 2) {
+            continue;
+        }
+        TEST_CHECK(CMN_Dequeue(CMN_QUE_KIND_HID_RPT, &stOut));
+        TEST_CHECK(stOut.report[0] == (uint8_t)(i - CMN_QUE_DATA_MAX_HID_RPT / 2));
+    }
+    CMN_ClearQueue(CMN_QUE_KIND_HID_RPT);
+}
+
+// Checks a string descriptor against an ASCII string
+static void test_check_string(uint8_t index, const char *pszExpected)
+{
+    const uint16_t *pDesc = tud_descriptor_string_cb(index, 0x0409);
+    size_t len = strlen(pszExpected);
+    size_t i;
+
+    TEST_CHECK(pDesc != NULL);
+    TEST_CHECK(pDesc[0] == ((TUSB_DESC_STRING << 8) | (2 * len + 2)));
+    for (i = 0; i < len; i++) {
+        TEST_CHECK(pDesc[1 + i] == (uint16_t)pszExpected[i]);
+    }
+}
+
+// USB identity of the connected BLE device (Device Information Service)
+static void test_identity(void)
+{
+    const tusb_desc_device_t *pstDev = (const tusb_desc_device_t *)tud_descriptor_device_cb();
+    const ST_DEVI *pstDevi = DEVI_Get();
+    uint16_t bcd = pstDev->bcdDevice;
+    uint32_t i;
+
+    TEST_CHECK(pstDev->idVendor == (DEVI_USE_PNP_ID ? HOST_BRIDGE_VID : 0xCafe));
+    TEST_CHECK(DEVI_USE_PNP_ID ? (pstDev->idProduct == HOST_BRIDGE_PID) : (pstDev->idProduct != HOST_BRIDGE_PID));
+    for (i = 0; i < 4; i++) {
+        TEST_CHECK(((bcd >> (4 * i)) & 0x0f) <= 9);
+    }
+    TEST_CHECK(memcmp(pstDevi->addr, "\x11\x22\x33\x44\x55\x66", 6) == 0);
+    test_check_string(pstDev->iManufacturer, HOST_BRIDGE_MANUFACTURER);
+    test_check_string(pstDev->iProduct, HOST_BRIDGE_MODEL);
+    test_check_string(pstDev->iSerialNumber, "112233445566");
+}
+
+// Configuration descriptor and device context published by core1
+static void test_desc(void)
+{
+    const tusb_desc_configuration_t *pstCfg;
+    const uint8_t *pDesc;
+    uint16_t ble_desc_len;
+    const uint8_t *pBleDesc = HOST_BridgeGetBleDesc(&ble_desc_len);
+    static ST_DCTX stCtx;
+    uint32_t seq;
+    uint32_t i;
+
+    pDesc = tud_descriptor_configuration_cb(0);
+    pstCfg = (const tusb_desc_configuration_t *)pDesc;
+    TEST_CHECK(pstCfg->wTotalLength == TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN * CFG_TUD_HID);
+    TEST_CHECK(pstCfg->bNumInterfaces == CFG_TUD_HID);
+    // wDescriptorLength of the bridge interface is the BLE report map
+    TEST_CHECK(little_endian_read_16(pDesc, TUD_CONFIG_DESC_LEN + 9 + 7) == ble_desc_len);
+    // The report map is the copy published by core1, not the hids_client storage
+    pDesc = tud_hid_descriptor_report_cb(HID_INST_BRIDGE);
+    TEST_CHECK((pDesc != pBleDesc) && (memcmp(pDesc, pBleDesc, ble_desc_len) == 0));
+    test_identity();
+
+    // Each publication of core1 is seen by the next descriptor callback
+    seq = DCTX_GetSeq();
+    TEST_CHECK(DCTX_Read(&stCtx) && (stCtx.seq == seq) && (stCtx.desc_len == ble_desc_len));
+    DCTX_Publish(false, NULL, 0, NULL);
+    pDesc = tud_descriptor_configuration_cb(0);
+    TEST_CHECK(little_endian_read_16(pDesc, TUD_CONFIG_DESC_LEN + 9 + 7) != ble_desc_len);
+    DCTX_Publish(true, stCtx.aucDesc, stCtx.desc_len, &stCtx.stDevi);
+    TEST_CHECK(DCTX_GetSeq() == seq + 2);
+    pDesc = tud_descriptor_configuration_cb(0);
+    TEST_CHECK(little_endian_read_16(pDesc, TUD_CONFIG_DESC_LEN + 9 + 7) == ble_desc_len);
+    test_identity();
+
+    for (i = 0; i < 16; i++) {
+        TEST_CHECK(DCTX_Read(&stCtx) && (stCtx.seq == seq + 2));
+    }
+    TEST_CHECK(DCTX_GetRetryCount() == 0);
+}
+
+// Report map compile, field extraction and merge
+static void test_hrd(void)
+{
+    static ST_HRD_MAP stMap;
+    static const uint8_t aucMouse[4] = { 0x01, 0xFF, 0x02, 0x80 }; // Button 1, X -1, Y 2, wheel -128
+    uint8_t aucDst[4];
+    const ST_HRD_REPORT *pstReport;
+    const ST_HRD_FIELD *pstField;
+    uint16_t ble_desc_len;
+    const uint8_t *pBleDesc = HOST_BridgeGetBleDesc(&ble_desc_len);
+
+    TEST_CHECK(HRD_Parse(pBleDesc, ble_desc_len, &stMap) == HRD_OK);
+    TEST_CHECK(stMap.bValid && stMap.bUseId && (stMap.report_cnt == 3));
+    TEST_CHECK(HRD_GetReport(&stMap, HRD_NO_REPORT_ID) == NULL);
+    TEST_CHECK(HRD_GetInputLen(HRD_GetReport(&stMap, REPORT_ID_KEYBOARD)) == 8);
+    TEST_CHECK(HRD_GetInputLen(HRD_GetReport(&stMap, REPORT_ID_CONSUMER_CONTROL)) == 2);
+    pstReport = HRD_GetReport(&stMap, REPORT_ID_MOUSE);
+    TEST_CHECK((pstReport != NULL) && (HRD_GetInputLen(pstReport) == 4) && (pstReport->field_cnt == 2));
+    pstField = &stMap.astField[pstReport->field_idx];
+    TEST_CHECK((pstField[0].bit_size == 1) && (pstField[0].count == 5) && (pstField[0].usage_min == 1) && (pstField[0].usage_max == 5));
+    TEST_CHECK((pstField[1].bit_off == 8) && (pstField[1].flags & HRD_FIELD_RELATIVE) && (pstField[1].flags & HRD_FIELD_SIGNED));
+    TEST_CHECK((pstField[1].usage_min == HID_USAGE_DESKTOP_X) && (pstField[1].usage_max == HID_USAGE_DESKTOP_WHEEL));
+    TEST_CHECK(HRD_GetFieldValue(&pstField[0], aucMouse, sizeof(aucMouse), 0) == 1);
+    TEST_CHECK(HRD_GetFieldValue(&pstField[1], aucMouse, sizeof(aucMouse), 0) == -1);
+    TEST_CHECK(HRD_GetFieldValue(&pstField[1], aucMouse, sizeof(aucMouse), 1) == 2);
+    TEST_CHECK(HRD_GetFieldValue(&pstField[1], aucMouse, sizeof(aucMouse), 2) == -128);
+    TEST_CHECK(HRD_GetFieldValue(&pstField[1], aucMouse, 3, 2) == 0); // Outside the data
+    // Movement is added, a button change or an overflow is not merged
+    memcpy(aucDst, "\x01\x01\x02\x00", 4);
+    TEST_CHECK(pstReport->rel_cnt == 1);
+    TEST_CHECK(HRD_MergeReport(&stMap, pstReport, aucDst, (const uint8_t *)"\x01\x03\xFE\x01", 4));
+    TEST_CHECK(memcmp(aucDst, "\x01\x04\x00\x01", 4) == 0);
+    TEST_CHECK(!HRD_MergeReport(&stMap, pstReport, aucDst, (const uint8_t *)"\x00\x01\x00\x00", 4));
+    TEST_CHECK(!HRD_MergeReport(&stMap, pstReport, aucDst, (const uint8_t *)"\x01\x7F\x00\x00", 4));
+    TEST_CHECK(memcmp(aucDst, "\x01\x04\x00\x01", 4) == 0);
+    TEST_CHECK(!HRD_MergeReport(&stMap, HRD_GetReport(&stMap, REPORT_ID_KEYBOARD), aucDst, aucDst, 4));
+}
+
+#if XFM_ENABLE
+// Report transform stage
+static void test_xform(void)
+{
+    static ST_HRD_MAP stMap;
+    static uint8_t aucCfg[64];
+    ST_HID_RPT stKbd, stMouse;
+    uint16_t ble_desc_len;
+    const uint8_t *pBleDesc = HOST_BridgeGetBleDesc(&ble_desc_len);
+
+    HOST_BridgeXformConfig(aucCfg, sizeof(aucCfg));
+    aucCfg[sizeof(ST_XFM_CFG_HDR)] ^= 1;
+    TEST_CHECK(!XFM_Init(aucCfg, sizeof(aucCfg))); // CRC error
+    aucCfg[sizeof(ST_XFM_CFG_HDR)] ^= 1;
+    TEST_CHECK(XFM_Init(aucCfg, sizeof(aucCfg)));
+    TEST_CHECK(HRD_Parse(pBleDesc, ble_desc_len, &stMap) == HRD_OK);
+    XFM_Compile(&stMap);
+
+    memset(&stKbd, 0, sizeof(stKbd));
+    stKbd.report_id = REPORT_ID_KEYBOARD;
+    stKbd.report_len = 8;
+    stKbd.report[0] = 0x01; // Left Ctrl
+    stKbd.report[2] = 0x39; // Caps Lock
+    stKbd.report[3] = 0x04; // A
+    XFM_Apply(&stKbd);
+    TEST_CHECK((stKbd.report[0] == 0x08) && (stKbd.report[2] == 0x29) && (stKbd.report[3] == 0x04));
+
+    memset(&stMouse, 0, sizeof(stMouse));
+    stMouse.report_id = REPORT_ID_MOUSE;
+    stMouse.report_len = 4;
+    stMouse.report[1] = 2;
+    stMouse.report[2] = (uint8_t)-2;
+    stMouse.report[3] = 1;
+    XFM_Apply(&stMouse);
+    TEST_CHECK((stMouse.report[1] == 3) && (stMouse.report[2] == (uint8_t)-3) && (stMouse.report[3] == 1));
+    // The fraction is carried: 1 x 1.5 twice moves 1 then 2
+    stMouse.report[1] = 1;
+    XFM_Apply(&stMouse);
+    TEST_CHECK(stMouse.report[1] == 1);
+    stMouse.report[1] = 1;
+    XFM_Apply(&stMouse);
+    TEST_CHECK(stMouse.report[1] == 2);
+    // Clamped to the logical range
+    stMouse.report[1] = 100;
+    XFM_Apply(&stMouse);
+    TEST_CHECK(stMouse.report[1] == 127);
+
+    // A rejected report map (cleared by HRD_Parse) drops the plans of the previous device
+    TEST_CHECK(HRD_Parse(pBleDesc, 1, &stMap) != HRD_OK);
+    XFM_Compile(&stMap);
+    stKbd.report[0] = 0x01;
+    stKbd.report[2] = 0x39;
+    XFM_Apply(&stKbd);
+    TEST_CHECK((stKbd.report[0] == 0x01) && (stKbd.report[2] == 0x39));
+
+    // Back to no transform for the other tests
+    memset(aucCfg, 0xFF, sizeof(aucCfg));
+    TEST_CHECK(!XFM_Init(aucCfg, sizeof(aucCfg)));
+}
+#endif
+
+// BLE report event to USB transfer
+static void test_forward(void)
+{
+    static const uint8_t aucKey[8] = { 0x02, 0x00, 0x04, 0, 0, 0, 0, 0 };
+    static const uint8_t aucRelease[8] = { 0 };
+    static const uint8_t aucMove[4] = { 0x00, 0x03, 0x00, 0x00 }; // X +3
+    ST_HOST_USB *pstUsb = HOST_Usb();
+    uint32_t report_cnt = pstUsb->report_cnt;
+#if NTFP_ENABLE
+    uint32_t hids_cnt = HOST_Bt()->hids_report_cnt;
+    ULONG fast_cnt;
+    ULONG drop_cnt;
+#endif
+    uint32_t i;
+
+    HOST_SetCoreNum(1);
+    HOST_BtHidReport(REPORT_ID_KEYBOARD, aucKey, sizeof(aucKey));
+    HOST_SetCoreNum(0);
+    TEST_CHECK(send_hid_report());
+    TEST_CHECK(pstUsb->report_cnt == report_cnt + 1);
+    TEST_CHECK(pstUsb->last_report_id == REPORT_ID_KEYBOARD);
+    TEST_CHECK(pstUsb->last_len == sizeof(aucKey));
+    TEST_CHECK(memcmp(pstUsb->last_report, aucKey, sizeof(aucKey)) == 0);
+    TEST_CHECK(!send_hid_report()); // Queue is empty
+
+    // Reports that do not match the report map
+    HOST_BtHidReport(REPORT_ID_GAMEPAD, aucKey, sizeof(aucKey)); // Unknown ID: dropped
+    TEST_CHECK(CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) == 0);
+    HOST_BtHidReport(REPORT_ID_KEYBOARD, aucKey, 3);             // Short: padded
+    TEST_CHECK(send_hid_report());
+    TEST_CHECK((pstUsb->last_len == sizeof(aucKey)) && (pstUsb->last_report[2] == aucKey[2]) && (pstUsb->last_report[3] == 0));
+    report_cnt++;
+
+    // Suspended host: the movement is merged, a key change and the reports behind it stay in
+    // the queue in order, and one wakeup is signalled once the bus has been idle long enough
+    pstUsb->bSuspended = true;
+    tud_suspend_cb(true);
+    HOST_BtHidReport(REPORT_ID_MOUSE, aucMove, sizeof(aucMove));
+    HOST_BtHidReport(REPORT_ID_MOUSE, aucMove, sizeof(aucMove));
+    HOST_BtHidReport(REPORT_ID_KEYBOARD, aucKey, sizeof(aucKey));
+    TEST_CHECK(!send_hid_report());
+    TEST_CHECK((pstUsb->wakeup_cnt == 0) && (USPD_GetHeldCount() == 1) && (CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) == 1));
+    HOST_AdvanceUs(USPD_WAKEUP_DELAY_US);
+    HOST_BtHidReport(REPORT_ID_MOUSE, aucMove, sizeof(aucMove));
+    HOST_BtHidReport(REPORT_ID_KEYBOARD, aucRelease, sizeof(aucRelease));
+    TEST_CHECK(!send_hid_report());
+    TEST_CHECK(!send_hid_report());
+    TEST_CHECK((pstUsb->wakeup_cnt == 1) && (USPD_GetHeldCount() == 1) && (CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) == 3));
+    TEST_CHECK(USPD_GetStat()->collapse_cnt == 1);
+    pstUsb->bSuspended = false;
+    tud_resume_cb();
+    TEST_CHECK(send_hid_report());
+    TEST_CHECK((pstUsb->last_report_id == REPORT_ID_MOUSE) && (pstUsb->last_report[1] == 2 * aucMove[1]));
+    TEST_CHECK(send_hid_report());
+    TEST_CHECK((pstUsb->last_report_id == REPORT_ID_KEYBOARD) && (memcmp(pstUsb->last_report, aucKey, sizeof(aucKey)) == 0));
+    TEST_CHECK(send_hid_report());
+    TEST_CHECK((pstUsb->last_report_id == REPORT_ID_MOUSE) && (pstUsb->last_report[1] == aucMove[1]));
+    TEST_CHECK(send_hid_report());
+    TEST_CHECK((pstUsb->last_report_id == REPORT_ID_KEYBOARD) && (memcmp(pstUsb->last_report, aucRelease, sizeof(aucRelease)) == 0));
+    TEST_CHECK(!send_hid_report());
+    TEST_CHECK(USPD_GetStat()->wake_latency.cnt == 1);
+
+    for (i = 0; i < TEST_REPORTS; i++) {
+        HOST_SetCoreNum(1);
+        HOST_BtHidReport(REPORT_ID_KEYBOARD, aucKey, sizeof(aucKey));
+        HOST_SetCoreNum(0);
+        TEST_CHECK(send_hid_report());
+    }
+    TEST_CHECK(pstUsb->report_cnt == report_cnt + 5 + TEST_REPORTS);
+
+#if NTFP_ENABLE
+    // The reports of the unknown characteristic take the hids_client path; hids_client still builds
+    // an event for the others, which the bridge drops
+    TEST_CHECK(NTFP_GetStat()->handle_cnt == 3);
+    TEST_CHECK(NTFP_GetStat()->fast_cnt + NTFP_GetStat()->slow_cnt == 8 + TEST_REPORTS);
+    TEST_CHECK(NTFP_GetStat()->slow_cnt >= 1);
+    TEST_CHECK(NTFP_GetStat()->drop_cnt == NTFP_GetStat()->fast_cnt);
+    TEST_CHECK(HOST_Bt()->hids_report_cnt - hids_cnt == NTFP_GetStat()->fast_cnt + NTFP_GetStat()->slow_cnt);
+
+    // hids_client called before the direct path: still one USB report per notification
+    HOST_BtHidsListenFirst();
+    fast_cnt = NTFP_GetStat()->fast_cnt;
+    drop_cnt = NTFP_GetStat()->drop_cnt;
+    for (i = 0; i < TEST_REPORTS; i++) {
+        HOST_SetCoreNum(1);
+        HOST_BtHidReport(REPORT_ID_KEYBOARD, aucKey, sizeof(aucKey));
+        HOST_SetCoreNum(0);
+        TEST_CHECK(send_hid_report() && (pstUsb->last_report_id == REPORT_ID_KEYBOARD));
+        TEST_CHECK(!send_hid_report());
+    }
+    TEST_CHECK(NTFP_GetStat()->fast_cnt - fast_cnt == TEST_REPORTS);
+    TEST_CHECK(NTFP_GetStat()->drop_cnt - drop_cnt == TEST_REPORTS);
+    TEST_CHECK(pstUsb->report_cnt == report_cnt + 5 + 2 * TEST_REPORTS);
+
+    // Every report through hids_client, then the direct path again as after a reconnection
+    NTFP_Stop();
+    hids_cnt = HOST_Bt()->hids_report_cnt;
+    for (i = 0; i < TEST_REPORTS; i++) {
+        HOST_SetCoreNum(1);
+        HOST_BtHidReport(REPORT_ID_KEYBOARD, aucKey, sizeof(aucKey));
+        HOST_SetCoreNum(0);
+        TEST_CHECK(send_hid_report() && (pstUsb->last_report_id == REPORT_ID_KEYBOARD));
+    }
+    TEST_CHECK(HOST_Bt()->hids_report_cnt - hids_cnt == TEST_REPORTS);
+    TEST_CHECK(pstUsb->report_cnt == report_cnt + 5 + 3 * TEST_REPORTS);
+    HOST_SetCoreNum(1);
+    HOST_BtHidServiceConnected(ERROR_CODE_SUCCESS);
+    TEST_CHECK(NTFP_GetStat()->fast_cnt == 0);
+    HOST_BtRunTimers();
+    HOST_SetCoreNum(0);
+    TEST_CHECK(NTFP_GetStat()->handle_cnt == 3);
+#endif
+}
+
+// AES-128 kernel of the Security Manager, checked against FIPS-197 and SP 800-38A
+static void test_aes(void)
+{
+    // FIPS-197 Appendix A.1: last round key of the expansion of the SP 800-38A key
+    static const ULONG aulLastRk[4] = { 0xd014f9a8, 0xc9ee2589, 0xe13f0cc8, 0xb6630ca6 };
+    // FIPS-197 Appendix C.1
+    static const uint8_t aucKeyC1[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    };
+    static const uint8_t aucPtC1[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+    };
+    static const uint8_t aucCtC1[16] = {
+        0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a,
+    };
+    // SP 800-38A F.1.1 (ECB-AES128.Encrypt)
+    static const uint8_t aucKeyEcb[16] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+    };
+    static const uint8_t aucPtEcb[4][16] = {
+        { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a },
+        { 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51 },
+        { 0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef },
+        { 0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 },
+    };
+    static const uint8_t aucCtEcb[4][16] = {
+        { 0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60, 0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97 },
+        { 0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d, 0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf },
+        { 0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23, 0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88 },
+        { 0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f, 0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4 },
+    };
+    static ULONG aulRk[AES_RK_WORDS];
+    static uint8_t aucBlock[16];
+    uint32_t i;
+
+    AES_ExpandKey(aulRk, aucKeyEcb);
+    TEST_CHECK(memcmp(&aulRk[AES_RK_WORDS - 4], aulLastRk, sizeof(aulLastRk)) == 0);
+    for (i = 0; i < 4; i++) {
+        AES_EncryptBlock(aulRk, aucPtEcb[i], aucBlock);
+        TEST_CHECK(memcmp(aucBlock, aucCtEcb[i], sizeof(aucBlock)) == 0);
+    }
+    AES_Encrypt(aucKeyC1, aucPtC1, aucBlock);
+    TEST_CHECK(memcmp(aucBlock, aucCtC1, sizeof(aucBlock)) == 0);
+    AES_Encrypt(aucKeyEcb, aucPtEcb[3], aucBlock);  // Key change
+    TEST_CHECK(memcmp(aucBlock, aucCtEcb[3], sizeof(aucBlock)) == 0);
+    memcpy(aucBlock, aucPtC1, sizeof(aucBlock));
+    AES_Encrypt(aucKeyC1, aucBlock, aucBlock);      // In place
+    TEST_CHECK(memcmp(aucBlock, aucCtC1, sizeof(aucBlock)) == 0);
+}
+
+#if RPAC_ENABLE
+// Resolution of the private addresses seen while scanning
+static void test_rpa(void)
+{
+    // Core Vol 3 Part H D.7: ah(IRK, 0x708194) = 0x0dfbaa
+    static const uint8_t aucIrk[16] = {
+        0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b,
+    };
+    static const uint8_t aucRpa[6] = { 0x70, 0x81, 0x94, 0x0d, 0xfb, 0xaa };
+    static uint8_t aucOther[16];
+    static uint8_t aucAddr[6];
+    const ST_RPAC_STAT *pstStat = RPAC_GetStat();
+    uint32_t i;
+
+    // 16 bonds, the one of the vector last
+    for (i = 0; i < 15; i++) {
+        memset(aucOther, (int)(i + 1), sizeof(aucOther));
+        HOST_BtSetBond((int)i, aucRpa, aucOther);
+    }
+    HOST_BtSetBond(15, aucRpa, aucIrk);
+    RPAC_StartScan();
+
+    TEST_CHECK(RPAC_Resolve(aucRpa, BD_ADDR_TYPE_LE_RANDOM) == 15);
+    TEST_CHECK((pstStat->ah_cnt == 16) && (pstStat->hit_cnt == 0));
+    TEST_CHECK(RPAC_Resolve(aucRpa, BD_ADDR_TYPE_LE_RANDOM) == 15);
+    TEST_CHECK((pstStat->ah_cnt == 16) && (pstStat->hit_cnt == 1));
+    TEST_CHECK(RPAC_Resolve(aucRpa, BD_ADDR_TYPE_LE_PUBLIC) == RPAC_NO_MATCH); // Not an RPA
+    memcpy(aucAddr, aucRpa, sizeof(aucAddr));
+    aucAddr[5] ^= 1;
+    TEST_CHECK(RPAC_Resolve(aucAddr, BD_ADDR_TYPE_LE_RANDOM) == RPAC_NO_MATCH);
+    TEST_CHECK(RPAC_Resolve(aucAddr, BD_ADDR_TYPE_LE_RANDOM) == RPAC_NO_MATCH);
+    TEST_CHECK((pstStat->ah_cnt == 32) && (pstStat->hit_cnt == 2) && (pstStat->match_cnt == 2));
+
+    // Results expire with the RPA; a new bond drops the cache
+    HOST_AdvanceUs((uint64_t)RPAC_TTL_MS * 1000);
+    TEST_CHECK(RPAC_Resolve(aucRpa, BD_ADDR_TYPE_LE_RANDOM) == 15);
+    TEST_CHECK(pstStat->ah_cnt == 48);
+    HOST_BtSetBond(0, aucRpa, aucIrk);
+    RPAC_StartScan();
+    TEST_CHECK((RPAC_Resolve(aucRpa, BD_ADDR_TYPE_LE_RANDOM) == 0) && (pstStat->ah_cnt == 1));
+    memset(aucOther, 1, sizeof(aucOther));
+    HOST_BtSetBond(0, aucRpa, aucOther);
+    RPAC_StartScan();
+    TEST_CHECK(RPAC_Resolve(aucRpa, BD_ADDR_TYPE_LE_RANDOM) == 15);
+    RPAC_StopScan();
+
+    // Bond of the stored HID device, by RPA or by identity address
+    TEST_CHECK(RPAC_FindBond(aucRpa, BD_ADDR_TYPE_LE_RANDOM) == 15);
+    TEST_CHECK(RPAC_FindBond(aucRpa, BD_ADDR_TYPE_LE_PUBLIC) == 0);
+    TEST_CHECK(RPAC_FindBond(aucAddr, BD_ADDR_TYPE_LE_RANDOM) == RPAC_NO_MATCH);
+    for (i = 0; i < 16; i++) {
+        HOST_BtSetBond((int)i, NULL, NULL);
+    }
+}
+#endif
+
+#if ADVF_ENABLE
+// Classifier of the bridge (hog_host_demo.c), counted
+static uint32_t f_advWalkCnt = 0;
+static bool test_adv_accept(const uint8_t *packet)
+{
+    f_advWalkCnt++;
+    return ad_data_contains_uuid16(gap_event_advertising_report_get_data_length(packet),
+        gap_event_advertising_report_get_data(packet), ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE);
+}
+
+// Early rejection of the advertisers already classified
+static void test_adv(void)
+{
+    // A beacon filling the 31 bytes: flags, manufacturer data, name, 16-bit UUIDs (HID added below)
+    static const uint8_t aucAd[] = {
+        0x02, 0x01, 0x06,
+        0x0b, 0xff, 0x4c, 0x00, 0x10, 0x06, 0x33, 0x1d, 0x2a, 0x81, 0x5c, 0x08,
+        0x08, 0x09, 'B', 'e', 'a', 'c', 'o', 'n', '1',
+        0x05, 0x03, 0x0f, 0x18, 0x0a, 0x18,
+    };
+    static uint8_t aucPacket[12 + 31];
+    const ST_ADVF_STAT *pstStat = ADVF_GetStat();
+
+    aucPacket[0] = GAP_EVENT_ADVERTISING_REPORT;
+    aucPacket[1] = 10 + sizeof(aucAd);
+    aucPacket[3] = BD_ADDR_TYPE_LE_RANDOM;
+    memcpy(&aucPacket[4], "\x11\x22\x33\x44\x55\xc6", 6);
+    aucPacket[10] = 0xc0; // RSSI
+    aucPacket[11] = sizeof(aucAd);
+    memcpy(&aucPacket[12], aucAd, sizeof(aucAd));
+    ADVF_StartScan();
+
+    // Classified once, then rejected whatever the RSSI
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 1));
+    aucPacket[10] = 0xb0;
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 1));
+    TEST_CHECK((pstStat->hit_cnt == 1) && (pstStat->add_cnt == 1));
+    // Any change of the AD data is classified again: a manufacturer data counter...
+    aucPacket[12 + 10] = 0x07;
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 2));
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 2));
+    // ...or the HID service added at the end, after the same first structures; a HID one is never cached
+    aucPacket[12 + sizeof(aucAd) - 2] = 0x12;
+    TEST_CHECK(ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 3));
+    TEST_CHECK(ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 4));
+    aucPacket[12 + sizeof(aucAd) - 2] = 0x0a;
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 4));
+    // A shorter advertisement with the same start
+    aucPacket[11] = sizeof(aucAd) - 4;
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 5));
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 5));
+    aucPacket[11] = sizeof(aucAd);
+    // Another address with the same advertisement is classified by itself
+    aucPacket[9] = 0xc7;
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 6));
+    aucPacket[9] = 0xc6;
+    // Still known in the next generation, gone after two periods without being seen
+    HOST_AdvanceUs((uint64_t)ADVF_AGE_MS * 1000);
+    ADVF_StartScan();
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 6));
+    HOST_AdvanceUs((uint64_t)ADVF_AGE_MS * 2000);
+    ADVF_StartScan();
+    TEST_CHECK(!ADVF_Accept(aucPacket, &test_adv_accept) && (f_advWalkCnt == 7));
+    ADVF_StopScan();
+}
+#endif
+
+// P-256 reference for test_p256. micro-ecc is stubbed in the host build, so the reference is a
+// textbook implementation that shares no code with P256.c: generic bitwise reduction modulo p,
+// Jacobian double-and-add (left to right) and an affine result. Slow, not constant time.
+// Numbers are 8 little-endian words; a point with z = 0 is the point at infinity.
+typedef struct _ST_REF_PT {
+    uint32_t x[8];
+    uint32_t y[8];
+    uint32_t z[8];
+} ST_REF_PT;
+
+static const uint32_t f_aulRefP[8] = { 0xffffffff, 0xffffffff, 0xffffffff, 0, 0, 0, 1, 0xffffffff };
+static const uint32_t f_aulRefN[8] = { 0xfc632551, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, 0xffffffff, 0xffffffff, 0, 0xffffffff };
+static const uint32_t f_aulRefB[8] = { 0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0, 0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8 };
+static const uint32_t f_aulRefGx[8] = { 0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81, 0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2 };
+static const uint32_t f_aulRefGy[8] = { 0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357, 0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2 };
+
+static void ref_from_bytes(uint32_t *pW, const uint8_t *pBytes)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        pW[i] = ((uint32_t)pBytes[31 - 4 * i - 3] << 24) | ((uint32_t)pBytes[31 - 4 * i - 2] << 16) |
+                ((uint32_t)pBytes[31 - 4 * i - 1] << 8) | pBytes[31 - 4 * i];
+    }
+}
+
+static void ref_to_bytes(uint8_t *pBytes, const uint32_t *pW)
+{
+    int i;
+
+    for (i = 0; i < 32; i++) {
+        pBytes[31 - i] = (uint8_t)(pW[i / 4] >> (8 * (i % 4)));
+    }
+}
+
+static int ref_cmp(const uint32_t *pA, const uint32_t *pB)
+{
+    int i;
+
+    for (i = 7; i >= 0; i--) {
+        if (pA[i] != pB[i]) {
+            return (pA[i] > pB[i]) ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+static bool ref_is_zero(const uint32_t *pA)
+{
+    static const uint32_t aulZero[8] = { 0 };
+
+    return ref_cmp(pA, aulZero) == 0;
+}
+
+static uint32_t ref_add(uint32_t *pR, const uint32_t *pA, const uint32_t *pB)
+{
+    uint64_t t = 0;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        t += (uint64_t)pA[i] + pB[i];
+        pR[i] = (uint32_t)t;
+        t >>= 32;
+    }
+    return (uint32_t)t;
+}
+
+static uint32_t ref_sub(uint32_t *pR, const uint32_t *pA, const uint32_t *pB)
+{
+    uint64_t borrow = 0;
+    uint64_t t;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        t = (uint64_t)pA[i] - pB[i] - borrow;
+        pR[i] = (uint32_t)t;
+        borrow = (t >> 32) & 1;
+    }
+    return (uint32_t)borrow;
+}
+
+static void ref_mod_add(uint32_t *pR, const uint32_t *pA, const uint32_t *pB)
+{
+    if (ref_add(pR, pA, pB) || (ref_cmp(pR, f_aulRefP) >= 0)) {
+        ref_sub(pR, pR, f_aulRefP);
+    }
+}
+
+static void ref_mod_sub(uint32_t *pR, const uint32_t *pA, const uint32_t *pB)
+{
+    if (ref_sub(pR, pA, pB)) {
+        ref_add(pR, pR, f_aulRefP);
+    }
+}
+
+// Product, then reduced one bit at a time from the top
+static void ref_mod_mul(uint32_t *pR, const uint32_t *pA, const uint32_t *pB)
+{
+    uint32_t aulT[16] = { 0 };
+    uint32_t aulR[8] = { 0 };
+    uint64_t t;
+    uint32_t carry;
+    int i, j;
+
+    for (i = 0; i < 8; i++) {
+        t = 0;
+        for (j = 0; j < 8; j++) {
+            t += (uint64_t)pA[i] * pB[j] + aulT[i + j];
+            aulT[i + j] = (uint32_t)t;
+            t >>= 32;
+        }
+        aulT[i + 8] = (uint32_t)t;
+    }
+    for (i = 511; i >= 0; i--) {
+        carry = aulR[7] >> 31;
+        for (j = 7; j > 0; j--) {
+            aulR[j] = (aulR[j] << 1) | (aulR[j - 1] >> 31);
+        }
+        aulR[0] = (aulR[0] << 1) | ((aulT[i / 32] >> (i % 32)) & 1);
+        if (carry || (ref_cmp(aulR, f_aulRefP) >= 0)) {
+            ref_sub(aulR, aulR, f_aulRefP);
+        }
+    }
+    memcpy(pR, aulR, sizeof(aulR));
+}
+
+// a^(p - 2)
+static void ref_mod_inv(uint32_t *pR, const uint32_t *pA)
+{
+    static const uint32_t aulTwo[8] = { 2 };
+    uint32_t aulE[8];
+    uint32_t aulR[8] = { 1 };
+    int i;
+
+    ref_sub(aulE, f_aulRefP, aulTwo);
+    for (i = 255; i >= 0; i--) {
+        ref_mod_mul(aulR, aulR, aulR);
+        if ((aulE[i / 32] >> (i % 32)) & 1) {
+            ref_mod_mul(aulR, aulR, pA);
+        }
+    }
+    memcpy(pR, aulR, sizeof(aulR));
+}
+
+// y^2 = x^3 - 3x + b, coordinates below p
+static bool ref_on_curve(const uint32_t *pX, const uint32_t *pY)
+{
+    uint32_t aulL[8], aulR[8], aulT[8];
+
+    if ((ref_cmp(pX, f_aulRefP) >= 0) || (ref_cmp(pY, f_aulRefP) >= 0)) {
+        return false;
+    }
+    ref_mod_mul(aulL, pY, pY);
+    ref_mod_mul(aulR, pX, pX);
+    ref_mod_mul(aulR, aulR, pX);
+    ref_mod_add(aulT, pX, pX);
+    ref_mod_add(aulT, aulT, pX);
+    ref_mod_sub(aulR, aulR, aulT);
+    ref_mod_add(aulR, aulR, f_aulRefB);
+    return ref_cmp(aulL, aulR) == 0;
+}
+
+// R = 2 A (a = -3)
+static void ref_double(ST_REF_PT *pstR, const ST_REF_PT *pstA)
+{
+    uint32_t aulDelta[8], aulGamma[8], aulBeta[8], aulAlpha[8], aulT[8], aulU[8];
+    ST_REF_PT stR;
+
+    if (ref_is_zero(pstA->z) || ref_is_zero(pstA->y)) {
+        memset(pstR, 0, sizeof(*pstR));
+        return;
+    }
+    ref_mod_mul(aulDelta, pstA->z, pstA->z);
+    ref_mod_mul(aulGamma, pstA->y, pstA->y);
+    ref_mod_mul(aulBeta, pstA->x, aulGamma);
+    ref_mod_sub(aulT, pstA->x, aulDelta);
+    ref_mod_add(aulU, pstA->x, aulDelta);
+    ref_mod_mul(aulAlpha, aulT, aulU);
+    ref_mod_add(aulT, aulAlpha, aulAlpha);
+    ref_mod_add(aulAlpha, aulT, aulAlpha);                  // alpha = 3 (x - delta)(x + delta)
+    ref_mod_add(aulT, aulBeta, aulBeta);
+    ref_mod_add(aulT, aulT, aulT);                          // 4 beta
+    ref_mod_mul(stR.x, aulAlpha, aulAlpha);
+    ref_mod_sub(stR.x, stR.x, aulT);
+    ref_mod_sub(stR.x, stR.x, aulT);                        // x = alpha^2 - 8 beta
+    ref_mod_add(aulU, pstA->y, pstA->z);
+    ref_mod_mul(stR.z, aulU, aulU);
+    ref_mod_sub(stR.z, stR.z, aulGamma);
+    ref_mod_sub(stR.z, stR.z, aulDelta);                    // z = (y + z)^2 - gamma - delta
+    ref_mod_sub(aulT, aulT, stR.x);
+    ref_mod_mul(stR.y, aulAlpha, aulT);
+    ref_mod_mul(aulU, aulGamma, aulGamma);
+    ref_mod_add(aulU, aulU, aulU);
+    ref_mod_add(aulU, aulU, aulU);
+    ref_mod_add(aulU, aulU, aulU);
+    ref_mod_sub(stR.y, stR.y, aulU);                        // y = alpha (4 beta - x) - 8 gamma^2
+    *pstR = stR;
+}
+
+// R = A + B
+static void ref_add_pt(ST_REF_PT *pstR, const ST_REF_PT *pstA, const ST_REF_PT *pstB)
+{
+    uint32_t aulZ1Z1[8], aulZ2Z2[8], aulU1[8], aulU2[8], aulS1[8], aulS2[8], aulH[8], aulHH[8], aulHHH[8], aulRr[8], aulT[8];
+    ST_REF_PT stR;
+
+    if (ref_is_zero(pstA->z)) {
+        *pstR = *pstB;
+        return;
+    }
+    if (ref_is_zero(pstB->z)) {
+        *pstR = *pstA;
+        return;
+    }
+    ref_mod_mul(aulZ1Z1, pstA->z, pstA->z);
+    ref_mod_mul(aulZ2Z2, pstB->z, pstB->z);
+    ref_mod_mul(aulU1, pstA->x, aulZ2Z2);
+    ref_mod_mul(aulU2, pstB->x, aulZ1Z1);
+    ref_mod_mul(aulS1, pstA->y, pstB->z);
+    ref_mod_mul(aulS1, aulS1, aulZ2Z2);
+    ref_mod_mul(aulS2, pstB->y, pstA->z);
+    ref_mod_mul(aulS2, aulS2, aulZ1Z1);
+    if (ref_cmp(aulU1, aulU2) == 0) {
+        if (ref_cmp(aulS1, aulS2) == 0) {
+            ref_double(pstR, pstA);
+        }
+        else {
+            memset(pstR, 0, sizeof(*pstR));
+        }
+        return;
+    }
+    ref_mod_sub(aulH, aulU2, aulU1);
+    ref_mod_sub(aulRr, aulS2, aulS1);
+    ref_mod_mul(aulHH, aulH, aulH);
+    ref_mod_mul(aulHHH, aulHH, aulH);
+    ref_mod_mul(aulU1, aulU1, aulHH);                       // U1 H^2
+    ref_mod_mul(stR.x, aulRr, aulRr);
+    ref_mod_sub(stR.x, stR.x, aulHHH);
+    ref_mod_sub(stR.x, stR.x, aulU1);
+    ref_mod_sub(stR.x, stR.x, aulU1);                       // x = R^2 - H^3 - 2 U1 H^2
+    ref_mod_sub(aulT, aulU1, stR.x);
+    ref_mod_mul(stR.y, aulRr, aulT);
+    ref_mod_mul(aulT, aulS1, aulHHH);
+    ref_mod_sub(stR.y, stR.y, aulT);                        // y = R (U1 H^2 - x) - S1 H^3
+    ref_mod_mul(stR.z, pstA->z, pstB->z);
+    ref_mod_mul(stR.z, stR.z, aulH);                        // z = z1 z2 H
+    *pstR = stR;
+}
+
+// k P in uECC format (P = NULL: base point). Returns false for the point at infinity.
+static bool ref_mult(uint8_t *pResult, const uint8_t *pPoint, const uint8_t *pScalar)
+{
+    ST_REF_PT stP, stR;
+    uint32_t aulK[8], aulZi[8], aulT[8];
+    int i;
+
+    if (pPoint != NULL) {
+        ref_from_bytes(stP.x, &pPoint[0]);
+        ref_from_bytes(stP.y, &pPoint[32]);
+    }
+    else {
+        memcpy(stP.x, f_aulRefGx, sizeof(stP.x));
+        memcpy(stP.y, f_aulRefGy, sizeof(stP.y));
+    }
+    memset(stP.z, 0, sizeof(stP.z));
+    stP.z[0] = 1;
+    memset(&stR, 0, sizeof(stR));
+    ref_from_bytes(aulK, pScalar);
+    for (i = 255; i >= 0; i--) {
+        ref_double(&stR, &stR);
+        if ((aulK[i / 32] >> (i % 32)) & 1) {
+            ref_add_pt(&stR, &stR, &stP);
+        }
+    }
+    if (ref_is_zero(stR.z)) {
+        return false;
+    }
+    ref_mod_inv(aulZi, stR.z);
+    ref_mod_mul(aulT, aulZi, aulZi);
+    ref_mod_mul(stR.x, stR.x, aulT);
+    ref_mod_mul(aulT, aulT, aulZi);
+    ref_mod_mul(stR.y, stR.y, aulT);
+    ref_to_bytes(&pResult[0], stR.x);
+    ref_to_bytes(&pResult[32], stR.y);
+    return true;
+}
+
+// Random bytes of a fixed sequence (xorshift32)
+static void test_p256_random(uint8_t *pBytes, uint32_t len)
+{
+    static uint32_t s = 0x2545f491;
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        pBytes[i] = (uint8_t)s;
+    }
+}
+
+// One multiplication in P256_STEPS steps. Returns the result of P256_MultResult.
+static bool test_p256_mult(uint8_t *pResult, const uint8_t *pPoint, const uint8_t *pScalar)
+{
+    static ST_P256_MULT stMult;
+    uint32_t steps = 0;
+
+    P256_MultStart(&stMult, pPoint, pScalar);
+    do {
+        steps++;
+        TEST_CHECK(steps <= P256_STEPS);
+    } while (!P256_MultStep(&stMult));
+    TEST_CHECK(steps == P256_STEPS);
+    return P256_MultResult(&stMult, pResult);
+}
+
+// k P of P256.c against the reference (bValid: false if P256_MultResult must reject the scalar)
+static void test_p256_check(const uint8_t *pPoint, const uint8_t *pScalar, bool bValid)
+{
+    uint8_t aucResult[64], aucRef[64];
+
+    TEST_CHECK(ref_mult(aucRef, pPoint, pScalar));
+    TEST_CHECK(test_p256_mult(aucResult, pPoint, pScalar) == bValid);
+    TEST_CHECK(!bValid || (memcmp(aucResult, aucRef, sizeof(aucRef)) == 0));
+}
+
+// P-256 multiplication against the reference: random scalars, scalars near 0 and n, points with x = 0
+static void test_p256(void)
+{
+    static const bool abEdgeValid[8] = { false, true, true, true, false, false, true, true };
+    uint8_t aucK[32], aucJ[32], aucQ[64], aucX0[64], aucPt[64];
+    uint8_t aaucEdge[8][32];
+    uint32_t aulW[8], aulT[8];
+    uint32_t i, j;
+
+    // Reference self-check: the base point is on the curve, n G is the point at infinity
+    TEST_CHECK(ref_on_curve(f_aulRefGx, f_aulRefGy));
+    ref_to_bytes(aucK, f_aulRefN);
+    TEST_CHECK(!ref_mult(aucPt, NULL, aucK));
+
+    // Scalars: 0 and n are rejected, 1 and n - 1 accepted
+    memset(aucK, 0, sizeof(aucK));
+    TEST_CHECK(!P256_ValidScalar(aucK));
+    ref_to_bytes(aucK, f_aulRefN);
+    TEST_CHECK(!P256_ValidScalar(aucK));
+    aucK[31]--;
+    TEST_CHECK(P256_ValidScalar(aucK));
+    memset(aucK, 0, sizeof(aucK));
+    aucK[31] = 1;
+    TEST_CHECK(P256_ValidScalar(aucK));
+
+    // Edge scalars: 1, 2, 3, 2^128, n - 1, n - 2, n - 3, (n + 1) / 2.
+    // 1, n - 2 and n - 1 meet the point at infinity on the ladder and are rejected (P256.h).
+    memset(aaucEdge, 0, sizeof(aaucEdge));
+    aaucEdge[0][31] = 1;
+    aaucEdge[1][31] = 2;
+    aaucEdge[2][31] = 3;
+    aaucEdge[3][15] = 1;
+    for (i = 0; i < 3; i++) {
+        memset(aulW, 0, sizeof(aulW));
+        aulW[0] = i + 1;
+        ref_sub(aulT, f_aulRefN, aulW);
+        ref_to_bytes(aaucEdge[4 + i], aulT);
+    }
+    memset(aulW, 0, sizeof(aulW));
+    aulW[0] = 1;
+    ref_add(aulT, f_aulRefN, aulW);
+    for (i = 0; i < 8; i++) {
+        aulT[i] = (aulT[i] >> 1) | ((i < 7) ? (aulT[i + 1] << 31) : 0);
+    }
+    ref_to_bytes(aaucEdge[7], aulT);
+
+    // A point with x = 0: y = sqrt(b) (p = 3 mod 4)
+    memset(aulW, 0, sizeof(aulW));
+    memset(aulT, 0, sizeof(aulT));
+    aulT[0] = 1;
+    ref_add(aulW, f_aulRefP, aulT);
+    for (i = 0; i < 8; i++) {
+        aulW[i] = (aulW[i] >> 2) | ((i < 7) ? (aulW[i + 1] << 30) : 0); // (p + 1) / 4
+    }
+    for (i = 256; i-- > 0;) {
+        ref_mod_mul(aulT, aulT, aulT);
+        if ((aulW[i / 32] >> (i % 32)) & 1) {
+            ref_mod_mul(aulT, aulT, f_aulRefB);
+        }
+    }
+    memset(aulW, 0, sizeof(aulW));
+    TEST_CHECK(ref_on_curve(aulW, aulT));
+    memset(aucX0, 0, 32);
+    ref_to_bytes(&aucX0[32], aulT);
+    TEST_CHECK(P256_ValidPoint(aucX0));
+
+    // Points that are not valid: y = 0 (P-256 has no point of order 2), x = p (not reduced)
+    ref_to_bytes(&aucPt[0], f_aulRefGx);
+    memset(&aucPt[32], 0, 32);
+    TEST_CHECK(!P256_ValidPoint(aucPt));
+    memset(aucPt, 0, 32);
+    TEST_CHECK(!P256_ValidPoint(aucPt));
+    memcpy(aucPt, aucX0, sizeof(aucPt));
+    ref_to_bytes(&aucPt[0], f_aulRefP);
+    TEST_CHECK(!P256_ValidPoint(aucPt));
+
+    for (i = 0; i < 8; i++) {
+        test_p256_check(NULL, aaucEdge[i], abEdgeValid[i]);
+        test_p256_check(aucX0, aaucEdge[i], abEdgeValid[i]);
+    }
+
+    // Random key pairs: public keys and the DHKey of both sides
+    for (i = 0; i < 8; i++) {
+        do {
+            test_p256_random(aucK, sizeof(aucK));
+        } while (!P256_ValidScalar(aucK));
+        do {
+            test_p256_random(aucJ, sizeof(aucJ));
+        } while (!P256_ValidScalar(aucJ));
+        test_p256_check(NULL, aucK, true);
+        TEST_CHECK(ref_mult(aucQ, NULL, aucJ));
+        TEST_CHECK(P256_ValidPoint(aucQ));
+        test_p256_check(aucQ, aucK, true);
+        test_p256_check(aucX0, aucK, true);
+        for (j = 0; j < 8; j++) {
+            test_p256_check(aucQ, aaucEdge[j], abEdgeValid[j]);
+        }
+    }
+}
+
+#if CRYP_ENABLE
+// Security Manager crypto commands answered on core0 instead of the controller
+static void test_crypto(void)
+{
+    // LE Secure Connections sample data (Core Vol 3 Part H 2.3.5.6.1), uECC format
+    static const uint8_t aucPrivateA[32] = {
+        0x3f, 0x49, 0xf6, 0xd4, 0xa3, 0xc5, 0x5f, 0x38, 0x74, 0xc9, 0xb3, 0xe3, 0xd2, 0x10, 0x3f, 0x50,
+        0x4a, 0xff, 0x60, 0x7b, 0xeb, 0x40, 0xb7, 0x99, 0x58, 0x99, 0xb8, 0xa6, 0xcd, 0x3c, 0x1a, 0xbd,
+    };
+    static const uint8_t aucPublicA[64] = {
+        0x20, 0xb0, 0x03, 0xd2, 0xf2, 0x97, 0xbe, 0x2c, 0x5e, 0x2c, 0x83, 0xa7, 0xe9, 0xf9, 0xa5, 0xb9,
+        0xef, 0xf4, 0x91, 0x11, 0xac, 0xf4, 0xfd, 0xdb, 0xcc, 0x03, 0x01, 0x48, 0x0e, 0x35, 0x9d, 0xe6,
+        0xdc, 0x80, 0x9c, 0x49, 0x65, 0x2a, 0xeb, 0x6d, 0x63, 0x32, 0x9a, 0xbf, 0x5a, 0x52, 0x15, 0x5c,
+        0x76, 0x63, 0x45, 0xc2, 0x8f, 0xed, 0x30, 0x24, 0x74, 0x1c, 0x8e, 0xd0, 0x15, 0x89, 0xd2, 0x8b,
+    };
+    static const uint8_t aucPublicB[64] = {
+        0x1e, 0xa1, 0xf0, 0xf0, 0x1f, 0xaf, 0x1d, 0x96, 0x09, 0x59, 0x22, 0x84, 0xf1, 0x9e, 0x4c, 0x00,
+        0x47, 0xb5, 0x8a, 0xfd, 0x86, 0x15, 0xa6, 0x9f, 0x55, 0x90, 0x77, 0xb2, 0x2f, 0xaa, 0xa1, 0x90,
+        0x4c, 0x55, 0xf3, 0x3e, 0x42, 0x9d, 0xad, 0x37, 0x73, 0x56, 0x70, 0x3a, 0x9a, 0xb8, 0x51, 0x60,
+        0x47, 0x2d, 0x11, 0x30, 0xe2, 0x8e, 0x36, 0x76, 0x5f, 0x89, 0xaf, 0xf9, 0x15, 0xb1, 0x21, 0x4a,
+    };
+    static const uint8_t aucDhKeyAB[32] = {
+        0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b,
+        0x99, 0x79, 0x6b, 0x13, 0xb4, 0xf8, 0x66, 0xf1, 0x86, 0x8d, 0x34, 0xf3, 0x73, 0xbf, 0xa6, 0x98,
+    };
+    // FIPS-197 C.1 (AES-128), in HCI byte order: Key, Plaintext_Data
+    static const uint8_t aucEncrypt[3 + 32] = {
+        0x17, 0x20, 32,
+        0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00,
+        0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00,
+    };
+    static const uint8_t aucEncrypted[16] = {
+        0x5a, 0xc5, 0xb4, 0x70, 0x80, 0xb7, 0xcd, 0xd8, 0x30, 0x04, 0x7b, 0x6a, 0xd8, 0xe0, 0xc4, 0x69,
+    };
+    static const uint8_t aucReadP256[3] = { 0x25, 0x20, 0 };
+    static const uint8_t aucReset[3] = { 0x03, 0x0c, 0 };
+    static uint8_t aucDhKey[3 + 64] = { 0x26, 0x20, 64 };
+    static uint8_t aucSupported[6 + 64] = { HCI_EVENT_COMMAND_COMPLETE, 4 + 64, 1, 0x02, 0x10, 0 };
+    ST_HOST_BT *pstBt = HOST_Bt();
+    uint32_t cmd_cnt = pstBt->hci_cmd_cnt;
+    uint32_t status_cnt = pstBt->hci_status_cnt;
+    uint32_t aes_cnt = CRYP_GetStat()->aes_cnt;
+    uint32_t i;
+
+    HOST_SetCoreNum(1);
+    // The controller reports the ECC commands as supported
+    HOST_BtHciEvent(aucSupported, sizeof(aucSupported));
+    TEST_CHECK((pstBt->hci_last_evt_len == sizeof(aucSupported)) && (pstBt->hci_last_evt[6 + 34] == 0x06));
+
+    // Other commands go to the controller
+    HOST_BtHciCommand(aucReset, sizeof(aucReset));
+    TEST_CHECK((pstBt->hci_cmd_cnt == cmd_cnt + 1) && (pstBt->hci_last_opcode == 0x0c03));
+
+    HOST_BtHciCommand(aucEncrypt, sizeof(aucEncrypt));
+    HOST_SetCoreNum(0);
+    CRYP_Task();
+    HOST_SetCoreNum(1);
+    HOST_BtRunTimers();
+    TEST_CHECK(pstBt->hci_cmd_cnt == cmd_cnt + 1);
+    TEST_CHECK((pstBt->hci_last_evt_len == 22) && (pstBt->hci_last_evt[0] == HCI_EVENT_COMMAND_COMPLETE));
+    TEST_CHECK((little_endian_read_16(pstBt->hci_last_evt, 3) == 0x2017) && (pstBt->hci_last_evt[5] == 0));
+    TEST_CHECK(memcmp(&pstBt->hci_last_evt[6], aucEncrypted, sizeof(aucEncrypted)) == 0);
+
+    // Local public key: Command Status, then the key given to the SM (EccKey.h) in HCI byte order
+    HOST_BtHciCommand(aucReadP256, sizeof(aucReadP256));
+    HOST_BtRunTimers();
+    TEST_CHECK(pstBt->hci_status_cnt == status_cnt + 1);
+    HOST_SetCoreNum(0);
+    CRYP_Task();
+    HOST_SetCoreNum(1);
+    HOST_BtRunTimers();
+    TEST_CHECK((pstBt->hci_last_evt_len == 68) && (pstBt->hci_last_evt[0] == HCI_EVENT_LE_META) && (pstBt->hci_last_evt[2] == 0x08));
+    TEST_CHECK((pstBt->hci_last_evt[3] == 0) && (CRYP_GetPublicKey() != NULL));
+    TEST_CHECK(pstBt->hci_last_evt[4 + 31] == CRYP_GetPublicKey()[0]);
+
+    // A remote key that is not on the curve is rejected
+    HOST_BtHciCommand(aucDhKey, sizeof(aucDhKey));
+    HOST_SetCoreNum(0);
+    CRYP_Task();
+    HOST_SetCoreNum(1);
+    HOST_BtRunTimers();
+    TEST_CHECK(pstBt->hci_status_cnt == status_cnt + 2);
+    TEST_CHECK((pstBt->hci_last_evt_len == 36) && (pstBt->hci_last_evt[2] == 0x09) && (pstBt->hci_last_evt[3] == 0x12));
+    aucDhKey[3] = 0x01;
+    HOST_BtHciCommand(aucDhKey, sizeof(aucDhKey));
+    TEST_CHECK((HOST_BridgeRunCrypto() == 1) && (pstBt->hci_last_evt[3] == 0x12));
+
+    // DHKey of the sample keys, in P256_STEPS steps that each return to the loop
+    CRYP_SetKey(aucPublicA, aucPrivateA);
+    HOST_BridgeReverseKey(&aucDhKey[3], aucPublicB);
+    HOST_BtHciCommand(aucDhKey, sizeof(aucDhKey));
+    TEST_CHECK(HOST_BridgeRunCrypto() == P256_STEPS);
+    TEST_CHECK((pstBt->hci_last_evt_len == 36) && (pstBt->hci_last_evt[3] == 0) && (CRYP_GetStat()->dhkey_cnt == 3));
+    for (i = 0; i < 32; i++) {
+        TEST_CHECK(pstBt->hci_last_evt[4 + i] == aucDhKeyAB[31 - i]);
+    }
+    TEST_CHECK(pstBt->hci_cmd_cnt == cmd_cnt + 1);
+    TEST_CHECK((CRYP_GetStat()->aes_cnt == aes_cnt + 1) && (CRYP_GetStat()->forward_cnt == 0));
+    HOST_SetCoreNum(0);
+}
+#endif
+
+#if CFG_BRIDGE_DIAG && FREC_ENABLE
+// Reads the flight recorder dump through the diagnostics feature report
+static void test_diag(void)
+{
+    static uint8_t aucCmd[DIAG_REPORT_SIZE];
+    static uint8_t aucRsp[DIAG_REPORT_SIZE];
+    ST_FREC_HDR stHdr, stNow;
+
+    memset(aucCmd, 0, sizeof(aucCmd));
+    aucCmd[0] = DIAG_CMD_OPEN;
+    aucCmd[1] = DIAG_SRC_FREC;
+    tud_hid_set_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucCmd, sizeof(aucCmd));
+    TEST_CHECK(tud_hid_get_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucRsp, sizeof(aucRsp)) == sizeof(aucRsp));
+    TEST_CHECK(aucRsp[0] == DIAG_STS_OK);
+    memcpy(&stHdr, &aucRsp[DIAG_RSP_HDR_SIZE], sizeof(stHdr));
+    TEST_CHECK(stHdr.magic == 0x43455246);
+    aucCmd[0] = DIAG_CMD_CLOSE;
+    tud_hid_set_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucCmd, sizeof(aucCmd));
+
+    // A dump the host stops reading is closed and recording resumes, after the timeout
+    // or when USB is unmounted
+    aucCmd[0] = DIAG_CMD_OPEN;
+    tud_hid_set_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucCmd, sizeof(aucCmd));
+    HOST_AdvanceUs((uint64_t)DIAG_IDLE_TIMEOUT_MS * 1000 - 1);
+    DIAG_Task();
+    TEST_CHECK(tud_hid_get_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucRsp, sizeof(aucRsp)) == sizeof(aucRsp));
+    TEST_CHECK(aucRsp[0] == DIAG_STS_OK);
+    HOST_AdvanceUs((uint64_t)DIAG_IDLE_TIMEOUT_MS * 1000);
+    DIAG_Task();
+    TEST_CHECK(tud_hid_get_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucRsp, sizeof(aucRsp)) == sizeof(aucRsp));
+    TEST_CHECK(aucRsp[0] == DIAG_STS_NOT_OPEN);
+    aucCmd[0] = DIAG_CMD_OPEN;
+    tud_hid_set_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucCmd, sizeof(aucCmd));
+    tud_umount_cb();
+    tud_mount_cb();
+    TEST_CHECK(tud_hid_get_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucRsp, sizeof(aucRsp)) == sizeof(aucRsp));
+    TEST_CHECK(aucRsp[0] == DIAG_STS_NOT_OPEN);
+    // The unmount was recorded while frozen: skipped; the mount after the reset is recorded
+    aucCmd[0] = DIAG_CMD_OPEN;
+    tud_hid_set_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucCmd, sizeof(aucCmd));
+    tud_hid_get_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucRsp, sizeof(aucRsp));
+    memcpy(&stNow, &aucRsp[DIAG_RSP_HDR_SIZE], sizeof(stNow));
+    TEST_CHECK((stNow.skip_cnt == stHdr.skip_cnt + 1) && (stNow.widx[0] == stHdr.widx[0] + 1));
+    aucCmd[0] = DIAG_CMD_CLOSE;
+    tud_hid_set_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucCmd, sizeof(aucCmd));
+}
+#endif
+
+#if CFG_BRIDGE_DIAG && (BPRF_ENABLE || TPRF_ENABLE)
+// Reads a whole diagnostics source through the feature report
+static void test_diag_read(uint8_t src, void *pBuf, uint32_t size)
+{
+    static uint8_t aucCmd[DIAG_REPORT_SIZE];
+    static uint8_t aucRsp[DIAG_REPORT_SIZE];
+    uint32_t done = 0;
+    uint32_t n;
+
+    memset(aucCmd, 0, sizeof(aucCmd));
+    aucCmd[0] = DIAG_CMD_OPEN;
+    aucCmd[1] = src;
+    tud_hid_set_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucCmd, sizeof(aucCmd));
+    while (done < size) {
+        TEST_CHECK(tud_hid_get_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucRsp, sizeof(aucRsp)) == sizeof(aucRsp));
+        TEST_CHECK(aucRsp[0] == DIAG_STS_OK);
+        n = aucRsp[2];
+        TEST_CHECK((n > 0) && (done + n <= size));
+        memcpy((uint8_t *)pBuf + done, &aucRsp[DIAG_RSP_HDR_SIZE], n);
+        done += n;
+    }
+    aucCmd[0] = DIAG_CMD_CLOSE;
+    tud_hid_set_report_cb(HID_INST_DIAG, DIAG_REPORT_ID, HID_REPORT_TYPE_FEATURE, aucCmd, sizeof(aucCmd));
+}
+#endif
+
+#if CFG_BRIDGE_DIAG && BPRF_ENABLE
+// Reads the boot profile through the diagnostics feature report
+static void test_boot(void)
+{
+    static ST_BPRF_IMAGE stImage;
+    uint32_t i;
+
+    test_diag_read(DIAG_SRC_BOOT, &stImage, sizeof(stImage));
+    TEST_CHECK((stImage.magic == 0x46525042) && (stImage.ms_num == BPRF_MS_NUM));
+    // The host bridge goes through every BLE milestone in order, then forwards reports
+    for (i = BPRF_MS_HCI_WORKING; i <= BPRF_MS_READY; i++) {
+        TEST_CHECK((stImage.aulTimeUs[i] != 0) && (stImage.aulTimeUs[i] >= stImage.aulTimeUs[i - 1]));
+    }
+    TEST_CHECK(stImage.aulTimeUs[BPRF_MS_FIRST_REPORT] >= stImage.aulTimeUs[BPRF_MS_READY]);
+}
+#endif
+
+#if CFG_BRIDGE_DIAG && TPRF_ENABLE
+// Task-time profiler: self time of nested tasks, long runs, loop histogram, read through the diagnostics feature report
+static void test_prof(void)
+{
+    static ST_TPRF_IMAGE stBefore;
+    static ST_TPRF_IMAGE stAfter;
+    const ST_TPRF_TASK *pstHid = &stAfter.astTask[TPRF_TASK_HID];
+    const ST_TPRF_TASK *pstIrq = &stAfter.astTask[TPRF_TASK_USB_IRQ];
+    const ST_TPRF_LOOP *pstLoop = &stAfter.astLoop[1];
+    uint32_t i;
+
+    // The report path of the previous tests was timed on core1
+    test_diag_read(DIAG_SRC_PROF, &stBefore, sizeof(stBefore));
+    TEST_CHECK((stBefore.magic == 0x46525054) && (stBefore.task_num == TPRF_TASK_NUM) && (stBefore.cyc_per_us == 125));
+    TEST_CHECK((stBefore.astTask[TPRF_TASK_BT_HCI].cnt > 0) && (stBefore.astTask[TPRF_TASK_BT_GATT].cnt > 0));
+    TEST_CHECK(stBefore.astTask[TPRF_TASK_BT_NOTIFY].cnt > 0);
+
+    // hid_task interrupted by the USB IRQ: the IRQ is not counted in the self time of hid_task
+    HOST_SetCoreNum(0);
+    systick_hw->cvr = 0x1000;
+    TPRF_Begin(TPRF_TASK_HID);
+    systick_hw->cvr = 0x0F00;
+    TPRF_Begin(TPRF_TASK_USB_IRQ);
+    systick_hw->cvr = 0x0E00;
+    TPRF_End();
+    systick_hw->cvr = 0x0C00;
+    TPRF_End();
+    // A run longer than the SysTick period is timed in us
+    TPRF_Begin(TPRF_TASK_LED);
+    HOST_AdvanceUs(200000);
+    TPRF_End();
+    // Runs nested too deep are not timed, the others still are
+    for (i = 0; i <= TPRF_DEPTH_MAX; i++) {
+        TPRF_Begin(TPRF_TASK_CRYPTO);
+    }
+    for (i = 0; i <= TPRF_DEPTH_MAX; i++) {
+        TPRF_End();
+    }
+    systick_hw->cvr = 0;
+    // Loop periods of core1: 3 us, 5 ms
+    HOST_SetCoreNum(1);
+    TPRF_Loop();
+    HOST_AdvanceUs(3);
+    TPRF_Loop();
+    HOST_AdvanceUs(5000);
+    TPRF_Loop();
+    HOST_SetCoreNum(0);
+    // Load log of core0 (visible with -v)
+    TPRF_Loop();
+    HOST_AdvanceUs((uint64_t)TPRF_LOG_MS * 1000);
+    TPRF_Loop();
+
+    test_diag_read(DIAG_SRC_PROF, &stAfter, sizeof(stAfter));
+    TEST_CHECK((pstHid->cnt == stBefore.astTask[TPRF_TASK_HID].cnt + 1) && (pstHid->cyc - stBefore.astTask[TPRF_TASK_HID].cyc == 0x300));
+    TEST_CHECK((pstIrq->cnt == stBefore.astTask[TPRF_TASK_USB_IRQ].cnt + 1) && (pstIrq->cyc - stBefore.astTask[TPRF_TASK_USB_IRQ].cyc == 0x100));
+    TEST_CHECK((pstHid->max >= 0x400) && (pstIrq->max >= 0x100));
+    TEST_CHECK(stAfter.astTask[TPRF_TASK_LED].max >= 200000 * 125);
+    TEST_CHECK(stAfter.astTask[TPRF_TASK_CRYPTO].cnt == stBefore.astTask[TPRF_TASK_CRYPTO].cnt + TPRF_DEPTH_MAX);
+    TEST_CHECK(stAfter.overflow_cnt == stBefore.overflow_cnt + 1);
+    TEST_CHECK(pstLoop->cnt - stBefore.astLoop[1].cnt == 2);
+    TEST_CHECK(pstLoop->aulHist[1] - stBefore.astLoop[1].aulHist[1] == 1);
+    TEST_CHECK(pstLoop->aulHist[TPRF_HIST_NUM - 1] - stBefore.astLoop[1].aulHist[TPRF_HIST_NUM - 1] == 1);
+    TEST_CHECK(pstLoop->max_us >= 5000);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            HOST_SetUartEcho(true);
+        }
+        else {
+            fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    HOST_BridgeInit();
+
+    test_queue();
+    test_desc();
+    test_hrd();
+#if XFM_ENABLE
+    test_xform();
+#endif
+    test_forward();
+    test_aes();
+#if RPAC_ENABLE
+    test_rpa();
+#endif
+#if ADVF_ENABLE
+    test_adv();
+#endif
+    test_p256();
+#if CRYP_ENABLE
+    test_crypto();
+#endif
+#if CFG_BRIDGE_DIAG && FREC_ENABLE
+    test_diag();
+#endif
+#if CFG_BRIDGE_DIAG && BPRF_ENABLE
+    test_boot();
+#endif
+#if CFG_BRIDGE_DIAG && TPRF_ENABLE
+    test_prof();
+#endif
+
+    // Output the deferred log (visible with -v)
+    for (i = 0; i < 10000; i++) {
+        LOG_Drain();
+    }
+    printf("bridge_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Binary trace of BLE HID report arrivals and USB host events (little endian).
+//
+//   header : ST_TRACE_HDR
+//   records: ST_TRACE_REC followed by len data bytes, sorted by time
+//
+// Records of kind TRACE_KIND_REPORT carry the report as delivered by the
+// HID service client (without the report ID byte).
+
+// [Definitions]
+#define TRACE_MAGIC   0x52544842 // 'BHTR'
+#define TRACE_VERSION 1
+
+// Maximum data length of one record
+#define TRACE_DATA_MAX 512
+
+// [Enumerations]
+// Record kinds
+typedef enum _E_TRACE_KIND {
+    TRACE_KIND_REPORT = 0,   // BLE HID input report received by core1
+    TRACE_KIND_SUSPEND,      // USB host suspends the bus
+    TRACE_KIND_RESUME,       // USB host resumes the bus on its own
+    TRACE_KIND_NUM
+} E_TRACE_KIND;
+
+#pragma pack(1)
+
+// [Structures]
+// File header
+typedef struct _ST_TRACE_HDR {
+    uint32_t magic;          // TRACE_MAGIC
+    uint16_t version;        // TRACE_VERSION
+    uint16_t rsv;
+    uint32_t rec_cnt;        // Number of records
+} ST_TRACE_HDR;
+
+// Record header
+typedef struct _ST_TRACE_REC {
+    uint32_t time_us;        // Time since the start of the trace
+    uint8_t kind;            // E_TRACE_KIND
+    uint8_t report_id;       // Report ID (TRACE_KIND_REPORT)
+    uint16_t len;            // Data bytes following the header
+} ST_TRACE_REC;
+
+#pragma pack()
+
+#endif
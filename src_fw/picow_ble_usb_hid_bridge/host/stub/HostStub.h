@@ -0,0 +1,112 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+#ifndef HOSTSTUB_H
+#define HOSTSTUB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Control interface of the host-native stubs of pico_sdk, TinyUSB and BTstack.
+// The stubs run everything on one thread in virtual time: time only advances
+// through HOST_AdvanceUs() (or the busy-wait/delay functions of the firmware).
+
+// [Definitions]
+// Maximum HID report length captured by the USB stub
+#define HOST_USB_RPT_MAX 64
+
+// Maximum HCI event length captured by the BTstack stub
+#define HOST_HCI_EVT_MAX 68
+
+// Connection parameters reported by HOST_BtLeConnectionComplete
+#define HOST_BT_CONN_INTERVAL       6   // 7.5 ms (1.25 ms units)
+#define HOST_BT_SUPERVISION_TIMEOUT 100 // 1 s (10 ms units)
+
+// [Structures]
+// State of the USB device stub
+typedef struct _ST_HOST_USB {
+    bool bMounted;                     // tud_mounted()
+    bool bSuspended;                   // tud_suspended()
+    bool bReady;                       // tud_hid_ready() of the bridge interface
+    bool bAutoComplete;                // Complete each transfer immediately (ready stays true)
+    uint32_t report_cnt;               // Reports accepted by tud_hid_report()
+    uint32_t wakeup_cnt;               // tud_remote_wakeup() calls
+    uint32_t connect_cnt;              // tud_connect() calls
+    uint8_t last_report_id;            // Report ID of the last report
+    uint16_t last_len;                 // Length of the last report
+    uint8_t last_report[HOST_USB_RPT_MAX]; // Last report (truncated)
+} ST_HOST_USB;
+
+// BTstack calls recorded by the stub
+typedef struct _ST_HOST_BT {
+    uint32_t power_on_cnt;             // hci_power_control(HCI_POWER_ON)
+    uint32_t scan_start_cnt;           // gap_start_scan()
+    uint32_t connect_cnt;              // gap_connect()
+    uint32_t pairing_cnt;              // sm_request_pairing()
+    uint32_t hids_connect_cnt;         // hids_client_connect()
+    uint32_t hids_report_cnt;          // Report events built by hids_client
+    uint32_t gatt_query_cnt;           // GATT client queries (discovery and reads)
+    uint32_t dis_query_cnt;            // device_information_service_client_query()
+    uint32_t tlv_store_cnt;            // Writes to the flash TLV stub
+    uint32_t conn_update_cnt;          // gap_update_connection_parameters()
+    uint16_t conn_interval;            // Maximum interval of the last update
+    uint16_t conn_latency;             // Latency of the last update
+    uint32_t ecc_gen_cnt;              // uECC_make_key()
+    uint32_t ecc_set_key_cnt;          // btstack_crypto_ecc_p256_set_key()
+    uint8_t ecc_public_key[64];        // Key pair of the last btstack_crypto_ecc_p256_set_key()
+    uint32_t hci_cmd_cnt;              // HCI commands that reached the controller
+    uint16_t hci_last_opcode;          // Opcode of the last of them
+    uint32_t hci_evt_cnt;              // HCI events that reached BTstack (hci.c)
+    uint32_t hci_status_cnt;           // Command Status events among them
+    uint16_t hci_last_evt_len;         // Length of the last event
+    uint8_t hci_last_evt[HOST_HCI_EVT_MAX]; // Last event (truncated)
+    uint32_t acl_rx_cnt;               // ACL packets delivered to the host (HOST_BtHidReport)
+    uint32_t acl_done_cnt;             // ACL packets returned by HCI_Host_Number_Of_Completed_Packets
+} ST_HOST_BT;
+
+// Watchdog calls recorded by the stub (the scratch registers are in watchdog_hw)
+typedef struct _ST_HOST_WDG {
+    bool bCausedReboot;                // watchdog_caused_reboot()
+    bool bEnabled;                     // watchdog_enable() was called
+    uint32_t update_cnt;               // watchdog_update() calls
+    uint32_t reboot_cnt;               // watchdog_reboot() calls
+} ST_HOST_WDG;
+
+// [Function Prototypes]
+// Time
+void HOST_AdvanceUs(uint64_t us);
+uint64_t HOST_GetTimeUs(void);
+void HOST_SetCoreNum(uint32_t core);
+
+// Watchdog
+ST_HOST_WDG *HOST_Wdg(void);
+
+// UART (log output)
+void HOST_SetUartEcho(bool bEcho);
+
+// TinyUSB
+ST_HOST_USB *HOST_Usb(void);
+void HOST_UsbCompleteTransfer(void);
+
+// BTstack
+ST_HOST_BT *HOST_Bt(void);
+void HOST_BtReset(void);
+void HOST_BtRunTimers(void);
+void HOST_BtSetHidDescriptor(const uint8_t *pDesc, uint16_t len);
+void HOST_BtSetHidReports(const uint8_t *pReportId, uint8_t cnt); // Input report characteristics of the HID service
+void HOST_BtEventState(uint8_t state);
+void HOST_BtAdvReport(const uint8_t *addr, bool bHidService);
+void HOST_BtAdvReportType(const uint8_t *addr, uint8_t addr_type, bool bHidService);
+void HOST_BtSetBond(int index, const uint8_t *addr, const uint8_t *irk); // irk NULL: remove the bond
+void HOST_BtLeConnectionComplete(uint16_t con_handle);
+void HOST_BtConnectionUpdateComplete(uint16_t con_handle, uint16_t interval, uint16_t latency);
+void HOST_BtDisconnectionComplete(uint16_t con_handle);
+void HOST_BtPairingComplete(uint16_t con_handle, uint8_t status);
+void HOST_BtReencryptionComplete(uint16_t con_handle, uint8_t status);
+void HOST_BtHidServiceConnected(uint8_t status);
+void HOST_BtHidReport(uint8_t report_id, const uint8_t *pReport, uint16_t len); // Input report notification (pReport: data without the report ID)
+void HOST_BtHidsListenFirst(void);  // hids_client gets the notifications before the other value listeners
+void HOST_BtHciCommand(const uint8_t *pCmd, uint16_t len);  // BTstack -> controller, through the HCI transport
+void HOST_BtHciEvent(const uint8_t *pEvt, uint16_t len);    // Controller -> BTstack, through the HCI transport
+void HOST_BtDeviceInformation(const char *pszManufacturer, const char *pszModel, uint8_t vid_src, uint16_t vid, uint16_t pid); // NULL: not provided
+
+#endif
@@ -0,0 +1,955 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of BTstack: timers, TLV in RAM, handler registration and event injection
+#include <stdio.h>
+#include "btstack.h"
+#include "uECC.h"
+#include "pico/cyw43_arch.h"
+#include "HostStub.h"
+#include "CryptoOffload.h"
+#include "AclFlow.h"
+
+// [Definitions]
+#define HOST_HANDLER_MAX  4   // Registered handlers per list
+#define HOST_TLV_MAX      8   // Tags of the TLV stub
+#define HOST_TLV_SIZE     128 // Maximum value size of the TLV stub
+#define HOST_EVT_SIZE     300 // Maximum event size
+#define HOST_HIDS_CID     1   // hids_cid handed out by hids_client_connect()
+#define HOST_HID_VALUE_HANDLE(report_id) (0x0020 + 4 * (report_id)) // Value handle of each input report characteristic
+#define HOST_MAIN_MAX     4   // Callbacks pending on the run loop
+#define HOST_BOND_MAX     16  // Entries of the device DB stub
+#define HOST_HID_RPT_MAX  8   // Input report characteristics of the HID service stub
+#define HOST_HID_SERVICE_START 0x0010                            // Handle range of the HID service
+#define HOST_HID_SERVICE_END   (HOST_HID_VALUE_HANDLE(255) + 2)  // (value, CCCD, Report Reference per report)
+
+// HCI_Host_Number_Of_Completed_Packets
+#define HOST_OPCODE_HOST_NUM_COMPLETED_PACKETS 0x0C35
+
+// The firmware links with --wrap=hci_transport_cyw43_instance when the crypto offload or the backpressure is built in
+#if CRYP_ENABLE || ACLF_ENABLE
+const hci_transport_t *__wrap_hci_transport_cyw43_instance(void);
+#define HOST_HCI_TRANSPORT() __wrap_hci_transport_cyw43_instance()
+#else
+#define HOST_HCI_TRANSPORT() __real_hci_transport_cyw43_instance()
+#endif
+const hci_transport_t *__real_hci_transport_cyw43_instance(void);
+
+// [Structures]
+// One entry of the device DB stub
+typedef struct _ST_HOST_BOND {
+    bool bValid;
+    bd_addr_t addr;
+    sm_key_t irk;
+} ST_HOST_BOND;
+
+// One tag of the TLV stub
+typedef struct _ST_HOST_TLV {
+    uint32_t tag;
+    uint32_t len;
+    uint8_t data[HOST_TLV_SIZE];
+} ST_HOST_TLV;
+
+// [File Scope Variables]
+static ST_HOST_BT f_stBt = {0};
+static btstack_timer_source_t *f_pTimerList = NULL;
+static btstack_packet_callback_registration_t *f_apHci[HOST_HANDLER_MAX] = {0};
+static btstack_packet_callback_registration_t *f_apSm[HOST_HANDLER_MAX] = {0};
+static btstack_packet_handler_t f_pfnHids = NULL;
+static btstack_packet_handler_t f_pfnDis = NULL;
+static const btstack_tlv_t *f_pTlvImpl = NULL;
+static void *f_pTlvCtx = NULL;
+static ST_HOST_TLV f_astTlv[HOST_TLV_MAX] = {0};
+static const uint8_t *f_pHidDesc = NULL;
+static uint16_t f_hidDescLen = 0;
+static uint8_t f_aucEvt[HOST_EVT_SIZE];
+static const hci_transport_t *f_pHciTransport = NULL;
+static void (*f_pfnHciTransportHandler)(uint8_t packet_type, uint8_t *packet, uint16_t size) = NULL;
+static btstack_context_callback_registration_t *f_apMain[HOST_MAIN_MAX] = {0};
+static ST_HOST_BOND f_astBond[HOST_BOND_MAX] = {0};
+static uint16_t f_conHandle = 0;
+static gatt_client_notification_t *f_pValueList = NULL;  // Value listeners, latest first like gatt_client.c
+static gatt_client_notification_t f_stHidsListener;      // Value listener of hids_client
+static uint8_t f_aucHidsEvt[HOST_EVT_SIZE];              // Report event built by hids_client
+static uint8_t f_aucHidRptId[HOST_HID_RPT_MAX];          // Input report characteristics of the HID service
+static uint8_t f_hidRptCnt = 0;
+static btstack_packet_handler_t f_pfnGatt = NULL;        // GATT client query in progress (answered by the run loop)
+static uint16_t f_gattUuid = 0;                          // UUID of the query
+
+//--------------------------------------------------------------------+
+// TLV stub (stands in for the flash TLV)
+//--------------------------------------------------------------------+
+static ST_HOST_TLV *host_tlv_find(uint32_t tag)
+{
+    int i;
+
+    for (i = 0; i < HOST_TLV_MAX; i++) {
+        if ((f_astTlv[i].len > 0) && (f_astTlv[i].tag == tag)) {
+            return &f_astTlv[i];
+        }
+    }
+    return NULL;
+}
+
+static int host_tlv_get_tag(void *context, uint32_t tag, uint8_t *buffer, uint32_t buffer_size)
+{
+    ST_HOST_TLV *pstTlv = host_tlv_find(tag);
+
+    (void)context;
+    if (pstTlv == NULL) {
+        return 0;
+    }
+    if (buffer != NULL) {
+        memcpy(buffer, pstTlv->data, (pstTlv->len < buffer_size) ? pstTlv->len : buffer_size);
+    }
+    return (int)pstTlv->len;
+}
+
+static int host_tlv_store_tag(void *context, uint32_t tag, const uint8_t *data, uint32_t data_size)
+{
+    ST_HOST_TLV *pstTlv = host_tlv_find(tag);
+    int i;
+
+    (void)context;
+    if ((data_size == 0) || (data_size > HOST_TLV_SIZE)) {
+        return 1;
+    }
+    for (i = 0; (pstTlv == NULL) && (i < HOST_TLV_MAX); i++) {
+        if (f_astTlv[i].len == 0) {
+            pstTlv = &f_astTlv[i];
+        }
+    }
+    if (pstTlv == NULL) {
+        return 1;
+    }
+    pstTlv->tag = tag;
+    pstTlv->len = data_size;
+    memcpy(pstTlv->data, data, data_size);
+    f_stBt.tlv_store_cnt++;
+    return 0;
+}
+
+static void host_tlv_delete_tag(void *context, uint32_t tag)
+{
+    ST_HOST_TLV *pstTlv = host_tlv_find(tag);
+
+    (void)context;
+    if (pstTlv != NULL) {
+        pstTlv->len = 0;
+    }
+}
+
+static const btstack_tlv_t f_stHostTlv = {
+    &host_tlv_get_tag,
+    &host_tlv_store_tag,
+    &host_tlv_delete_tag,
+};
+
+//--------------------------------------------------------------------+
+// Stub control
+//--------------------------------------------------------------------+
+// Returns the recorded BTstack calls
+ST_HOST_BT *HOST_Bt(void)
+{
+    return &f_stBt;
+}
+
+// Forgets registered handlers, timers and stored tags
+void HOST_BtReset(void)
+{
+    memset(&f_stBt, 0, sizeof(f_stBt));
+    memset(f_apHci, 0, sizeof(f_apHci));
+    memset(f_apSm, 0, sizeof(f_apSm));
+    memset(f_astTlv, 0, sizeof(f_astTlv));
+    memset(f_apMain, 0, sizeof(f_apMain));
+    memset(f_astBond, 0, sizeof(f_astBond));
+    f_pTimerList = NULL;
+    f_pValueList = NULL;
+    f_pfnHids = NULL;
+    f_pfnDis = NULL;
+    f_pfnGatt = NULL;
+    f_hidRptCnt = 0;
+    f_pTlvImpl = NULL;
+    f_pTlvCtx = NULL;
+}
+
+// Answers the GATT client query in progress from the HID service stub
+static void host_bt_gatt_run(void)
+{
+    btstack_packet_handler_t pfnGatt = f_pfnGatt;
+    uint16_t value_handle;
+    int i;
+
+    f_pfnGatt = NULL;
+    memset(f_aucEvt, 0, 14);
+    little_endian_store_16(f_aucEvt, 2, f_conHandle);
+    if (f_gattUuid == ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE) {
+        f_aucEvt[0] = GATT_EVENT_SERVICE_QUERY_RESULT;
+        f_aucEvt[1] = 8;
+        little_endian_store_16(f_aucEvt, 4, HOST_HID_SERVICE_START);
+        little_endian_store_16(f_aucEvt, 6, HOST_HID_SERVICE_END);
+        little_endian_store_16(f_aucEvt, 8, ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE);
+        pfnGatt(HCI_EVENT_PACKET, 0, f_aucEvt, 10);
+    }
+    for (i = 0; i < f_hidRptCnt; i++) {
+        value_handle = HOST_HID_VALUE_HANDLE(f_aucHidRptId[i]);
+        if (f_gattUuid == ORG_BLUETOOTH_CHARACTERISTIC_REPORT) {
+            f_aucEvt[0] = GATT_EVENT_CHARACTERISTIC_QUERY_RESULT;
+            f_aucEvt[1] = 12;
+            little_endian_store_16(f_aucEvt, 4, value_handle - 1);
+            little_endian_store_16(f_aucEvt, 6, value_handle);
+            little_endian_store_16(f_aucEvt, 8, value_handle + 2);
+            little_endian_store_16(f_aucEvt, 10, ATT_PROPERTY_READ | ATT_PROPERTY_NOTIFY);
+            little_endian_store_16(f_aucEvt, 12, ORG_BLUETOOTH_CHARACTERISTIC_REPORT);
+            pfnGatt(HCI_EVENT_PACKET, 0, f_aucEvt, 14);
+        }
+        else if (f_gattUuid == ORG_BLUETOOTH_DESCRIPTOR_REPORT_REFERENCE) {
+            // Report ID, input report
+            f_aucEvt[0] = GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT;
+            f_aucEvt[1] = 8;
+            little_endian_store_16(f_aucEvt, 4, value_handle + 2);
+            little_endian_store_16(f_aucEvt, 6, 2);
+            f_aucEvt[8] = f_aucHidRptId[i];
+            f_aucEvt[9] = 1;
+            pfnGatt(HCI_EVENT_PACKET, 0, f_aucEvt, 10);
+        }
+    }
+    f_aucEvt[0] = GATT_EVENT_QUERY_COMPLETE;
+    f_aucEvt[1] = 3;
+    little_endian_store_16(f_aucEvt, 2, f_conHandle);
+    f_aucEvt[4] = ATT_ERROR_SUCCESS;
+    pfnGatt(HCI_EVENT_PACKET, 0, f_aucEvt, 5);
+}
+
+// Runs the callbacks posted to the run loop, the GATT client queries and the handlers of all expired timers
+void HOST_BtRunTimers(void)
+{
+    btstack_context_callback_registration_t *pReg;
+    btstack_timer_source_t *ts;
+    int i;
+
+    // A query may start the next one from its completion
+    while (f_pfnGatt != NULL) {
+        host_bt_gatt_run();
+    }
+
+    while (f_apMain[0] != NULL) {
+        pReg = f_apMain[0];
+        for (i = 1; i < HOST_MAIN_MAX; i++) {
+            f_apMain[i - 1] = f_apMain[i];
+        }
+        f_apMain[HOST_MAIN_MAX - 1] = NULL;
+        pReg->callback(pReg->context);
+    }
+
+    while ((f_pTimerList != NULL) && ((int32_t)(f_pTimerList->timeout - btstack_run_loop_get_time_ms()) <= 0)) {
+        ts = f_pTimerList;
+        f_pTimerList = (btstack_timer_source_t *)ts->item.next;
+        ts->item.next = NULL;
+        ts->process(ts);
+    }
+}
+
+// Sets the report map returned by hids_client_descriptor_storage_get_descriptor_data()
+void HOST_BtSetHidDescriptor(const uint8_t *pDesc, uint16_t len)
+{
+    f_pHidDesc = pDesc;
+    f_hidDescLen = len;
+}
+
+// Sets the input report characteristics found by a GATT discovery of the HID service
+void HOST_BtSetHidReports(const uint8_t *pReportId, uint8_t cnt)
+{
+    f_hidRptCnt = (cnt < HOST_HID_RPT_MAX) ? cnt : HOST_HID_RPT_MAX;
+    memcpy(f_aucHidRptId, pReportId, f_hidRptCnt);
+}
+
+static void host_bt_deliver(btstack_packet_callback_registration_t **apList, uint16_t size)
+{
+    int i;
+
+    for (i = 0; i < HOST_HANDLER_MAX; i++) {
+        if (apList[i] != NULL) {
+            apList[i]->callback(HCI_EVENT_PACKET, 0, f_aucEvt, size);
+        }
+    }
+}
+
+static void host_bt_add_handler(btstack_packet_callback_registration_t **apList, btstack_packet_callback_registration_t *pReg)
+{
+    int i;
+
+    for (i = 0; i < HOST_HANDLER_MAX; i++) {
+        if ((apList[i] == NULL) || (apList[i] == pReg)) {
+            apList[i] = pReg;
+            return;
+        }
+    }
+}
+
+void HOST_BtEventState(uint8_t state)
+{
+    f_aucEvt[0] = BTSTACK_EVENT_STATE;
+    f_aucEvt[1] = 1;
+    f_aucEvt[2] = state;
+    host_bt_deliver(f_apHci, 3);
+}
+
+void HOST_BtAdvReport(const uint8_t *addr, bool bHidService)
+{
+    HOST_BtAdvReportType(addr, BD_ADDR_TYPE_LE_PUBLIC, bHidService);
+}
+
+void HOST_BtAdvReportType(const uint8_t *addr, uint8_t addr_type, bool bHidService)
+{
+    static const uint8_t aucAdHid[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0x12, 0x18 };
+    static const uint8_t aucAdOther[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0x0f, 0x18 };
+    const uint8_t *pAd = bHidService ? aucAdHid : aucAdOther;
+
+    memset(f_aucEvt, 0, 12);
+    f_aucEvt[0] = GAP_EVENT_ADVERTISING_REPORT;
+    f_aucEvt[1] = 10 + sizeof(aucAdHid);
+    f_aucEvt[3] = addr_type;
+    memcpy(&f_aucEvt[4], addr, 6);
+    f_aucEvt[11] = sizeof(aucAdHid);
+    memcpy(&f_aucEvt[12], pAd, sizeof(aucAdHid));
+    host_bt_deliver(f_apHci, 12 + sizeof(aucAdHid));
+}
+
+void HOST_BtLeConnectionComplete(uint16_t con_handle)
+{
+    memset(f_aucEvt, 0, 33);
+    f_aucEvt[0] = HCI_EVENT_META_GAP;
+    f_aucEvt[1] = 31;
+    f_aucEvt[2] = GAP_SUBEVENT_LE_CONNECTION_COMPLETE;
+    f_conHandle = con_handle;
+    f_aucEvt[4] = (uint8_t)con_handle;
+    f_aucEvt[5] = (uint8_t)(con_handle >> 8);
+    f_aucEvt[26] = HOST_BT_CONN_INTERVAL;
+    f_aucEvt[30] = HOST_BT_SUPERVISION_TIMEOUT;
+    host_bt_deliver(f_apHci, 33);
+}
+
+void HOST_BtConnectionUpdateComplete(uint16_t con_handle, uint16_t interval, uint16_t latency)
+{
+    memset(f_aucEvt, 0, 12);
+    f_aucEvt[0] = HCI_EVENT_LE_META;
+    f_aucEvt[1] = 10;
+    f_aucEvt[2] = HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE;
+    f_aucEvt[4] = (uint8_t)con_handle;
+    f_aucEvt[5] = (uint8_t)(con_handle >> 8);
+    f_aucEvt[6] = (uint8_t)interval;
+    f_aucEvt[7] = (uint8_t)(interval >> 8);
+    f_aucEvt[8] = (uint8_t)latency;
+    f_aucEvt[9] = (uint8_t)(latency >> 8);
+    f_aucEvt[10] = HOST_BT_SUPERVISION_TIMEOUT;
+    host_bt_deliver(f_apHci, 12);
+}
+
+void HOST_BtDisconnectionComplete(uint16_t con_handle)
+{
+    f_aucEvt[0] = HCI_EVENT_DISCONNECTION_COMPLETE;
+    f_aucEvt[1] = 4;
+    f_aucEvt[2] = ERROR_CODE_SUCCESS;
+    f_aucEvt[3] = (uint8_t)con_handle;
+    f_aucEvt[4] = (uint8_t)(con_handle >> 8);
+    f_aucEvt[5] = 0x13;
+    host_bt_deliver(f_apHci, 6);
+}
+
+void HOST_BtPairingComplete(uint16_t con_handle, uint8_t status)
+{
+    memset(f_aucEvt, 0, 13);
+    f_aucEvt[0] = SM_EVENT_PAIRING_COMPLETE;
+    f_aucEvt[1] = 11;
+    f_aucEvt[2] = (uint8_t)con_handle;
+    f_aucEvt[3] = (uint8_t)(con_handle >> 8);
+    f_aucEvt[11] = status;
+    host_bt_deliver(f_apSm, 13);
+}
+
+void HOST_BtReencryptionComplete(uint16_t con_handle, uint8_t status)
+{
+    memset(f_aucEvt, 0, 12);
+    f_aucEvt[0] = SM_EVENT_REENCRYPTION_COMPLETE;
+    f_aucEvt[1] = 10;
+    f_aucEvt[2] = (uint8_t)con_handle;
+    f_aucEvt[3] = (uint8_t)(con_handle >> 8);
+    f_aucEvt[11] = status;
+    host_bt_deliver(f_apSm, 12);
+}
+
+void HOST_BtHidServiceConnected(uint8_t status)
+{
+    if (f_pfnHids == NULL) {
+        return;
+    }
+    f_aucEvt[0] = HCI_EVENT_GATTSERVICE_META;
+    f_aucEvt[1] = 6;
+    f_aucEvt[2] = GATTSERVICE_SUBEVENT_HID_SERVICE_CONNECTED;
+    f_aucEvt[3] = HOST_HIDS_CID;
+    f_aucEvt[4] = 0;
+    f_aucEvt[5] = status;
+    f_aucEvt[6] = HID_PROTOCOL_MODE_REPORT;
+    f_aucEvt[7] = 1;
+    f_pfnHids(HCI_EVENT_PACKET, 0, f_aucEvt, 8);
+}
+
+// Returns the controller's buffer of the ACL packet, like hci.c does once it has been handled
+// (ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL)
+static void host_bt_acl_completed(void)
+{
+    uint8_t aucCmd[8];
+
+    little_endian_store_16(aucCmd, 0, HOST_OPCODE_HOST_NUM_COMPLETED_PACKETS);
+    aucCmd[2] = 5;
+    aucCmd[3] = 1;
+    little_endian_store_16(aucCmd, 4, f_conHandle);
+    little_endian_store_16(aucCmd, 6, 1);
+    if (f_pHciTransport != NULL) {
+        f_pHciTransport->send_packet(HCI_COMMAND_DATA_PACKET, aucCmd, sizeof(aucCmd));
+    }
+}
+
+// hids_client: turns the notification of an input report into a report event, the report data starting with the report ID
+static void host_bt_hids_notification(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size)
+{
+    uint16_t len = gatt_event_notification_get_value_length(packet);
+    uint8_t report_id = (uint8_t)((gatt_event_notification_get_value_handle(packet) - HOST_HID_VALUE_HANDLE(0)) / 4);
+
+    (void)packet_type;
+    (void)channel;
+    (void)size;
+    // Like hids_client.c: events other than notifications and unknown value handles are skipped
+    if ((hci_event_packet_get_type(packet) != GATT_EVENT_NOTIFICATION) ||
+        (gatt_event_notification_get_value_handle(packet) < HOST_HID_VALUE_HANDLE(0)) || (f_pfnHids == NULL)) {
+        return;
+    }
+    f_stBt.hids_report_cnt++;
+    f_aucHidsEvt[0] = HCI_EVENT_GATTSERVICE_META;
+    f_aucHidsEvt[1] = (uint8_t)(8 + len);
+    f_aucHidsEvt[2] = GATTSERVICE_SUBEVENT_HID_REPORT;
+    f_aucHidsEvt[3] = HOST_HIDS_CID;
+    f_aucHidsEvt[4] = 0;
+    f_aucHidsEvt[5] = 0;
+    f_aucHidsEvt[6] = report_id;
+    f_aucHidsEvt[7] = (uint8_t)(len + 1);
+    f_aucHidsEvt[8] = (uint8_t)((len + 1) >> 8);
+    f_aucHidsEvt[9] = report_id;
+    memcpy(&f_aucHidsEvt[10], gatt_event_notification_get_value(packet), len);
+    f_pfnHids(HCI_EVENT_PACKET, 0, f_aucHidsEvt, (uint16_t)(10 + len));
+}
+
+// Notification of the input report characteristic of the report ID, dispatched to the value listeners
+void HOST_BtHidReport(uint8_t report_id, const uint8_t *pReport, uint16_t len)
+{
+    gatt_client_notification_t *pNotification;
+    gatt_client_notification_t *pNext;
+
+    if ((f_pfnHids == NULL) || (len > HOST_EVT_SIZE - 10)) {
+        return;
+    }
+    f_aucEvt[0] = GATT_EVENT_NOTIFICATION;
+    f_aucEvt[1] = (uint8_t)(6 + len);
+    little_endian_store_16(f_aucEvt, 2, f_conHandle);
+    little_endian_store_16(f_aucEvt, 4, HOST_HID_VALUE_HANDLE(report_id));
+    little_endian_store_16(f_aucEvt, 6, len);
+    memcpy(&f_aucEvt[8], pReport, len);
+    f_stBt.acl_rx_cnt++;
+    for (pNotification = f_pValueList; pNotification != NULL; pNotification = pNext) {
+        pNext = (gatt_client_notification_t *)pNotification->item.next;
+        if ((pNotification->con_handle == f_conHandle) &&
+            ((pNotification->attribute_handle == 0) || (pNotification->attribute_handle == HOST_HID_VALUE_HANDLE(report_id)))) {
+            pNotification->callback(HCI_EVENT_PACKET, 0, f_aucEvt, (uint16_t)(8 + len));
+        }
+    }
+    host_bt_acl_completed();
+}
+
+// Registers the listener of hids_client again: the listener registered last is called first
+void HOST_BtHidsListenFirst(void)
+{
+    if (f_pfnHids != NULL) {
+        gatt_client_listen_for_characteristic_value_updates(&f_stHidsListener, &host_bt_hids_notification, f_conHandle, NULL);
+    }
+}
+
+// Adds or removes a bond of the device DB stub
+void HOST_BtSetBond(int index, const uint8_t *addr, const uint8_t *irk)
+{
+    if ((index < 0) || (index >= HOST_BOND_MAX)) {
+        return;
+    }
+    f_astBond[index].bValid = (irk != NULL);
+    if (irk != NULL) {
+        memcpy(f_astBond[index].addr, addr, sizeof(bd_addr_t));
+        memcpy(f_astBond[index].irk, irk, sizeof(sm_key_t));
+    }
+}
+
+// Sends an HCI command the way hci.c does
+void HOST_BtHciCommand(const uint8_t *pCmd, uint16_t len)
+{
+    static uint8_t aucCmd[HOST_EVT_SIZE];
+
+    if ((f_pHciTransport == NULL) || (len > sizeof(aucCmd))) {
+        return;
+    }
+    memcpy(aucCmd, pCmd, len);
+    (void)f_pHciTransport->send_packet(HCI_COMMAND_DATA_PACKET, aucCmd, len);
+}
+
+// Injects an HCI event of the controller
+void HOST_BtHciEvent(const uint8_t *pEvt, uint16_t len)
+{
+    if ((f_pfnHciTransportHandler == NULL) || (len > HOST_EVT_SIZE)) {
+        return;
+    }
+    memcpy(f_aucEvt, pEvt, len);
+    f_pfnHciTransportHandler(HCI_EVENT_PACKET, f_aucEvt, len);
+}
+
+static void host_bt_dis_value(uint8_t subevent, const char *pszValue)
+{
+    uint16_t len = (pszValue != NULL) ? (uint16_t)strlen(pszValue) : 0;
+
+    if (len > HOST_EVT_SIZE - 7) {
+        len = HOST_EVT_SIZE - 7;
+    }
+    f_aucEvt[0] = HCI_EVENT_GATTSERVICE_META;
+    f_aucEvt[1] = (uint8_t)(5 + len);
+    f_aucEvt[2] = subevent;
+    f_aucEvt[3] = 0;
+    f_aucEvt[4] = 0;
+    f_aucEvt[5] = (pszValue != NULL) ? ATT_ERROR_SUCCESS : ATT_ERROR_ATTRIBUTE_NOT_FOUND;
+    memcpy(&f_aucEvt[6], (pszValue != NULL) ? pszValue : "", len);
+    f_aucEvt[6 + len] = 0;
+    f_pfnDis(HCI_EVENT_PACKET, 0, f_aucEvt, (uint16_t)(7 + len));
+}
+
+// Completes the Device Information Service query with the given characteristics
+void HOST_BtDeviceInformation(const char *pszManufacturer, const char *pszModel, uint8_t vid_src, uint16_t vid, uint16_t pid)
+{
+    btstack_packet_handler_t pfnDis = f_pfnDis;
+
+    if (pfnDis == NULL) {
+        return;
+    }
+    host_bt_dis_value(GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_MANUFACTURER_NAME, pszManufacturer);
+    host_bt_dis_value(GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_MODEL_NUMBER, pszModel);
+
+    memset(f_aucEvt, 0, 13);
+    f_aucEvt[0] = HCI_EVENT_GATTSERVICE_META;
+    f_aucEvt[1] = 11;
+    f_aucEvt[2] = GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_PNP_ID;
+    f_aucEvt[5] = (vid_src != 0) ? ATT_ERROR_SUCCESS : ATT_ERROR_ATTRIBUTE_NOT_FOUND;
+    f_aucEvt[6] = vid_src;
+    f_aucEvt[7] = (uint8_t)vid;
+    f_aucEvt[8] = (uint8_t)(vid >> 8);
+    f_aucEvt[9] = (uint8_t)pid;
+    f_aucEvt[10] = (uint8_t)(pid >> 8);
+    f_aucEvt[11] = 0x01;
+    pfnDis(HCI_EVENT_PACKET, 0, f_aucEvt, 13);
+
+    // The client is free for the next query before the done event is delivered
+    f_pfnDis = NULL;
+    f_aucEvt[0] = HCI_EVENT_GATTSERVICE_META;
+    f_aucEvt[1] = 4;
+    f_aucEvt[2] = GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_DONE;
+    f_aucEvt[3] = 0;
+    f_aucEvt[4] = 0;
+    f_aucEvt[5] = ATT_ERROR_SUCCESS;
+    pfnDis(HCI_EVENT_PACKET, 0, f_aucEvt, 6);
+}
+
+//--------------------------------------------------------------------+
+// BTstack API
+//--------------------------------------------------------------------+
+bool ad_data_contains_uuid16(uint8_t ad_len, const uint8_t *ad_data, uint16_t uuid16)
+{
+    uint8_t pos = 0;
+    uint8_t i;
+
+    while (pos + 1 < ad_len) {
+        uint8_t len = ad_data[pos];
+        uint8_t type = ad_data[pos + 1];
+        if ((type == 0x02) || (type == 0x03)) {
+            for (i = 2; i + 1 <= len; i += 2) {
+                if (little_endian_read_16(ad_data, pos + i) == uuid16) {
+                    return true;
+                }
+            }
+        }
+        pos += len + 1;
+    }
+    return false;
+}
+
+const char *bd_addr_to_str(const bd_addr_t addr)
+{
+    static char szAddr[18];
+
+    snprintf(szAddr, sizeof(szAddr), "%02X:%02X:%02X:%02X:%02X:%02X",
+             addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
+    return szAddr;
+}
+
+void btstack_run_loop_set_timer(btstack_timer_source_t *ts, uint32_t timeout_in_ms)
+{
+    ts->timeout = btstack_run_loop_get_time_ms() + timeout_in_ms;
+}
+
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *ts))
+{
+    ts->process = process;
+}
+
+void btstack_run_loop_add_timer(btstack_timer_source_t *ts)
+{
+    btstack_timer_source_t **ppNext = &f_pTimerList;
+    int bAdded = btstack_run_loop_remove_timer(ts);
+
+    // Adding a timer twice is an error in BTstack as well
+    btstack_assert(bAdded == 0);
+    (void)bAdded;
+    while ((*ppNext != NULL) && ((int32_t)((*ppNext)->timeout - ts->timeout) <= 0)) {
+        ppNext = (btstack_timer_source_t **)&(*ppNext)->item.next;
+    }
+    ts->item.next = (btstack_linked_item_t *)*ppNext;
+    *ppNext = ts;
+}
+
+int btstack_run_loop_remove_timer(btstack_timer_source_t *ts)
+{
+    btstack_timer_source_t **ppNext = &f_pTimerList;
+
+    while (*ppNext != NULL) {
+        if (*ppNext == ts) {
+            *ppNext = (btstack_timer_source_t *)ts->item.next;
+            ts->item.next = NULL;
+            return 1;
+        }
+        ppNext = (btstack_timer_source_t **)&(*ppNext)->item.next;
+    }
+    return 0;
+}
+
+uint32_t btstack_run_loop_get_time_ms(void)
+{
+    return (uint32_t)(HOST_GetTimeUs() / 1000);
+}
+
+// Returns immediately: the caller drives the run loop with HOST_BtRunTimers()
+void btstack_run_loop_execute(void) { }
+
+// Any core: the callback runs at the next HOST_BtRunTimers()
+void btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t *callback_registration)
+{
+    int i;
+
+    for (i = 0; i < HOST_MAIN_MAX; i++) {
+        if ((f_apMain[i] == NULL) || (f_apMain[i] == callback_registration)) {
+            f_apMain[i] = callback_registration;
+            return;
+        }
+    }
+}
+
+void btstack_tlv_set_instance(const btstack_tlv_t *tlv_impl, void *tlv_context)
+{
+    f_pTlvImpl = tlv_impl;
+    f_pTlvCtx = tlv_context;
+}
+
+void btstack_tlv_get_instance(const btstack_tlv_t **tlv_impl, void **tlv_context)
+{
+    *tlv_impl = f_pTlvImpl;
+    *tlv_context = f_pTlvCtx;
+}
+
+//--------------------------------------------------------------------+
+// CYW43 HCI transport stub (the controller answers no command)
+//--------------------------------------------------------------------+
+// Events from the transport to hci.c
+static void host_hci_packet_handler(uint8_t packet_type, uint8_t *packet, uint16_t size)
+{
+    if (packet_type != HCI_EVENT_PACKET) {
+        return;
+    }
+    f_stBt.hci_evt_cnt++;
+    if (packet[0] == HCI_EVENT_COMMAND_STATUS) {
+        f_stBt.hci_status_cnt++;
+    }
+    f_stBt.hci_last_evt_len = size;
+    memcpy(f_stBt.hci_last_evt, packet, (size < HOST_HCI_EVT_MAX) ? size : HOST_HCI_EVT_MAX);
+}
+
+static void host_hci_register_packet_handler(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size))
+{
+    f_pfnHciTransportHandler = handler;
+}
+
+static int host_hci_send_packet(uint8_t packet_type, uint8_t *packet, int size)
+{
+    int i;
+
+    if ((packet_type == HCI_COMMAND_DATA_PACKET) && (size >= 3)) {
+        f_stBt.hci_cmd_cnt++;
+        f_stBt.hci_last_opcode = little_endian_read_16(packet, 0);
+        if ((f_stBt.hci_last_opcode == HOST_OPCODE_HOST_NUM_COMPLETED_PACKETS) && (size == 4 + packet[3] * 4)) {
+            for (i = 0; i < packet[3]; i++) {
+                f_stBt.acl_done_cnt += little_endian_read_16(packet, 6 + i * 4);
+            }
+        }
+    }
+    return 0;
+}
+
+const hci_transport_t *__real_hci_transport_cyw43_instance(void)
+{
+    static const hci_transport_t stTransport = {
+        .name = "CYW43 stub",
+        .register_packet_handler = &host_hci_register_packet_handler,
+        .send_packet = &host_hci_send_packet,
+    };
+
+    return &stTransport;
+}
+
+// Stands in for the CYW43 driver init, which installs the flash TLV and
+// hands the HCI transport to hci_init()
+int cyw43_arch_init(void)
+{
+    btstack_tlv_set_instance(&f_stHostTlv, NULL);
+    f_pHciTransport = HOST_HCI_TRANSPORT();
+    f_pHciTransport->register_packet_handler(&host_hci_packet_handler);
+    return 0;
+}
+
+void hci_add_event_handler(btstack_packet_callback_registration_t *callback_handler)
+{
+    host_bt_add_handler(f_apHci, callback_handler);
+}
+
+int hci_power_control(int power_mode)
+{
+    if (power_mode == HCI_POWER_ON) {
+        f_stBt.power_on_cnt++;
+    }
+    return 0;
+}
+
+void l2cap_init(void) { }
+void gatt_client_init(void) { }
+
+void gatt_client_stop_listening_for_characteristic_value_updates(gatt_client_notification_t *notification)
+{
+    gatt_client_notification_t **ppLink;
+
+    for (ppLink = &f_pValueList; *ppLink != NULL; ppLink = (gatt_client_notification_t **)&(*ppLink)->item.next) {
+        if (*ppLink == notification) {
+            *ppLink = (gatt_client_notification_t *)notification->item.next;
+            return;
+        }
+    }
+}
+
+// characteristic NULL: all value handles of the connection
+void gatt_client_listen_for_characteristic_value_updates(gatt_client_notification_t *notification, btstack_packet_handler_t callback,
+                                                        hci_con_handle_t con_handle, gatt_client_characteristic_t *characteristic)
+{
+    gatt_client_stop_listening_for_characteristic_value_updates(notification);
+    notification->callback = callback;
+    notification->con_handle = con_handle;
+    notification->attribute_handle = (characteristic != NULL) ? characteristic->value_handle : 0;
+    notification->item.next = (btstack_linked_item_t *)f_pValueList;
+    f_pValueList = notification;
+}
+// The queries are answered by HOST_BtRunTimers, one at a time like gatt_client.c
+static uint8_t host_bt_gatt_query(btstack_packet_handler_t callback, uint16_t uuid16)
+{
+    if (f_pfnGatt != NULL) {
+        return GATT_CLIENT_BUSY;
+    }
+    f_pfnGatt = callback;
+    f_gattUuid = uuid16;
+    f_stBt.gatt_query_cnt++;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t uuid16)
+{
+    (void)con_handle;
+    return host_bt_gatt_query(callback, uuid16);
+}
+
+uint8_t gatt_client_discover_characteristics_for_service_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle,
+                                                                  gatt_client_service_t *service, uint16_t uuid16)
+{
+    (void)con_handle;
+    (void)service;
+    return host_bt_gatt_query(callback, uuid16);
+}
+
+uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle,
+                                                            uint16_t start_handle, uint16_t end_handle, uint16_t uuid16)
+{
+    (void)con_handle;
+    (void)start_handle;
+    (void)end_handle;
+    return host_bt_gatt_query(callback, uuid16);
+}
+
+void att_server_init(const uint8_t *db, void *read_callback, void *write_callback) { (void)db; (void)read_callback; (void)write_callback; }
+
+void gap_local_bd_addr(bd_addr_t address_buffer)
+{
+    static const bd_addr_t addr = { 0x28, 0xcd, 0xc1, 0x00, 0x00, 0x01 };
+    memcpy(address_buffer, addr, sizeof(bd_addr_t));
+}
+
+void gap_set_scan_parameters(uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window) { (void)scan_type; (void)scan_interval; (void)scan_window; }
+void gap_start_scan(void) { f_stBt.scan_start_cnt++; }
+void gap_stop_scan(void) { }
+
+uint8_t gap_connect(const bd_addr_t addr, bd_addr_type_t addr_type)
+{
+    (void)addr;
+    (void)addr_type;
+    f_stBt.connect_cnt++;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_connect_cancel(void) { return ERROR_CODE_SUCCESS; }
+
+int gap_update_connection_parameters(hci_con_handle_t con_handle, uint16_t conn_interval_min, uint16_t conn_interval_max,
+                                     uint16_t conn_latency, uint16_t supervision_timeout)
+{
+    (void)con_handle;
+    (void)conn_interval_min;
+    (void)supervision_timeout;
+    f_stBt.conn_update_cnt++;
+    f_stBt.conn_interval = conn_interval_max;
+    f_stBt.conn_latency = conn_latency;
+    return ERROR_CODE_SUCCESS;
+}
+uint8_t gap_disconnect(hci_con_handle_t handle) { (void)handle; return ERROR_CODE_SUCCESS; }
+
+// micro-ecc: a key pair is random bytes, valid unless the public key is all zero
+static uECC_RNG_Function f_pfnRng = NULL;
+
+uECC_Curve uECC_secp256r1(void) { return NULL; }
+void uECC_set_rng(uECC_RNG_Function rng_function) { f_pfnRng = rng_function; }
+
+int uECC_make_key(uint8_t *public_key, uint8_t *private_key, uECC_Curve curve)
+{
+    (void)curve;
+    if ((f_pfnRng == NULL) || !f_pfnRng(private_key, 32) || !f_pfnRng(public_key, 64)) {
+        return 0;
+    }
+    public_key[0] |= 1;
+    f_stBt.ecc_gen_cnt++;
+    return 1;
+}
+
+int uECC_valid_public_key(const uint8_t *public_key, uECC_Curve curve)
+{
+    int i;
+
+    (void)curve;
+    for (i = 0; i < 64; i++) {
+        if (public_key[i] != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The secret depends on both keys only, so that the result of a DHKey can be checked
+int uECC_shared_secret(const uint8_t *public_key, const uint8_t *private_key, uint8_t *secret, uECC_Curve curve)
+{
+    int i;
+
+    (void)curve;
+    for (i = 0; i < 32; i++) {
+        secret[i] = public_key[i] ^ public_key[32 + i] ^ private_key[i];
+    }
+    return 1;
+}
+
+void btstack_crypto_ecc_p256_set_key(const uint8_t *public_key, const uint8_t *private_key)
+{
+    (void)private_key;
+    memcpy(f_stBt.ecc_public_key, public_key, sizeof(f_stBt.ecc_public_key));
+    f_stBt.ecc_set_key_cnt++;
+}
+
+int le_device_db_max_count(void)
+{
+    return HOST_BOND_MAX;
+}
+
+void le_device_db_info(int index, int *addr_type, bd_addr_t addr, sm_key_t irk)
+{
+    const ST_HOST_BOND *pstBond = &f_astBond[index];
+
+    if (addr_type != NULL) {
+        *addr_type = pstBond->bValid ? BD_ADDR_TYPE_LE_PUBLIC : BD_ADDR_TYPE_UNKNOWN;
+    }
+    if (addr != NULL) {
+        memcpy(addr, pstBond->addr, sizeof(bd_addr_t));
+    }
+    if (irk != NULL) {
+        memcpy(irk, pstBond->irk, sizeof(sm_key_t));
+    }
+}
+
+void sm_init(void) { }
+void sm_set_io_capabilities(int io_capability) { (void)io_capability; }
+void sm_set_authentication_requirements(uint8_t auth_req) { (void)auth_req; }
+
+void sm_add_event_handler(btstack_packet_callback_registration_t *callback_handler)
+{
+    host_bt_add_handler(f_apSm, callback_handler);
+}
+
+void sm_request_pairing(hci_con_handle_t con_handle) { (void)con_handle; f_stBt.pairing_cnt++; }
+void sm_just_works_confirm(hci_con_handle_t con_handle) { (void)con_handle; }
+void sm_numeric_comparison_confirm(hci_con_handle_t con_handle) { (void)con_handle; }
+
+void hids_client_init(uint8_t *hid_descriptor_storage, uint16_t hid_descriptor_storage_len)
+{
+    (void)hid_descriptor_storage;
+    (void)hid_descriptor_storage_len;
+}
+
+uint8_t hids_client_connect(hci_con_handle_t con_handle, btstack_packet_handler_t packet_handler, hid_protocol_mode_t protocol_mode, uint16_t *hids_cid)
+{
+    (void)protocol_mode;
+    f_pfnHids = packet_handler;
+    *hids_cid = HOST_HIDS_CID;
+    // hids_client listens to its input report characteristics while connecting
+    gatt_client_listen_for_characteristic_value_updates(&f_stHidsListener, &host_bt_hids_notification, con_handle, NULL);
+    f_stBt.hids_connect_cnt++;
+    return ERROR_CODE_SUCCESS;
+}
+
+const uint8_t *hids_client_descriptor_storage_get_descriptor_data(uint16_t hids_cid, uint8_t service_index)
+{
+    (void)service_index;
+    return (hids_cid == HOST_HIDS_CID) ? f_pHidDesc : NULL;
+}
+
+uint16_t hids_client_descriptor_storage_get_descriptor_len(uint16_t hids_cid, uint8_t service_index)
+{
+    (void)service_index;
+    return (hids_cid == HOST_HIDS_CID) ? f_hidDescLen : 0;
+}
+
+void device_information_service_client_init(void) { }
+
+uint8_t device_information_service_client_query(hci_con_handle_t con_handle, btstack_packet_handler_t packet_handler)
+{
+    (void)con_handle;
+    f_pfnDis = packet_handler;
+    f_stBt.dis_query_cnt++;
+    return ERROR_CODE_SUCCESS;
+}
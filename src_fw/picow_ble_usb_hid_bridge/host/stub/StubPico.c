@@ -0,0 +1,135 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stubs of pico_sdk and the TinyUSB board API
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/rand.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include "pico/cyw43_arch.h"
+#include "hardware/irq.h"
+#include "hardware/watchdog.h"
+#include "hardware/structs/systick.h"
+#include "bsp/board_api.h"
+#include "HostStub.h"
+
+// [File Scope Variables]
+static uint64_t f_nowUs = 0;      // Virtual time
+static uint32_t f_coreNum = 0;    // Core the caller pretends to run on
+static bool f_bUartEcho = false;  // Write UART output to stdout
+static ST_HOST_WDG f_stWdg = {0};  // Watchdog calls
+
+watchdog_hw_t g_host_watchdog_hw = {0};
+systick_hw_t g_host_systick_hw = {0};
+
+// Advances the virtual time
+void HOST_AdvanceUs(uint64_t us)
+{
+    f_nowUs += us;
+}
+
+// Returns the virtual time
+uint64_t HOST_GetTimeUs(void)
+{
+    return f_nowUs;
+}
+
+// Selects the core returned by get_core_num()
+void HOST_SetCoreNum(uint32_t core)
+{
+    f_coreNum = core;
+}
+
+// Enables the output of the UART stub
+void HOST_SetUartEcho(bool bEcho)
+{
+    f_bUartEcho = bEcho;
+}
+
+// Returns the watchdog stub state (may be modified by the caller)
+ST_HOST_WDG *HOST_Wdg(void)
+{
+    return &f_stWdg;
+}
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug)
+{
+    (void)delay_ms;
+    (void)pause_on_debug;
+    f_stWdg.bEnabled = true;
+}
+
+void watchdog_update(void) { f_stWdg.update_cnt++; }
+bool watchdog_caused_reboot(void) { return f_stWdg.bCausedReboot; }
+
+void watchdog_reboot(uint32_t pc, uint32_t sp, uint32_t delay_ms)
+{
+    (void)pc;
+    (void)sp;
+    (void)delay_ms;
+    f_stWdg.reboot_cnt++;
+}
+
+uint32_t time_us_32(void) { return (uint32_t)f_nowUs; }
+uint64_t time_us_64(void) { return f_nowUs; }
+void busy_wait_us_32(uint32_t delay_us) { f_nowUs += delay_us; }
+void sleep_ms(uint32_t ms) { f_nowUs += (uint64_t)ms * 1000; }
+uint32_t get_core_num(void) { return f_coreNum; }
+bool stdio_init_all(void) { return true; }
+
+bool uart_is_writable(uart_inst_t *uart)
+{
+    (void)uart;
+    return true;
+}
+
+void uart_putc_raw(uart_inst_t *uart, char c)
+{
+    (void)uart;
+    if (f_bUartEcho && (c != '\r')) {
+        putchar(c);
+    }
+}
+
+void multicore_launch_core1(void (*entry)(void)) { (void)entry; }
+bool flash_safe_execute_core_init(void) { return true; }
+void cyw43_arch_gpio_put(uint32_t wl_gpio, bool value) { (void)wl_gpio; (void)value; }
+void cyw43_arch_poll(void) { }
+
+void gpio_add_raw_irq_handler_with_order_priority(unsigned int gpio, irq_handler_t handler, uint8_t order_priority)
+{
+    (void)gpio;
+    (void)handler;
+    (void)order_priority;
+}
+
+void irq_add_shared_handler(unsigned int num, irq_handler_t handler, uint8_t order_priority)
+{
+    (void)num;
+    (void)handler;
+    (void)order_priority;
+}
+
+uint32_t gpio_get_irq_event_mask(unsigned int gpio) { (void)gpio; return 0; }
+
+uint32_t get_rand_32(void)
+{
+    static uint32_t state = 0x12345678;
+
+    state = state * 1664525u + 1013904223u;
+    return state;
+}
+
+void board_init(void) { }
+uint32_t board_millis(void) { return (uint32_t)(f_nowUs / 1000); }
+void board_delay(uint32_t ms) { sleep_ms(ms); }
+
+size_t board_usb_get_serial(uint16_t desc_str1[], size_t max_chars)
+{
+    static const char szSerial[] = "HOST0000";
+    size_t i;
+
+    for (i = 0; (i < max_chars) && (i < sizeof(szSerial) - 1); i++) {
+        desc_str1[i] = (uint16_t)szSerial[i];
+    }
+    return i;
+}
@@ -0,0 +1,74 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of the TinyUSB device stack
+#include "tusb.h"
+#include "HostStub.h"
+
+// [File Scope Variables]
+static ST_HOST_USB f_stUsb = {
+    .bMounted = true,
+    .bReady = true,
+    .bAutoComplete = true,
+};
+
+// Returns the USB stub state (may be modified by the caller)
+ST_HOST_USB *HOST_Usb(void)
+{
+    return &f_stUsb;
+}
+
+// Completes the transfer in flight on the bridge interface
+void HOST_UsbCompleteTransfer(void)
+{
+    if (!f_stUsb.bReady) {
+        f_stUsb.bReady = true;
+        tud_hid_report_complete_cb(0, f_stUsb.last_report, f_stUsb.last_len);
+    }
+}
+
+bool tud_init(uint8_t rhport) { (void)rhport; return true; }
+void tud_task(void) { }
+bool tud_mounted(void) { return f_stUsb.bMounted && !f_stUsb.bSuspended; }
+bool tud_suspended(void) { return f_stUsb.bSuspended; }
+
+bool tud_remote_wakeup(void)
+{
+    f_stUsb.wakeup_cnt++;
+    return true;
+}
+
+bool tud_connect(void)
+{
+    f_stUsb.connect_cnt++;
+    return true;
+}
+
+bool tud_disconnect(void)
+{
+    return true;
+}
+
+void tud_sof_cb_enable(bool en) { (void)en; }
+
+bool tud_hid_n_ready(uint8_t instance)
+{
+    return (instance == 0) && tud_mounted() && f_stUsb.bReady;
+}
+
+bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const *report, uint16_t len)
+{
+    uint16_t copy_len = (len < HOST_USB_RPT_MAX) ? len : HOST_USB_RPT_MAX;
+
+    if (!tud_hid_n_ready(instance)) {
+        return false;
+    }
+    f_stUsb.report_cnt++;
+    f_stUsb.last_report_id = report_id;
+    f_stUsb.last_len = len;
+    memcpy(f_stUsb.last_report, report, copy_len);
+
+    f_stUsb.bReady = false;
+    if (f_stUsb.bAutoComplete) {
+        HOST_UsbCompleteTransfer();
+    }
+    return true;
+}
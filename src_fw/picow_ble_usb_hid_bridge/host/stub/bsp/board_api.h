@@ -0,0 +1,20 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of the TinyUSB board API
+#ifndef _BSP_BOARD_API_H_
+#define _BSP_BOARD_API_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include "pico/cyw43_arch.h"
+
+void board_init(void);
+void board_init_after_tusb(void) __attribute__((weak));
+uint32_t board_millis(void);
+void board_delay(uint32_t ms);
+size_t board_usb_get_serial(uint16_t desc_str1[], size_t max_chars);
+
+#endif
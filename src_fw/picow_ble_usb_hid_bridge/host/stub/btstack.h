@@ -0,0 +1,319 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of the BTstack API used by the bridge.
+// Event packets use the BTstack field offsets; event codes are stub-local values.
+// Events are injected with the HOST_Bt... functions (see HostStub.h).
+#ifndef BTSTACK_H
+#define BTSTACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+//--------------------------------------------------------------------+
+// Common
+//--------------------------------------------------------------------+
+#define UNUSED(x) (void)(x)
+#define btstack_assert(cond) assert(cond)
+
+typedef uint8_t bd_addr_t[6];
+typedef uint16_t hci_con_handle_t;
+
+typedef enum {
+    BD_ADDR_TYPE_LE_PUBLIC = 0,
+    BD_ADDR_TYPE_LE_RANDOM = 1,
+    BD_ADDR_TYPE_UNKNOWN = 0xfe,
+} bd_addr_type_t;
+
+typedef uint8_t sm_key_t[16];
+
+typedef enum {
+    HID_PROTOCOL_MODE_BOOT = 0,
+    HID_PROTOCOL_MODE_REPORT = 1,
+} hid_protocol_mode_t;
+
+#define HCI_CON_HANDLE_INVALID 0xffff
+
+#define ERROR_CODE_SUCCESS             0x00
+#define ERROR_CODE_CONNECTION_TIMEOUT  0x08
+
+#define ATT_ERROR_SUCCESS              0x00
+#define ATT_ERROR_ATTRIBUTE_NOT_FOUND  0x0a
+
+#define GATT_CLIENT_BUSY               0x94
+
+#define ATT_PROPERTY_READ              0x02
+#define ATT_PROPERTY_NOTIFY            0x10
+
+#define HCI_POWER_OFF 0
+#define HCI_POWER_ON  1
+
+#define HCI_STATE_OFF          0
+#define HCI_STATE_INITIALIZING 1
+#define HCI_STATE_WORKING      2
+
+#define IO_CAPABILITY_DISPLAY_ONLY 0
+#define SM_AUTHREQ_BONDING            0x01
+#define SM_AUTHREQ_SECURE_CONNECTION  0x08
+
+#define ORG_BLUETOOTH_SERVICE_HUMAN_INTERFACE_DEVICE 0x1812
+#define ORG_BLUETOOTH_CHARACTERISTIC_REPORT          0x2A4D
+#define ORG_BLUETOOTH_DESCRIPTOR_REPORT_REFERENCE    0x2908
+
+// Packet types
+#define HCI_COMMAND_DATA_PACKET 0x01
+#define HCI_EVENT_PACKET        0x04
+
+// Events
+#define HCI_EVENT_DISCONNECTION_COMPLETE      0x05
+#define HCI_EVENT_COMMAND_COMPLETE            0x0E
+#define HCI_EVENT_COMMAND_STATUS              0x0F
+#define HCI_EVENT_NUMBER_OF_COMPLETED_PACKETS 0x13
+#define HCI_EVENT_LE_META                     0x3E
+#define BTSTACK_EVENT_STATE                   0x60
+#define HCI_EVENT_TRANSPORT_PACKET_SENT       0x6E
+#define GATT_EVENT_QUERY_COMPLETE             0xA0
+#define GATT_EVENT_SERVICE_QUERY_RESULT       0xA1
+#define GATT_EVENT_CHARACTERISTIC_QUERY_RESULT 0xA2
+#define GATT_EVENT_CHARACTERISTIC_VALUE_QUERY_RESULT 0xA5
+#define GATT_EVENT_NOTIFICATION               0xA7
+#define SM_EVENT_JUST_WORKS_REQUEST           0xC8
+#define SM_EVENT_PASSKEY_DISPLAY_NUMBER       0xCA
+#define SM_EVENT_NUMERIC_COMPARISON_REQUEST   0xCC
+#define SM_EVENT_PAIRING_COMPLETE             0xD4
+#define SM_EVENT_REENCRYPTION_COMPLETE        0xD7
+#define GAP_EVENT_ADVERTISING_REPORT          0xDA
+#define HCI_EVENT_META_GAP                    0xE7
+#define HCI_EVENT_GATTSERVICE_META            0xEA
+#define HCI_EVENT_VENDOR_SPECIFIC             0xFF
+
+// Subevents
+#define HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE    0x03
+#define GAP_SUBEVENT_LE_CONNECTION_COMPLETE           0x01
+#define GATTSERVICE_SUBEVENT_HID_SERVICE_CONNECTED    0x10
+#define GATTSERVICE_SUBEVENT_HID_SERVICE_DISCONNECTED 0x11
+#define GATTSERVICE_SUBEVENT_HID_REPORT               0x12
+#define GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_DONE              0x20
+#define GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_MANUFACTURER_NAME 0x21
+#define GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_MODEL_NUMBER      0x22
+#define GATTSERVICE_SUBEVENT_DEVICE_INFORMATION_PNP_ID            0x23
+
+typedef void (*btstack_packet_handler_t)(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+typedef struct btstack_linked_item {
+    struct btstack_linked_item *next;
+} btstack_linked_item_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    btstack_packet_handler_t callback;
+} btstack_packet_callback_registration_t;
+
+typedef struct btstack_timer_source {
+    btstack_linked_item_t item;
+    uint32_t timeout;
+    void (*process)(struct btstack_timer_source *ts);
+    void *context;
+} btstack_timer_source_t;
+
+typedef struct {
+    btstack_linked_item_t item;
+    void (*callback)(void *context);
+    void *context;
+} btstack_context_callback_registration_t;
+
+typedef struct gatt_client_notification {
+    btstack_linked_item_t item;
+    btstack_packet_handler_t callback;
+    hci_con_handle_t con_handle;
+    uint16_t attribute_handle;
+} gatt_client_notification_t;
+
+typedef struct {
+    uint16_t start_group_handle;
+    uint16_t end_group_handle;
+    uint16_t uuid16;
+    uint8_t uuid128[16];
+} gatt_client_service_t;
+
+typedef struct {
+    uint16_t start_handle;
+    uint16_t value_handle;
+    uint16_t end_handle;
+    uint16_t properties;
+    uint16_t uuid16;
+    uint8_t uuid128[16];
+} gatt_client_characteristic_t;
+
+typedef struct {
+    const char *name;
+    void (*init)(const void *transport_config);
+    int  (*open)(void);
+    int  (*close)(void);
+    void (*register_packet_handler)(void (*handler)(uint8_t packet_type, uint8_t *packet, uint16_t size));
+    int  (*can_send_packet_now)(uint8_t packet_type);
+    int  (*send_packet)(uint8_t packet_type, uint8_t *packet, int size);
+    int  (*set_baudrate)(uint32_t baudrate);
+    void (*reset_link)(void);
+    void (*set_sco_config)(uint16_t voice_setting, int num_connections);
+} hci_transport_t;
+
+typedef struct {
+    int  (*get_tag)(void *context, uint32_t tag, uint8_t *buffer, uint32_t buffer_size);
+    int  (*store_tag)(void *context, uint32_t tag, const uint8_t *data, uint32_t data_size);
+    void (*delete_tag)(void *context, uint32_t tag);
+} btstack_tlv_t;
+
+static inline void little_endian_store_16(uint8_t *buffer, uint16_t pos, uint16_t value)
+{
+    buffer[pos] = (uint8_t)value;
+    buffer[pos + 1] = (uint8_t)(value >> 8);
+}
+
+static inline uint16_t little_endian_read_16(const uint8_t *buffer, int pos)
+{
+    return (uint16_t)(buffer[pos] | (buffer[pos + 1] << 8));
+}
+
+static inline uint32_t little_endian_read_32(const uint8_t *buffer, int pos)
+{
+    return (uint32_t)buffer[pos] | ((uint32_t)buffer[pos + 1] << 8) |
+           ((uint32_t)buffer[pos + 2] << 16) | ((uint32_t)buffer[pos + 3] << 24);
+}
+
+//--------------------------------------------------------------------+
+// Event getters
+//--------------------------------------------------------------------+
+static inline uint8_t hci_event_packet_get_type(const uint8_t *event) { return event[0]; }
+static inline uint16_t gatt_event_notification_get_handle(const uint8_t *event) { return little_endian_read_16(event, 2); }
+static inline uint16_t gatt_event_notification_get_value_handle(const uint8_t *event) { return little_endian_read_16(event, 4); }
+static inline uint16_t gatt_event_notification_get_value_length(const uint8_t *event) { return little_endian_read_16(event, 6); }
+static inline const uint8_t *gatt_event_notification_get_value(const uint8_t *event) { return &event[8]; }
+static inline uint8_t gatt_event_query_complete_get_att_status(const uint8_t *event) { return event[4]; }
+static inline void gatt_event_service_query_result_get_service(const uint8_t *event, gatt_client_service_t *service)
+{
+    memset(service, 0, sizeof(*service));
+    service->start_group_handle = little_endian_read_16(event, 4);
+    service->end_group_handle = little_endian_read_16(event, 6);
+    service->uuid16 = little_endian_read_16(event, 8);
+}
+static inline void gatt_event_characteristic_query_result_get_characteristic(const uint8_t *event, gatt_client_characteristic_t *characteristic)
+{
+    memset(characteristic, 0, sizeof(*characteristic));
+    characteristic->start_handle = little_endian_read_16(event, 4);
+    characteristic->value_handle = little_endian_read_16(event, 6);
+    characteristic->end_handle = little_endian_read_16(event, 8);
+    characteristic->properties = little_endian_read_16(event, 10);
+    characteristic->uuid16 = little_endian_read_16(event, 12);
+}
+static inline uint16_t gatt_event_characteristic_value_query_result_get_value_handle(const uint8_t *event) { return little_endian_read_16(event, 4); }
+static inline uint16_t gatt_event_characteristic_value_query_result_get_value_length(const uint8_t *event) { return little_endian_read_16(event, 6); }
+static inline const uint8_t *gatt_event_characteristic_value_query_result_get_value(const uint8_t *event) { return &event[8]; }
+static inline uint8_t btstack_event_state_get_state(const uint8_t *event) { return event[2]; }
+static inline uint8_t hci_event_gap_meta_get_subevent_code(const uint8_t *event) { return event[2]; }
+static inline uint8_t hci_event_le_meta_get_subevent_code(const uint8_t *event) { return event[2]; }
+static inline uint8_t hci_event_gattservice_meta_get_subevent_code(const uint8_t *event) { return event[2]; }
+
+static inline uint8_t gap_event_advertising_report_get_address_type(const uint8_t *event) { return event[3]; }
+static inline void gap_event_advertising_report_get_address(const uint8_t *event, bd_addr_t address) { memcpy(address, &event[4], 6); }
+static inline uint8_t gap_event_advertising_report_get_data_length(const uint8_t *event) { return event[11]; }
+static inline const uint8_t *gap_event_advertising_report_get_data(const uint8_t *event) { return &event[12]; }
+
+static inline hci_con_handle_t gap_subevent_le_connection_complete_get_connection_handle(const uint8_t *event) { return little_endian_read_16(event, 4); }
+static inline uint16_t gap_subevent_le_connection_complete_get_conn_interval(const uint8_t *event) { return little_endian_read_16(event, 26); }
+static inline uint16_t gap_subevent_le_connection_complete_get_conn_latency(const uint8_t *event) { return little_endian_read_16(event, 28); }
+static inline uint16_t gap_subevent_le_connection_complete_get_supervision_timeout(const uint8_t *event) { return little_endian_read_16(event, 30); }
+
+static inline uint8_t hci_subevent_le_connection_update_complete_get_status(const uint8_t *event) { return event[3]; }
+static inline uint16_t hci_subevent_le_connection_update_complete_get_conn_interval(const uint8_t *event) { return little_endian_read_16(event, 6); }
+static inline uint16_t hci_subevent_le_connection_update_complete_get_conn_latency(const uint8_t *event) { return little_endian_read_16(event, 8); }
+static inline uint16_t hci_subevent_le_connection_update_complete_get_supervision_timeout(const uint8_t *event) { return little_endian_read_16(event, 10); }
+
+static inline hci_con_handle_t sm_event_just_works_request_get_handle(const uint8_t *event) { return little_endian_read_16(event, 2); }
+static inline hci_con_handle_t sm_event_passkey_display_number_get_handle(const uint8_t *event) { return little_endian_read_16(event, 2); }
+static inline uint32_t sm_event_passkey_display_number_get_passkey(const uint8_t *event) { return little_endian_read_32(event, 11); }
+static inline uint32_t sm_event_numeric_comparison_request_get_passkey(const uint8_t *event) { return little_endian_read_32(event, 11); }
+static inline uint8_t sm_event_pairing_complete_get_status(const uint8_t *event) { return event[11]; }
+
+static inline uint8_t gattservice_subevent_hid_service_connected_get_status(const uint8_t *event) { return event[5]; }
+static inline uint8_t gattservice_subevent_hid_service_connected_get_num_instances(const uint8_t *event) { return event[7]; }
+static inline uint8_t gattservice_subevent_hid_report_get_service_index(const uint8_t *event) { return event[5]; }
+static inline uint8_t gattservice_subevent_hid_report_get_report_id(const uint8_t *event) { return event[6]; }
+static inline uint16_t gattservice_subevent_hid_report_get_report_len(const uint8_t *event) { return little_endian_read_16(event, 7); }
+static inline const uint8_t *gattservice_subevent_hid_report_get_report(const uint8_t *event) { return &event[9]; }
+
+static inline uint8_t gattservice_subevent_device_information_done_get_att_status(const uint8_t *event) { return event[5]; }
+static inline uint8_t gattservice_subevent_device_information_manufacturer_name_get_att_status(const uint8_t *event) { return event[5]; }
+static inline const char *gattservice_subevent_device_information_manufacturer_name_get_value(const uint8_t *event) { return (const char *)&event[6]; }
+static inline uint8_t gattservice_subevent_device_information_model_number_get_att_status(const uint8_t *event) { return event[5]; }
+static inline const char *gattservice_subevent_device_information_model_number_get_value(const uint8_t *event) { return (const char *)&event[6]; }
+static inline uint8_t gattservice_subevent_device_information_pnp_id_get_att_status(const uint8_t *event) { return event[5]; }
+static inline uint8_t gattservice_subevent_device_information_pnp_id_get_vendor_source_id(const uint8_t *event) { return event[6]; }
+static inline uint16_t gattservice_subevent_device_information_pnp_id_get_vendor_id(const uint8_t *event) { return little_endian_read_16(event, 7); }
+static inline uint16_t gattservice_subevent_device_information_pnp_id_get_product_id(const uint8_t *event) { return little_endian_read_16(event, 9); }
+static inline uint16_t gattservice_subevent_device_information_pnp_id_get_product_version(const uint8_t *event) { return little_endian_read_16(event, 11); }
+
+//--------------------------------------------------------------------+
+// API
+//--------------------------------------------------------------------+
+bool ad_data_contains_uuid16(uint8_t ad_len, const uint8_t *ad_data, uint16_t uuid16);
+const char *bd_addr_to_str(const bd_addr_t addr);
+
+void btstack_run_loop_set_timer(btstack_timer_source_t *ts, uint32_t timeout_in_ms);
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t *ts, void (*process)(btstack_timer_source_t *ts));
+void btstack_run_loop_add_timer(btstack_timer_source_t *ts);
+int  btstack_run_loop_remove_timer(btstack_timer_source_t *ts);
+uint32_t btstack_run_loop_get_time_ms(void);
+void btstack_run_loop_execute(void);
+void btstack_run_loop_execute_on_main_thread(btstack_context_callback_registration_t *callback_registration);
+
+void btstack_tlv_set_instance(const btstack_tlv_t *tlv_impl, void *tlv_context);
+void btstack_tlv_get_instance(const btstack_tlv_t **tlv_impl, void **tlv_context);
+
+void hci_add_event_handler(btstack_packet_callback_registration_t *callback_handler);
+int  hci_power_control(int power_mode);
+void l2cap_init(void);
+void gatt_client_init(void);
+void gatt_client_listen_for_characteristic_value_updates(gatt_client_notification_t *notification, btstack_packet_handler_t callback,
+                                                        hci_con_handle_t con_handle, gatt_client_characteristic_t *characteristic);
+void gatt_client_stop_listening_for_characteristic_value_updates(gatt_client_notification_t *notification);
+uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t uuid16);
+uint8_t gatt_client_discover_characteristics_for_service_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle,
+                                                                  gatt_client_service_t *service, uint16_t uuid16);
+uint8_t gatt_client_read_value_of_characteristics_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle,
+                                                            uint16_t start_handle, uint16_t end_handle, uint16_t uuid16);
+void att_server_init(const uint8_t *db, void *read_callback, void *write_callback);
+
+void gap_local_bd_addr(bd_addr_t address_buffer);
+void gap_set_scan_parameters(uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window);
+void gap_start_scan(void);
+void gap_stop_scan(void);
+uint8_t gap_connect(const bd_addr_t addr, bd_addr_type_t addr_type);
+uint8_t gap_connect_cancel(void);
+uint8_t gap_disconnect(hci_con_handle_t handle);
+int gap_update_connection_parameters(hci_con_handle_t con_handle, uint16_t conn_interval_min, uint16_t conn_interval_max,
+                                     uint16_t conn_latency, uint16_t supervision_timeout);
+
+void btstack_crypto_ecc_p256_set_key(const uint8_t *public_key, const uint8_t *private_key);
+
+int  le_device_db_max_count(void);
+void le_device_db_info(int index, int *addr_type, bd_addr_t addr, sm_key_t irk);
+
+void sm_init(void);
+void sm_set_io_capabilities(int io_capability);
+void sm_set_authentication_requirements(uint8_t auth_req);
+void sm_add_event_handler(btstack_packet_callback_registration_t *callback_handler);
+void sm_request_pairing(hci_con_handle_t con_handle);
+void sm_just_works_confirm(hci_con_handle_t con_handle);
+void sm_numeric_comparison_confirm(hci_con_handle_t con_handle);
+
+void hids_client_init(uint8_t *hid_descriptor_storage, uint16_t hid_descriptor_storage_len);
+uint8_t hids_client_connect(hci_con_handle_t con_handle, btstack_packet_handler_t packet_handler, hid_protocol_mode_t protocol_mode, uint16_t *hids_cid);
+const uint8_t *hids_client_descriptor_storage_get_descriptor_data(uint16_t hids_cid, uint8_t service_index);
+uint16_t hids_client_descriptor_storage_get_descriptor_len(uint16_t hids_cid, uint8_t service_index);
+
+void device_information_service_client_init(void);
+uint8_t device_information_service_client_query(hci_con_handle_t con_handle, btstack_packet_handler_t packet_handler);
+
+#endif
@@ -0,0 +1,3 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub: everything is declared in btstack.h
+#include "btstack.h"
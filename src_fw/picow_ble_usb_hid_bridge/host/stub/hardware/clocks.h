@@ -0,0 +1,19 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of hardware/clocks.h
+#ifndef _HARDWARE_CLOCKS_H
+#define _HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+// Default system clock of the RP2040
+static inline uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    (void)clk_index;
+    return 125000000;
+}
+
+#endif
@@ -0,0 +1,19 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of hardware/gpio.h (GPIO interrupts only; they never fire in the host build)
+#ifndef _HARDWARE_GPIO_H
+#define _HARDWARE_GPIO_H
+
+#include <stdint.h>
+#include "hardware/irq.h"
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+void gpio_add_raw_irq_handler_with_order_priority(unsigned int gpio, irq_handler_t handler, uint8_t order_priority);
+uint32_t gpio_get_irq_event_mask(unsigned int gpio);
+
+#endif
@@ -0,0 +1,18 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of hardware/irq.h (interrupts never fire in the host build)
+#ifndef _HARDWARE_IRQ_H
+#define _HARDWARE_IRQ_H
+
+#include <stdint.h>
+
+typedef void (*irq_handler_t)(void);
+
+#define USBCTRL_IRQ 5
+#define IO_IRQ_BANK0 13
+
+#define PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY 0xff
+#define PICO_SHARED_IRQ_HANDLER_LOWEST_ORDER_PRIORITY 0x00
+
+void irq_add_shared_handler(unsigned int num, irq_handler_t handler, uint8_t order_priority);
+
+#endif
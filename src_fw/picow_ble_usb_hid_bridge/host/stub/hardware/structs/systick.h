@@ -0,0 +1,21 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of hardware/structs/systick.h (the counter does not run in the host build)
+#ifndef _HARDWARE_STRUCTS_SYSTICK_H
+#define _HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+#define M0PLUS_SYST_CSR_ENABLE_BITS    0x00000001u
+#define M0PLUS_SYST_CSR_CLKSOURCE_BITS 0x00000004u
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t g_host_systick_hw;
+#define systick_hw (&g_host_systick_hw)
+
+#endif
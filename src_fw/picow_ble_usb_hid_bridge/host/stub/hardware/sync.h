@@ -0,0 +1,14 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of hardware/sync.h
+#ifndef _HARDWARE_SYNC_H
+#define _HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+
+#define __dmb() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
+
+#endif
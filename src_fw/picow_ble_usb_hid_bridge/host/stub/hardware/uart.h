@@ -0,0 +1,16 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of hardware/uart.h: the default UART writes to stdout (see HOST_SetUartEcho)
+#ifndef _HARDWARE_UART_H
+#define _HARDWARE_UART_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct uart_inst uart_inst_t;
+
+#define uart_default ((uart_inst_t *)0)
+
+bool uart_is_writable(uart_inst_t *uart);
+void uart_putc_raw(uart_inst_t *uart, char c);
+
+#endif
@@ -0,0 +1,21 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of hardware/watchdog.h (the watchdog never fires in the host build, see HOST_Wdg)
+#ifndef _HARDWARE_WATCHDOG_H
+#define _HARDWARE_WATCHDOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    volatile uint32_t scratch[8];
+} watchdog_hw_t;
+
+extern watchdog_hw_t g_host_watchdog_hw;
+#define watchdog_hw (&g_host_watchdog_hw)
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+void watchdog_update(void);
+bool watchdog_caused_reboot(void);
+void watchdog_reboot(uint32_t pc, uint32_t sp, uint32_t delay_ms);
+
+#endif
@@ -0,0 +1,15 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stand-in for the GATT database generated from hog_host_demo.gatt
+#ifndef HOG_HOST_DEMO_H
+#define HOG_HOST_DEMO_H
+
+#include <stdint.h>
+
+const uint8_t profile_data[] = {
+    // ATT DB Version
+    1,
+    // END
+    0x00, 0x00,
+};
+
+#endif
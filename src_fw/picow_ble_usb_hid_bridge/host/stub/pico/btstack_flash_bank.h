@@ -0,0 +1,10 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of pico/btstack_flash_bank.h
+#ifndef _PICO_BTSTACK_FLASH_BANK_H
+#define _PICO_BTSTACK_FLASH_BANK_H
+
+#define PICO_FLASH_SIZE_BYTES          (2 * 1024 * 1024)
+#define PICO_FLASH_BANK_TOTAL_SIZE     (2 * 4096)
+#define PICO_FLASH_BANK_STORAGE_OFFSET (PICO_FLASH_SIZE_BYTES - PICO_FLASH_BANK_TOTAL_SIZE)
+
+#endif
@@ -0,0 +1,15 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of pico/cyw43_arch.h
+#ifndef _PICO_CYW43_ARCH_H
+#define _PICO_CYW43_ARCH_H
+
+#include "pico/stdlib.h"
+
+#define CYW43_WL_GPIO_LED_PIN 0
+#define CYW43_PIN_WL_HOST_WAKE 24
+
+int cyw43_arch_init(void);
+void cyw43_arch_gpio_put(uint32_t wl_gpio, bool value);
+void cyw43_arch_poll(void);
+
+#endif
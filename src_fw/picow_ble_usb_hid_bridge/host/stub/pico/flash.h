@@ -0,0 +1,10 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of pico/flash.h
+#ifndef _PICO_FLASH_H
+#define _PICO_FLASH_H
+
+#include "pico/stdlib.h"
+
+bool flash_safe_execute_core_init(void);
+
+#endif
@@ -0,0 +1,11 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of pico/multicore.h: core1 is not started, the bench drives it
+#ifndef _PICO_MULTICORE_H
+#define _PICO_MULTICORE_H
+
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+
+void multicore_launch_core1(void (*entry)(void));
+
+#endif
@@ -0,0 +1,10 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of pico/rand.h (deterministic)
+#ifndef _PICO_RAND_H
+#define _PICO_RAND_H
+
+#include <stdint.h>
+
+uint32_t get_rand_32(void);
+
+#endif
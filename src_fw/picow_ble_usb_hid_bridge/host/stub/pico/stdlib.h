@@ -0,0 +1,34 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of pico/stdlib.h (see host/stub/HostStub.h)
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "hardware/uart.h"
+#include "hardware/gpio.h"
+
+typedef uint64_t absolute_time_t;
+
+// Flash is not mapped in the host build; XIP addresses are only formed, never read
+#define XIP_BASE 0x10000000u
+
+#define __not_in_flash(group)
+#define __not_in_flash_func(func) func
+#define __time_critical_func(func) func
+#define __uninitialized_ram(group) group
+#define __scratch_x(group)
+#define __scratch_y(group)
+
+static inline void tight_loop_contents(void) { }
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+void busy_wait_us_32(uint32_t delay_us);
+void sleep_ms(uint32_t ms);
+uint32_t get_core_num(void);
+bool stdio_init_all(void);
+
+#endif
@@ -0,0 +1,17 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of pico/sync.h.
+// The stubs are single-threaded, so critical sections only count their use.
+#ifndef _PICO_SYNC_H
+#define _PICO_SYNC_H
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    uint32_t enter_cnt;
+} critical_section_t;
+
+static inline void critical_section_init(critical_section_t *crit_sec) { crit_sec->enter_cnt = 0; }
+static inline void critical_section_enter_blocking(critical_section_t *crit_sec) { crit_sec->enter_cnt++; }
+static inline void critical_section_exit(critical_section_t *crit_sec) { (void)crit_sec; }
+
+#endif
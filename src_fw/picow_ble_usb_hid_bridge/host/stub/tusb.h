@@ -0,0 +1,299 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of the TinyUSB device API used by the bridge.
+// Descriptor types and HID item macros follow TinyUSB; the built-in report
+// descriptor templates are shortened versions of the TinyUSB ones.
+#ifndef _TUSB_H_
+#define _TUSB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define OPT_MCU_RP2040          1900
+#define OPT_OS_NONE             1
+#define OPT_MODE_DEFAULT_SPEED  0
+
+#ifndef CFG_TUSB_MCU
+#define CFG_TUSB_MCU OPT_MCU_RP2040
+#endif
+
+#include "tusb_config.h"
+
+//--------------------------------------------------------------------+
+// Common
+//--------------------------------------------------------------------+
+#define TU_ATTR_PACKED __attribute__((packed))
+#define TU_ASSERT(cond, ret) do { if (!(cond)) { return ret; } } while (0)
+
+#define U16_TO_U8S_LE(u16) ((uint8_t)((u16) & 0xff)), ((uint8_t)(((u16) >> 8) & 0xff))
+#define U32_TO_U8S_LE(u32) ((uint8_t)((u32) & 0xff)), ((uint8_t)(((u32) >> 8) & 0xff)), \
+                           ((uint8_t)(((u32) >> 16) & 0xff)), ((uint8_t)(((u32) >> 24) & 0xff))
+
+static inline uint16_t tu_htole16(uint16_t v) { return v; }
+static inline void tu_unaligned_write16(void *mem, uint16_t value) { memcpy(mem, &value, sizeof(value)); }
+
+//--------------------------------------------------------------------+
+// Descriptors
+//--------------------------------------------------------------------+
+enum {
+    TUSB_DESC_DEVICE = 0x01,
+    TUSB_DESC_CONFIGURATION = 0x02,
+    TUSB_DESC_STRING = 0x03,
+    TUSB_DESC_INTERFACE = 0x04,
+    TUSB_DESC_ENDPOINT = 0x05,
+};
+
+enum { TUSB_CLASS_HID = 3 };
+enum { TUSB_XFER_INTERRUPT = 3 };
+enum { TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP = 0x20 };
+
+#define TUD_CONFIG_DESC_LEN (9)
+#define TUD_HID_DESC_LEN    (9 + 9 + 7)
+
+typedef struct TU_ATTR_PACKED {
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+    uint16_t bcdUSB;
+    uint8_t  bDeviceClass;
+    uint8_t  bDeviceSubClass;
+    uint8_t  bDeviceProtocol;
+    uint8_t  bMaxPacketSize0;
+    uint16_t idVendor;
+    uint16_t idProduct;
+    uint16_t bcdDevice;
+    uint8_t  iManufacturer;
+    uint8_t  iProduct;
+    uint8_t  iSerialNumber;
+    uint8_t  bNumConfigurations;
+} tusb_desc_device_t;
+
+typedef struct TU_ATTR_PACKED {
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+    uint16_t wTotalLength;
+    uint8_t  bNumInterfaces;
+    uint8_t  bConfigurationValue;
+    uint8_t  iConfiguration;
+    uint8_t  bmAttributes;
+    uint8_t  bMaxPower;
+} tusb_desc_configuration_t;
+
+typedef struct TU_ATTR_PACKED {
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+    uint8_t  bInterfaceNumber;
+    uint8_t  bAlternateSetting;
+    uint8_t  bNumEndpoints;
+    uint8_t  bInterfaceClass;
+    uint8_t  bInterfaceSubClass;
+    uint8_t  bInterfaceProtocol;
+    uint8_t  iInterface;
+} tusb_desc_interface_t;
+
+typedef struct TU_ATTR_PACKED {
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+    uint8_t  bEndpointAddress;
+    struct TU_ATTR_PACKED {
+        uint8_t xfer  : 2;
+        uint8_t sync  : 2;
+        uint8_t usage : 2;
+        uint8_t       : 2;
+    } bmAttributes;
+    uint16_t wMaxPacketSize;
+    uint8_t  bInterval;
+} tusb_desc_endpoint_t;
+
+//--------------------------------------------------------------------+
+// HID
+//--------------------------------------------------------------------+
+enum { HID_SUBCLASS_NONE = 0 };
+enum { HID_ITF_PROTOCOL_NONE = 0 };
+enum { HID_DESC_TYPE_HID = 0x21, HID_DESC_TYPE_REPORT = 0x22 };
+
+typedef enum {
+    HID_REPORT_TYPE_INVALID = 0,
+    HID_REPORT_TYPE_INPUT,
+    HID_REPORT_TYPE_OUTPUT,
+    HID_REPORT_TYPE_FEATURE
+} hid_report_type_t;
+
+// Report descriptor items
+#define HID_REPORT_DATA_0(data)
+#define HID_REPORT_DATA_1(data) , (data)
+#define HID_REPORT_DATA_2(data) , U16_TO_U8S_LE(data)
+#define HID_REPORT_DATA_3(data) , U32_TO_U8S_LE(data)
+#define HID_REPORT_ITEM(data, tag, type, size) \
+    (((tag) << 4) | ((type) << 2) | (size)) HID_REPORT_DATA_##size(data)
+
+#define RI_TYPE_MAIN   0
+#define RI_TYPE_GLOBAL 1
+#define RI_TYPE_LOCAL  2
+
+#define HID_DATA     (0 << 0)
+#define HID_CONSTANT (1 << 0)
+#define HID_ARRAY    (0 << 1)
+#define HID_VARIABLE (1 << 1)
+#define HID_ABSOLUTE (0 << 2)
+#define HID_RELATIVE (1 << 2)
+
+#define HID_INPUT(x)             HID_REPORT_ITEM(x, 8, RI_TYPE_MAIN, 1)
+#define HID_OUTPUT(x)            HID_REPORT_ITEM(x, 9, RI_TYPE_MAIN, 1)
+#define HID_COLLECTION(x)        HID_REPORT_ITEM(x, 10, RI_TYPE_MAIN, 1)
+#define HID_FEATURE(x)           HID_REPORT_ITEM(x, 11, RI_TYPE_MAIN, 1)
+#define HID_COLLECTION_END       HID_REPORT_ITEM(x, 12, RI_TYPE_MAIN, 0)
+
+#define HID_USAGE_PAGE(x)        HID_REPORT_ITEM(x, 0, RI_TYPE_GLOBAL, 1)
+#define HID_USAGE_PAGE_N(x, n)   HID_REPORT_ITEM(x, 0, RI_TYPE_GLOBAL, n)
+#define HID_LOGICAL_MIN(x)       HID_REPORT_ITEM(x, 1, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MIN_N(x, n)  HID_REPORT_ITEM(x, 1, RI_TYPE_GLOBAL, n)
+#define HID_LOGICAL_MAX(x)       HID_REPORT_ITEM(x, 2, RI_TYPE_GLOBAL, 1)
+#define HID_LOGICAL_MAX_N(x, n)  HID_REPORT_ITEM(x, 2, RI_TYPE_GLOBAL, n)
+#define HID_REPORT_SIZE(x)       HID_REPORT_ITEM(x, 7, RI_TYPE_GLOBAL, 1)
+#define HID_REPORT_ID(x)         HID_REPORT_ITEM(x, 8, RI_TYPE_GLOBAL, 1),
+#define HID_REPORT_COUNT(x)      HID_REPORT_ITEM(x, 9, RI_TYPE_GLOBAL, 1)
+
+#define HID_USAGE(x)             HID_REPORT_ITEM(x, 0, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_N(x, n)        HID_REPORT_ITEM(x, 0, RI_TYPE_LOCAL, n)
+#define HID_USAGE_MIN(x)         HID_REPORT_ITEM(x, 1, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_MIN_N(x, n)    HID_REPORT_ITEM(x, 1, RI_TYPE_LOCAL, n)
+#define HID_USAGE_MAX(x)         HID_REPORT_ITEM(x, 2, RI_TYPE_LOCAL, 1)
+#define HID_USAGE_MAX_N(x, n)    HID_REPORT_ITEM(x, 2, RI_TYPE_LOCAL, n)
+
+#define HID_COLLECTION_PHYSICAL    0
+#define HID_COLLECTION_APPLICATION 1
+
+#define HID_USAGE_PAGE_DESKTOP   0x01
+#define HID_USAGE_PAGE_KEYBOARD  0x07
+#define HID_USAGE_PAGE_LED       0x08
+#define HID_USAGE_PAGE_BUTTON    0x09
+#define HID_USAGE_PAGE_CONSUMER  0x0c
+#define HID_USAGE_PAGE_VENDOR    0xFF00
+
+#define HID_USAGE_DESKTOP_POINTER  0x01
+#define HID_USAGE_DESKTOP_MOUSE    0x02
+#define HID_USAGE_DESKTOP_GAMEPAD  0x05
+#define HID_USAGE_DESKTOP_KEYBOARD 0x06
+#define HID_USAGE_DESKTOP_X        0x30
+#define HID_USAGE_DESKTOP_Y        0x31
+#define HID_USAGE_DESKTOP_WHEEL    0x38
+#define HID_USAGE_CONSUMER_CONTROL 0x01
+
+#define TUD_HID_REPORT_DESC_KEYBOARD(...) \
+    HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP ), \
+    HID_USAGE      ( HID_USAGE_DESKTOP_KEYBOARD ), \
+    HID_COLLECTION ( HID_COLLECTION_APPLICATION ), \
+        __VA_ARGS__ \
+        HID_USAGE_PAGE ( HID_USAGE_PAGE_KEYBOARD ), \
+        HID_USAGE_MIN  ( 224 ), \
+        HID_USAGE_MAX  ( 231 ), \
+        HID_LOGICAL_MIN( 0 ), \
+        HID_LOGICAL_MAX( 1 ), \
+        HID_REPORT_COUNT( 8 ), \
+        HID_REPORT_SIZE( 1 ), \
+        HID_INPUT      ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ), \
+        HID_REPORT_COUNT( 1 ), \
+        HID_REPORT_SIZE( 8 ), \
+        HID_INPUT      ( HID_CONSTANT ), \
+        HID_USAGE_PAGE ( HID_USAGE_PAGE_KEYBOARD ), \
+        HID_USAGE_MIN  ( 0 ), \
+        HID_USAGE_MAX_N( 255, 2 ), \
+        HID_LOGICAL_MIN( 0 ), \
+        HID_LOGICAL_MAX_N( 255, 2 ), \
+        HID_REPORT_COUNT( 6 ), \
+        HID_REPORT_SIZE( 8 ), \
+        HID_INPUT      ( HID_DATA | HID_ARRAY | HID_ABSOLUTE ), \
+    HID_COLLECTION_END
+
+#define TUD_HID_REPORT_DESC_MOUSE(...) \
+    HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP ), \
+    HID_USAGE      ( HID_USAGE_DESKTOP_MOUSE ), \
+    HID_COLLECTION ( HID_COLLECTION_APPLICATION ), \
+        __VA_ARGS__ \
+        HID_USAGE      ( HID_USAGE_DESKTOP_POINTER ), \
+        HID_COLLECTION ( HID_COLLECTION_PHYSICAL ), \
+            HID_USAGE_PAGE ( HID_USAGE_PAGE_BUTTON ), \
+            HID_USAGE_MIN  ( 1 ), \
+            HID_USAGE_MAX  ( 5 ), \
+            HID_LOGICAL_MIN( 0 ), \
+            HID_LOGICAL_MAX( 1 ), \
+            HID_REPORT_COUNT( 5 ), \
+            HID_REPORT_SIZE( 1 ), \
+            HID_INPUT      ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ), \
+            HID_REPORT_COUNT( 1 ), \
+            HID_REPORT_SIZE( 3 ), \
+            HID_INPUT      ( HID_CONSTANT ), \
+            HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP ), \
+            HID_USAGE      ( HID_USAGE_DESKTOP_X ), \
+            HID_USAGE      ( HID_USAGE_DESKTOP_Y ), \
+            HID_USAGE      ( HID_USAGE_DESKTOP_WHEEL ), \
+            HID_LOGICAL_MIN( 0x81 ), \
+            HID_LOGICAL_MAX( 0x7f ), \
+            HID_REPORT_COUNT( 3 ), \
+            HID_REPORT_SIZE( 8 ), \
+            HID_INPUT      ( HID_DATA | HID_VARIABLE | HID_RELATIVE ), \
+        HID_COLLECTION_END, \
+    HID_COLLECTION_END
+
+#define TUD_HID_REPORT_DESC_CONSUMER(...) \
+    HID_USAGE_PAGE ( HID_USAGE_PAGE_CONSUMER ), \
+    HID_USAGE      ( HID_USAGE_CONSUMER_CONTROL ), \
+    HID_COLLECTION ( HID_COLLECTION_APPLICATION ), \
+        __VA_ARGS__ \
+        HID_LOGICAL_MIN( 0x00 ), \
+        HID_LOGICAL_MAX_N( 0x03FF, 2 ), \
+        HID_USAGE_MIN  ( 0x00 ), \
+        HID_USAGE_MAX_N( 0x03FF, 2 ), \
+        HID_REPORT_COUNT( 1 ), \
+        HID_REPORT_SIZE( 16 ), \
+        HID_INPUT      ( HID_DATA | HID_ARRAY | HID_ABSOLUTE ), \
+    HID_COLLECTION_END
+
+#define TUD_HID_REPORT_DESC_GAMEPAD(...) \
+    HID_USAGE_PAGE ( HID_USAGE_PAGE_DESKTOP ), \
+    HID_USAGE      ( HID_USAGE_DESKTOP_GAMEPAD ), \
+    HID_COLLECTION ( HID_COLLECTION_APPLICATION ), \
+        __VA_ARGS__ \
+        HID_USAGE_PAGE ( HID_USAGE_PAGE_BUTTON ), \
+        HID_USAGE_MIN  ( 1 ), \
+        HID_USAGE_MAX  ( 32 ), \
+        HID_LOGICAL_MIN( 0 ), \
+        HID_LOGICAL_MAX( 1 ), \
+        HID_REPORT_COUNT( 32 ), \
+        HID_REPORT_SIZE( 1 ), \
+        HID_INPUT      ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ), \
+    HID_COLLECTION_END
+
+//--------------------------------------------------------------------+
+// Device API
+//--------------------------------------------------------------------+
+bool tud_init(uint8_t rhport);
+void tud_task(void);
+bool tud_mounted(void);
+bool tud_suspended(void);
+bool tud_remote_wakeup(void);
+bool tud_connect(void);
+bool tud_disconnect(void);
+void tud_sof_cb_enable(bool en);
+
+bool tud_hid_n_ready(uint8_t instance);
+bool tud_hid_n_report(uint8_t instance, uint8_t report_id, void const *report, uint16_t len);
+static inline bool tud_hid_ready(void) { return tud_hid_n_ready(0); }
+static inline bool tud_hid_report(uint8_t report_id, void const *report, uint16_t len) { return tud_hid_n_report(0, report_id, report, len); }
+
+// Application callbacks
+uint8_t const *tud_descriptor_device_cb(void);
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index);
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid);
+uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance);
+void tud_mount_cb(void);
+void tud_umount_cb(void);
+void tud_suspend_cb(bool remote_wakeup_en);
+void tud_resume_cb(void);
+void tud_sof_cb(uint32_t frame_count);
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const *report, uint16_t len);
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer, uint16_t reqlen);
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const *buffer, uint16_t bufsize);
+
+#endif
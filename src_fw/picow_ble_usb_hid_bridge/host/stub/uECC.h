@@ -0,0 +1,17 @@
+// Copyright © 2025 Shiomachi Software. All rights reserved.
+// Host-native stub of micro-ecc (BTstack 3rd-party): no real curve arithmetic
+#ifndef _UECC_H_
+#define _UECC_H_
+
+#include <stdint.h>
+
+typedef const struct uECC_Curve_t *uECC_Curve;
+typedef int (*uECC_RNG_Function)(uint8_t *dest, unsigned size);
+
+uECC_Curve uECC_secp256r1(void);
+void uECC_set_rng(uECC_RNG_Function rng_function);
+int uECC_make_key(uint8_t *public_key, uint8_t *private_key, uECC_Curve curve);
+int uECC_valid_public_key(const uint8_t *public_key, uECC_Curve curve);
+int uECC_shared_secret(const uint8_t *public_key, const uint8_t *private_key, uint8_t *secret, uECC_Curve curve);
+
+#endif
@@ -28,6 +28,20 @@
 // @@add
 // =====>
 #include "Common.h"
+#include "Log.h"
+#include "Diag.h"
+#include "FlightRec.h"
+#include "Xform.h"
+#include "HidRptDesc.h"
+#include "UsbSof.h"
+#include "UsbSuspend.h"
+#include "Watchdog.h"
+#include "BootProf.h"
+#include "TaskProf.h"
+#include "TlvCache.h"
+#include "CryptoOffload.h"
+#include "AclFlow.h"
+#include "usb_descriptors.h"
 // <=====
 
 //--------------------------------------------------------------------+
@@ -37,6 +51,8 @@
 // =====>
 #define USB_REINIT_STABILIZATION_DELAY 100 // ms
 #define LED_BLINKING_INTERVAL 200 // ms
+#define USB_IDLE_THRESHOLD 50 // ms without HID traffic before USB is considered idle
+#define TX_CYCLES_WINDOW 1000 // Reports per log line of the send cycles
 // <=====
 //--------------------------------------------------------------------+
 // GLOBAL VARIABLES
@@ -44,6 +60,10 @@
 // @@add
 // =====>
 volatile bool g_usb_reinit_request = false; // Flag to request USB re-initialization when BLE HID connection is established
+volatile uint32_t g_usb_last_report_ms = 0; // Time the last HID report was handed to the USB stack
+static ST_CMN_STAT CMN_CORE0_DATA("hid_tx") f_stTxCycles; // Cycles of send_hid_report per report sent (scratch Y)
+static ULONG CMN_CORE0_DATA("hid_tx") f_txFlashCnt = 0;   // Flash writes seen by the TX cycle measurement
+volatile bool g_led_state = false; // LED state applied by core1 (poll-mode CYW43 architecture)
 // <=====
 
 //--------------------------------------------------------------------+
@@ -55,18 +75,34 @@ void usb_dev_main(void);
 void hid_task(void);
 void led_blinking_task(void);
 bool send_hid_report(void);
+bool is_usb_idle(void);
+static void led_put(bool state);
 
 extern bool is_ble_app_state_ready(void);
+extern const ST_HRD_MAP* get_ble_hid_report_map(void);
 extern void ble_host_main(void);
 // <=====
 
 /*------------- MAIN -------------*/
 int main(void)
 {
+    // @@add
+    // =====>
+    BPRF_Mark(BPRF_MS_MAIN);
+    CMN_CycInit();
+    // <=====
     board_init();  
+    // @@add
+    // =====>
+    BPRF_Mark(BPRF_MS_BOARD_INIT);
+    // <=====
 
     // init device stack on configured roothub port
     tud_init(BOARD_TUD_RHPORT);
+    // @@add
+    // =====>
+    BPRF_Mark(BPRF_MS_TUD_INIT);
+    // <=====
 
     if (board_init_after_tusb) {
         board_init_after_tusb();
@@ -76,6 +112,12 @@ int main(void)
     // =====>
     stdio_init_all();
     CMN_Init(); 
+    FREC_Init();
+    BPRF_Init();
+    TPRF_Init();
+    USOF_Init();
+    WDG_Init();
+    (void)XFM_Init(XFM_CFG_ADDR, XFM_CFG_SIZE);
 
     // Initialize to lock out CPU Core 0 when btstack writes to flash memory on CPU Core 1
     flash_safe_execute_core_init();
@@ -99,21 +141,44 @@ void usb_dev_main(void)
 {    
     while (1) 
     {
+        TPRF_Loop();
+
         // Check for USB re-initialization request from Core1 (BLE host)
         if (g_usb_reinit_request) {
+            TPRF_Begin(TPRF_TASK_MISC);
             g_usb_reinit_request = false; 
+            FREC_Record(FREC_KIND_USB_REINIT, NULL, 0);
             if (tud_mounted()) {
                 tud_disconnect(); // Disconnect the USB device
                 board_delay(USB_REINIT_STABILIZATION_DELAY); // Wait a bit for stabilization
             }
             // Clear any pending HID reports from the queue before reconnecting.
             CMN_ClearQueue(CMN_QUE_KIND_HID_RPT);
+            USPD_Clear();
+            DIAG_Reset();
+            FREC_Record(FREC_KIND_QUE_CLEAR, NULL, 0);
             tud_connect();
+            TPRF_End();
         }
 
+        TPRF_Begin(TPRF_TASK_TUD);
         tud_task();          // Run TinyUSB device task
+        TPRF_End();
+        TPRF_Begin(TPRF_TASK_LED);
         led_blinking_task(); // Run LED blinking task
+        TPRF_End();
+        TPRF_Begin(TPRF_TASK_HID);
         hid_task();          // Run HID report sending task
+        TPRF_End();
+        TPRF_Begin(TPRF_TASK_MISC);
+        ACLF_Task();         // Let Core1 return the BLE link credits once the queue has drained
+        LOG_Drain();         // Output deferred log records (never blocks)
+        DIAG_Task();         // Close a diagnostics source the host stopped reading
+        WDG_Feed();          // Feed the watchdog while Core1 is alive
+        TPRF_End();
+        TPRF_Begin(TPRF_TASK_CRYPTO);
+        CRYP_Task();         // Run one step of a queued SM crypto command of Core1
+        TPRF_End();
     }
 }
 // <=====
@@ -125,11 +190,24 @@ void usb_dev_main(void)
 // Invoked when device is mounted
 void tud_mount_cb(void)
 {
+    // @@add
+    // =====>
+    FREC_Record(FREC_KIND_USB_MOUNT, NULL, 0);
+    WDG_SetUsbMounted(true);
+    BPRF_Mark(BPRF_MS_USB_MOUNT);
+    // <=====
 }
 
 // Invoked when device is unmounted
 void tud_umount_cb(void)
 {
+    // @@add
+    // =====>
+    FREC_Record(FREC_KIND_USB_UMOUNT, NULL, 0);
+    WDG_SetUsbMounted(false);
+    USPD_Clear();
+    DIAG_Reset();
+    // <=====
 }
 
 // Invoked when usb bus is suspended
@@ -137,41 +215,108 @@ void tud_umount_cb(void)
 // Within 7ms, device must draw an average of current less than 2.5 mA from bus
 void tud_suspend_cb(bool remote_wakeup_en)
 {
-    (void) remote_wakeup_en;
+    // @@chg
+    // =====>
+    UCHAR ucWakeupEn = remote_wakeup_en ? 1 : 0;
+    FREC_Record(FREC_KIND_USB_SUSPEND, &ucWakeupEn, sizeof(ucWakeupEn));
+    USPD_OnSuspend(remote_wakeup_en);
+    // <=====
 }
 
 // Invoked when usb bus is resumed
 void tud_resume_cb(void)
 {
+    // @@add
+    // =====>
+    FREC_Record(FREC_KIND_USB_RESUME, NULL, 0);
+    USPD_OnResume();
+    // <=====
 }
 
+// @@add
+// =====>
+// Invoked at the start of each frame (enabled by USOF_Init)
+void __time_critical_func(tud_sof_cb)(uint32_t frame_count)
+{
+    (void) frame_count;
+    USOF_OnSof();
+}
+// <=====
+
 //--------------------------------------------------------------------+
 // USB HID
 //--------------------------------------------------------------------+
 
+// @@add
+// =====>
+// Record a report accepted by the USB stack in the flight recorder
+static inline void send_hid_report_record(const ST_HID_RPT *pstHidRpt)
+{
+    UCHAR aucData[3];
+
+    aucData[0] = pstHidRpt->report_id;
+    memcpy(&aucData[1], &pstHidRpt->report_len, sizeof(pstHidRpt->report_len));
+    FREC_Record(FREC_KIND_USB_SUBMIT, aucData, sizeof(aucData));
+}
+// <=====
+
 // @@chg
 // =====>
 // Dequeue and send one HID report from the queue to the USB host.
 // return true if a report was successfully sent, false otherwise.
-bool send_hid_report(void)
+bool __time_critical_func(send_hid_report)(void)
 {
-    static ST_HID_RPT stHidRpt; // Change local variable to static to use static memory (data area) instead of stack, preventing stack overflow.
+    static ST_HID_RPT CMN_CORE0_RPT("hid_tx") stHidRpt; // Change local variable to static to use static memory (data area) instead of stack, preventing stack overflow.
+    static bool bFirstSent = false; // BPRF_Mark (in flash) is only called for the first report
+    const ST_HID_RPT *pstHeld;
     bool bRet = false;
+    ULONG merge_cnt;
+    ULONG i;
+
+    // If the host is suspended, keep only the net state of each report ID and wake it up once.
+    // The held reports are sent on subsequent calls after the host resumes.
+    if (tud_suspended()) {
+        USPD_Collect(get_ble_hid_report_map());
+        return bRet;
+    }
+    // The reports held during the suspend are sent first
+    pstHeld = USPD_PeekHeld();
+    if (pstHeld != NULL) {
+        if (tud_hid_ready()) {
+            if (tud_hid_report(pstHeld->report_id, pstHeld->report, pstHeld->report_len)) {
+                send_hid_report_record(pstHeld);
+                USPD_AdvanceHeld();
+                USOF_OnSubmit(0);
+                g_usb_last_report_ms = board_millis();
+                bRet = true;
+            }
+        }
+        return bRet;
+    }
 
     // Peek at the next report in the queue without removing it yet
     if (CMN_PeekQueue(CMN_QUE_KIND_HID_RPT, &stHidRpt)) {
-        // If the host is suspended, wake it up and exit.
-        // The report will be sent on a subsequent call after the host resumes.
-        if ( tud_suspended()) {
-            tud_remote_wakeup();
-            return bRet;
-        }                 
         // If the HID interface is ready, try to send the report
         if (tud_hid_ready()) {      
+            // A movement report may be held until just before the host poll,
+            // and the movement queued behind it is merged into it
+            if (!USOF_PrepareSubmit(&stHidRpt, get_ble_hid_report_map(), &merge_cnt)) {
+                return bRet;
+            }
             // Try to send the report
-            if (tud_hid_report(0, stHidRpt.report, stHidRpt.report_len)) {
-                // If sent successfully, remove the report from the queue
-                CMN_AdvanceQueue(CMN_QUE_KIND_HID_RPT);
+            // Report ID 0 sends the data as is (report map without IDs, or unchecked data)
+            if (tud_hid_report(stHidRpt.report_id, stHidRpt.report, stHidRpt.report_len)) {
+                send_hid_report_record(&stHidRpt);
+                // If sent successfully, remove the report and the merged ones from the queue
+                for (i = 0; i <= merge_cnt; i++) {
+                    CMN_AdvanceQueue(CMN_QUE_KIND_HID_RPT);
+                }
+                USOF_OnSubmit(merge_cnt);
+                g_usb_last_report_ms = board_millis();
+                if (!bFirstSent) {
+                    bFirstSent = true;
+                    BPRF_Mark(BPRF_MS_FIRST_REPORT);
+                }
                 bRet = true;
             }  
         }
@@ -181,28 +326,78 @@ bool send_hid_report(void)
 }
 // <=====
 
+// @@add
+// =====>
+// Check whether the USB side can tolerate a flash write (core0 lockout).
+// Called from Core1. True while the bus is suspended, or while mounted with
+// no queued reports and no report sent within USB_IDLE_THRESHOLD.
+bool is_usb_idle(void)
+{
+    if (tud_suspended()) {
+        return true;
+    }
+    if (!tud_mounted()) {
+        // Possibly enumerating, control requests must be answered
+        return false;
+    }
+    return (CMN_GetQueueCount(CMN_QUE_KIND_HID_RPT) == 0) && (USPD_GetHeldCount() == 0) &&
+           ((board_millis() - g_usb_last_report_ms) >= USB_IDLE_THRESHOLD);
+}
+// <=====
+
 //--------------------------------------------------------------------+
 // HID TASK
 //--------------------------------------------------------------------+
-void hid_task(void)
+// @@chg
+// =====>
+//void hid_task(void)
+void __time_critical_func(hid_task)(void)
+// <=====
 {
     // @@chg
     // =====>
-    // Dequeue and send one HID report.
-    (void)send_hid_report();
+    // Dequeue and send one HID report, counting the cycles of the reports sent
+    ULONG cyc = CMN_CycNow();
+    ULONG cycles;
+
+    if (send_hid_report()) {
+        cycles = CMN_CycSince(cyc);
+        CMN_StatAdd(&f_stTxCycles, cycles);
+        // The first report after a flash write runs with the XIP cache flushed
+        if (f_txFlashCnt != TLVC_GetStat()->lockout.cnt) {
+            f_txFlashCnt = TLVC_GetStat()->lockout.cnt;
+            LOG_INFO("TX cycles after flash write: %lu\n", cycles);
+        }
+        if (f_stTxCycles.cnt >= TX_CYCLES_WINDOW) {
+            LOG_INFO("TX cycles: min %lu avg %lu max %lu\n", f_stTxCycles.min,
+                (ULONG)(f_stTxCycles.sum / f_stTxCycles.cnt), f_stTxCycles.max);
+            CMN_StatClear(&f_stTxCycles);
+        }
+    }
     // <=====
 }
 
 // Invoked when sent REPORT successfully to host
 // Application can use this to send the next report
 // Note: For composite reports, report[0] is report ID
-void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len)
+// @@chg
+// =====>
+//void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len)
+void __time_critical_func(tud_hid_report_complete_cb)(uint8_t instance, uint8_t const* report, uint16_t len)
+// <=====
 {
-    (void) instance;
-    (void) len;
     // @@chg
     // =====>
+    UCHAR aucData[3];
+
     (void) report;
+    aucData[0] = instance;
+    memcpy(&aucData[1], &len, sizeof(len));
+    FREC_Record(FREC_KIND_USB_DONE, aucData, sizeof(aucData));
+    if (instance == HID_INST_BRIDGE) {
+        // The host has polled the endpoint
+        USOF_OnComplete();
+    }
     // <=====
 }
 
@@ -211,33 +406,63 @@ void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_
 // Return zero will cause the stack to STALL request
 uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t reqlen)
 {
-    // TODO not Implemented
+    // @@chg
+    // =====>
+#if CFG_BRIDGE_DIAG
+    // Diagnostics channel (vendor-defined interface)
+    if ((instance == HID_INST_DIAG) && (report_type == HID_REPORT_TYPE_FEATURE)) {
+        return DIAG_GetReport(report_id, buffer, reqlen);
+    }
+#else
     (void) instance;
     (void) report_id;
     (void) report_type;
     (void) buffer;
     (void) reqlen;
+#endif
 
     return 0;
+    // <=====
 }
 
 // Invoked when received SET_REPORT control request or
 // received data on OUT endpoint ( Report ID = 0, Type = 0 )
 void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer, uint16_t bufsize)
 {
-    (void) instance;
     // @@chg
     // =====>
+#if CFG_BRIDGE_DIAG
+    // Diagnostics channel (vendor-defined interface)
+    if ((instance == HID_INST_DIAG) && (report_type == HID_REPORT_TYPE_FEATURE)) {
+        DIAG_SetReport(report_id, buffer, bufsize);
+    }
+#else
+    (void) instance;
     (void) report_id;
     (void) report_type;
     (void) buffer;
     (void) bufsize;
+#endif
     // <=====
 }
 
 //--------------------------------------------------------------------+
 // BLINKING TASK
 //--------------------------------------------------------------------+
+// @@add
+// =====>
+// Set the LED (CYW43 GPIO).
+// The poll-mode CYW43 architecture may only be used from core1, which applies g_led_state.
+static void led_put(bool state)
+{
+#if PICO_CYW43_ARCH_POLL
+    g_led_state = state;
+#else
+    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, state);
+#endif
+}
+// <=====
+
 void led_blinking_task(void)
 {
     static uint32_t start_ms = 0;
@@ -249,7 +474,7 @@ void led_blinking_task(void)
     if (is_ble_app_state_ready()) {
         // Turn on LED when in READY state
         if (!led_state) {
-            cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, true);
+            led_put(true);
             led_state = true;
         }
     } else {
@@ -258,7 +483,7 @@ void led_blinking_task(void)
         start_ms += blink_interval;
 
         led_state = !led_state;
-        cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, led_state);
+        led_put(led_state);
     }
     // <=====
 }
\ No newline at end of file
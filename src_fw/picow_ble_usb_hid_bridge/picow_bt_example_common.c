@@ -9,6 +9,10 @@
 #include "pico/cyw43_arch.h"
 #include "pico/stdlib.h"
 #include "btstack.h"
+// @@add
+// =====>
+#include "Log.h"
+// <=====
 
 // Start the btstack example
 int btstack_main(int argc, const char * argv[]);
@@ -24,7 +28,11 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
         case BTSTACK_EVENT_STATE:
             if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) return;
             gap_local_bd_addr(local_addr);
-            printf("BTstack up and running on %s.\n", bd_addr_to_str(local_addr));
+            // @@chg
+            // =====>
+            LOG_INFO("BTstack up and running on %02lX:%02lX:%02lX:%02lX:%02lX:%02lX.\n",
+                local_addr[0], local_addr[1], local_addr[2], local_addr[3], local_addr[4], local_addr[5]);
+            // <=====
             break;
         default:
             break;
@@ -34,7 +42,10 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
 int picow_bt_example_init(void) {
     // initialize CYW43 driver architecture (will enable BT if/because CYW43_ENABLE_BLUETOOTH == 1)
     if (cyw43_arch_init()) {
-        printf("failed to initialise cyw43_arch\n");
+        // @@chg
+        // =====>
+        LOG_ERROR("failed to initialise cyw43_arch\n");
+        // <=====
         return -1;
     }
 
@@ -0,0 +1,402 @@
+#!/usr/bin/env python3
+# Copyright © 2025 Shiomachi Software. All rights reserved.
+"""Diagnostics client for the BLE-USB HID bridge.
+
+Usage:
+  bridge_diag.py frec [-d /dev/hidrawN] [-o dump.bin] [--pklg out.pklg]
+  bridge_diag.py decode dump.bin [--pklg out.pklg]
+  bridge_diag.py boot [-d /dev/hidrawN] [-o boot.bin] [--compare other.bin]
+  bridge_diag.py load [-d /dev/hidrawN] [-i seconds]
+
+'frec' reads the flight recorder over the vendor-defined HID interface (Linux hidraw,
+feature report ID 1, see Diag.h) and prints a merged timeline of both cores.
+'decode' prints the timeline of a dump saved with -o.
+--pklg exports the recorded HCI events as a PacketLogger file that Wireshark opens.
+'boot' prints the boot milestone profile (see BootProf.h); --compare shows the change
+against a profile saved with -o, for example from another firmware build.
+'load' reads the task-time profile twice (see TaskProf.h) and prints the load of each task
+of both cores over the interval, the longest runs and the loop period histograms.
+"""
+
+import argparse
+import fcntl
+import glob
+import os
+import struct
+import sys
+import time
+
+# Diagnostics protocol (keep in sync with Diag.h)
+DIAG_REPORT_ID = 1
+DIAG_REPORT_SIZE = 63
+DIAG_RSP_HDR_SIZE = 12
+DIAG_CMD_OPEN = 1
+DIAG_CMD_SEEK = 2
+DIAG_CMD_CLOSE = 3
+DIAG_STS_OK = 0
+DIAG_SRC_FREC = 1
+DIAG_SRC_BOOT = 2
+DIAG_SRC_PROF = 3
+DIAG_STATUS = {0: 'OK', 1: 'NOT_OPEN', 2: 'BAD_SOURCE'}
+
+# Flight recorder dump (keep in sync with FlightRec.h)
+FREC_MAGIC = 0x43455246
+FREC_VERSION = 1
+FREC_HDR = struct.Struct('<IHHHBBII2I')
+FREC_REC_HEAD = struct.Struct('<IBB')
+FREC_KINDS = [
+    'NONE', 'HCI_EVT', 'GATT_EVT', 'APP_STATE', 'QUE_ENQ', 'QUE_DROP', 'QUE_CLEAR',
+    'USB_SUBMIT', 'USB_DONE', 'USB_MOUNT', 'USB_UMOUNT', 'USB_SUSPEND', 'USB_RESUME',
+    'USB_REINIT', 'RPT_REJECT', 'WDG_RESET',
+]
+APP_STATES = [
+    'W4_WORKING', 'W4_HID_DEVICE_FOUND', 'W4_CONNECTED', 'W4_ENCRYPTED',
+    'W4_HID_CLIENT_CONNECTED', 'READY', 'W4_TIMEOUT_THEN_SCAN', 'W4_TIMEOUT_THEN_RECONNECT',
+    'W4_DEVICE_INFORMATION',
+]
+
+# Boot profile (keep in sync with BootProf.h)
+BPRF_MAGIC = 0x46525042
+BPRF_VERSION = 1
+BPRF_HDR = struct.Struct('<IHHI24s')
+BPRF_MILESTONES = [
+    'MAIN', 'BOARD_INIT', 'TUD_INIT', 'CORE1_START', 'CYW43_INIT', 'HCI_WORKING', 'FIRST_ADV',
+    'CONNECTED', 'ENCRYPTED', 'HID_CONNECTED', 'READY', 'USB_MOUNT', 'FIRST_REPORT',
+]
+
+# Task-time profile (keep in sync with TaskProf.h)
+TPRF_MAGIC = 0x46525054
+TPRF_VERSION = 1
+TPRF_HDR = struct.Struct('<IHBBIII')
+TPRF_TASK = struct.Struct('<III')
+TPRF_CORE_NUM = 2
+TPRF_TASKS = [
+    (0, 'tud'), (0, 'hid'), (0, 'led'), (0, 'misc'), (0, 'crypto'), (0, 'usb_irq'),
+    (1, 'bt_hci'), (1, 'bt_sm'), (1, 'bt_gatt'), (1, 'bt_notify'), (1, 'bt_timer'), (1, 'bt_poll'),
+    (1, 'cyw43_irq'),
+]
+
+USB_VID = 0xCAFE
+VENDOR_USAGE_PAGE = bytes([0x06, 0x00, 0xFF])  # Usage Page (Vendor 0xFF00), 2-byte item
+
+
+def _ioc_rw(nr, size):
+    return (3 << 30) | (size << 16) | (ord('H') << 8) | nr
+
+
+def hidiocsfeature(size):
+    return _ioc_rw(0x06, size)
+
+
+def hidiocgfeature(size):
+    return _ioc_rw(0x07, size)
+
+
+def find_hidraw():
+    """Return the hidraw node of the diagnostics interface, or None."""
+    for node in sorted(glob.glob('/sys/class/hidraw/hidraw*')):
+        try:
+            with open(os.path.join(node, 'device', 'uevent')) as f:
+                uevent = f.read()
+            with open(os.path.join(node, 'device', 'report_descriptor'), 'rb') as f:
+                rdesc = f.read()
+        except OSError:
+            continue
+        if ('%08X' % USB_VID) in uevent.upper() and rdesc.startswith(VENDOR_USAGE_PAGE):
+            return '/dev/' + os.path.basename(node)
+    return None
+
+
+class DiagChannel:
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR)
+
+    def close(self):
+        os.close(self.fd)
+
+    def command(self, cmd, source=0, offset=0):
+        buf = bytearray(1 + DIAG_REPORT_SIZE)
+        buf[0] = DIAG_REPORT_ID
+        struct.pack_into('<BBxxI', buf, 1, cmd, source, offset)
+        fcntl.ioctl(self.fd, hidiocsfeature(len(buf)), buf)
+
+    def get(self):
+        buf = bytearray(1 + DIAG_REPORT_SIZE)
+        buf[0] = DIAG_REPORT_ID
+        fcntl.ioctl(self.fd, hidiocgfeature(len(buf)), buf)
+        status, source, length, total, offset = struct.unpack_from('<BBBxII', buf, 1)
+        data = bytes(buf[1 + DIAG_RSP_HDR_SIZE:1 + DIAG_RSP_HDR_SIZE + length])
+        return status, total, offset, data
+
+    def read_source(self, source):
+        """Open a source, read its whole snapshot and close it."""
+        self.command(DIAG_CMD_OPEN, source)
+        try:
+            image = bytearray()
+            while True:
+                status, total, offset, data = self.get()
+                if status != DIAG_STS_OK:
+                    raise RuntimeError('diag status %s' % DIAG_STATUS.get(status, status))
+                if offset != len(image):
+                    # A GET was lost or repeated: resynchronize
+                    self.command(DIAG_CMD_SEEK, source, len(image))
+                    continue
+                image += data
+                if len(image) >= total or not data:
+                    return bytes(image)
+        finally:
+            self.command(DIAG_CMD_CLOSE)
+
+
+def parse_frec(dump):
+    """Return (header dict, records) with records sorted oldest first.
+
+    Each record is (age_us, core, kind, data); age is relative to the snapshot time.
+    """
+    (magic, version, rec_size, rec_num, core_num, _rsv, now_us, skip_cnt,
+     widx0, widx1) = FREC_HDR.unpack_from(dump, 0)
+    if magic != FREC_MAGIC:
+        raise ValueError('not a flight recorder dump')
+    if version != FREC_VERSION:
+        raise ValueError('unsupported dump version %d' % version)
+    hdr = dict(now_us=now_us, skip_cnt=skip_cnt, widx=(widx0, widx1), rec_num=rec_num)
+
+    records = []
+    pos = FREC_HDR.size
+    for core, widx in enumerate((widx0, widx1)[:core_num]):
+        count = min(widx, rec_num)
+        for i in range(widx - count, widx):
+            off = pos + (i % rec_num) * rec_size
+            time_us, kind, length = FREC_REC_HEAD.unpack_from(dump, off)
+            data = dump[off + FREC_REC_HEAD.size:off + FREC_REC_HEAD.size + length]
+            age = (now_us - time_us) & 0xFFFFFFFF
+            records.append((age, core, kind, data))
+        pos += rec_num * rec_size
+
+    records.sort(key=lambda r: -r[0])
+    return hdr, records
+
+
+def describe(kind, data):
+    if kind == 3 and len(data) >= 2:
+        name = lambda s: APP_STATES[s] if s < len(APP_STATES) else str(s)
+        return '%s -> %s' % (name(data[0]), name(data[1]))
+    if kind in (4, 5, 7) and len(data) >= 3:
+        text = 'id=%d len=%d' % (data[0], struct.unpack_from('<H', data, 1)[0])
+        if len(data) >= 4:
+            text += ' que=%d' % data[3]
+        return text
+    if kind == 8 and len(data) >= 3:
+        return 'inst=%d len=%d' % (data[0], struct.unpack_from('<H', data, 1)[0])
+    if kind == 11 and data:
+        return 'remote_wakeup=%d' % data[0]
+    if kind == 14 and len(data) >= 5:
+        rid, rlen, exp = struct.unpack_from('<BHH', data, 0)
+        return 'id=%d len=%d %s' % (rid, rlen, ('expected=%d' % exp) if exp else 'unknown id')
+    return data.hex(' ')
+
+
+def print_timeline(hdr, records, out=sys.stdout):
+    out.write('snapshot at %u us, widx=%s, %u records skipped while frozen\n'
+              % (hdr['now_us'], hdr['widx'], hdr['skip_cnt']))
+    for age, core, kind, data in records:
+        name = FREC_KINDS[kind] if kind < len(FREC_KINDS) else 'KIND_%d' % kind
+        out.write('%12.3f ms  core%d  %-11s %s\n' % (-age / 1000.0, core, name, describe(kind, data)))
+
+
+def write_pklg(path, hdr, records):
+    """Export HCI events (and other records as text) in PacketLogger format."""
+    with open(path, 'wb') as f:
+        for age, core, kind, data in records:
+            t = (hdr['now_us'] - age) & 0xFFFFFFFF
+            if kind == 1 and len(data) >= 2:
+                payload = bytearray(data)
+                payload[1] = len(payload) - 2  # Event was truncated by the recorder
+                ptype = 0x01
+            else:
+                name = FREC_KINDS[kind] if kind < len(FREC_KINDS) else 'KIND_%d' % kind
+                payload = ('core%d %s %s' % (core, name, describe(kind, data))).encode() + b'\0'
+                ptype = 0xFC
+            f.write(struct.pack('>III', len(payload) + 9, t // 1000000, t % 1000000))
+            f.write(bytes([ptype]) + bytes(payload))
+
+
+def output(hdr, records, args):
+    print_timeline(hdr, records)
+    if args.pklg:
+        write_pklg(args.pklg, hdr, records)
+
+
+def cmd_frec(args):
+    path = args.device or find_hidraw()
+    if path is None:
+        sys.exit('diagnostics interface not found (use -d /dev/hidrawN)')
+    chan = DiagChannel(path)
+    try:
+        dump = chan.read_source(DIAG_SRC_FREC)
+    finally:
+        chan.close()
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(dump)
+    output(*parse_frec(dump), args)
+
+
+def cmd_decode(args):
+    with open(args.dump, 'rb') as f:
+        dump = f.read()
+    output(*parse_frec(dump), args)
+
+
+def parse_boot(image):
+    """Return (build string, {milestone: time_us}) of the milestones reached."""
+    magic, version, ms_num, _now_us, build = BPRF_HDR.unpack_from(image, 0)
+    if magic != BPRF_MAGIC:
+        raise ValueError('not a boot profile')
+    if version != BPRF_VERSION:
+        raise ValueError('unsupported profile version %d' % version)
+    times = struct.unpack_from('<%dI' % ms_num, image, BPRF_HDR.size)
+    names = [BPRF_MILESTONES[i] if i < len(BPRF_MILESTONES) else 'MS_%d' % i for i in range(ms_num)]
+    return build.rstrip(b'\0').decode(errors='replace'), {n: t for n, t in zip(names, times) if t}
+
+
+def print_boot(build, times, base=None, out=sys.stdout):
+    """Print the milestones in time order with the time spent in each phase."""
+    out.write('build %s\n' % build)
+    if base:
+        out.write('compared with build %s\n' % base[0])
+    prev = 0
+    for name, t in sorted(times.items(), key=lambda item: item[1]):
+        line = '%-14s %10.3f ms  +%9.3f ms' % (name, t / 1000.0, (t - prev) / 1000.0)
+        if base and name in base[1]:
+            line += '  (%+.3f ms)' % ((t - base[1][name]) / 1000.0)
+        out.write(line + '\n')
+        prev = t
+    missing = [n for n in BPRF_MILESTONES if n not in times]
+    if missing:
+        out.write('not reached: %s\n' % ' '.join(missing))
+
+
+def cmd_boot(args):
+    path = args.device or find_hidraw()
+    if path is None:
+        sys.exit('diagnostics interface not found (use -d /dev/hidrawN)')
+    chan = DiagChannel(path)
+    try:
+        image = chan.read_source(DIAG_SRC_BOOT)
+    finally:
+        chan.close()
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(image)
+    base = None
+    if args.compare:
+        with open(args.compare, 'rb') as f:
+            base = parse_boot(f.read())
+    print_boot(*parse_boot(image), base=base)
+
+
+def parse_prof(image):
+    """Return (now_us, cyc_per_us, overflow, [(cnt, cyc, max)], [(cnt, max_us, hist)])."""
+    magic, version, task_num, hist_num, now_us, cyc_per_us, overflow = TPRF_HDR.unpack_from(image, 0)
+    if magic != TPRF_MAGIC:
+        raise ValueError('not a task-time profile')
+    if version != TPRF_VERSION:
+        raise ValueError('unsupported profile version %d' % version)
+    offset = TPRF_HDR.size
+    tasks = []
+    for _ in range(task_num):
+        tasks.append(TPRF_TASK.unpack_from(image, offset))
+        offset += TPRF_TASK.size
+    loops = []
+    for _ in range(TPRF_CORE_NUM):
+        cnt, max_us = struct.unpack_from('<II', image, offset)
+        hist = struct.unpack_from('<%dI' % hist_num, image, offset + 8)
+        loops.append((cnt, max_us, hist))
+        offset += 8 + 4 * hist_num
+    return now_us, cyc_per_us, overflow, tasks, loops
+
+
+def hist_label(i, num):
+    """Range of a log2 loop period bucket."""
+    if i == 0:
+        return '<2 us'
+    if i == num - 1:
+        return '>=%d us' % (1 << i)
+    return '%d-%d us' % (1 << i, (1 << (i + 1)) - 1)
+
+
+def print_load(first, second, out=sys.stdout):
+    """Print the load of each task and the loop periods between two profiles."""
+    now0, _, ovf0, tasks0, loops0 = first
+    now1, cyc_per_us, ovf1, tasks1, loops1 = second
+    elapsed_cyc = ((now1 - now0) & 0xFFFFFFFF) * cyc_per_us
+    if elapsed_cyc == 0:
+        raise ValueError('empty interval')
+    out.write('interval %.3f s\n' % (elapsed_cyc / cyc_per_us / 1e6))
+    busy = [0.0] * TPRF_CORE_NUM
+    for i, (t0, t1) in enumerate(zip(tasks0, tasks1)):
+        core, name = TPRF_TASKS[i] if i < len(TPRF_TASKS) else (0, 'task_%d' % i)
+        runs = (t1[0] - t0[0]) & 0xFFFFFFFF
+        load = 100.0 * ((t1[1] - t0[1]) & 0xFFFFFFFF) / elapsed_cyc
+        busy[core] += load
+        out.write('core%d %-10s %6.2f %%  runs %8d  max %8.1f us\n' % (core, name, load, runs, t1[2] / cyc_per_us))
+    for core in range(TPRF_CORE_NUM):
+        out.write('core%d busy %6.2f %%\n' % (core, busy[core]))
+    if ovf1 != ovf0:
+        out.write('runs nested too deep: %d\n' % ((ovf1 - ovf0) & 0xFFFFFFFF))
+    for core, (l0, l1) in enumerate(zip(loops0, loops1)):
+        cnt = (l1[0] - l0[0]) & 0xFFFFFFFF
+        out.write('core%d loop: %d iterations, max %d us\n' % (core, cnt, l1[1]))
+        for i, (h0, h1) in enumerate(zip(l0[2], l1[2])):
+            n = (h1 - h0) & 0xFFFFFFFF
+            if n:
+                out.write('  %-14s %9d  %6.2f %%\n' % (hist_label(i, len(l1[2])), n, 100.0 * n / cnt))
+
+
+def cmd_load(args):
+    path = args.device or find_hidraw()
+    if path is None:
+        sys.exit('diagnostics interface not found (use -d /dev/hidrawN)')
+    chan = DiagChannel(path)
+    try:
+        first = parse_prof(chan.read_source(DIAG_SRC_PROF))
+        time.sleep(args.interval)
+        second = parse_prof(chan.read_source(DIAG_SRC_PROF))
+    finally:
+        chan.close()
+    print_load(first, second)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('frec', help='read the flight recorder from the bridge')
+    p.add_argument('-d', '--device', help='hidraw node of the diagnostics interface')
+    p.add_argument('-o', '--output', help='save the raw dump to this file')
+    p.add_argument('--pklg', help='export HCI events as a PacketLogger file')
+    p.set_defaults(func=cmd_frec)
+
+    p = sub.add_parser('decode', help='decode a saved flight recorder dump')
+    p.add_argument('dump', help='raw dump saved with frec -o')
+    p.add_argument('--pklg', help='export HCI events as a PacketLogger file')
+    p.set_defaults(func=cmd_decode)
+
+    p = sub.add_parser('boot', help='read the boot milestone profile from the bridge')
+    p.add_argument('-d', '--device', help='hidraw node of the diagnostics interface')
+    p.add_argument('-o', '--output', help='save the raw profile to this file')
+    p.add_argument('--compare', help='profile saved with -o to compare with')
+    p.set_defaults(func=cmd_boot)
+
+    p = sub.add_parser('load', help='measure the load of each task of both cores')
+    p.add_argument('-d', '--device', help='hidraw node of the diagnostics interface')
+    p.add_argument('-i', '--interval', type=float, default=5.0, help='measurement interval in seconds')
+    p.set_defaults(func=cmd_load)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+# Copyright © 2025 Shiomachi Software. All rights reserved.
+"""RAM/flash budget report from a GNU ld map file.
+
+Usage: mem_report.py <firmware.elf.map> [-o report.txt] [-n TOP]
+
+Sizes are taken from the input sections listed in the map file.
+Initialised data (.data etc.) is counted in RAM and, via its load address, in flash.
+"""
+
+import argparse
+import collections
+import os
+import re
+import sys
+
+# Matches " .text.name  0x10000234  0x4c  path/lib.a(obj.o)" (name may be on the previous line)
+RE_INPUT = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$')
+RE_SECTION_ONLY = re.compile(r'^ (\.\S+|COMMON)\s*$')
+RE_SECTION_FULL = re.compile(r'^ (\.\S+|COMMON)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$')
+RE_SYMBOL = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$')
+RE_OUTPUT = re.compile(r'^(\.\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)(?:\s+load address\s+(0x[0-9a-fA-F]+))?')
+RE_OUTPUT_ONLY = re.compile(r'^(\.\S+)\s*$')
+RE_OUTPUT_CONT = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)(?:\s+load address\s+(0x[0-9a-fA-F]+))?\s*$')
+RE_REGION = re.compile(r'^(\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s*\S*\s*$')
+
+# Output sections that take no space in the image even though ld prints a load address for them
+RE_NOLOAD = re.compile(r'bss|^\.heap$|^\.stack|^\.uninitialized|^\.noinit')
+
+
+def parse_regions(lines):
+    """Return {name: (origin, length)} from the 'Memory Configuration' block."""
+    regions = collections.OrderedDict()
+    in_block = False
+    for line in lines:
+        if line.startswith('Memory Configuration'):
+            in_block = True
+            continue
+        if in_block:
+            if line.startswith('Linker script and memory map'):
+                break
+            m = RE_REGION.match(line)
+            if m and m.group(1) not in ('Name', '*default*'):
+                regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+    return regions
+
+
+def library_name(origin):
+    """Reduce 'path/libfoo.a(bar.o)' to 'libfoo.a' and 'path/CMakeFiles/x.dir/main.c.obj' to 'main.c.obj'."""
+    origin = origin.strip()
+    m = re.match(r'^(.*?)\((.*)\)$', origin)
+    if m:
+        return os.path.basename(m.group(1))
+    return os.path.basename(origin)
+
+
+def output_load_delta(name, vma, lma):
+    if lma is None or RE_NOLOAD.search(name):
+        return 0
+    return int(lma, 16) - vma
+
+
+def parse_sections(lines):
+    """Yield (address, load_address, size, section, library, symbol) for every input section."""
+    in_map = False
+    load_delta = 0
+    pending_name = None
+    current = None
+    out_pending = None
+
+    def flush():
+        if current and current['size'] > 0:
+            sym = current['symbol'] or current['section']
+            return (current['addr'], current['addr'] + current['delta'], current['size'],
+                    current['section'], current['lib'], sym)
+        return None
+
+    for line in lines:
+        if not in_map:
+            if line.startswith('Linker script and memory map'):
+                in_map = True
+            continue
+        line = line.rstrip('\n')
+
+        # Output section header (".data  0x20000000  0x100 load address 0x10001000")
+        if out_pending is not None:
+            m = RE_OUTPUT_CONT.match(line)
+            out_name, out_pending = out_pending, None
+            if m:
+                load_delta = output_load_delta(out_name, int(m.group(1), 16), m.group(3))
+                continue
+        m = RE_OUTPUT.match(line)
+        if m:
+            rec = flush()
+            if rec:
+                yield rec
+            current = None
+            load_delta = output_load_delta(m.group(1), int(m.group(2), 16), m.group(4))
+            continue
+        m = RE_OUTPUT_ONLY.match(line)
+        if m:
+            rec = flush()
+            if rec:
+                yield rec
+            current = None
+            out_pending = m.group(1)
+            continue
+
+        # Input section on one line
+        m = RE_SECTION_FULL.match(line)
+        if m:
+            rec = flush()
+            if rec:
+                yield rec
+            current = {'section': m.group(1), 'addr': int(m.group(2), 16), 'size': int(m.group(3), 16),
+                       'lib': library_name(m.group(4)), 'symbol': None, 'delta': load_delta}
+            pending_name = None
+            continue
+        # Input section name alone (long names wrap to the next line)
+        m = RE_SECTION_ONLY.match(line)
+        if m:
+            rec = flush()
+            if rec:
+                yield rec
+            current = None
+            pending_name = m.group(1)
+            continue
+        if pending_name:
+            m = RE_INPUT.match(line)
+            if m:
+                current = {'section': pending_name, 'addr': int(m.group(1), 16), 'size': int(m.group(2), 16),
+                           'lib': library_name(m.group(3)), 'symbol': None, 'delta': load_delta}
+                pending_name = None
+                continue
+        # First symbol inside the current input section names it
+        if current and current['symbol'] is None:
+            m = RE_SYMBOL.match(line)
+            if m and int(m.group(1), 16) >= current['addr']:
+                current['symbol'] = m.group(2)
+    rec = flush()
+    if rec:
+        yield rec
+
+
+def region_of(regions, addr):
+    for name, (origin, length) in regions.items():
+        if origin <= addr < origin + length:
+            return name
+    return None
+
+
+def build_report(map_path, top):
+    with open(map_path, encoding='utf-8', errors='replace') as f:
+        lines = f.readlines()
+    regions = parse_regions(lines)
+
+    used = collections.Counter()
+    by_symbol = collections.defaultdict(collections.Counter)
+    by_lib = collections.defaultdict(collections.Counter)
+    for addr, load_addr, size, section, lib, sym in parse_sections(lines):
+        # Sections that do not occupy memory (debug info etc.) are outside every region
+        places = {region_of(regions, addr)}
+        if load_addr != addr:
+            places.add(region_of(regions, load_addr))
+        for region in places:
+            if region is None:
+                continue
+            used[region] += size
+            by_symbol[region][sym] += size
+            by_lib[region][lib] += size
+
+    out = []
+    out.append('Memory budget: %s' % os.path.basename(map_path))
+    out.append('')
+    out.append('%-12s %10s %10s %7s' % ('Region', 'Used', 'Size', 'Use%'))
+    for name, (origin, length) in regions.items():
+        pct = (100.0 * used[name] / length) if length else 0.0
+        out.append('%-12s %10d %10d %6.1f%%' % (name, used[name], length, pct))
+    for name in regions:
+        if not used[name]:
+            continue
+        out.append('')
+        out.append('[%s] by library' % name)
+        for lib, size in by_lib[name].most_common(top):
+            out.append('  %8d  %s' % (size, lib))
+        out.append('')
+        out.append('[%s] top %d symbols' % (name, top))
+        for sym, size in by_symbol[name].most_common(top):
+            out.append('  %8d  %s' % (size, sym))
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('map', help='GNU ld map file (e.g. firmware.elf.map)')
+    parser.add_argument('-o', '--output', help='write the report to this file as well')
+    parser.add_argument('-n', '--top', type=int, default=25, help='number of symbols/libraries per region')
+    args = parser.parse_args()
+
+    report = build_report(args.map, args.top)
+    if args.output:
+        with open(args.output, 'w', encoding='utf-8') as f:
+            f.write(report)
+    # Print only the region summary to keep the build log short
+    sys.stdout.write('\n'.join(report.split('\n\n')[:2]) + '\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+# Copyright © 2025 Shiomachi Software. All rights reserved.
+"""Build the configuration blob of the report transform stage (Xform.h).
+
+Usage:
+  xform_cfg.py station.cfg [-o xform.bin] [--uf2 xform.uf2] [--flash-size 2M]
+
+The configuration is a text file with one entry per line ('#' starts a comment):
+  key CAPSLOCK ESC        remap a key code (names below or numbers, e.g. 0x39)
+  mod LCTRL LGUI          move a modifier bit (LCTRL LSHIFT LALT LGUI RCTRL RSHIFT RALT RGUI)
+  gain x 1.5              pointer gain of x, y or wheel (8.8 fixed point, -127.99 to 127.99)
+
+--uf2 writes a UF2 file that places the blob in the flash sector below the BTstack
+flash bank, so it can be dropped onto the RPI-RP2 drive next to the firmware.
+The firmware must be built with -DBRIDGE_XFORM=ON.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+# Blob format (keep in sync with Xform.h)
+XFM_CFG_MAGIC = 0x434D4658
+XFM_CFG_VERSION = 1
+XFM_CFG_SIZE = 4096
+XFM_CFG_HDR = struct.Struct('<IHHI')
+XFM_CFG_END = 0
+XFM_CFG_KEY_MAP = 1
+XFM_CFG_MOD_MAP = 2
+XFM_CFG_PTR_GAIN = 3
+
+# Flash layout (pico_btstack flash bank at the end of flash)
+XIP_BASE = 0x10000000
+BTSTACK_FLASH_BANK_SIZE = 2 * 4096
+
+# UF2 (RP2040 family)
+UF2_MAGIC0 = 0x0A324655
+UF2_MAGIC1 = 0x9E5D5157
+UF2_MAGIC_END = 0x0AB16F30
+UF2_FLAG_FAMILY = 0x00002000
+UF2_FAMILY_RP2040 = 0xE48BFF56
+UF2_PAYLOAD = 256
+
+MODIFIERS = ['LCTRL', 'LSHIFT', 'LALT', 'LGUI', 'RCTRL', 'RSHIFT', 'RALT', 'RGUI']
+AXES = ['X', 'Y', 'WHEEL']
+
+KEYS = {chr(ord('A') + i): 0x04 + i for i in range(26)}
+KEYS.update({str((i + 1) % 10): 0x1E + i for i in range(10)})
+KEYS.update({'F%d' % (i + 1): 0x3A + i for i in range(12)})
+KEYS.update({
+    'ENTER': 0x28, 'ESC': 0x29, 'BACKSPACE': 0x2A, 'TAB': 0x2B, 'SPACE': 0x2C,
+    'MINUS': 0x2D, 'EQUAL': 0x2E, 'LBRACKET': 0x2F, 'RBRACKET': 0x30, 'BACKSLASH': 0x31,
+    'SEMICOLON': 0x33, 'QUOTE': 0x34, 'GRAVE': 0x35, 'COMMA': 0x36, 'DOT': 0x37,
+    'SLASH': 0x38, 'CAPSLOCK': 0x39, 'PRINTSCREEN': 0x46, 'SCROLLLOCK': 0x47,
+    'PAUSE': 0x48, 'INSERT': 0x49, 'HOME': 0x4A, 'PAGEUP': 0x4B, 'DELETE': 0x4C,
+    'END': 0x4D, 'PAGEDOWN': 0x4E, 'RIGHT': 0x4F, 'LEFT': 0x50, 'DOWN': 0x51, 'UP': 0x52,
+    'NUMLOCK': 0x53, 'APPLICATION': 0x65,
+})
+
+
+def parse_key(text):
+    name = text.upper()
+    if name in KEYS:
+        return KEYS[name]
+    value = int(text, 0)
+    if not 0 <= value <= 0xFF:
+        raise ValueError('key code out of range: %s' % text)
+    return value
+
+
+def parse_config(path):
+    keys, mods, gains = [], [], [256, 256, 256]
+    with open(path) as f:
+        for no, line in enumerate(f, 1):
+            words = line.split('#', 1)[0].split()
+            if not words:
+                continue
+            try:
+                if words[0] == 'key' and len(words) == 3:
+                    keys += [parse_key(words[1]), parse_key(words[2])]
+                elif words[0] == 'mod' and len(words) == 3:
+                    mods += [MODIFIERS.index(words[1].upper()), MODIFIERS.index(words[2].upper())]
+                elif words[0] == 'gain' and len(words) == 3:
+                    gain = round(float(words[2]) * 256)
+                    if not -0x8000 <= gain <= 0x7FFF:
+                        raise ValueError('gain out of range')
+                    gains[AXES.index(words[1].upper())] = gain
+                else:
+                    raise ValueError('unknown entry')
+            except ValueError as e:
+                sys.exit('%s:%d: %s' % (path, no, e))
+    return keys, mods, gains
+
+
+def build_blob(keys, mods, gains):
+    entries = bytearray()
+    # One entry holds up to 127 pairs
+    for kind, pairs in ((XFM_CFG_KEY_MAP, keys), (XFM_CFG_MOD_MAP, mods)):
+        for i in range(0, len(pairs), 254):
+            chunk = bytes(pairs[i:i + 254])
+            entries += bytes([kind, len(chunk)]) + chunk
+    if gains != [256, 256, 256]:
+        entries += bytes([XFM_CFG_PTR_GAIN, 6]) + struct.pack('<3h', *gains)
+    entries += bytes([XFM_CFG_END, 0])
+    size = XFM_CFG_HDR.size + len(entries)
+    if size > XFM_CFG_SIZE:
+        sys.exit('configuration too large (%d bytes)' % size)
+    return XFM_CFG_HDR.pack(XFM_CFG_MAGIC, XFM_CFG_VERSION, size, zlib.crc32(entries)) + entries
+
+
+def build_uf2(data, addr):
+    data = data + b'\xff' * (-len(data) % UF2_PAYLOAD)
+    num = len(data) // UF2_PAYLOAD
+    out = bytearray()
+    for i in range(num):
+        payload = data[i * UF2_PAYLOAD:(i + 1) * UF2_PAYLOAD]
+        out += struct.pack('<8I', UF2_MAGIC0, UF2_MAGIC1, UF2_FLAG_FAMILY, addr + i * UF2_PAYLOAD,
+                           UF2_PAYLOAD, i, num, UF2_FAMILY_RP2040)
+        out += payload + b'\0' * (476 - UF2_PAYLOAD) + struct.pack('<I', UF2_MAGIC_END)
+    return out
+
+
+def parse_size(text):
+    scale = {'K': 1024, 'M': 1024 * 1024}.get(text[-1:].upper(), 1)
+    return int(text[:-1] if scale > 1 else text, 0) * scale
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('config', help='transform configuration (text)')
+    parser.add_argument('-o', '--output', help='write the raw blob to this file')
+    parser.add_argument('--uf2', help='write a UF2 file that programs the blob')
+    parser.add_argument('--flash-size', default='2M', help='flash size of the board (default 2M)')
+    args = parser.parse_args()
+
+    blob = build_blob(*parse_config(args.config))
+    offset = parse_size(args.flash_size) - BTSTACK_FLASH_BANK_SIZE - XFM_CFG_SIZE
+    print('%d bytes, flash offset 0x%06x (XIP 0x%08x)' % (len(blob), offset, XIP_BASE + offset))
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(blob)
+    if args.uf2:
+        with open(args.uf2, 'wb') as f:
+            f.write(build_uf2(blob, XIP_BASE + offset))
+
+
+if __name__ == '__main__':
+    main()
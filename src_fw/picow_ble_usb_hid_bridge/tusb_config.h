@@ -91,7 +91,16 @@
 #endif
 
 //------------- CLASS -------------//
-#define CFG_TUD_HID               1
+// @@chg
+// =====>
+// Vendor-defined diagnostics HID interface (flight recorder dump etc.).
+// Off by default: it adds an interface to the USB device of the product (BRIDGE_DIAG in CMakeLists.txt)
+#ifndef CFG_BRIDGE_DIAG
+#define CFG_BRIDGE_DIAG           0
+#endif
+//#define CFG_TUD_HID               1
+#define CFG_TUD_HID               (1 + CFG_BRIDGE_DIAG)
+// <=====
 #define CFG_TUD_CDC               0
 #define CFG_TUD_MSC               0
 #define CFG_TUD_MIDI              0
@@ -26,6 +26,13 @@
 #include "bsp/board_api.h"
 #include "tusb.h"
 #include "usb_descriptors.h"
+// @@add
+// =====>
+#include "Diag.h"
+#include "DevInfo.h"
+#include "Watchdog.h"
+#include "DevCtx.h"
+// <=====
 
 /* A combination of interfaces must have a unique product id, since PC will save device driver after the first plug.
  * Same VID/PID with different interface e.g MSC (first), then CDC (later) will possibly cause system error on PC.
@@ -42,9 +49,8 @@
 
 // @@add
 // =====>
-extern bool is_ble_app_state_ready(void);
-extern const uint8_t* get_ble_hid_report_descriptor_data(void);
-extern uint16_t get_ble_hid_report_descriptor_len(void);
+// Device context of core1, copied again whenever it is published
+static ST_DCTX f_stDctx;
 // <=====
 
 //--------------------------------------------------------------------+
@@ -71,11 +77,66 @@ tusb_desc_device_t const desc_device =
     .bNumConfigurations     = 0x01
 };
 
+// @@add
+// =====>
+// Report map and identity presented on the bridge interface: the connected BLE device while
+// READY, or the device restored by a warm restart until it is READY again (see Watchdog.h).
+// Returns NULL if neither; the default descriptors are used then.
+static uint8_t const *get_ble_device(uint16_t *p_len, ST_DEVI const **pp_devi)
+{
+    uint8_t const *p_desc;
+
+    // Core1 may tear the device down at any time: only its published context is used
+    if (f_stDctx.seq != DCTX_GetSeq()) {
+        (void) DCTX_Read(&f_stDctx);
+    }
+    if (f_stDctx.bReady) {
+        p_desc = f_stDctx.aucDesc;
+        *p_len = f_stDctx.desc_len;
+        *pp_devi = &f_stDctx.stDevi;
+    } else {
+        p_desc = WDG_GetWarmDevice(p_len, pp_devi);
+    }
+    return ((p_desc != NULL) && (*p_len > 0)) ? p_desc : NULL;
+}
+
+// bcdDevice of the BLE device: FNV-1a hash of its report map as 4 BCD digits.
+// Hosts that cache descriptors by VID/PID/bcdDevice re-read them when the report map changes.
+static uint16_t get_ble_report_desc_bcd(uint8_t const *p_desc, uint16_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    for (uint16_t i = 0; i < len; i++) {
+        hash = (hash ^ p_desc[i]) * 16777619u;
+    }
+    hash %= 10000;
+    return (uint16_t) (((hash / 1000) << 12) | (((hash / 100) % 10) << 8) | (((hash / 10) % 10) << 4) | (hash % 10));
+}
+// <=====
+
 // Invoked when received GET DEVICE DESCRIPTOR
 // Application return pointer to descriptor
 uint8_t const * tud_descriptor_device_cb(void)
 {
-    return (uint8_t const *) &desc_device;
+    // @@chg
+    // =====>
+    // The connected BLE device has its own identity (see DevInfo.h)
+    static tusb_desc_device_t desc_device_ble;
+    ST_DEVI const *pstDevi;
+    uint16_t len;
+    uint8_t const *p_desc = get_ble_device(&len, &pstDevi);
+
+    if (p_desc == NULL) {
+        return (uint8_t const *) &desc_device;
+    }
+    desc_device_ble = desc_device;
+    if (DEVI_USE_PNP_ID && (pstDevi->vid_src == DEVI_VID_SRC_USB)) {
+        desc_device_ble.idVendor  = pstDevi->vid;
+        desc_device_ble.idProduct = pstDevi->pid;
+    }
+    desc_device_ble.bcdDevice = get_ble_report_desc_bcd(p_desc, len);
+    return (uint8_t const *) &desc_device_ble;
+    // <=====
 }
 
 //--------------------------------------------------------------------+
@@ -90,17 +151,48 @@ uint8_t const desc_hid_report[] =
     TUD_HID_REPORT_DESC_GAMEPAD ( HID_REPORT_ID(REPORT_ID_GAMEPAD       ))
 };
 
+// @@add
+// =====>
+#if CFG_BRIDGE_DIAG
+// Vendor-defined diagnostics interface: one feature report (see Diag.h)
+uint8_t const desc_hid_report_diag[] =
+{
+    HID_USAGE_PAGE_N ( HID_USAGE_PAGE_VENDOR, 2 ),
+    HID_USAGE        ( 0x01 ),
+    HID_COLLECTION   ( HID_COLLECTION_APPLICATION ),
+        HID_REPORT_ID    ( DIAG_REPORT_ID )
+        HID_USAGE        ( 0x02 ),
+        HID_LOGICAL_MIN  ( 0x00 ),
+        HID_LOGICAL_MAX_N( 0xff, 2 ),
+        HID_REPORT_SIZE  ( 8 ),
+        HID_REPORT_COUNT ( DIAG_REPORT_SIZE ),
+        HID_FEATURE      ( HID_DATA | HID_VARIABLE | HID_ABSOLUTE ),
+    HID_COLLECTION_END
+};
+#endif
+// <=====
+
 // Invoked when received GET HID REPORT DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance)
 {
-    (void) instance;
     // @@chg
     // =====>
+#if CFG_BRIDGE_DIAG
+    if (instance == HID_INST_DIAG) {
+        return desc_hid_report_diag;
+    }
+#else
+    (void) instance;
+#endif
+    ST_DEVI const *pstDevi;
+    uint16_t len;
+    uint8_t const *p_desc = get_ble_device(&len, &pstDevi);
+
     // When connected via BLE, return the Report Descriptor from the BLE device
-    if (is_ble_app_state_ready() && get_ble_hid_report_descriptor_data() != NULL) {
-        return get_ble_hid_report_descriptor_data();
+    if (p_desc != NULL) {
+        return p_desc;
     } else {
         // When not connected, return the default descriptor
         return desc_hid_report;
@@ -115,12 +207,23 @@ uint8_t const * tud_hid_descriptor_report_cb(uint8_t instance)
 enum
 {
     ITF_NUM_HID,
+    // @@add
+    // =====>
+#if CFG_BRIDGE_DIAG
+    ITF_NUM_DIAG,
+#endif
+    // <=====
     ITF_NUM_TOTAL
 };
 
 #define     CONFIG_TOTAL_LEN    (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
 
 #define EPNUM_HID   0x81
+// @@add
+// =====>
+#define EPNUM_DIAG  0x82
+#define DIAG_POLLING_INTERVAL 100 // ms (the diagnostics interface only uses control transfers)
+// <=====
 
 // @@chg
 // =====>
@@ -134,9 +237,49 @@ uint8_t const desc_configuration[] =
     TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE, sizeof(desc_hid_report), EPNUM_HID, CFG_TUD_HID_EP_BUFSIZE, 5)
 };
 #endif
-#define DYNAMIC_CONFIG_BUF_SIZE (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
+#define DYNAMIC_CONFIG_BUF_SIZE (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN * CFG_TUD_HID)
 // Align the buffer to 4 bytes to ensure efficient and safe access
 static uint8_t desc_configuration[DYNAMIC_CONFIG_BUF_SIZE] __attribute__((aligned(4)));
+
+// Build the Interface, HID and Endpoint descriptors of one HID interface.
+// Return the position after the descriptors.
+static uint8_t *build_hid_interface(uint8_t *p_desc, uint8_t itf_num, uint16_t report_desc_len, uint8_t ep_addr, uint8_t interval)
+{
+    // 1. Build HID Interface Descriptor
+    tusb_desc_interface_t *if_desc = (tusb_desc_interface_t*) p_desc;
+    if_desc->bLength = sizeof(tusb_desc_interface_t);
+    if_desc->bDescriptorType = TUSB_DESC_INTERFACE;
+    if_desc->bInterfaceNumber = itf_num;
+    if_desc->bAlternateSetting = 0;
+    if_desc->bNumEndpoints = 1;
+    if_desc->bInterfaceClass = TUSB_CLASS_HID;
+    if_desc->bInterfaceSubClass = HID_SUBCLASS_NONE;
+    if_desc->bInterfaceProtocol = HID_ITF_PROTOCOL_NONE;
+    if_desc->iInterface = 0;
+    p_desc += sizeof(tusb_desc_interface_t);
+
+    // 2. Build HID Descriptor
+    // Use tu_unaligned_write16() for fields that might not be aligned.
+    *p_desc++ = 9; // bLength
+    *p_desc++ = HID_DESC_TYPE_HID; // bDescriptorType
+    tu_unaligned_write16(p_desc, 0x0111); p_desc += 2; // bcdHID
+    *p_desc++ = 0; // bCountryCode
+    *p_desc++ = 1; // bNumDescriptors
+    *p_desc++ = HID_DESC_TYPE_REPORT; // bDescriptorType
+    tu_unaligned_write16(p_desc, report_desc_len); p_desc += 2; // wDescriptorLength
+
+    // 3. Build Endpoint Descriptor
+    tusb_desc_endpoint_t *ep_desc = (tusb_desc_endpoint_t*) p_desc;
+    ep_desc->bLength = sizeof(tusb_desc_endpoint_t);
+    ep_desc->bDescriptorType = TUSB_DESC_ENDPOINT;
+    ep_desc->bEndpointAddress = ep_addr;
+    ep_desc->bmAttributes.xfer = TUSB_XFER_INTERRUPT;
+    ep_desc->wMaxPacketSize = CFG_TUD_HID_EP_BUFSIZE;
+    ep_desc->bInterval = interval;
+    p_desc += sizeof(tusb_desc_endpoint_t);
+
+    return p_desc;
+}
 // <=====
 
 
@@ -156,9 +299,8 @@ uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
 
     // Determine which report descriptor to use
     uint16_t report_desc_len;
-    if (is_ble_app_state_ready() && get_ble_hid_report_descriptor_len() > 0) {
-        report_desc_len = get_ble_hid_report_descriptor_len();
-    } else {
+    ST_DEVI const *pstDevi;
+    if (get_ble_device(&report_desc_len, &pstDevi) == NULL) {
         report_desc_len = sizeof(desc_hid_report);
     }
 
@@ -176,42 +318,17 @@ uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
     config_desc->bMaxPower = 250;
     p_desc += sizeof(tusb_desc_configuration_t);
 
-    // 2. Build HID Interface Descriptor
-    tusb_desc_interface_t *if_desc = (tusb_desc_interface_t*) p_desc;
-    if_desc->bLength = sizeof(tusb_desc_interface_t);
-    if_desc->bDescriptorType = TUSB_DESC_INTERFACE;
-    if_desc->bInterfaceNumber = ITF_NUM_HID;
-    if_desc->bAlternateSetting = 0;
-    if_desc->bNumEndpoints = 1;
-    if_desc->bInterfaceClass = TUSB_CLASS_HID;
-    if_desc->bInterfaceSubClass = HID_SUBCLASS_NONE;
-    if_desc->bInterfaceProtocol = HID_ITF_PROTOCOL_NONE;
-    if_desc->iInterface = 0;
-    p_desc += sizeof(tusb_desc_interface_t);
+    // 2. Build the HID interface of the bridge
+    p_desc = build_hid_interface(p_desc, ITF_NUM_HID, report_desc_len, EPNUM_HID, 1);
+
+#if CFG_BRIDGE_DIAG
+    // 3. Build the diagnostics HID interface
+    p_desc = build_hid_interface(p_desc, ITF_NUM_DIAG, sizeof(desc_hid_report_diag), EPNUM_DIAG, DIAG_POLLING_INTERVAL);
+#endif
 
-    // 3. Build HID Descriptor
-    // Use tu_unaligned_write16() for fields that might not be aligned.
-    *p_desc++ = 9; // bLength
-    *p_desc++ = HID_DESC_TYPE_HID; // bDescriptorType
-    tu_unaligned_write16(p_desc, 0x0111); p_desc += 2; // bcdHID
-    *p_desc++ = 0; // bCountryCode
-    *p_desc++ = 1; // bNumDescriptors
-    *p_desc++ = HID_DESC_TYPE_REPORT; // bDescriptorType
-    tu_unaligned_write16(p_desc, report_desc_len); p_desc += 2; // wDescriptorLength
-    
-    // 4. Build Endpoint Descriptor
-    tusb_desc_endpoint_t *ep_desc = (tusb_desc_endpoint_t*) p_desc;
     // Set wTotalLength
     // Use tu_htole16 for portability (though RP2040 is little-endian)
-    config_desc->wTotalLength = tu_htole16((uint16_t)(p_desc - desc_configuration) + sizeof(tusb_desc_endpoint_t));
-
-    ep_desc->bLength = sizeof(tusb_desc_endpoint_t);
-    ep_desc->bDescriptorType = TUSB_DESC_ENDPOINT;
-    ep_desc->bEndpointAddress = EPNUM_HID;
-    ep_desc->bmAttributes.xfer = TUSB_XFER_INTERRUPT;
-    ep_desc->wMaxPacketSize = CFG_TUD_HID_EP_BUFSIZE;
-    ep_desc->bInterval = 1;
-    p_desc += sizeof(tusb_desc_endpoint_t);
+    config_desc->wTotalLength = tu_htole16((uint16_t)(p_desc - desc_configuration));
 
     TU_ASSERT(p_desc <= desc_end, NULL);
     // <=====
@@ -242,11 +359,41 @@ char const *string_desc_arr[] =
 
 static uint16_t _desc_str[32 + 1];
 
+// @@add
+// =====>
+// Returns the manufacturer or product string of the BLE device, or NULL if it has none
+static char const *get_ble_device_string(ST_DEVI const *pstDevi, uint8_t index)
+{
+    char const *str = (index == STRID_MANUFACTURER) ? pstDevi->manufacturer :
+                      (index == STRID_PRODUCT)      ? pstDevi->model : "";
+
+    return (str[0] != '\0') ? str : NULL;
+}
+
+// Serial number of the BLE device: its BD address in hex (12 chars)
+static size_t get_ble_device_serial(ST_DEVI const *pstDevi, uint16_t desc_str1[])
+{
+    static char const hex[] = "0123456789ABCDEF";
+
+    for (size_t i = 0; i < sizeof(pstDevi->addr); i++) {
+        desc_str1[2 * i]     = hex[pstDevi->addr[i] >> 4];
+        desc_str1[2 * i + 1] = hex[pstDevi->addr[i] & 0x0f];
+    }
+    return 2 * sizeof(pstDevi->addr);
+}
+// <=====
+
 // Invoked when received GET STRING DESCRIPTOR request
 // Application return pointer to descriptor, whose contents must exist long enough for transfer to complete
 uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
     (void) langid;
     size_t chr_count;
+    // @@add
+    // =====>
+    ST_DEVI const *pstDevi;
+    uint16_t len;
+    bool const is_ble = (get_ble_device(&len, &pstDevi) != NULL);
+    // <=====
 
     switch ( index ) {
         case STRID_LANGID:
@@ -255,7 +402,15 @@ uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
             break;
 
         case STRID_SERIAL:
-            chr_count = board_usb_get_serial(_desc_str + 1, 32);
+            // @@chg
+            // =====>
+            //chr_count = board_usb_get_serial(_desc_str + 1, 32);
+            if (is_ble) {
+                chr_count = get_ble_device_serial(pstDevi, _desc_str + 1);
+            } else {
+                chr_count = board_usb_get_serial(_desc_str + 1, 32);
+            }
+            // <=====
             break;
 
         default:
@@ -265,6 +420,12 @@ uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
             if ( !(index < sizeof(string_desc_arr) / sizeof(string_desc_arr[0])) ) return NULL;
 
             const char *str = string_desc_arr[index];
+            // @@add
+            // =====>
+            if (is_ble && (get_ble_device_string(pstDevi, index) != NULL)) {
+                str = get_ble_device_string(pstDevi, index);
+            }
+            // <=====
 
             // Cap at max char
             chr_count = strlen(str);
@@ -34,4 +34,14 @@ enum
     REPORT_ID_COUNT
 };
 
+// @@add
+// =====>
+// HID instances (order of the HID interfaces in the configuration descriptor)
+enum
+{
+    HID_INST_BRIDGE = 0, // Report pass-through of the BLE device
+    HID_INST_DIAG,       // Vendor-defined diagnostics (if CFG_BRIDGE_DIAG)
+};
+// <=====
+
 #endif /* USB_DESCRIPTORS_H_ */